@@ -0,0 +1,22 @@
+// Auto Generate
+
+#ifndef __LINUX__
+#   define __LINUX__ 1
+#endif
+
+#ifndef __CPU_X64__
+#   define __CPU_X64__
+#endif
+
+#ifndef PROJ_CFG_VLLINKLITE
+#   define PROJ_CFG_VLLINKLITE
+#endif
+
+#ifndef BRD_CFG_VLLINKLITE_USBIP
+#   define BRD_CFG_VLLINKLITE_USBIP
+#endif
+
+#ifndef VENDOR_SCRIPT
+#   define VENDOR_SCRIPT 0
+#endif
+
@@ -10,6 +10,10 @@
 #elif defined(BRD_CFG_VLLINKLITE_MT006)
 #	include "chip_cfg_mt006.h"
 #   include "brd_cfg_vllinklite_mt006.h"
+#elif defined(BRD_CFG_VLLINKLITE_SIM)
+#   include "brd_cfg_vllinklite_sim.h"
+#elif defined(BRD_CFG_VLLINKLITE_USBIP)
+#   include "brd_cfg_vllinklite_usbip.h"
 #endif
 
 #endif // __BRD_CFG_H__
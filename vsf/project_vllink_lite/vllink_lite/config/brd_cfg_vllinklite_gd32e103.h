@@ -8,6 +8,8 @@
 
 #define FLASH0_ENABLE           0
 
+#define CRC0_ENABLE             1
+
 #define GPIOA_ENABLE            1
 #define GPIOB_ENABLE            1
 #define GPIOC_ENABLE            0
@@ -16,7 +18,7 @@
 
 #define USART_STREAM_ENABLE     1
 #define USART_STREAM_EDA_PRIORITY   vsf_prio_1      // same as VSF_USBD_CFG_EDA_PRIORITY
-#define USART_BUFF_SIZE         64
+#define USART_BUFF_SIZE         128
 #define USART0_ENABLE           1
 #   define USART0_DMA_ENABLE    1
 #   define USART0_IO_REMAP      0
@@ -157,7 +159,7 @@
 // UART, SWO & EXT
 #define PERIPHERAL_UART_SWO_IDX             USART1_IDX
 #define PERIPHERAL_UART_EXT_IDX             USART0_IDX
-#   define PERIPHERAL_UART_EXT_BAUD_MAX     (96000000 / 20)
+#   define PERIPHERAL_UART_EXT_BAUD_MAX     CHIP_USART_BAUD_MAX
 #   define PERIPHERAL_UART_EXT_BAUD_MIN     (2000)
 #define PERIPHERAL_UART_SWO_PRIORITY        vsf_arch_prio_3
 #define PERIPHERAL_UART_EXT_PRIORITY        vsf_arch_prio_3
@@ -7,6 +7,8 @@
 
 #define FLASH0_ENABLE           0
 
+#define CRC0_ENABLE             1
+
 #define GPIOA_ENABLE            1
 #define GPIOB_ENABLE            1
 #define GPIOC_ENABLE            0
@@ -15,7 +17,7 @@
 
 #define USART_STREAM_ENABLE     1
 #define USART_STREAM_EDA_PRIORITY   vsf_prio_1      // same as VSF_USBD_CFG_EDA_PRIORITY
-#define USART_BUFF_SIZE         64
+#define USART_BUFF_SIZE         128
 #define USART0_ENABLE           1
 #   define USART0_DMA_ENABLE    1
 #   define USART0_TXD_IO_IDX    GPIOA_IDX 
@@ -76,9 +78,20 @@
 
 #define SWD0_ENABLE             1
 #   define SWD_SPI_BASE         SPI0
+// no SWD_SPI_DMAX: SPI0 only has DMA CH1/CH2, which USART0 uses, and the
+// USART0 remap channels CH3/CH4 are USART1's, so the SWD data phase polls SPI
 
 #define JTAG0_ENABLE            1
 #   define JTAG_SPI_BASE        SPI0
+// no JTAG_SPI_DMAX for the same reason as SWD, JTAG_ASYNC polls SPI and
+// leaves the last byte of a scan on the wire
+
+// TIMER1_CH3 captures both SWO edges, shares the pin with USART1 RX
+#define SWO_MANCHESTER_ENABLE   SWO_MANCHESTER
+#   define SWO_MANCHESTER_IO_IDX    GPIOA_IDX
+#   define SWO_MANCHESTER_IO_PIN    3
+#   define SWO_MANCHESTER_IO_AF     (IO_AF | IO_AF_2)
+#   define SWO_MANCHESTER_DMA_CH    6
 
 #define PERIPHERAL_JTAG_PRIORITY            vsf_arch_prio_2
 #define PERIPHERAL_SWD_PRIORITY             vsf_arch_prio_2
@@ -126,9 +139,10 @@
 // UART, SWO & EXT
 #define PERIPHERAL_UART_SWO_IDX             USART1_IDX
 #define PERIPHERAL_UART_EXT_IDX             USART0_IDX
-#   define PERIPHERAL_UART_EXT_BAUD_MAX     (96000000 / 20)
+#   define PERIPHERAL_UART_EXT_BAUD_MAX     CHIP_USART_BAUD_MAX
 #   define PERIPHERAL_UART_EXT_BAUD_MIN     (2000)
 #define PERIPHERAL_UART_SWO_PRIORITY        vsf_arch_prio_3
+#define PERIPHERAL_SWO_MANCHESTER_PRIORITY  vsf_arch_prio_3
 #define PERIPHERAL_UART_EXT_PRIORITY        vsf_arch_prio_3
 #define PERIPHERAL_UART_PARITY_NONE         USART_PARITY_NONE
 #define PERIPHERAL_UART_PARITY_ODD          USART_PARITY_ODD
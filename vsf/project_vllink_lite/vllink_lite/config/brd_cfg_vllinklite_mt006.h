@@ -74,7 +74,7 @@
 // UART, SWO & EXT
 #define PERIPHERAL_UART_EXT_IDX             USART0_IDX
 //#define PERIPHERAL_UART_EXT_IDX             USART0_IDX
-#   define PERIPHERAL_UART_EXT_BAUD_MAX     (96000000 / 20)
+#   define PERIPHERAL_UART_EXT_BAUD_MAX     CHIP_USART_BAUD_MAX
 #   define PERIPHERAL_UART_EXT_BAUD_MIN     (2000)
 #define PERIPHERAL_UART_EXT_PRIORITY        vsf_arch_prio_2
 //#define PERIPHERAL_UART_EXT_PRIORITY        vsf_arch_prio_2
@@ -0,0 +1,46 @@
+#ifndef __BOARD_CFG_USBIP_H__
+#define __BOARD_CFG_USBIP_H__
+
+/*
+    The sim board run by the real vsf kernel on linux, USB over the USB/IP DCD,
+    see cmake_vllinklite_usbip. GPIO/SWD/JTAG are sim_hal.c, the UARTs are
+    looped back there, tx to rx. The shell port is the RTT console of the
+    sim target.
+*/
+
+#define VSF_DRIVER_HEADER               "../../../project_vllink_lite/vllink_lite/sim/sim_driver.h"
+
+#include "brd_cfg_vllinklite_sim.h"
+
+// the linux arch has a single interrupt priority and no swi
+#undef PERIPHERAL_JTAG_PRIORITY
+#undef PERIPHERAL_SWD_PRIORITY
+#undef PERIPHERAL_TIMESTAMP_PRIORITY
+#undef PERIPHERAL_UART_SWO_PRIORITY
+#undef PERIPHERAL_UART_EXT_PRIORITY
+#define PERIPHERAL_JTAG_PRIORITY            vsf_arch_prio_0
+#define PERIPHERAL_SWD_PRIORITY             vsf_arch_prio_0
+#define PERIPHERAL_TIMESTAMP_PRIORITY       vsf_arch_prio_0
+#define PERIPHERAL_UART_SWO_PRIORITY        vsf_arch_prio_0
+#define PERIPHERAL_UART_EXT_PRIORITY        vsf_arch_prio_0
+
+// no swi to run the kernel on, so it runs in the idle loop
+#undef VSF_OS_CFG_PRIORITY_NUM
+#define VSF_OS_CFG_ADD_EVTQ_TO_IDLE                     ENABLED
+#undef VSF_USBD_CFG_HW_PRIORITY
+#define VSF_USBD_CFG_HW_PRIORITY                        vsf_arch_prio_0
+#undef VSF_USBD_CFG_EDA_PRIORITY
+#define VSF_USBD_CFG_EDA_PRIORITY                       vsf_prio_0
+#define USART_STREAM_EDA_PRIORITY                       vsf_prio_0  // same as VSF_USBD_CFG_EDA_PRIORITY
+
+#define VSF_SYSTIMER_FREQ                               (1000000)   // ticks are us on linux
+
+#define VSF_USBD_USE_DCD_USBIP                          ENABLED
+// the USB/IP DCD allocates its urbs
+#undef VSF_USE_HEAP
+#define VSF_USE_HEAP                                    ENABLED
+#ifndef VSF_HEAP_SIZE
+#   define VSF_HEAP_SIZE                                0x10000
+#endif
+
+#endif // __BOARD_CFG_USBIP_H__
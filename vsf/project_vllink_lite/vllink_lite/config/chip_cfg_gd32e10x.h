@@ -106,6 +106,10 @@
 #	define CHIP_APB2_FREQ_HZ               (CHIP_AHB_FREQ_HZ / 2)
 #endif
 
+// highest baud the UART bridge is set to, the USART divider limit; not a
+// measured sustained rate, bytes lost when the DMA ring laps are counted
+#define CHIP_USART_BAUD_MAX                 (96000000 / 20)
+
 #if (VSF_USE_USB_DEVICE == ENABLED) || (VSF_USE_USB_HOST == ENABLED)
 #   define VSF_USBD_USE_DCD_DWCOTG          ENABLED
 #endif
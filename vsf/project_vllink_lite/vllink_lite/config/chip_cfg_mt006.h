@@ -54,6 +54,9 @@
 #   error "Need Config Clock"
 #endif
 
+// highest baud the UART bridge is set to, not a measured sustained rate
+#define CHIP_USART_BAUD_MAX                 (96000000 / 20)
+
 #if (VSF_USE_USB_DEVICE == ENABLED) || (VSF_USE_USB_HOST == ENABLED)
 #   if (VSF_USE_USB_DEVICE == ENABLED)
 #       if (VSF_USBD_CFG_USE_EDA == DISABLED)
@@ -12,6 +12,7 @@
 #   define APP_CFG_USBD_PRODUCT_STR                     u"Vllink Lite"
 #   define APP_CFG_USBD_SERIAL_STR                      u"GD32E103"
 #   define PROJ_CFG_GD32E10X_HSI48M_USB_PLL_128M_OVERCLOCK
+#   define VENDOR_SCRIPT                                1   // 1 KB bytecode, 0x100 heap of the vsfvm runtime
 #   if (VSF_USE_USB_DEVICE == ENABLED) || (VSF_USE_USB_HOST == ENABLED)
 #       define VSF_DWCOTG_DCD_CFG_FAKE_EP               ENABLED
 #       define USRAPP_CFG_USBD_SPEED                    USB_SPEED_FULL
@@ -19,21 +20,27 @@
 #   endif
 #	define APP_CFG_CMSIS_DAP_V2_SUPPORT
 #	define APP_CFG_WEBUSB_SUPPORT
+//#	define APP_CFG_CMSIS_DAP_V1_SUPPORT                // HID, needs an IN ep, e.g. the one of SWO_STREAM
 #	define APP_CFG_CDCEXT_SUPPORT
-#       define APP_CFG_CDCEXT_EXT2USB_PKT_NUM           4
-#       define APP_CFG_CDCEXT_USB2EXT_PKT_NUM           3
+#       define APP_CFG_CDCEXT_EXT2USB_PKT_NUM           8
+#       define APP_CFG_CDCEXT_USB2EXT_PKT_NUM           8
 #       define APP_CFG_CDCEXT_PKT_SIZE                  64
-//#	define APP_CFG_CDCSHELL_SUPPORT
+#	define APP_CFG_CDCSHELL_SUPPORT                     // takes ep 3 from SWO_STREAM, SWO is read with DAP_SWO_Data
 #       define APP_CFG_CDCSHELL_EXT2USB_PKT_NUM         4
 #       define APP_CFG_CDCSHELL_USB2EXT_PKT_NUM         3
 #       define APP_CFG_CDCSHELL_PKT_SIZE                64
-#       define APP_CFG_CDCSHELL_DAPHOST
+#       define APP_CFG_CDCSHELL_DAPHOST                 // RTT console of the target, DTR starts it
 #   define APP_CFG_CDCEXT_DATA_OUT_EP                   2
 #   define APP_CFG_CDCEXT_DATA_IN_EP                    2
-#   define APP_CFG_CDCEXT_NOTIFY_EP                     3
-//#   define APP_CFG_CDCSHELL_DATA_OUT_EP                 3
-//#   define APP_CFG_CDCSHELL_DATA_IN_EP                  3
-//#   define APP_CFG_CDCSHELL_NOTIFY_EP                   5
+#   define APP_CFG_CDCEXT_NOTIFY_EP                     4   // fake ep, never sent on
+//#   define APP_CFG_CMSIS_DAP_V1_EP                      3
+#   ifdef APP_CFG_CDCSHELL_SUPPORT
+#       define APP_CFG_CDCSHELL_DATA_OUT_EP             3
+#       define APP_CFG_CDCSHELL_DATA_IN_EP              3
+#       define APP_CFG_CDCSHELL_NOTIFY_EP               5   // fake ep, never sent on
+#   else
+#       define APP_CFG_CMSIS_DAP_V2_SWO_EP              3
+#   endif
 #elif defined(BRD_CFG_VLLINKLITE_GD32F350)
 #   define APP_CFG_SERIAL_HEADER_STR                    u"GD32F350."
 #   define APP_CFG_SERIAL_HEADER_STR_LENGTH             (sizeof(APP_CFG_SERIAL_HEADER_STR) - 2)
@@ -45,6 +52,9 @@
 #   define APP_CFG_USBD_PRODUCT_STR                     u"Vllink Lite"
 #   define APP_CFG_USBD_SERIAL_STR                      u"GD32F350"
 #   define PROJ_CFG_GD32F3X0_HSI48M_USB_PLL_128M_OVERCLOCK
+//#   define SWO_MANCHESTER                               1   // PA3 capture, 1 KB edge ring
+#   define VENDOR_UART_BUFFER_SIZE                      64  // 8 KB RAM, the host polls the tunnel more often
+#   define CMSIS_DAP_V2_PACKED                          0   // 8 KB RAM, no room for two more packet buffers
 #   if (VSF_USE_USB_DEVICE == ENABLED) || (VSF_USE_USB_HOST == ENABLED)
 #       define VSF_DWCOTG_DCD_CFG_FAKE_EP               ENABLED
 #       define USRAPP_CFG_USBD_SPEED                    USB_SPEED_FULL
@@ -52,23 +62,68 @@
 #   endif
 #	define APP_CFG_CMSIS_DAP_V2_SUPPORT
 #	define APP_CFG_WEBUSB_SUPPORT
+//#	define APP_CFG_CMSIS_DAP_V1_SUPPORT                // HID, needs an IN ep, e.g. the one of SWO_STREAM
 #	define APP_CFG_CDCEXT_SUPPORT
-#       define APP_CFG_CDCEXT_EXT2USB_PKT_NUM           4
+#       define APP_CFG_CDCEXT_EXT2USB_PKT_NUM           4   // 8 KB RAM, 8/8 on the larger boards
 #       define APP_CFG_CDCEXT_USB2EXT_PKT_NUM           3
 #       define APP_CFG_CDCEXT_PKT_SIZE                  64
-//#   define APP_CFG_CDCSHELL_SUPPORT
+//#   define APP_CFG_CDCSHELL_SUPPORT                    // takes ep 3 from SWO_STREAM
+#       define APP_CFG_CDCSHELL_EXT2USB_PKT_NUM         4
+#       define APP_CFG_CDCSHELL_USB2EXT_PKT_NUM         3
+#       define APP_CFG_CDCSHELL_PKT_SIZE                64
+#       define APP_CFG_CDCSHELL_DAPHOST                 // RTT console of the target, DTR starts it
+#   define APP_CFG_CDCEXT_DATA_OUT_EP                   2
+#   define APP_CFG_CDCEXT_DATA_IN_EP                    2
+#   define APP_CFG_CDCEXT_NOTIFY_EP                     4   // fake ep, never sent on
+//#   define APP_CFG_CMSIS_DAP_V1_EP                      3
+#   ifdef APP_CFG_CDCSHELL_SUPPORT
+#       define APP_CFG_CDCSHELL_DATA_OUT_EP             3
+#       define APP_CFG_CDCSHELL_DATA_IN_EP              3
+#       define APP_CFG_CDCSHELL_NOTIFY_EP               5   // fake ep, never sent on
+#   else
+#       define APP_CFG_CMSIS_DAP_V2_SWO_EP              3
+#   endif
+#elif defined(BRD_CFG_VLLINKLITE_USBIP)
+#   define APP_CFG_SERIAL_HEADER_STR                    u"USBIP."
+#   define APP_CFG_SERIAL_HEADER_STR_LENGTH             (sizeof(APP_CFG_SERIAL_HEADER_STR) - 2)
+#   define APP_CFG_SERIAL_ATTACH_UUID
+#   define APP_CFG_USBD_VID                             0x1209
+#   define APP_CFG_USBD_PID                             0x6666
+#   define APP_CFG_USBD_BCD                             0x0101
+#   define APP_CFG_USBD_VENDOR_STR                      u"Vllogic.com"
+#   define APP_CFG_USBD_PRODUCT_STR                     u"Vllink Lite"
+#   define APP_CFG_USBD_SERIAL_STR                      u"USBIP.SIM"
+#   if (VSF_USE_USB_DEVICE == ENABLED) || (VSF_USE_USB_HOST == ENABLED)
+#       define USRAPP_CFG_USBD_SPEED                    USB_SPEED_FULL
+#       define APP_CFG_USBD_SPEED                       USB_DC_SPEED_FULL
+#   endif
+#	define APP_CFG_CMSIS_DAP_V2_SUPPORT
+#	define APP_CFG_WEBUSB_SUPPORT
+#	define APP_CFG_CDCEXT_SUPPORT
+#       define APP_CFG_CDCEXT_EXT2USB_PKT_NUM           8
+#       define APP_CFG_CDCEXT_USB2EXT_PKT_NUM           8
+#       define APP_CFG_CDCEXT_PKT_SIZE                  64
+#	define APP_CFG_CDCSHELL_SUPPORT                     // USB/IP has the eps for SWO_STREAM and the shell
 #       define APP_CFG_CDCSHELL_EXT2USB_PKT_NUM         4
 #       define APP_CFG_CDCSHELL_USB2EXT_PKT_NUM         3
 #       define APP_CFG_CDCSHELL_PKT_SIZE                64
+#       define APP_CFG_CDCSHELL_DAPHOST                 // RTT console of the target, DTR starts it
+#   define APP_CFG_CMSIS_DAP_V2_SWO_EP                  3
 #   define APP_CFG_CDCEXT_DATA_OUT_EP                   2
 #   define APP_CFG_CDCEXT_DATA_IN_EP                    2
-#   define APP_CFG_CDCEXT_NOTIFY_EP                     3
-//#   define APP_CFG_CDCSHELL_DATA_OUT_EP                 3
-//#   define APP_CFG_CDCSHELL_DATA_IN_EP                  3
-//#   define APP_CFG_CDCSHELL_NOTIFY_EP                   5
+#   define APP_CFG_CDCEXT_NOTIFY_EP                     4
+#   define APP_CFG_CDCSHELL_DATA_OUT_EP                 5
+#   define APP_CFG_CDCSHELL_DATA_IN_EP                  5
+#   define APP_CFG_CDCSHELL_NOTIFY_EP                   6
 #endif
 
-#ifdef APP_CFG_CDCSHELL_SUPPORT
+#ifndef APP_CFG_CDCSHELL_SUPPORT
+#   undef APP_CFG_CDCSHELL_DAPHOST                     // an option of the shell port
+#endif
+#ifndef VENDOR_SCRIPT
+#   define VENDOR_SCRIPT                                0   // vsfvm scripts of DAP accesses on the probe, compiled on the host
+#endif
+#if defined(APP_CFG_CDCSHELL_SUPPORT) && !defined(APP_CFG_CDCSHELL_DAPHOST)
 #   define VSF_KERNEL_CFG_EDA_SUPPORT_SUB_CALL          ENABLED
 #   define VSF_KERNEL_CFG_EDA_SUPPORT_FSM               ENABLED
 #   define VSF_USE_HEAP                                 ENABLED
@@ -78,14 +133,37 @@
 #else
 #   define VSF_KERNEL_CFG_EDA_SUPPORT_SUB_CALL          DISABLED
 #   define VSF_KERNEL_CFG_EDA_SUPPORT_FSM               DISABLED
-#   define VSF_USE_HEAP                                 DISABLED
+#   if VENDOR_SCRIPT
+// linked in by the vsfvm runtime, the dap extension does not allocate
+#       define VSF_USE_HEAP                             ENABLED
+#       define VSF_HEAP_SIZE                            0x100
+#   else
+#       define VSF_USE_HEAP                             DISABLED
+#   endif
 #endif
 
-#define CMSIS_DAP_V2_PACKET_SIZE                        512
+/*
+    A board with a high speed PHY on dwcotg defines APP_CFG_USBD_HS_SUPPORT,
+    sets USRAPP_CFG_USBD_SPEED/APP_CFG_USBD_SPEED to high speed and makes its
+    CDC packets 512 bytes. The config descriptor below stays the full speed
+    one, the high speed one is built from it when the host enumerates.
+*/
+#ifdef APP_CFG_USBD_HS_SUPPORT
+#   define CMSIS_DAP_V2_PACKET_SIZE                     1024
+#   define APP_CFG_USBD_HS_DESC_COUNT                   2
+#else
+#   define CMSIS_DAP_V2_PACKET_SIZE                     512
+#   define APP_CFG_USBD_HS_DESC_COUNT                   0
+#endif
+#define CMSIS_DAP_V2_FS_PACKET_SIZE                     512     // on a full speed host
+#define CMSIS_DAP_V2_FS_EP_SIZE                         64      // bulk eps, SWO_STREAM too
+#ifndef CMSIS_DAP_V2_PACKED
+#   define CMSIS_DAP_V2_PACKED                          1       // two more packet buffers
+#endif
 #define WEBUSB_DAP_PACKET_SIZE                          64
 
 #ifdef APP_CFG_CMSIS_DAP_V2_SUPPORT
-#	define CMSIS_DAP_V2_DESC_LENGTH			            23
+#	define CMSIS_DAP_V2_DESC_LENGTH			            (23 + (SWO_STREAM ? 7 : 0))
 #	define CMSIS_DAP_V2_INTERFACE_COUNT		            1
 #	define WINUSB_BOS_DESC_LENGTH			            28
 #	define WINUSB_BOS_COUNT					            1
@@ -116,6 +194,17 @@
 #	define WEBUSB_STR_DESC_COUNT                        0
 #endif
 
+#ifdef APP_CFG_CMSIS_DAP_V1_SUPPORT
+#   define VSF_USBD_USE_HID                             ENABLED
+#	define CMSIS_DAP_V1_DESC_LENGTH			            32
+#	define CMSIS_DAP_V1_INTERFACE_COUNT		            1
+#	define CMSIS_DAP_V1_STR_DESC_COUNT                  1
+#else
+#	define CMSIS_DAP_V1_DESC_LENGTH			            0
+#	define CMSIS_DAP_V1_INTERFACE_COUNT		            0
+#	define CMSIS_DAP_V1_STR_DESC_COUNT                  0
+#endif
+
 #ifdef APP_CFG_CDCEXT_SUPPORT
 #	define CDCEXT_DESC_LENGTH				            66
 #	define CDCEXT_INTERFACE_COUNT			            2
@@ -136,12 +225,12 @@
 #	define CDCSHELL_STR_DESC_COUNT                      0
 #endif
 
-#define APP_CFG_USBD_CONFIGDESC_LENGTH                  (9 + CMSIS_DAP_V2_DESC_LENGTH + WEBUSB_DESC_LENGTH + CDCEXT_DESC_LENGTH + CDCSHELL_DESC_LENGTH)
-#define APP_CFG_USBD_INTERFACE_COUNT                    (CMSIS_DAP_V2_INTERFACE_COUNT + WEBUSB_INTERFACE_COUNT + CDCEXT_INTERFACE_COUNT + CDCSHELL_INTERFACE_COUNT)
+#define APP_CFG_USBD_CONFIGDESC_LENGTH                  (9 + CMSIS_DAP_V2_DESC_LENGTH + WEBUSB_DESC_LENGTH + CDCEXT_DESC_LENGTH + CDCSHELL_DESC_LENGTH + CMSIS_DAP_V1_DESC_LENGTH)
+#define APP_CFG_USBD_INTERFACE_COUNT                    (CMSIS_DAP_V2_INTERFACE_COUNT + WEBUSB_INTERFACE_COUNT + CDCEXT_INTERFACE_COUNT + CDCSHELL_INTERFACE_COUNT + CMSIS_DAP_V1_INTERFACE_COUNT)
 #define APP_CFG_USBD_WINUSB_DESC_LENGTH                 (10 + FUNCTION_WEBUSB_SUBSET_LEN + FUNCTION_CMSIS_DAP_V2_SUBSET_LEN)
 #define APP_CFG_USBD_BOS_NUMBER                         (WINUSB_BOS_COUNT + WEBUSB_BOS_COUNT)
 #define APP_CFG_USBD_BOS_DESC_LENGTH                    (5 + WINUSB_BOS_DESC_LENGTH + WEBUSB_BOS_DESC_LENGTH)
-#define APP_CFG_USBD_DESC_COUNT                         (7 + CMSIS_DAP_V2_STR_DESC_COUNT + WEBUSB_STR_DESC_COUNT + CDCEXT_STR_DESC_COUNT + CDCSHELL_STR_DESC_COUNT)
+#define APP_CFG_USBD_DESC_COUNT                         (7 + APP_CFG_USBD_HS_DESC_COUNT + CMSIS_DAP_V2_STR_DESC_COUNT + WEBUSB_STR_DESC_COUNT + CDCEXT_STR_DESC_COUNT + CDCSHELL_STR_DESC_COUNT + CMSIS_DAP_V1_STR_DESC_COUNT)
 
 
 /*
@@ -156,26 +245,69 @@
 #define DAP_SWD                                         1
 #define DAP_JTAG                                        1
 #define DAP_JTAG_DEV_CNT                                8
+#ifndef DAP_SWD_ADAPT
+#   define DAP_SWD_ADAPT                                0   // adaptive SWD clock from start
+#endif
+#ifndef DAP_SWD_CACHE
+#   define DAP_SWD_CACHE                                0   // SWD write cache from start, else the host switches it
+#endif
 #define DAP_DEFAULT_PORT                                1
 #define DAP_DEFAULT_SWJ_CLOCK                           4000000
 #define DAP_CTRL_PACKET_SIZE                            64
-#define DAP_BULK_PACKET_SIZE                            512
+#define DAP_BULK_PACKET_SIZE                            CMSIS_DAP_V2_PACKET_SIZE
 #define DAP_HID_PACKET_SIZE                             64
 #if DAP_BULK_PACKET_SIZE > DAP_HID_PACKET_SIZE
 #   define DAP_PACKET_SIZE                              DAP_BULK_PACKET_SIZE
 #else
 #   define DAP_PACKET_SIZE                              DAP_HID_PACKET_SIZE
 #endif
-#define DAP_PACKET_COUNT                                4
+#ifdef APP_CFG_USBD_HS_SUPPORT
+#   define DAP_PACKET_COUNT                             8
+#else
+#   define DAP_PACKET_COUNT                             4
+#endif
 #define TIMESTAMP_CLOCK                                 1000000			// 1M
 #define SWO_UART                                        1
-#define SWO_STREAM                                      0
+#if defined(APP_CFG_CDCSHELL_SUPPORT) && !defined(APP_CFG_CMSIS_DAP_V2_SWO_EP)
+#   define SWO_STREAM                                   0   // its ep went to the shell port
+#else
+#   define SWO_STREAM                                   1   // needs SWO_UART, trace on its own bulk IN ep
+#endif
 #define SWO_UART_MAX_BAUDRATE                           3200000
 #define SWO_UART_MIN_BAUDRATE                           2000
-#define SWO_MANCHESTER                                  0
+#ifndef SWO_MANCHESTER
+#   define SWO_MANCHESTER                               0   // needs SWO_UART, decodes into the same swo_rx
+#endif
+#define SWO_MANCHESTER_MAX_BAUDRATE                     SWO_UART_MAX_BAUDRATE
+#define SWO_MANCHESTER_MIN_BAUDRATE                     2000
 #define SWO_BUFFER_SIZE                                 512
-#define VENDOR_UART                                     0
-#define VENDOR_UART_BUFFER_SIZE                         256
+#ifndef VENDOR_UART
+#   define VENDOR_UART                                  1   // USART tunnel over the vendor commands
+#endif
+#ifndef VENDOR_UART_BUFFER_SIZE
+#   define VENDOR_UART_BUFFER_SIZE                      256 // each of ext_tx, ext_rx and swo_tx
+#endif
+#define VENDOR_RTT                                      1   // SEGGER RTT over the vendor commands, RTT host of APP_CFG_CDCSHELL_DAPHOST
+#define VENDOR_RTT_SCAN_ADDR                            0x20000000  // where the RTT host looks for the control block
+#define VENDOR_RTT_SCAN_SIZE                            0x10000
+#define VENDOR_CRC                                      1   // CRC-32 of target memory on the probe, for flash verify
+#define VENDOR_MULTIDROP                                1   // SWD multi-drop target selection, targets of the SWD write cache
+#define VENDOR_MULTIDROP_NUM                            4   // targets remembered
+#define VENDOR_SCRIPT_SIZE                              1024    // bytecode
+#define VENDOR_SCRIPT_STACK                             64      // vsfvm variables
+
+#if VENDOR_SCRIPT
+#   define VSFVM_CFG_RUNTIME_EN                         ENABLED
+#   define VSFVM_CFG_COMPILER_EN                        DISABLED
+#   define VSFVM_CFG_RUNTIME_STACK_SIZE                 VENDOR_SCRIPT_STACK
+#else
+// the target builds list the vsfvm sources, they compile empty
+#   define VSFVM_CFG_RUNTIME_EN                         DISABLED
+#   define VSFVM_CFG_COMPILER_EN                        DISABLED
+#endif
+#ifndef DAP_STATS
+#   define DAP_STATS                                    0   // command timing, needs TIMESTAMP_CLOCK
+#endif
 
 
 #endif // __PROJ_CFG_LVL2_H__
\ No newline at end of file
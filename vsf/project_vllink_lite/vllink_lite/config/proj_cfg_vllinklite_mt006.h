@@ -51,6 +51,8 @@
 #endif
 
 #define CMSIS_DAP_V2_PACKET_SIZE                        256
+#define CMSIS_DAP_V2_FS_PACKET_SIZE                     CMSIS_DAP_V2_PACKET_SIZE
+#define CMSIS_DAP_V2_FS_EP_SIZE                         64      // bulk eps
 #define WEBUSB_DAP_PACKET_SIZE                          64
 
 #ifdef APP_CFG_CMSIS_DAP_V2_SUPPORT
@@ -85,6 +87,17 @@
 #	define WEBUSB_STR_DESC_COUNT                        0
 #endif
 
+#ifdef APP_CFG_CMSIS_DAP_V1_SUPPORT
+#   define VSF_USBD_USE_HID                             ENABLED
+#	define CMSIS_DAP_V1_DESC_LENGTH			            32
+#	define CMSIS_DAP_V1_INTERFACE_COUNT		            1
+#	define CMSIS_DAP_V1_STR_DESC_COUNT                  1
+#else
+#	define CMSIS_DAP_V1_DESC_LENGTH			            0
+#	define CMSIS_DAP_V1_INTERFACE_COUNT		            0
+#	define CMSIS_DAP_V1_STR_DESC_COUNT                  0
+#endif
+
 #ifdef APP_CFG_CDCEXT_SUPPORT
 #	define CDCEXT_DESC_LENGTH				            66
 #	define CDCEXT_INTERFACE_COUNT			            2
@@ -105,12 +118,12 @@
 #	define CDCSHELL_STR_DESC_COUNT                      0
 #endif
 
-#define APP_CFG_USBD_CONFIGDESC_LENGTH                  (9 + CMSIS_DAP_V2_DESC_LENGTH + WEBUSB_DESC_LENGTH + CDCEXT_DESC_LENGTH + CDCSHELL_DESC_LENGTH)
-#define APP_CFG_USBD_INTERFACE_COUNT                    (CMSIS_DAP_V2_INTERFACE_COUNT + WEBUSB_INTERFACE_COUNT + CDCEXT_INTERFACE_COUNT + CDCSHELL_INTERFACE_COUNT)
+#define APP_CFG_USBD_CONFIGDESC_LENGTH                  (9 + CMSIS_DAP_V2_DESC_LENGTH + WEBUSB_DESC_LENGTH + CDCEXT_DESC_LENGTH + CDCSHELL_DESC_LENGTH + CMSIS_DAP_V1_DESC_LENGTH)
+#define APP_CFG_USBD_INTERFACE_COUNT                    (CMSIS_DAP_V2_INTERFACE_COUNT + WEBUSB_INTERFACE_COUNT + CDCEXT_INTERFACE_COUNT + CDCSHELL_INTERFACE_COUNT + CMSIS_DAP_V1_INTERFACE_COUNT)
 #define APP_CFG_USBD_WINUSB_DESC_LENGTH                 (10 + FUNCTION_WEBUSB_SUBSET_LEN + FUNCTION_CMSIS_DAP_V2_SUBSET_LEN)
 #define APP_CFG_USBD_BOS_NUMBER                         (WINUSB_BOS_COUNT + WEBUSB_BOS_COUNT)
 #define APP_CFG_USBD_BOS_DESC_LENGTH                    (5 + WINUSB_BOS_DESC_LENGTH + WEBUSB_BOS_DESC_LENGTH)
-#define APP_CFG_USBD_DESC_COUNT                         (7 + CMSIS_DAP_V2_STR_DESC_COUNT + WEBUSB_STR_DESC_COUNT + CDCEXT_STR_DESC_COUNT + CDCSHELL_STR_DESC_COUNT)
+#define APP_CFG_USBD_DESC_COUNT                         (7 + CMSIS_DAP_V2_STR_DESC_COUNT + WEBUSB_STR_DESC_COUNT + CDCEXT_STR_DESC_COUNT + CDCSHELL_STR_DESC_COUNT + CMSIS_DAP_V1_STR_DESC_COUNT)
 
 
 /*
@@ -125,6 +138,8 @@
 #define DAP_SWD                                         1
 #define DAP_JTAG                                        0
 #define DAP_JTAG_DEV_CNT                                8
+#define DAP_SWD_ADAPT                                   0
+#define DAP_SWD_CACHE                                   0
 #define DAP_DEFAULT_PORT                                1
 #define DAP_DEFAULT_SWJ_CLOCK                           4000000
 #define DAP_CTRL_PACKET_SIZE                            64
@@ -145,6 +160,11 @@
 #define SWO_BUFFER_SIZE                                 512
 #define VENDOR_UART                                     0
 #define VENDOR_UART_BUFFER_SIZE                         256
+#define VENDOR_RTT                                      0
+#define VENDOR_CRC                                      0
+#define VENDOR_MULTIDROP                                0
+#define VENDOR_SCRIPT                                   0
+#define DAP_STATS                                       0
 
 
 #endif // __PROJ_CFG_LVL2_H__
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "dap.h"
 #include "dap_swo.h"
 #include "dap_vendor.h"
+#include "dap_script.h"
 
 #ifdef DAP_VENDOR
 const char DAP_Vendor[] = DAP_VENDOR;
@@ -25,16 +26,292 @@ static uint64_t buf_tms[2], buf_tdi[2], buf_tdo[2];
 static uint64_t buf_tms, buf_tdi, buf_tdo;
 #endif
 
+#if DAP_SWD
+/*
+    Adaptive SWD clock, see swd_adapt(). A parity error halves the clock at
+    once. The clock doubles again, up to the DAP_SWJ_Clock of the host, after
+    up_windows windows of SWD_ADAPT_WINDOW transfers without parity error,
+    and up_windows doubles with every parity error, so a clock that fails is
+    tried less and less often. Idle cycles go up by one after a window with
+    more than one WAIT retry in SWD_ADAPT_WAIT_RATIO transfers, and down to
+    the DAP_TransferConfigure value of the host after a window without.
+*/
+#define SWD_ADAPT_WINDOW                256
+#define SWD_ADAPT_WAIT_RATIO            8
+#define SWD_ADAPT_UP_WINDOWS            4
+#define SWD_ADAPT_UP_WINDOWS_MAX        128
+#define SWD_ADAPT_MIN_KHZ               100
+#define SWD_ADAPT_IDLE_MAX              32
+
+// WAIT retries of the driver since the last call
+static uint32_t swd_retries(dap_param_t* param)
+{
+    uint32_t retries = vsfhal_swd_get_retries();
+#if DAP_STATS
+    param->stats.swd_retries += retries;
+#endif
+    return retries;
+}
+
+static void swd_config(dap_param_t* param)
+{
+    if (param->swd_adapt.enable)
+        vsfhal_swd_config(param->swd_adapt.khz, param->transfer.retry_count,
+                param->swd_adapt.idle, param->swd_conf.turnaround,
+                param->swd_conf.data_phase);
+    else
+        vsfhal_swd_config(param->speed_khz, param->transfer.retry_count,
+                param->transfer.idle_cycles, param->swd_conf.turnaround,
+                param->swd_conf.data_phase);
+}
+
+// start over from the settings of the host
+static void swd_adapt_reset(dap_param_t* param)
+{
+    param->swd_adapt.khz = param->speed_khz;
+    param->swd_adapt.idle = param->transfer.idle_cycles;
+    param->swd_adapt.stable = 0;
+    param->swd_adapt.up_windows = SWD_ADAPT_UP_WINDOWS;
+    param->swd_adapt.transfers = 0;
+    param->swd_adapt.retries = 0;
+}
+
+// after DAP_Transfer / DAP_TransferBlock on SWD
+static void swd_adapt(dap_param_t* param, uint16_t transfers)
+{
+    uint32_t parity_errors, retries;
+    bool reconfig = false;
+
+    if (!param->swd_adapt.enable || !param->swd_adapt.khz)
+        return;
+
+    parity_errors = vsfhal_swd_get_parity_errors();
+    retries = swd_retries(param);
+    param->swd_adapt.parity_errors += parity_errors;
+    param->swd_adapt.wait_retries += retries;
+    param->swd_adapt.retries += retries;
+    param->swd_adapt.transfers += transfers;
+
+    if (parity_errors) {
+        if (param->swd_adapt.khz > SWD_ADAPT_MIN_KHZ) {
+            param->swd_adapt.khz = max(param->swd_adapt.khz / 2, SWD_ADAPT_MIN_KHZ);
+            reconfig = true;
+        }
+        param->swd_adapt.stable = 0;
+        param->swd_adapt.up_windows = min(param->swd_adapt.up_windows * 2, SWD_ADAPT_UP_WINDOWS_MAX);
+        param->swd_adapt.transfers = 0;
+        param->swd_adapt.retries = 0;
+    } else if (param->swd_adapt.transfers >= SWD_ADAPT_WINDOW) {
+        if (param->swd_adapt.retries * SWD_ADAPT_WAIT_RATIO > param->swd_adapt.transfers) {
+            if (param->swd_adapt.idle < SWD_ADAPT_IDLE_MAX) {
+                param->swd_adapt.idle++;
+                reconfig = true;
+            }
+        } else if (!param->swd_adapt.retries && (param->swd_adapt.idle > param->transfer.idle_cycles)) {
+            param->swd_adapt.idle--;
+            reconfig = true;
+        }
+        if ((++param->swd_adapt.stable >= param->swd_adapt.up_windows)
+                && (param->swd_adapt.khz < param->speed_khz)) {
+            param->swd_adapt.khz = min(param->swd_adapt.khz * 2, param->speed_khz);
+            param->swd_adapt.stable = 0;
+            reconfig = true;
+        }
+        param->swd_adapt.transfers = 0;
+        param->swd_adapt.retries = 0;
+    }
+
+    if (reconfig)
+        swd_config(param);
+}
+
+void dap_swd_adapt_enable(dap_param_t* param, bool enable)
+{
+    param->swd_adapt.enable = enable;
+    param->swd_adapt.parity_errors = 0;
+    param->swd_adapt.wait_retries = 0;
+    vsfhal_swd_get_parity_errors();
+    swd_retries(param);
+    swd_adapt_reset(param);
+    if (param->port == DAP_PORT_SWD)
+        swd_config(param);
+}
+
+/*
+    SWD write cache. Hosts write SELECT, CSW and TAR again and again with
+    the values they had, each a full packet on the wire. The values written
+    are kept for each target (see VENDOR_ID_SWD_TARGETSEL) and each AP in
+    it, and a write of the value the target holds is left out with an OK.
+    TAR is forgotten with every DRW access, and the APs of a target with
+    ABORT or CTRL/STAT writes and MATCH reads. A failed access, and
+    DAP_WriteABORT, drop all of the target, SWJ and SWD sequences of the
+    host, a new port and nRESET drop all targets.
+    A reset the probe does not see, by the target itself or a button, leaves
+    values it no longer holds, so the cache is off unless DAP_SWD_CACHE and
+    the host switches it with VENDOR_ID_SWD_CACHE.
+*/
+#define SWD_CACHE_CSW                   (1U << 0)
+#define SWD_CACHE_TAR                   (1U << 1)
+#define SWD_CACHE_APBANKSEL_MASK        0x000000F0UL
+
+// MEM-AP registers, bank 0
+#define SWD_CACHE_AP_CSW                0x00U
+#define SWD_CACHE_AP_TAR                0x04U
+#define SWD_CACHE_AP_DRW                0x0CU
+
+static void swd_cache_clear(dap_swd_cache_dp_t* dp)
+{
+    uint8_t i;
+
+    dp->select_valid = false;
+    for (i = 0; i < DAP_SWD_CACHE_AP_NUM; i++)
+        dp->ap[i].valid = 0;
+}
+
+static dap_swd_cache_ap_t* swd_cache_ap(dap_swd_cache_dp_t* dp, uint8_t ap)
+{
+    dap_swd_cache_ap_t* entry;
+    uint8_t i;
+
+    for (i = 0; i < DAP_SWD_CACHE_AP_NUM; i++) {
+        if (dp->ap[i].valid && (dp->ap[i].ap == ap))
+            return &dp->ap[i];
+    }
+    entry = &dp->ap[dp->ap_next];
+    dp->ap_next = (dp->ap_next + 1) % DAP_SWD_CACHE_AP_NUM;
+    entry->ap = ap;
+    entry->valid = 0;
+    return entry;
+}
+
+// true if the value is the one known to be in the target, else it is taken as the new one
+static bool swd_cache_update(uint8_t* valid, uint8_t known, uint32_t* value, uint8_t* data)
+{
+    uint32_t new_value;
+
+    // unknown, a block write
+    if (!data) {
+        *valid &= ~known;
+        return false;
+    }
+    new_value = get_unaligned_le32(data);
+    if ((*valid & known) && (*value == new_value))
+        return true;
+    *value = new_value;
+    *valid |= known;
+    return false;
+}
+
+void dap_swd_cache_enable(dap_param_t* param, bool enable)
+{
+    uint8_t i;
+
+    param->swd_cache.enable = enable;
+    for (i = 0; i < DAP_SWD_CACHE_DP_NUM; i++)
+        swd_cache_clear(&param->swd_cache.entry[i]);
+}
+
+/*
+    Follows a DP/AP access before it is done, true for a write the target
+    does not need. data is NULL for reads and for a write of unknown data.
+    A failed access has to be followed by dap_swd_cache_forget().
+*/
+bool dap_swd_cache_access(dap_param_t* param, uint8_t request, uint8_t* data)
+{
+    dap_swd_cache_dp_t* dp = &param->swd_cache.entry[param->swd_cache.dp];
+    dap_swd_cache_ap_t* ap;
+    uint8_t reg = request & (DAP_TRANSFER_A2 | DAP_TRANSFER_A3), i;
+    bool cached = false;
+
+    if (!param->swd_cache.enable || (param->port != DAP_PORT_SWD))
+        return false;
+
+    if ((request & (DAP_TRANSFER_RnW | DAP_TRANSFER_MATCH_VALUE))
+                == (DAP_TRANSFER_RnW | DAP_TRANSFER_MATCH_VALUE)
+            || (!(request & (DAP_TRANSFER_APnDP | DAP_TRANSFER_RnW)) && (reg != DP_SELECT))) {
+        // a MATCH read retries, ABORT may cut an AP access short, CTRL/STAT may power the APs down
+        for (i = 0; i < DAP_SWD_CACHE_AP_NUM; i++)
+            dp->ap[i].valid = 0;
+    } else if (!(request & DAP_TRANSFER_APnDP)) {
+        if (!(request & DAP_TRANSFER_RnW)) {
+            uint8_t valid = dp->select_valid;
+
+            cached = swd_cache_update(&valid, 1, &dp->select, data);
+            dp->select_valid = valid;
+        }
+    } else if (!dp->select_valid) {
+        // not known which AP it is
+        for (i = 0; i < DAP_SWD_CACHE_AP_NUM; i++)
+            dp->ap[i].valid = 0;
+    } else if (!(dp->select & SWD_CACHE_APBANKSEL_MASK)) {
+        // CSW and TAR are in bank 0
+        ap = swd_cache_ap(dp, dp->select >> 24);
+        if (reg == SWD_CACHE_AP_DRW)
+            ap->valid &= ~SWD_CACHE_TAR;
+        else if ((reg == SWD_CACHE_AP_CSW) && !(request & DAP_TRANSFER_RnW))
+            cached = swd_cache_update(&ap->valid, SWD_CACHE_CSW, &ap->csw, data);
+        else if ((reg == SWD_CACHE_AP_TAR) && !(request & DAP_TRANSFER_RnW))
+            cached = swd_cache_update(&ap->valid, SWD_CACHE_TAR, &ap->tar, data);
+    }
+
+    #if DAP_STATS
+    if (cached)
+        param->stats.swd_cached++;
+    #endif
+    return cached;
+}
+
+// nothing is known of the target on the wire
+void dap_swd_cache_forget(dap_param_t* param)
+{
+    swd_cache_clear(&param->swd_cache.entry[param->swd_cache.dp]);
+}
+
+// the host drives the wire, or the targets may have been reset
+void dap_swd_cache_reset(dap_param_t* param)
+{
+    uint8_t i;
+
+    param->swd_cache.dp = 0;
+    for (i = 0; i < DAP_SWD_CACHE_DP_NUM; i++)
+        swd_cache_clear(&param->swd_cache.entry[i]);
+}
+
+#if VENDOR_MULTIDROP
+// after a TARGETSEL, the target answering to it takes an entry, 0 if none answered
+void dap_swd_cache_target(dap_param_t* param, uint32_t targetsel, bool answered)
+{
+    dap_swd_cache_dp_t* dp;
+    uint8_t i;
+
+    if (!answered) {
+        param->swd_cache.dp = 0;
+        swd_cache_clear(&param->swd_cache.entry[0]);
+        return;
+    }
+    for (i = 1; i < DAP_SWD_CACHE_DP_NUM; i++) {
+        if (param->swd_cache.entry[i].targetsel == targetsel)
+            break;
+    }
+    if (i >= DAP_SWD_CACHE_DP_NUM) {
+        i = param->swd_cache.dp_next + 1;
+        param->swd_cache.dp_next = (param->swd_cache.dp_next + 1) % VENDOR_MULTIDROP_NUM;
+        dp = &param->swd_cache.entry[i];
+        dp->targetsel = targetsel;
+        swd_cache_clear(dp);
+    }
+    param->swd_cache.dp = i;
+}
+#endif
+#endif
+
 static vsf_err_t port_init(dap_param_t* param, uint8_t port)
 {
 #if DAP_SWD
     if (port == DAP_PORT_SWD) {
         vsfhal_swd_init(PERIPHERAL_SWD_PRIORITY);
-        if (param->speed_khz) { // for keil
-            vsfhal_swd_config(param->speed_khz, param->transfer.retry_count,
-                param->transfer.idle_cycles, param->swd_conf.turnaround,
-                param->swd_conf.data_phase);
-        }
+        if (param->speed_khz)   // for keil
+            swd_config(param);
     }
 #endif
 #if DAP_JTAG
@@ -47,6 +324,9 @@ static vsf_err_t port_init(dap_param_t* param, uint8_t port)
     }
 #endif
     param->port_io_need_reconfig = false;
+#if DAP_SWD
+    dap_swd_cache_reset(param);
+#endif
     return VSF_ERR_NONE;
 }
 
@@ -159,6 +439,15 @@ static uint8_t get_dap_info(dap_param_t* param, uint8_t id, uint8_t* info, uint1
             info[0] = DAP_PACKET_COUNT;
         length = 1U;
         break;
+    case DAP_ID_PACKED_SIZE:
+        if (param->packed_size) {
+            if (info) {
+                put_unaligned_le16(param->packed_size, info);
+                param->packed_start = true;
+            }
+            length = 2U;
+        }
+        break;
     default:
         break;
     }
@@ -167,7 +456,7 @@ static uint8_t get_dap_info(dap_param_t* param, uint8_t id, uint8_t* info, uint1
 }
 
 #ifdef JTAG_ASYNC
-static uint16_t jtag_ir_to_raw(uint64_t *buf_tms, uint64_t *buf_tdi, uint32_t ir, uint8_t lr_length, uint16_t ir_before, uint16_t ir_after)
+uint16_t jtag_ir_to_raw(uint64_t *buf_tms, uint64_t *buf_tdi, uint32_t ir, uint8_t lr_length, uint16_t ir_before, uint16_t ir_after)
 {
     uint16_t bitlen;
 
@@ -213,7 +502,7 @@ static uint16_t jtag_ir_to_raw(uint64_t *buf_tms, uint64_t *buf_tdi, uint32_t ir
     return bitlen + 1;
 }
 
-static uint16_t jtag_dr_to_raw(uint64_t *buf_tms, uint64_t *buf_tdi, uint8_t request, uint32_t dr, uint16_t dr_before, uint16_t dr_after, uint8_t idle)
+uint16_t jtag_dr_to_raw(uint64_t *buf_tms, uint64_t *buf_tdi, uint8_t request, uint32_t dr, uint16_t dr_before, uint16_t dr_after, uint8_t idle)
 {
     uint16_t bitlen;
 
@@ -238,29 +527,190 @@ static uint16_t jtag_dr_to_raw(uint64_t *buf_tms, uint64_t *buf_tdi, uint8_t req
 }
 #endif
 
+#if DAP_STATS
+// account the command started at start, returns the start of the next one
+static uint32_t stats_command(dap_param_t* param, uint8_t cmd_id, uint8_t* response, uint32_t start)
+{
+    dap_stats_t *stats = &param->stats;
+    uint32_t now = vsfhal_timestamp_get(), ticks = now - start, idx;
+
+    if (cmd_id < 0x20)
+        idx = cmd_id;
+    else if ((cmd_id >= ID_DAP_Vendor0) && (cmd_id <= ID_DAP_Vendor31))
+        idx = cmd_id - ID_DAP_Vendor0 + 0x20;
+    else
+        return now;
+
+    if (!stats->cmd[idx].count || (ticks < stats->cmd[idx].min))
+        stats->cmd[idx].min = ticks;
+    if (ticks > stats->cmd[idx].max)
+        stats->cmd[idx].max = ticks;
+    stats->cmd[idx].count++;
+    stats->cmd[idx].total += ticks;
+
+    // response[0] is ID_DAP_Invalid if the command failed
+    if (response[0] == ID_DAP_Transfer)
+        stats->port_bytes[param->port] += response[1] * 4;
+    else if (response[0] == ID_DAP_TransferBlock)
+        stats->port_bytes[param->port] += get_unaligned_le16(response + 1) * 4;
+    return now;
+}
+
+static void stats_request(dap_param_t* param)
+{
+    param->stats.requests++;
+#if DAP_SWD
+    swd_retries(param);
+#endif
+#if DAP_JTAG
+    param->stats.jtag_retries += vsfhal_jtag_get_retries();
+#endif
+}
+#endif
+
+#if VENDOR_RTT
+// SELECT is write-only on SWD, the probe-side commands need the one set by the host
+static void transfer_track_select(dap_param_t* param, uint8_t* request, uint16_t transfer_cnt)
+{
+    uint8_t transfer_req;
+
+    while (transfer_cnt--) {
+        transfer_req = *request++;
+        if (transfer_req & DAP_TRANSFER_RnW) {
+            if (transfer_req & DAP_TRANSFER_MATCH_VALUE)
+                request += 4;
+        } else {
+            if (!(transfer_req & (DAP_TRANSFER_APnDP | DAP_TRANSFER_MATCH_MASK))
+                    && ((transfer_req & (DAP_TRANSFER_A2 | DAP_TRANSFER_A3)) == DP_SELECT))
+                param->dp_select = get_unaligned_le32(request);
+            request += 4;
+        }
+    }
+}
+#endif
+
+// DAP_SWJ_Pins, the pins read back after waiting up to delay_us for the selected ones
+uint8_t dap_swj_pins(dap_param_t* param, uint8_t value, uint8_t select, uint32_t delay_us)
+{
+    vsf_systimer_cnt_t tick;
+
+    if (select & (1U << DAP_SWJ_SWCLK_TCK)) {
+        if (value & (0x1 << DAP_SWJ_SWCLK_TCK))
+            PERIPHERAL_GPIO_TCK_SET();
+        else
+            PERIPHERAL_GPIO_TCK_CLEAR();
+        PERIPHERAL_GPIO_TCK_SET_OUTPUT();
+    }
+    if (select & (1U << DAP_SWJ_SWDIO_TMS)) {
+        if (value & (0x1 << DAP_SWJ_SWDIO_TMS))
+            PERIPHERAL_GPIO_TMS_SET();
+        else
+            PERIPHERAL_GPIO_TMS_CLEAR();
+        PERIPHERAL_GPIO_TMS_SET_OUTPUT();
+    }
+    if (select & (0x1 << DAP_SWJ_nRESET)) {
+        if (value & (0x1 << DAP_SWJ_nRESET)) {
+            PERIPHERAL_GPIO_SRST_SET();
+        } else {
+            PERIPHERAL_GPIO_SRST_CLEAR();
+            #if DAP_SWD
+            dap_swd_cache_reset(param);
+            #endif
+        }
+        PERIPHERAL_GPIO_SRST_SET_OUTPUT();
+    }
+    if (param->port == DAP_PORT_JTAG) {
+        if (select & (0x1 << DAP_SWJ_TDI)) {
+            if (value & (0x1 << DAP_SWJ_TDI))
+                PERIPHERAL_GPIO_TDI_SET();
+            else
+                PERIPHERAL_GPIO_TDI_CLEAR();
+            PERIPHERAL_GPIO_TDI_SET_OUTPUT();
+        }
+        if (select & (0x1 << DAP_SWJ_nTRST)) {
+            if (value & (0x1 << DAP_SWJ_nTRST))
+                PERIPHERAL_GPIO_TRST_SET();
+            else
+                PERIPHERAL_GPIO_TRST_CLEAR();
+            PERIPHERAL_GPIO_TRST_SET_OUTPUT();
+        }
+    }
+
+    if (delay_us) // us
+    {
+        if (delay_us > 3000000)
+            delay_us = 3000000;
+        tick = vsf_systimer_get_tick() + vsf_systimer_us_to_tick(delay_us);
+        do {
+            if (select & (1U << DAP_SWJ_SWCLK_TCK)) {
+                if (((value >> DAP_SWJ_SWCLK_TCK) & 0x1) ^ PERIPHERAL_GPIO_TDI_READ())
+                    continue;
+            }
+            if (select & (1U << DAP_SWJ_SWDIO_TMS)) {
+                if (((value >> DAP_SWJ_SWDIO_TMS) & 0x1) ^ PERIPHERAL_GPIO_TMS_READ())
+                    continue;
+            }
+            if (select & (1U << DAP_SWJ_TDI)) {
+                if (((value >> DAP_SWJ_TDI) & 0x1) ^ PERIPHERAL_GPIO_TCK_READ())
+                    continue;
+            }
+            if (select & (1U << DAP_SWJ_nTRST)) {
+                if (((value >> DAP_SWJ_nTRST) & 0x1) ^ PERIPHERAL_GPIO_TRST_READ())
+                    continue;
+            }
+            if (select & (1U << DAP_SWJ_nRESET)) {
+                if (((value >> DAP_SWJ_nRESET) & 0x1) ^ PERIPHERAL_GPIO_SRST_READ())
+                    continue;
+            }
+            break;
+        } while (tick > vsf_systimer_get_tick());
+    }
+    param->port_io_need_reconfig = true;
+    return (PERIPHERAL_GPIO_TCK_READ() ?  (0x1 << DAP_SWJ_SWCLK_TCK) : 0) |
+           (PERIPHERAL_GPIO_TMS_READ() ? (0x1 << DAP_SWJ_SWDIO_TMS) : 0) |
+           (PERIPHERAL_GPIO_TDI_READ() ? (0x1 << DAP_SWJ_TDI) : 0) |
+           (PERIPHERAL_GPIO_TDO_READ() ? (0x1 << DAP_SWJ_TDO) : 0) |
+           (PERIPHERAL_GPIO_TRST_READ() ? (0x1 << DAP_SWJ_nTRST) : 0) |
+           (PERIPHERAL_GPIO_SRST_READ() ? (0x1 << DAP_SWJ_nRESET) : 0);
+}
+
 static uint16_t request_handler(dap_param_t* param, uint8_t* request,
         uint8_t* response, uint16_t pkt_size)
 {
     uint8_t cmd_id, cmd_num;
     uint16_t req_ptr, resp_ptr;
+    bool streaming = dap_vendor_stream_pending(param);     // of another client
+#if DAP_STATS
+    uint32_t cmd_start = vsfhal_timestamp_get();
+    uint16_t cmd_resp = 0;
+#endif
 
     req_ptr = 0;
     resp_ptr = 0;
     cmd_num = 1;
 
     do {
+        #if DAP_STATS
+        if (resp_ptr)
+            cmd_start = stats_command(param, cmd_id, response + cmd_resp, cmd_start);
+        cmd_resp = resp_ptr;
+        #endif
         cmd_num--;
         cmd_id = request[req_ptr++];
         response[resp_ptr++] = cmd_id;
 
         if ((cmd_id >= ID_DAP_Vendor0) && (cmd_id <= ID_DAP_Vendor31)) {
-            uint32_t ret = dap_vendor_request_handler(param, request + req_ptr, response + resp_ptr, cmd_id, pkt_size - resp_ptr);
+            uint16_t req_size = (req_ptr < pkt_size) ? (pkt_size - req_ptr) : 0;
+            uint32_t ret = dap_vendor_request_handler(param, request + req_ptr, req_size, response + resp_ptr, cmd_id, pkt_size - resp_ptr);
             if (ret == 0)
                 goto fault;
             else {
                 req_ptr += ret & 0xffff;
                 resp_ptr += ret >> 16;
             }
+            // streamed command must be the last one, the rest of its result follows
+            if (!streaming && dap_vendor_stream_pending(param))
+                break;
         }
         #if SWO_UART || SWO_MANCHESTER
         else if ((cmd_id >= ID_DAP_SWO_Transport) && (cmd_id <= ID_DAP_SWO_ExtendedStatus)) {
@@ -345,88 +795,11 @@ static uint16_t request_handler(dap_param_t* param, uint8_t* request,
                 response[resp_ptr++] = DAP_OK;
                 response[resp_ptr++] = 0; // TODO: reset target return
                 break;
-            case ID_DAP_SWJ_Pins: {
-                uint8_t value, select;
-                uint64_t delay_us = get_unaligned_le32(request + req_ptr + 2);
-                value = request[req_ptr];
-                select = request[req_ptr + 1];
+            case ID_DAP_SWJ_Pins:
+                response[resp_ptr++] = dap_swj_pins(param, request[req_ptr], request[req_ptr + 1],
+                        get_unaligned_le32(request + req_ptr + 2));
                 req_ptr += 6;
-
-                if (select & (1U << DAP_SWJ_SWCLK_TCK)) {
-                    if (value & (0x1 << DAP_SWJ_SWCLK_TCK))
-                        PERIPHERAL_GPIO_TCK_SET();
-                    else
-                        PERIPHERAL_GPIO_TCK_CLEAR();
-                    PERIPHERAL_GPIO_TCK_SET_OUTPUT();
-                }
-                if (select & (1U << DAP_SWJ_SWDIO_TMS)) {
-                    if (value & (0x1 << DAP_SWJ_SWDIO_TMS))
-                        PERIPHERAL_GPIO_TMS_SET();
-                    else
-                        PERIPHERAL_GPIO_TMS_CLEAR();
-                    PERIPHERAL_GPIO_TMS_SET_OUTPUT();
-                }
-                if (select & (0x1 << DAP_SWJ_nRESET)) {
-                    if (value & (0x1 << DAP_SWJ_nRESET))
-                        PERIPHERAL_GPIO_SRST_SET();
-                    else
-                        PERIPHERAL_GPIO_SRST_CLEAR();
-                    PERIPHERAL_GPIO_SRST_SET_OUTPUT();
-                }
-                if (param->port == DAP_PORT_JTAG) {
-                    if (select & (0x1 << DAP_SWJ_TDI)) {
-                        if (value & (0x1 << DAP_SWJ_TDI))
-                            PERIPHERAL_GPIO_TDI_SET();
-                        else
-                            PERIPHERAL_GPIO_TDI_CLEAR();
-                        PERIPHERAL_GPIO_TDI_SET_OUTPUT();
-                    }
-                    if (select & (0x1 << DAP_SWJ_nTRST)) {
-                        if (value & (0x1 << DAP_SWJ_nTRST))
-                            PERIPHERAL_GPIO_TRST_SET();
-                        else
-                            PERIPHERAL_GPIO_TRST_CLEAR();
-                        PERIPHERAL_GPIO_TRST_SET_OUTPUT();
-                    }
-                }
-
-                if (delay_us) // us
-                {
-                    if (delay_us > 3000000)
-                        delay_us = 3000000;
-                    delay_us = vsf_systimer_get_tick() + vsf_systimer_us_to_tick(delay_us);;
-                    do {
-                        if (select & (1U << DAP_SWJ_SWCLK_TCK)) {
-                            if (((value >> DAP_SWJ_SWCLK_TCK) & 0x1) ^ PERIPHERAL_GPIO_TDI_READ())
-                                continue;
-                        }
-                        if (select & (1U << DAP_SWJ_SWDIO_TMS)) {
-                            if (((value >> DAP_SWJ_SWDIO_TMS) & 0x1) ^ PERIPHERAL_GPIO_TMS_READ())
-                                continue;
-                        }
-                        if (select & (1U << DAP_SWJ_TDI)) {
-                            if (((value >> DAP_SWJ_TDI) & 0x1) ^ PERIPHERAL_GPIO_TCK_READ())
-                                continue;
-                        }
-                        if (select & (1U << DAP_SWJ_nTRST)) {
-                            if (((value >> DAP_SWJ_nTRST) & 0x1) ^ PERIPHERAL_GPIO_TRST_READ())
-                                continue;
-                        }
-                        if (select & (1U << DAP_SWJ_nRESET)) {
-                            if (((value >> DAP_SWJ_nRESET) & 0x1) ^ PERIPHERAL_GPIO_SRST_READ())
-                                continue;
-                        }
-                        break;
-                    } while (delay_us > vsf_systimer_get_tick());
-                }
-                param->port_io_need_reconfig = true;
-                response[resp_ptr++] = (PERIPHERAL_GPIO_TCK_READ() ?  (0x1 << DAP_SWJ_SWCLK_TCK) : 0) |
-                                       (PERIPHERAL_GPIO_TMS_READ() ? (0x1 << DAP_SWJ_SWDIO_TMS) : 0) |
-                                       (PERIPHERAL_GPIO_TDI_READ() ? (0x1 << DAP_SWJ_TDI) : 0) |
-                                       (PERIPHERAL_GPIO_TDO_READ() ? (0x1 << DAP_SWJ_TDO) : 0) |
-                                       (PERIPHERAL_GPIO_TRST_READ() ? (0x1 << DAP_SWJ_nTRST) : 0) |
-                                       (PERIPHERAL_GPIO_SRST_READ() ? (0x1 << DAP_SWJ_nRESET) : 0);
-            } break;
+                break;
             case ID_DAP_SWJ_Clock: {
                 uint32_t speed_khz = get_unaligned_le32(request + req_ptr) / 1000;
                 req_ptr += 4;
@@ -434,11 +807,9 @@ static uint16_t request_handler(dap_param_t* param, uint8_t* request,
                     speed_khz = 1;
                 param->speed_khz = speed_khz;
                 #if DAP_SWD
+                swd_adapt_reset(param);
                 if (param->port == DAP_PORT_SWD)
-                    vsfhal_swd_config(param->speed_khz, param->transfer.retry_count,
-                            param->transfer.idle_cycles,
-                            param->swd_conf.turnaround,
-                            param->swd_conf.data_phase);
+                    swd_config(param);
                 #endif
                 #if DAP_JTAG
                 if (param->port == DAP_PORT_JTAG)
@@ -458,6 +829,8 @@ static uint16_t request_handler(dap_param_t* param, uint8_t* request,
 
                 #if DAP_SWD
                 if (param->port == DAP_PORT_SWD) {
+                    // may be a line reset or a TARGETSEL the probe does not see
+                    dap_swd_cache_reset(param);
                     #ifdef SWD_ASYNC
                     vsfhal_swd_clear();
                     #endif
@@ -508,16 +881,14 @@ static uint16_t request_handler(dap_param_t* param, uint8_t* request,
                 uint8_t config = request[req_ptr++];
                 param->swd_conf.turnaround = (config & 0x03) + 1;
                 param->swd_conf.data_phase = (config & 0x04) ? 1 : 0;
-                vsfhal_swd_config(param->speed_khz, param->transfer.retry_count,
-                        param->transfer.idle_cycles,
-                        param->swd_conf.turnaround,
-                        param->swd_conf.data_phase);
+                swd_config(param);
                 response[resp_ptr++] = DAP_OK;
             } break;
             case ID_DAP_SWD_Sequence: {
                 if (param->port == DAP_PORT_SWD) {
                     response[resp_ptr++] = DAP_OK;
 
+                    dap_swd_cache_reset(param);
                     #ifdef SWD_ASYNC
                     vsfhal_swd_clear();
                     #endif
@@ -663,8 +1034,9 @@ static uint16_t request_handler(dap_param_t* param, uint8_t* request,
                     buf_tdi[1] = 0;
                     buf_tdo[1] = 0;
                     bitlen = 3 + param->jtag_dev.index + 32;
-                    buf_tms[1] |= 0x3 << (bitlen - 1);
+                    buf_tms[1] |= (uint64_t)0x3 << (bitlen - 1);
                     bitlen += 2;
+                    vsfhal_jtag_raw(0, bitlen, (uint8_t*)&buf_tms[1], (uint8_t*)&buf_tdi[1], (uint8_t*)&buf_tdo[1]);
 
                     vsfhal_jtag_wait();   // finish previous
                     response[resp_ptr++] = DAP_OK;
@@ -681,7 +1053,7 @@ static uint16_t request_handler(dap_param_t* param, uint8_t* request,
                     buf_tdo = 0;
                     buf_tms = 0x1;
                     bitlen = 3 + param->jtag_dev.index + 32;
-                    buf_tms |= 0x3 << (bitlen - 1);
+                    buf_tms |= (uint64_t)0x3 << (bitlen - 1);
                     bitlen += 2;
                     vsfhal_jtag_raw(bitlen, (uint8_t*)&buf_tms, (uint8_t*)&buf_tdi, (uint8_t*)&buf_tdo);
                     response[resp_ptr++] = DAP_OK;
@@ -705,10 +1077,9 @@ static uint16_t request_handler(dap_param_t* param, uint8_t* request,
                 }
 
                 #if DAP_SWD
+                swd_adapt_reset(param);
                 if (param->port == DAP_PORT_SWD)
-                    vsfhal_swd_config(param->speed_khz,
-                            param->transfer.retry_count, param->transfer.idle_cycles,
-                            param->swd_conf.turnaround, param->swd_conf.data_phase);
+                    swd_config(param);
                 #endif
                 #if DAP_JTAG
                 if (param->port == DAP_PORT_JTAG)
@@ -719,7 +1090,7 @@ static uint16_t request_handler(dap_param_t* param, uint8_t* request,
             } break;
             case ID_DAP_Transfer: {
                 bool post_read = false;
-                #if defined(SWD_ASYNC) || defined(JTAG_ASYNC)
+                #ifdef JTAG_ASYNC
                 uint8_t select = 0;
                 #endif
                 uint8_t transfer_req = 0;
@@ -743,6 +1114,7 @@ static uint16_t request_handler(dap_param_t* param, uint8_t* request,
                         transfer_cnt++;
                         transfer_req = request[req_ptr++];
                         if (transfer_req & DAP_TRANSFER_RnW) {  // read
+                            dap_swd_cache_access(param, transfer_req, NULL);
                             if (post_read) {
                                 if ((transfer_req & (DAP_TRANSFER_APnDP | DAP_TRANSFER_MATCH_VALUE)) == DAP_TRANSFER_APnDP) {
                                     // Read previous AP data and post next AP read
@@ -806,6 +1178,9 @@ static uint16_t request_handler(dap_param_t* param, uint8_t* request,
                                     }
                                 } else {    // Read DP register
                                     transfer_ack = vsfhal_swd_read(transfer_req, (uint8_t *)&data);
+                                    if (transfer_ack != DAP_TRANSFER_OK)
+                                        break;
+                                    transfer_ack = vsfhal_swd_wait();
                                     if (transfer_ack != DAP_TRANSFER_OK)
                                         break;
                                     #if TIMESTAMP_CLOCK
@@ -833,6 +1208,11 @@ static uint16_t request_handler(dap_param_t* param, uint8_t* request,
                                 param->transfer.match_mask = get_unaligned_le32(request + req_ptr);
                                 req_ptr += 4;
                                 transfer_ack = DAP_TRANSFER_OK;
+                            } else if (dap_swd_cache_access(param, transfer_req, request + req_ptr)
+                                    && !(transfer_req & DAP_TRANSFER_TIMESTAMP)) {
+                                // the target holds it already, a timestamp needs the write
+                                req_ptr += 4;
+                                transfer_ack = DAP_TRANSFER_OK;
                             } else {
                                 // Write DP/AP register
                                 transfer_ack = vsfhal_swd_write(transfer_req, request + req_ptr);
@@ -873,7 +1253,11 @@ static uint16_t request_handler(dap_param_t* param, uint8_t* request,
                             transfer_ack = vsfhal_swd_read(DP_RDBUFF | DAP_TRANSFER_RnW, NULL);
                         }
                     }
-                    transfer_ack = vsfhal_swd_wait();
+                    // keep a value mismatch, the wait only reports the wire
+                    if (transfer_ack & DAP_TRANSFER_MISMATCH)
+                        vsfhal_swd_wait();
+                    else
+                        transfer_ack = vsfhal_swd_wait();
                     #endif
                 }
                 #else
@@ -889,6 +1273,7 @@ static uint16_t request_handler(dap_param_t* param, uint8_t* request,
                         transfer_cnt++;
                         transfer_req = request[req_ptr++];
                         if (transfer_req & DAP_TRANSFER_RnW) {  // read
+                            dap_swd_cache_access(param, transfer_req, NULL);
                             if (post_read) {
                                 if ((transfer_req & (DAP_TRANSFER_APnDP | DAP_TRANSFER_MATCH_VALUE)) == DAP_TRANSFER_APnDP) {
                                     // Read previous AP data and post next AP read
@@ -976,6 +1361,11 @@ static uint16_t request_handler(dap_param_t* param, uint8_t* request,
                                 param->transfer.match_mask = get_unaligned_le32(request + req_ptr);
                                 req_ptr += 4;
                                 transfer_ack = DAP_TRANSFER_OK;
+                            } else if (dap_swd_cache_access(param, transfer_req, request + req_ptr)
+                                    && !(transfer_req & DAP_TRANSFER_TIMESTAMP)) {
+                                // the target holds it already, a timestamp needs the write
+                                req_ptr += 4;
+                                transfer_ack = DAP_TRANSFER_OK;
                             } else {
                                 // Write DP/AP register
                                 transfer_ack = vsfhal_swd_write(transfer_req, request + req_ptr);
@@ -1053,6 +1443,10 @@ static uint16_t request_handler(dap_param_t* param, uint8_t* request,
                                     transfer_ack = vsfhal_jtag_raw(dr_before + 3, bitlen, (uint8_t*)&buf_tms[select], (uint8_t*)&buf_tdi[select], (uint8_t*)&buf_tdo[select]);
                                     if (transfer_ack != DAP_TRANSFER_OK)
                                         break;
+                                    transfer_ack = vsfhal_jtag_wait();
+                                    if (transfer_ack != DAP_TRANSFER_OK)
+                                        break;
+                                    data = buf_tdo[select] >> (dr_before + 6);
                                     select = select ? 0 : 1;
                                 } else {
                                     // Select JTAG chain
@@ -1073,6 +1467,10 @@ static uint16_t request_handler(dap_param_t* param, uint8_t* request,
                                     transfer_ack = vsfhal_jtag_raw(dr_before + 3, bitlen, (uint8_t*)&buf_tms[select], (uint8_t*)&buf_tdi[select], (uint8_t*)&buf_tdo[select]);
                                     if (transfer_ack != DAP_TRANSFER_OK)
                                         break;
+                                    transfer_ack = vsfhal_jtag_wait();
+                                    if (transfer_ack != DAP_TRANSFER_OK)
+                                        break;
+                                    data = buf_tdo[select] >> (dr_before + 6);
                                     select = select ? 0 : 1;
                                     post_read = 0;
                                 }
@@ -1182,6 +1580,8 @@ static uint16_t request_handler(dap_param_t* param, uint8_t* request,
                                 transfer_ack = vsfhal_jtag_wait();
                                 if (transfer_ack != DAP_TRANSFER_OK)
                                     break;
+                                data = buf_tdo[select] >> (dr_before + 6);
+                                select = select ? 0 : 1;
                                 put_unaligned_le32(data, response + resp_ptr);
                                 resp_ptr += 4;
                                 post_read = 0;
@@ -1462,20 +1862,41 @@ static uint16_t request_handler(dap_param_t* param, uint8_t* request,
                     response[resp_ptr++] = 0;
                     break;
                 }
+                #if VENDOR_RTT
+                // the failed one may not have reached the register
+                transfer_track_select(param, request + req_start + 2,
+                        ((transfer_ack != DAP_TRANSFER_OK) && transfer_cnt) ? (transfer_cnt - 1) : transfer_cnt);
+                #endif
+                #if DAP_SWD
+                if (transfer_ack != DAP_TRANSFER_OK)
+                    dap_swd_cache_forget(param);
+                #endif
                 response[resp_start++] = transfer_cnt;
                 response[resp_start++] = transfer_ack;
+                #if DAP_SWD
+                if (param->port == DAP_PORT_SWD)
+                    swd_adapt(param, transfer_cnt);
+                #endif
             } break;
             case ID_DAP_TransferBlock:{
-                #if defined(SWD_ASYNC) || defined(JTAG_ASYNC)
+                #ifdef JTAG_ASYNC
                 uint8_t select = 0;
                 #endif
                 uint8_t transfer_req = 0;
                 uint16_t transfer_cnt = 0, transfer_num, transfer_ack = 0, resp_start = resp_ptr;
 
+                #if DAP_SWD
+                // the data is not followed, what the block writes is unknown
+                dap_swd_cache_access(param, request[req_ptr + 3], NULL);
+                #endif
                 if (param->port == DAP_PORT_SWD)
                 #ifdef SWD_ASYNC
                 {
                     #if DAP_SWD
+                    #ifdef SWD_BLOCK
+                    uint16_t block_num;
+                    #endif
+
                     vsfhal_swd_clear();
 
                     transfer_num = get_unaligned_le16(request + req_ptr + 1);
@@ -1492,6 +1913,17 @@ static uint16_t request_handler(dap_param_t* param, uint8_t* request,
                                 goto DAP_TransferBlock_END;
                         }
 
+                        #ifdef SWD_BLOCK
+                        // last AP read is taken from RDBUFF below
+                        block_num = transfer_num - ((transfer_req & DAP_TRANSFER_APnDP) ? 1 : 0);
+                        if (block_num > 1) {
+                            transfer_ack = vsfhal_swd_read_block(transfer_req, response + resp_ptr, block_num, &block_num);
+                            resp_ptr += 4 * block_num;
+                            transfer_cnt = block_num;
+                            if (transfer_ack != DAP_TRANSFER_OK)
+                                goto DAP_TransferBlock_END;
+                        }
+                        #endif
                         while (transfer_cnt < transfer_num) {   // Read DP/AP register
                             if ((transfer_cnt == (transfer_num - 1)) && (transfer_req & DAP_TRANSFER_APnDP))
                                 transfer_req = DP_RDBUFF | DAP_TRANSFER_RnW;
@@ -1502,6 +1934,17 @@ static uint16_t request_handler(dap_param_t* param, uint8_t* request,
                             transfer_cnt++;
                         }
                     } else {    // Write register block
+                        #ifdef SWD_BLOCK
+                        if (transfer_num > 1) {
+                            transfer_ack = vsfhal_swd_write_block(transfer_req, request + req_ptr, transfer_num, &block_num);
+                            req_ptr += 4 * block_num;
+                            transfer_cnt = block_num;
+                            if (transfer_ack != DAP_TRANSFER_OK) {
+                                req_ptr += 4;
+                                goto DAP_TransferBlock_END;
+                            }
+                        }
+                        #endif
                         while (transfer_cnt < transfer_num) {   // Write register block
                             transfer_ack = vsfhal_swd_write(transfer_req, request + req_ptr);
                             req_ptr += 4;
@@ -1518,6 +1961,10 @@ static uint16_t request_handler(dap_param_t* param, uint8_t* request,
                 #else
                 {
                     #if DAP_SWD
+                    #ifdef SWD_BLOCK
+                    uint16_t block_num;
+                    #endif
+
                     transfer_num = get_unaligned_le16(request + req_ptr + 1);
                     req_ptr += 3;
                     resp_ptr += 3;
@@ -1532,6 +1979,17 @@ static uint16_t request_handler(dap_param_t* param, uint8_t* request,
                                 goto DAP_TransferBlock_END;
                         }
 
+                        #ifdef SWD_BLOCK
+                        // last AP read is taken from RDBUFF below
+                        block_num = transfer_num - ((transfer_req & DAP_TRANSFER_APnDP) ? 1 : 0);
+                        if (block_num > 1) {
+                            transfer_ack = vsfhal_swd_read_block(transfer_req, response + resp_ptr, block_num, &block_num);
+                            resp_ptr += 4 * block_num;
+                            transfer_cnt = block_num;
+                            if (transfer_ack != DAP_TRANSFER_OK)
+                                goto DAP_TransferBlock_END;
+                        }
+                        #endif
                         while (transfer_cnt < transfer_num) {   // Read DP/AP register
                             if ((transfer_cnt == (transfer_num - 1)) && (transfer_req & DAP_TRANSFER_APnDP))
                                 transfer_req = DP_RDBUFF | DAP_TRANSFER_RnW;
@@ -1542,6 +2000,17 @@ static uint16_t request_handler(dap_param_t* param, uint8_t* request,
                             transfer_cnt++;
                         }
                     } else {    // Write register block
+                        #ifdef SWD_BLOCK
+                        if (transfer_num > 1) {
+                            transfer_ack = vsfhal_swd_write_block(transfer_req, request + req_ptr, transfer_num, &block_num);
+                            req_ptr += 4 * block_num;
+                            transfer_cnt = block_num;
+                            if (transfer_ack != DAP_TRANSFER_OK) {
+                                req_ptr += 4;
+                                goto DAP_TransferBlock_END;
+                            }
+                        }
+                        #endif
                         while (transfer_cnt < transfer_num) {   // Write register block
                             transfer_ack = vsfhal_swd_write(transfer_req, request + req_ptr);
                             req_ptr += 4;
@@ -1560,7 +2029,8 @@ static uint16_t request_handler(dap_param_t* param, uint8_t* request,
                 {
                     #if DAP_JTAG
                     uint8_t idle, jtag_ir = 0;
-                    uint16_t bitlen, dr_before, dr_after;
+                    uint16_t bitlen, dr_before, dr_after, read_num;
+                    uint64_t *read_tdo = NULL;
 
                     param->jtag_dev.index = request[req_ptr];
                     if (param->jtag_dev.index >= param->jtag_dev.count)
@@ -1598,10 +2068,9 @@ static uint16_t request_handler(dap_param_t* param, uint8_t* request,
                             goto DAP_TransferBlock_END;
                         select = select ? 0 : 1;
 
-                        // TODO: need async here
-                        // Read register block
-                        while (transfer_cnt < transfer_num) {
-                            if (transfer_cnt == (transfer_num - 1)) {   // Last read
+                        // Read register block, the data of a scan is taken once the next scan is issued
+                        for (read_num = 0; read_num < transfer_num; read_num++) {
+                            if (read_num == (transfer_num - 1)) {   // Last read
                                 if (jtag_ir != JTAG_DPACC) {
                                     jtag_ir = JTAG_DPACC;
                                     bitlen = jtag_ir_to_raw(&buf_tms[select], &buf_tdi[select], jtag_ir,
@@ -1612,6 +2081,12 @@ static uint16_t request_handler(dap_param_t* param, uint8_t* request,
                                     if (transfer_ack != DAP_TRANSFER_OK)
                                         goto DAP_TransferBlock_END;
                                     select = select ? 0 : 1;
+                                    if (read_tdo) {
+                                        put_unaligned_le32(*read_tdo >> (dr_before + 6), response + resp_ptr);
+                                        resp_ptr += 4;
+                                        transfer_cnt++;
+                                        read_tdo = NULL;
+                                    }
                                 }
                                 transfer_req = DP_RDBUFF | DAP_TRANSFER_RnW;
                             }
@@ -1621,16 +2096,20 @@ static uint16_t request_handler(dap_param_t* param, uint8_t* request,
                             transfer_ack = vsfhal_jtag_raw(dr_before + 3, bitlen, (uint8_t*)&buf_tms[select], (uint8_t*)&buf_tdi[select], (uint8_t*)&buf_tdo[select]);
                             if (transfer_ack != DAP_TRANSFER_OK)
                                 goto DAP_TransferBlock_END;
-                            transfer_ack = vsfhal_jtag_wait(); // Not check transfer_ack
-                            if (transfer_ack == DAP_TRANSFER_OK) {
-                                put_unaligned_le32(buf_tdo[select] >> (dr_before + 6), response + resp_ptr);
+                            if (read_tdo) {
+                                put_unaligned_le32(*read_tdo >> (dr_before + 6), response + resp_ptr);
                                 resp_ptr += 4;
-                            } else {
-                                goto DAP_TransferBlock_END;
+                                transfer_cnt++;
                             }
+                            read_tdo = &buf_tdo[select];
                             select = select ? 0 : 1;
-                            transfer_cnt++;
                         }
+                        transfer_ack = vsfhal_jtag_wait();
+                        if (transfer_ack != DAP_TRANSFER_OK)
+                            goto DAP_TransferBlock_END;
+                        put_unaligned_le32(*read_tdo >> (dr_before + 6), response + resp_ptr);
+                        resp_ptr += 4;
+                        transfer_cnt++;
                     } else {    // Write register block
                         while (transfer_cnt < transfer_num) {
                             // Write DP/AP register
@@ -1761,12 +2240,19 @@ static uint16_t request_handler(dap_param_t* param, uint8_t* request,
             DAP_TransferBlock_END:
                 put_unaligned_le16(transfer_cnt, response + resp_start);
 				response[resp_start + 2] = transfer_ack;
+                #if DAP_SWD
+                if (transfer_ack != DAP_TRANSFER_OK)
+                    dap_swd_cache_forget(param);
+                if (param->port == DAP_PORT_SWD)
+                    swd_adapt(param, transfer_cnt);
+                #endif
             } break;
             case ID_DAP_WriteABORT: {
                 uint16_t transfer_ack;
 
                 if (param->port == DAP_PORT_SWD) {
                     #if DAP_SWD
+                    dap_swd_cache_forget(param);
                     #ifdef SWD_ASYNC
                     vsfhal_swd_clear();
                     #endif
@@ -1837,103 +2323,384 @@ static uint16_t request_handler(dap_param_t* param, uint8_t* request,
 fault:
     response[resp_ptr - 1] = ID_DAP_Invalid;
 exit:
+#if DAP_STATS
+    stats_command(param, cmd_id, response + cmd_resp, cmd_start);
+    stats_request(param);
+#endif
     return resp_ptr;
 }
 
+// slot the client executes next, call with interrupts off
+static uint_fast8_t next_slot(dap_client_t *client)
+{
+    return client->queue[(client->queue_head + client->execute_cnt) % DAP_PACKET_COUNT];
+}
+
+// round robin from the client after the one served last, call with interrupts off
+static dap_client_t *next_client(dap_client_t *list, dap_client_t *last,
+        dap_response_t *response)
+{
+    dap_client_t *client = last ? last : list;
+    dap_client_t *end = client;
+    uint_fast8_t slot;
+
+    do {
+        client = client->next ? client->next : list;
+        if (client->queue_cnt > client->execute_cnt) {
+            // the next part of a stream waits until the last one is handed back
+            slot = next_slot(client);
+            if (!response[slot].more || response[slot].refill)
+                return client;
+        }
+    } while (client != end);
+    return NULL;
+}
+
 implement_vsf_task(dap_task_t)
 {
-    dap_request_t* request = &this.request[this.request_head];
+    dap_param_t* param = this.dap_param;
+    dap_request_t* request;
+    dap_response_t* response;
+    dap_client_t* client;
+    vsf_gint_state_t orig;
+    uint_fast8_t last = this.slot;
+    bool streaming;
 
     vsf_task_begin();
-    enum {
-        WAIT_FOR_REQ_SEM = 0,
-        WAIT_FOR_RESP_SEM,
-    };
 
-    on_vsf_task_init() { vsf_sem_init(&this.request_sem, 0); }
+    on_vsf_task_init() {
+        vsf_sem_init(&this.request_sem, 0);
+        vsf_sem_init(&this.response_sem, 0);
+    }
+
+    vsf_task_wait_until(vsf_sem_pend(&this.request_sem));
 
-    switch (vsf_task_state) {
-    case WAIT_FOR_REQ_SEM:
-        vsf_task_wait_until(vsf_sem_pend(&this.request_sem));
+    orig = vsf_disable_interrupt();
+    client = next_client(this.client_list, this.client, this.response);
+    if (client) {
+        this.client = client;
+        this.slot = next_slot(client);
+    }
+    vsf_set_interrupt(orig);
+
+    // a post may stand for a request behind a stream, made later
+    if (client) {
+        request = &this.request[this.slot];
+        response = &this.response[this.slot];
+        streaming = dap_vendor_stream_pending(param);
+        if (response->more) {
+            response->refill = false;
+            if (client->stream_abort) {
+                client->stream_abort = false;
+                param->do_abort = true;
+            }
+            response->response_size = dap_vendor_stream_handler(param,
+                response->response_buf, request->pkt_size, last != this.slot);
+            response->more = dap_vendor_stream_pending(param);
+        } else {
+            #if DAP_STATS
+            // the slot being executed is in use until its response is sent
+            {
+                uint_fast8_t i, used = 0;
+
+                for (i = 0; i < DAP_PACKET_COUNT; i++) {
+                    if (this.request[i].client)
+                        used++;
+                }
+                param->stats.queue_depth[used - 1]++;
+            }
+            #endif
+            client->stream_abort = false;
+            response->response_buf = this.spare;
+            param->packed_size = client->packed_size;
+            response->response_size = request_handler(param, request->request_buf,
+                response->response_buf, request->pkt_size);
+            param->packed_size = 0;
+            // a streamed part only needs pkt_size of the request
+            this.spare = request->request_buf;
+            request->request_buf = NULL;
+            // only a stream started by this request is its own
+            response->more = !streaming && dap_vendor_stream_pending(param);
+        }
 
-        request = &this.request[this.request_head];
+        #if DAP_STATS
+        response->ready_time = vsfhal_timestamp_get();
+        #endif
+        response->packed_start = param->packed_start;
+        param->packed_start = false;
+
+        orig = vsf_disable_interrupt();
+        response->ready = true;
+        if (!response->more)
+            client->execute_cnt++;
+        // the post of a request made behind a stream may be used up already
+        client = next_client(this.client_list, this.client, this.response);
+        vsf_set_interrupt(orig);
+        if (client)
+            vsf_sem_post(&this.request_sem);
+        vsf_sem_post(&this.response_sem);
+    }
 
-        this.response.response_sem = request->response_sem;
-        this.response.response = request->response;
-        this.response.response_param = request->response_param;
-        this.response.response_size = request_handler(this.dap_param, request->request_buf,
-            this.response.response_buf, request->pkt_size);
+    vsf_task_end();
+}
 
-        vsf_gint_state_t orig = vsf_disable_interrupt();
-        if (++this.request_head == DAP_PACKET_COUNT)
-            this.request_head = 0;
-        this.request_cnt--;
+// oldest response of a free client, call with interrupts off
+static dap_response_t *next_response(dap_task_t *task, dap_client_t **pclient)
+{
+    dap_client_t *client;
+    dap_response_t *response;
+
+    for (client = task->client_list; client; client = client->next) {
+        if (!client->busy && client->queue_cnt) {
+            response = &task->response[client->queue[client->queue_head]];
+            if (response->ready) {
+                response->ready = false;
+                client->busy = true;
+                *pclient = client;
+                return response;
+            }
+        }
+    }
+    return NULL;
+}
+
+implement_vsf_task(dap_response_task_t)
+{
+    dap_task_t* dap_task = this.dap_task;
+    dap_response_t* response;
+    dap_client_t* client;
+    vsf_gint_state_t orig;
+    bool packed_start;
+
+    vsf_task_begin();
+
+    vsf_task_wait_until(vsf_sem_pend(&dap_task->response_sem));
+
+    // the client may hand a response back from within its callback
+    while (1) {
+        orig = vsf_disable_interrupt();
+        response = next_response(dap_task, &client);
         vsf_set_interrupt(orig);
-        
-        vsf_task_state = WAIT_FOR_RESP_SEM;
+        if (!response)
+            break;
 
-    case WAIT_FOR_RESP_SEM:
-        vsf_task_wait_until(vsf_sem_pend(this.response.response_sem));
+        #if DAP_STATS
+        {
+            dap_stats_t *stats = &dap_task->dap_param->stats;
+            uint32_t ticks = vsfhal_timestamp_get() - response->ready_time;
 
-        this.response.response(this.response.response_param,
-            this.response.response_buf,
-            this.response.response_size);
-        
-        vsf_task_state = WAIT_FOR_REQ_SEM;
-        break;
+            stats->resp_wait_total += ticks;
+            if (ticks > stats->resp_wait_max)
+                stats->resp_wait_max = ticks;
+        }
+        #endif
+        // the response to DAP_ID_PACKED_SIZE itself is not packed yet
+        packed_start = response->packed_start;
+        client->response(client->response_param, response->response_buf,
+            response->response_size);
+        if (packed_start)
+            client->packed = true;
     }
+
     vsf_task_end();
 }
 
 void dap_init(dap_t *dap, vsf_prio_t prio)
 {
+    uint_fast8_t i;
+
     #if TIMESTAMP_CLOCK
     vsfhal_timestamp_init(TIMESTAMP_CLOCK, PERIPHERAL_TIMESTAMP_PRIORITY);
     #endif
 
+    #if DAP_SWD && DAP_SWD_ADAPT
+    dap->dap_param.swd_adapt.enable = true;
+    #endif
+    #if DAP_SWD && DAP_SWD_CACHE
+    dap->dap_param.swd_cache.enable = true;
+    #endif
+    #if VENDOR_SCRIPT
+    dap_script_init();
+    #endif
+    for (i = 0; i < DAP_PACKET_COUNT; i++)
+        dap->dap_task.request[i].request_buf = dap->dap_task.buf[i];
+    dap->dap_task.spare = dap->dap_task.buf[DAP_PACKET_COUNT];
     dap->dap_task.dap_param = &dap->dap_param;
+    dap->dap_response_task.dap_task = &dap->dap_task;
     init_vsf_task(dap_task_t, &dap->dap_task, prio);
+    init_vsf_task(dap_response_task_t, &dap->dap_response_task, prio);
 }
 
-vsf_err_t dap_requset(dap_t *dap, vsf_sem_t *response_sem,
+// called again on a bus reset, slots held by the client are kept
+void dap_client_init(dap_t *dap, dap_client_t *client,
         void (*response)(void* p, uint8_t* buf, uint16_t size),
-        void* response_param, uint8_t* buf, uint16_t pkt_size)
+        void* response_param)
+{
+    dap_task_t *task = &dap->dap_task;
+    dap_client_t *c;
+    vsf_gint_state_t orig = vsf_disable_interrupt();
+
+    client->response = response;
+    client->response_param = response_param;
+    client->packed = false;
+    for (c = task->client_list; c && (c != client); c = c->next);
+    if (!c) {
+        client->queue_head = 0;
+        client->queue_cnt = 0;
+        client->execute_cnt = 0;
+        client->reserved = DAP_PACKET_COUNT;
+        client->busy = false;
+        client->next = task->client_list;
+        task->client_list = client;
+    }
+    vsf_set_interrupt(orig);
+}
+
+// a free slot for the client, call with interrupts off
+static uint_fast8_t slot_alloc(dap_task_t *task, dap_client_t *client)
+{
+    dap_client_t *c;
+    uint_fast8_t i, slot = DAP_PACKET_COUNT, free = 0, idle = 0;
+
+    for (i = 0; i < DAP_PACKET_COUNT; i++) {
+        if (!task->request[i].client) {
+            slot = i;
+            free++;
+        }
+    }
+    // keep one slot for each other client holding none
+    if (client->queue_cnt || (client->reserved < DAP_PACKET_COUNT)) {
+        for (c = task->client_list; c; c = c->next) {
+            if ((c != client) && !c->queue_cnt && (c->reserved >= DAP_PACKET_COUNT))
+                idle++;
+        }
+        if (free <= idle)
+            return DAP_PACKET_COUNT;
+    }
+    if (slot < DAP_PACKET_COUNT)
+        task->request[slot].client = client;
+    return slot;
+}
+
+vsf_err_t dap_requset(dap_t *dap, dap_client_t *client, uint8_t* buf, uint16_t pkt_size)
 {
     dap_param_t *param = &dap->dap_param;
     dap_task_t *task = &dap->dap_task;
+    dap_request_t *request;
+    vsf_gint_state_t orig;
+    uint_fast8_t slot;
 
     if (buf[0] == ID_DAP_TransferAbort) {
-        param->do_abort = true;
+        // only the transfer of the same client is aborted
+        if (task->client == client)
+            param->do_abort = true;
+        // a stream of the client stops at its next part
+        client->stream_abort = true;
         return VSF_ERR_NONE;
-    } else if (task->request_cnt < DAP_PACKET_COUNT) {
-        dap_request_t *request = &task->request[(task->request_head + task->request_cnt) % DAP_PACKET_COUNT];
-        request->response_sem = response_sem;
-        request->response = response;
-        request->response_param = response_param;
-        request->pkt_size = min(pkt_size, DAP_PACKET_SIZE);
+    }
+
+    orig = vsf_disable_interrupt();
+    slot = client->reserved;
+    if (slot < DAP_PACKET_COUNT)
+        client->reserved = DAP_PACKET_COUNT;
+    else
+        slot = slot_alloc(task, client);
+    vsf_set_interrupt(orig);
+    if (slot >= DAP_PACKET_COUNT)
+        return VSF_ERR_NOT_READY;
+
+    request = &task->request[slot];
+    request->pkt_size = min(pkt_size, DAP_PACKET_SIZE);
+    // a packet received into dap_request_buf() is in place already
+    if (buf != request->request_buf)
         memcpy(request->request_buf, buf, request->pkt_size);
-        task->request_cnt++;
-        vsf_sem_post(&dap->dap_task.request_sem);
-        return VSF_ERR_NONE;
+    task->response[slot].ready = false;
+    task->response[slot].more = false;
+
+    orig = vsf_disable_interrupt();
+    client->queue[(client->queue_head + client->queue_cnt) % DAP_PACKET_COUNT] = slot;
+    client->queue_cnt++;
+    vsf_set_interrupt(orig);
+    vsf_sem_post(&task->request_sem);
+    return VSF_ERR_NONE;
+}
+
+// buffer of the slot reserved for the next request of the client, NULL while
+// the client may not take another slot
+uint8_t *dap_request_buf(dap_t *dap, dap_client_t *client)
+{
+    dap_task_t *task = &dap->dap_task;
+    vsf_gint_state_t orig = vsf_disable_interrupt();
+    uint_fast8_t slot = client->reserved;
+
+    if (slot >= DAP_PACKET_COUNT) {
+        slot = slot_alloc(task, client);
+        client->reserved = slot;
     }
-    return VSF_ERR_NOT_READY;
+    vsf_set_interrupt(orig);
+    if (slot >= DAP_PACKET_COUNT)
+        return NULL;
+    return task->request[slot].request_buf;
+}
+
+// buf is the response buffer passed to the response callback
+void dap_response_done(dap_t *dap, uint8_t *buf)
+{
+    dap_task_t *task = &dap->dap_task;
+    dap_client_t *client;
+    uint_fast8_t i;
+
+    for (i = 0; i < DAP_PACKET_COUNT; i++) {
+        if (task->request[i].client && (task->response[i].response_buf == buf))
+            break;
+    }
+    if (i == DAP_PACKET_COUNT)
+        return;
+    client = task->request[i].client;
+
+    vsf_gint_state_t orig = vsf_disable_interrupt();
+    client->busy = false;
+    if (task->response[i].more) {
+        task->response[i].refill = true;
+    } else {
+        if (++client->queue_head == DAP_PACKET_COUNT)
+            client->queue_head = 0;
+        client->queue_cnt--;
+        client->execute_cnt--;
+        task->request[i].request_buf = buf;
+        task->response[i].response_buf = NULL;
+        task->request[i].client = NULL;
+    }
+    vsf_set_interrupt(orig);
+
+    // a streamed part keeps the slot, dap_task_t refills response_buf
+    if (task->response[i].more)
+        vsf_sem_post(&task->request_sem);
+    // the next response of the client may be waiting
+    vsf_sem_post(&task->response_sem);
 }
 
 vsf_err_t dap_requset_sync(dap_t *dap, uint8_t *request_buf, uint8_t *response_buf, uint16_t pkt_size)
 {
     dap_param_t *param = &dap->dap_param;
     dap_task_t *dap_task = &dap->dap_task;
-    response_buf = dap_task->response.response_buf;
-    return request_handler(param, request_buf, response_buf, min(pkt_size, DAP_PACKET_SIZE));
+    bool streaming = dap_vendor_stream_pending(param);
+    vsf_err_t err;
+
+    response_buf = dap_task->spare;
+    err = request_handler(param, request_buf, response_buf, min(pkt_size, DAP_PACKET_SIZE));
+    // only the first part of a streamed command can be returned here
+    if (!streaming)
+        dap_vendor_stream_cancel(param);
+    return err;
 }
 
 void dap_test(dap_t *dap, uint8_t port, uint16_t speed_khz)
 { 
-    uint16_t ret;
     dap_param_t *param = &dap->dap_param;
     dap_task_t *dap_task = &dap->dap_task;
-    dap_request_t *request = &dap_task->request[0];
-    dap_response_t *response = &dap_task->response;
+    uint8_t *request_buf = dap_task->request[0].request_buf;
+    uint8_t *response_buf = dap_task->spare;
 
     param->port = port;
     param->speed_khz = speed_khz;
@@ -2050,38 +2817,38 @@ void dap_test(dap_t *dap, uint8_t port, uint16_t speed_khz)
         };
 #endif
 
-        memcpy(request->request_buf, sreq_ID_DAP_SWJ_Sequence, sizeof(sreq_ID_DAP_SWJ_Sequence));
-        ret = request_handler(param, request->request_buf, response->response_buf, DAP_PACKET_SIZE);
+        memcpy(request_buf, sreq_ID_DAP_SWJ_Sequence, sizeof(sreq_ID_DAP_SWJ_Sequence));
+        request_handler(param, request_buf, response_buf, DAP_PACKET_SIZE);
         
-        memcpy(request->request_buf, sreq_ID_DAP_Transfer1, sizeof(sreq_ID_DAP_Transfer1));
-        ret = request_handler(param, request->request_buf, response->response_buf, DAP_PACKET_SIZE);
+        memcpy(request_buf, sreq_ID_DAP_Transfer1, sizeof(sreq_ID_DAP_Transfer1));
+        request_handler(param, request_buf, response_buf, DAP_PACKET_SIZE);
         
-        memcpy(request->request_buf, sreq_ID_DAP_Transfer2, sizeof(sreq_ID_DAP_Transfer2));
-        ret = request_handler(param, request->request_buf, response->response_buf, DAP_PACKET_SIZE);
+        memcpy(request_buf, sreq_ID_DAP_Transfer2, sizeof(sreq_ID_DAP_Transfer2));
+        request_handler(param, request_buf, response_buf, DAP_PACKET_SIZE);
         
-        memcpy(request->request_buf, sreq_ID_DAP_Transfer3, sizeof(sreq_ID_DAP_Transfer3));
-        ret = request_handler(param, request->request_buf, response->response_buf, DAP_PACKET_SIZE);
+        memcpy(request_buf, sreq_ID_DAP_Transfer3, sizeof(sreq_ID_DAP_Transfer3));
+        request_handler(param, request_buf, response_buf, DAP_PACKET_SIZE);
         
-        memcpy(request->request_buf, sreq_ID_DAP_Transfer4, sizeof(sreq_ID_DAP_Transfer4));
-        ret = request_handler(param, request->request_buf, response->response_buf, DAP_PACKET_SIZE);
+        memcpy(request_buf, sreq_ID_DAP_Transfer4, sizeof(sreq_ID_DAP_Transfer4));
+        request_handler(param, request_buf, response_buf, DAP_PACKET_SIZE);
         
-        memcpy(request->request_buf, sreq_ID_DAP_Transfer5, sizeof(sreq_ID_DAP_Transfer5));
-        ret = request_handler(param, request->request_buf, response->response_buf, DAP_PACKET_SIZE);
+        memcpy(request_buf, sreq_ID_DAP_Transfer5, sizeof(sreq_ID_DAP_Transfer5));
+        request_handler(param, request_buf, response_buf, DAP_PACKET_SIZE);
         
-        memcpy(request->request_buf, sreq_ID_DAP_Transfer6, sizeof(sreq_ID_DAP_Transfer6));
-        ret = request_handler(param, request->request_buf, response->response_buf, DAP_PACKET_SIZE);
+        memcpy(request_buf, sreq_ID_DAP_Transfer6, sizeof(sreq_ID_DAP_Transfer6));
+        request_handler(param, request_buf, response_buf, DAP_PACKET_SIZE);
         
-        memcpy(request->request_buf, sreq_ID_DAP_Transfer7, sizeof(sreq_ID_DAP_Transfer7));
-        ret = request_handler(param, request->request_buf, response->response_buf, DAP_PACKET_SIZE);
+        memcpy(request_buf, sreq_ID_DAP_Transfer7, sizeof(sreq_ID_DAP_Transfer7));
+        request_handler(param, request_buf, response_buf, DAP_PACKET_SIZE);
         
-        memcpy(request->request_buf, sreq_ID_DAP_Transfer8, sizeof(sreq_ID_DAP_Transfer8));
-        ret = request_handler(param, request->request_buf, response->response_buf, DAP_PACKET_SIZE);
+        memcpy(request_buf, sreq_ID_DAP_Transfer8, sizeof(sreq_ID_DAP_Transfer8));
+        request_handler(param, request_buf, response_buf, DAP_PACKET_SIZE);
         
-        memcpy(request->request_buf, sreq_ID_DAP_Transfer9, sizeof(sreq_ID_DAP_Transfer9));
-        ret = request_handler(param, request->request_buf, response->response_buf, DAP_PACKET_SIZE);
+        memcpy(request_buf, sreq_ID_DAP_Transfer9, sizeof(sreq_ID_DAP_Transfer9));
+        request_handler(param, request_buf, response_buf, DAP_PACKET_SIZE);
         
-        memcpy(request->request_buf, sreq_ID_DAP_Transfer10, sizeof(sreq_ID_DAP_Transfer10));
-        ret = request_handler(param, request->request_buf, response->response_buf, DAP_PACKET_SIZE);
+        memcpy(request_buf, sreq_ID_DAP_Transfer10, sizeof(sreq_ID_DAP_Transfer10));
+        request_handler(param, request_buf, response_buf, DAP_PACKET_SIZE);
     } else if (param->port == DAP_PORT_JTAG) {
 #if 0   // OpenOCD
         // ID_DAP_SWJ_Sequence
@@ -2115,17 +2882,17 @@ void dap_test(dap_t *dap, uint8_t port, uint16_t speed_khz)
             0x8a, 0xff, 0xff, 0xc1, 0xff, 0x01, 0xff, 0x41, 0x00, 0x41, 0x00, 0x01, 0x00
         };
         
-        memcpy(request->request_buf, jreq_ID_DAP_SWJ_Sequence, sizeof(jreq_ID_DAP_SWJ_Sequence));
-        ret = request_handler(param, request->request_buf, response->response_buf, DAP_PACKET_SIZE);
+        memcpy(request_buf, jreq_ID_DAP_SWJ_Sequence, sizeof(jreq_ID_DAP_SWJ_Sequence));
+        request_handler(param, request_buf, response_buf, DAP_PACKET_SIZE);
         
-        memcpy(request->request_buf, jreq_ID_DAP_JTAG_Sequence1, sizeof(jreq_ID_DAP_JTAG_Sequence1));
-        ret = request_handler(param, request->request_buf, response->response_buf, DAP_PACKET_SIZE);
+        memcpy(request_buf, jreq_ID_DAP_JTAG_Sequence1, sizeof(jreq_ID_DAP_JTAG_Sequence1));
+        request_handler(param, request_buf, response_buf, DAP_PACKET_SIZE);
         
-        memcpy(request->request_buf, jreq_ID_DAP_SWJ_Sequence, sizeof(jreq_ID_DAP_SWJ_Sequence));
-        ret = request_handler(param, request->request_buf, response->response_buf, DAP_PACKET_SIZE);
+        memcpy(request_buf, jreq_ID_DAP_SWJ_Sequence, sizeof(jreq_ID_DAP_SWJ_Sequence));
+        request_handler(param, request_buf, response_buf, DAP_PACKET_SIZE);
         
-        memcpy(request->request_buf, jreq_ID_DAP_JTAG_Sequence2, sizeof(jreq_ID_DAP_JTAG_Sequence2));
-        ret = request_handler(param, request->request_buf, response->response_buf, DAP_PACKET_SIZE);
+        memcpy(request_buf, jreq_ID_DAP_JTAG_Sequence2, sizeof(jreq_ID_DAP_JTAG_Sequence2));
+        request_handler(param, request_buf, response_buf, DAP_PACKET_SIZE);
 #elif 1 // IAR
         // ID_DAP_TransferConfigure
         const uint8_t jreq_ID_DAP_TransferConfigure[] = {0x04, 0x00, 0x64, 0x00, 0x00, 0x00};
@@ -2162,41 +2929,41 @@ void dap_test(dap_t *dap, uint8_t port, uint16_t speed_khz)
         0x05, 0x00, 0x06, 0x04, 0x32, 0x00, 0x00, 0x50, 0x08, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x00, 0x00, 0xe3, 0x05, 0x00, 0xed, 0x00, 0xe0, 0x0f, 0x06
         };
 
-        memcpy(request->request_buf, jreq_ID_DAP_TransferConfigure, sizeof(jreq_ID_DAP_TransferConfigure));
-        ret = request_handler(param, request->request_buf, response->response_buf, DAP_PACKET_SIZE);
+        memcpy(request_buf, jreq_ID_DAP_TransferConfigure, sizeof(jreq_ID_DAP_TransferConfigure));
+        request_handler(param, request_buf, response_buf, DAP_PACKET_SIZE);
         
-        memcpy(request->request_buf, jreq_ID_DAP_JTAG_Configure, sizeof(jreq_ID_DAP_JTAG_Configure));
-        ret = request_handler(param, request->request_buf, response->response_buf, DAP_PACKET_SIZE);
+        memcpy(request_buf, jreq_ID_DAP_JTAG_Configure, sizeof(jreq_ID_DAP_JTAG_Configure));
+        request_handler(param, request_buf, response_buf, DAP_PACKET_SIZE);
 
-        memcpy(request->request_buf, jreq_ID_DAP_SWJ_Sequence, sizeof(jreq_ID_DAP_SWJ_Sequence));
-        ret = request_handler(param, request->request_buf, response->response_buf, DAP_PACKET_SIZE);
+        memcpy(request_buf, jreq_ID_DAP_SWJ_Sequence, sizeof(jreq_ID_DAP_SWJ_Sequence));
+        request_handler(param, request_buf, response_buf, DAP_PACKET_SIZE);
         
-        memcpy(request->request_buf, jreq_ID_DAP_Transfer1, sizeof(jreq_ID_DAP_Transfer1));
-        ret = request_handler(param, request->request_buf, response->response_buf, DAP_PACKET_SIZE);
+        memcpy(request_buf, jreq_ID_DAP_Transfer1, sizeof(jreq_ID_DAP_Transfer1));
+        request_handler(param, request_buf, response_buf, DAP_PACKET_SIZE);
         
-        memcpy(request->request_buf, jreq_ID_DAP_Transfer2, sizeof(jreq_ID_DAP_Transfer2));
-        ret = request_handler(param, request->request_buf, response->response_buf, DAP_PACKET_SIZE);
+        memcpy(request_buf, jreq_ID_DAP_Transfer2, sizeof(jreq_ID_DAP_Transfer2));
+        request_handler(param, request_buf, response_buf, DAP_PACKET_SIZE);
         
-        memcpy(request->request_buf, jreq_ID_DAP_Transfer3, sizeof(jreq_ID_DAP_Transfer3));
-        ret = request_handler(param, request->request_buf, response->response_buf, DAP_PACKET_SIZE);
+        memcpy(request_buf, jreq_ID_DAP_Transfer3, sizeof(jreq_ID_DAP_Transfer3));
+        request_handler(param, request_buf, response_buf, DAP_PACKET_SIZE);
         
-        memcpy(request->request_buf, jreq_ID_DAP_Transfer4, sizeof(jreq_ID_DAP_Transfer4));
-        ret = request_handler(param, request->request_buf, response->response_buf, DAP_PACKET_SIZE);
+        memcpy(request_buf, jreq_ID_DAP_Transfer4, sizeof(jreq_ID_DAP_Transfer4));
+        request_handler(param, request_buf, response_buf, DAP_PACKET_SIZE);
         
-        memcpy(request->request_buf, jreq_ID_DAP_Transfer5, sizeof(jreq_ID_DAP_Transfer5));
-        ret = request_handler(param, request->request_buf, response->response_buf, DAP_PACKET_SIZE);
+        memcpy(request_buf, jreq_ID_DAP_Transfer5, sizeof(jreq_ID_DAP_Transfer5));
+        request_handler(param, request_buf, response_buf, DAP_PACKET_SIZE);
         
-        memcpy(request->request_buf, jreq_ID_DAP_Transfer6, sizeof(jreq_ID_DAP_Transfer6));
-        ret = request_handler(param, request->request_buf, response->response_buf, DAP_PACKET_SIZE);
+        memcpy(request_buf, jreq_ID_DAP_Transfer6, sizeof(jreq_ID_DAP_Transfer6));
+        request_handler(param, request_buf, response_buf, DAP_PACKET_SIZE);
         
-        memcpy(request->request_buf, jreq_ID_DAP_Transfer7, sizeof(jreq_ID_DAP_Transfer7));
-        ret = request_handler(param, request->request_buf, response->response_buf, DAP_PACKET_SIZE);
+        memcpy(request_buf, jreq_ID_DAP_Transfer7, sizeof(jreq_ID_DAP_Transfer7));
+        request_handler(param, request_buf, response_buf, DAP_PACKET_SIZE);
         
-        memcpy(request->request_buf, jreq_ID_DAP_Transfer8, sizeof(jreq_ID_DAP_Transfer8));
-        ret = request_handler(param, request->request_buf, response->response_buf, DAP_PACKET_SIZE);
+        memcpy(request_buf, jreq_ID_DAP_Transfer8, sizeof(jreq_ID_DAP_Transfer8));
+        request_handler(param, request_buf, response_buf, DAP_PACKET_SIZE);
         
-        memcpy(request->request_buf, jreq_ID_DAP_Transfer9, sizeof(jreq_ID_DAP_Transfer9));
-        ret = request_handler(param, request->request_buf, response->response_buf, DAP_PACKET_SIZE);
+        memcpy(request_buf, jreq_ID_DAP_Transfer9, sizeof(jreq_ID_DAP_Transfer9));
+        request_handler(param, request_buf, response_buf, DAP_PACKET_SIZE);
 #endif
         
     }
@@ -103,6 +103,7 @@ extern "C" {
 #define DAP_ID_FW_VER 4U
 #define DAP_ID_DEVICE_VENDOR 5U
 #define DAP_ID_DEVICE_NAME 6U
+#define DAP_ID_PACKED_SIZE 0xE0U    // vendor, switches the client to packed responses
 #define DAP_ID_CAPABILITIES 0xF0U
 #define DAP_ID_TIMESTAMP_CLOCK 0xF1U
 #define DAP_ID_SWO_BUFFER_SIZE 0xFDU
@@ -179,13 +180,103 @@ extern "C" {
 #define SWD_SEQUENCE_CLK 0x3FU // SWCLK count
 #define SWD_SEQUENCE_DIN 0x80U // SWDIO capture
 
+#if DAP_STATS
+#if !TIMESTAMP_CLOCK
+#   error "DAP_STATS needs TIMESTAMP_CLOCK"
+#endif
+
+// commands 0x00 - 0x1F, then ID_DAP_Vendor0 - ID_DAP_Vendor31
+#define DAP_STATS_CMD_NUM 64
+
+/*
+    Times are in TIMESTAMP_CLOCK ticks and wrap with the timestamp. Commands
+    are timed from the end of the previous command in the same request, so
+    the time of the first one includes the start of request_handler.
+*/
+typedef struct dap_stats_t {
+    struct {
+        uint32_t count;
+        uint32_t min;
+        uint32_t max;
+        uint32_t total;
+    } cmd[DAP_STATS_CMD_NUM];
+
+    uint32_t requests;
+    uint32_t queue_depth[DAP_PACKET_COUNT]; // [n]: requests executed with n + 1 slots in use
+    uint32_t resp_wait_total;               // response ready, client still busy
+    uint32_t resp_wait_max;
+    uint32_t swd_retries;                   // WAIT retries done by the driver
+    uint32_t jtag_retries;
+    uint32_t port_bytes[3];                 // DP/AP data by DAP_PORT_xxx
+    uint32_t swd_cached;                    // writes left out by the SWD write cache
+} dap_stats_t;
+#endif
+
+#if VENDOR_UART
+// ports of the vendor USART commands, the SWO UART only while SWO is not capturing
+#define VENDOR_USART_EXT 0
+#if SWO_UART
+#define VENDOR_USART_SWO 1
+#define VENDOR_USART_NUM 2
+#else
+#define VENDOR_USART_NUM 1
+#endif
+#endif
+
+#if VENDOR_MULTIDROP && !DAP_SWD
+#   error "VENDOR_MULTIDROP needs DAP_SWD"
+#endif
+
+#if DAP_SWD
+// targets of the SWD write cache, entry 0 is the one the host selected itself
+#if VENDOR_MULTIDROP
+#define DAP_SWD_CACHE_DP_NUM (VENDOR_MULTIDROP_NUM + 1)
+#else
+#define DAP_SWD_CACHE_DP_NUM 1
+#endif
+#ifndef DAP_SWD_CACHE_AP_NUM
+#define DAP_SWD_CACHE_AP_NUM 4
+#endif
+
+// what an AP is known to hold
+typedef struct dap_swd_cache_ap_t {
+    uint8_t ap;
+    uint8_t valid;                  // SWD_CACHE_xxx of dap.c
+    uint32_t csw;
+    uint32_t tar;
+} dap_swd_cache_ap_t;
+
+// what a target is known to hold
+typedef struct dap_swd_cache_dp_t {
+#if VENDOR_MULTIDROP
+    uint32_t targetsel;
+#endif
+    bool select_valid;
+    uint8_t ap_next;                // entry taken by the next AP
+    uint32_t select;
+    dap_swd_cache_ap_t ap[DAP_SWD_CACHE_AP_NUM];
+} dap_swd_cache_dp_t;
+#endif
+
 declare_vsf_task(dap_task_t);
+declare_vsf_task(dap_response_task_t);
 
 typedef struct dap_param_t {
 #if VENDOR_UART || SWO_UART
     uint16_t (*get_serial)(uint8_t *serial);
     void (*config_usart)(enum usart_idx_t idx, uint32_t *mode, uint32_t *baudrate, vsf_stream_t *tx, vsf_stream_t *rx, bool return_actual_baud);
     uint32_t (*get_usart_baud)(enum usart_idx_t idx, uint32_t baudrate);
+    uint32_t (*get_usart_dropped)(enum usart_idx_t idx);   // read and clear, bytes lost on rx stream
+#endif
+#if SWO_UART && SWO_STREAM
+    void (*hold_usart_rx)(enum usart_idx_t idx, uint32_t size);     // rx stream bytes sent in place, 0 when done
+#endif
+#if SWO_MANCHESTER
+    void (*config_manchester)(uint32_t baudrate, vsf_stream_t *rx);     // rx NULL to stop
+    uint32_t (*get_manchester_dropped)(void);               // read and clear, bytes lost on rx stream
+#endif
+#if VENDOR_CRC
+    uint32_t (*crc32)(uint32_t crc, uint8_t *buf, uint32_t size);   // CRC-32 of zlib, 0 to start
 #endif
 
 #if VENDOR_UART
@@ -197,9 +288,9 @@ typedef struct dap_param_t {
     vsf_fifo_stream_t swo_rx;
 #endif
 #if VENDOR_UART
-    uint8_t ext_tx_buf[SWO_BUFFER_SIZE + 4];
-    uint8_t ext_rx_buf[SWO_BUFFER_SIZE + 4];
-    uint8_t swo_tx_buf[SWO_BUFFER_SIZE + 4];
+    uint8_t ext_tx_buf[VENDOR_UART_BUFFER_SIZE];
+    uint8_t ext_rx_buf[VENDOR_UART_BUFFER_SIZE];
+    uint8_t swo_tx_buf[VENDOR_UART_BUFFER_SIZE];
 #endif
 #if SWO_UART
     uint8_t swo_rx_buf[SWO_BUFFER_SIZE + 4];
@@ -207,9 +298,52 @@ typedef struct dap_param_t {
 
     bool do_abort;
     bool port_io_need_reconfig;
+    uint16_t packed_size;           // of the client being served, 0 if it does not pack
+    bool packed_start;              // DAP_ID_PACKED_SIZE was read
+
+#if DAP_STATS
+    dap_stats_t stats;
+#endif
+
+    struct {
+        uint8_t cmd;        // vendor command being streamed
+        uint8_t ap;
+        uint8_t size;       // access size in bytes
+        uint32_t addr;      // next address
+        uint32_t remain;    // bytes not sent yet, 0 if nothing is streamed
+    } vendor_mem;
+#if VENDOR_UART
+    struct {
+        uint32_t baudrate;  // 0 if the port is not open
+        uint32_t mode;
+        bool overrun;       // rx bytes lost since the last status
+    } vendor_usart[VENDOR_USART_NUM];
+#endif
+    struct {
+        uint8_t ap;
+        uint8_t status;             // first error since setup or init
+        uint8_t buffer;             // page buffer being filled
+        bool busy;                  // ProgramPage running on the other buffer
+        uint32_t result;            // R0 of the failed function
+        uint32_t breakpoint;
+        uint32_t static_base;
+        uint32_t stack_pointer;
+        uint32_t init;
+        uint32_t uninit;
+        uint32_t erase_sector;
+        uint32_t program_page;
+        uint32_t buffer_addr[2];
+        uint32_t page_size;         // 0 if not set up
+        uint32_t timeout_ms;        // for one function call
+        uint32_t page_addr;         // flash address of the page being filled
+        uint32_t page_len;
+    } vendor_flash;
 
     uint8_t port;
     uint16_t speed_khz;
+#if VENDOR_RTT
+    uint32_t dp_select;             // last one written, SELECT is write-only on SWD
+#endif
     struct {
         uint8_t idle_cycles; // Idle cycles after transfer
         uint16_t retry_count; // Number of retries after WAIT response
@@ -221,6 +355,23 @@ typedef struct dap_param_t {
         uint8_t turnaround; // Turnaround period [0, 4]
         uint8_t data_phase; // Always generate Data Phase
     } swd_conf;
+    struct {
+        bool enable;
+        uint8_t idle;               // idle cycles in use, from transfer.idle_cycles up
+        uint16_t khz;               // clock in use, up to speed_khz
+        uint8_t stable;             // windows without parity error
+        uint8_t up_windows;         // stable windows needed to step the clock up
+        uint32_t transfers;         // in the current window
+        uint32_t retries;           // in the current window
+        uint32_t parity_errors;     // since enabled
+        uint32_t wait_retries;      // since enabled
+    } swd_adapt;
+    struct {
+        bool enable;
+        uint8_t dp;                 // entry of the target on the wire
+        uint8_t dp_next;            // multi-drop entry taken by the next target
+        dap_swd_cache_dp_t entry[DAP_SWD_CACHE_DP_NUM];
+    } swd_cache;
 #endif
 #if DAP_JTAG
     struct {
@@ -242,6 +393,9 @@ typedef struct dap_param_t {
     uint32_t trace_timestamp;
 #endif  // TIMESTAMP_CLOCK
     uint32_t swo_baudrate;
+#if SWO_STREAM
+    uint32_t swo_stream_size;       // handed to the trace endpoint, still in swo_rx
+#endif
 #endif  // SWO_UART
     uint8_t transport;	// 0 - None; 1 - Read trace data via DAP_SWO_Data command; 2 - Send trace data via separate WinUSB endpoint
 	
@@ -250,47 +404,140 @@ typedef struct dap_param_t {
 #endif  // SWO_UART || SWO_MANCHESTER
 } dap_param_t;
 
-typedef struct dap_request_t {
-    vsf_sem_t* response_sem;
+typedef struct dap_client_t dap_client_t;
+
+/*
+    A front-end of the dap engine, one per usb interface. The slots of a
+    client are executed and passed on in its own request order, the clients
+    are served round robin, one request each.
+
+    A client able to pack several responses into one transfer sets
+    packed_size to the largest transfer it sends. DAP_Info DAP_ID_PACKED_SIZE
+    reports it, and the responses passed on after the one to that request
+    have packed set. It is cleared by dap_client_init().
+*/
+struct dap_client_t {
     void (*response)(void* p, uint8_t* buf, uint16_t size);
     void* response_param;
-    uint8_t request_buf[DAP_PACKET_SIZE];
+
+    dap_client_t *next;
+    uint8_t queue[DAP_PACKET_COUNT];    // slots in request order
+    uint8_t queue_head;
+    uint8_t queue_cnt;                  // slots queued, executed or with the client
+    uint8_t execute_cnt;                // of them executed
+    uint8_t reserved;                   // slot of dap_request_buf(), DAP_PACKET_COUNT for none
+    bool busy;                          // a response is with the client
+    bool stream_abort;                  // DAP_TransferAbort between the parts of its stream
+    bool packed;                        // host reads packed responses
+    uint16_t packed_size;               // 0 if the client does not pack
+};
+
+typedef struct dap_request_t {
+    dap_client_t *client;           // owner of the slot, NULL while free
+    uint8_t *request_buf;           // NULL once executed
     uint16_t pkt_size;
 } dap_request_t;
 
 typedef struct dap_response_t {
-    vsf_sem_t* response_sem;
-    void (*response)(void* p, uint8_t* buf, uint16_t size);
-    void* response_param;
-    uint8_t response_buf[DAP_PACKET_SIZE];
+    uint8_t *response_buf;          // NULL until executed
     uint16_t response_size;
+    bool more;                      // more responses follow for the same request
+    bool refill;                    // streamed part handed back, the next one may be made
+    bool ready;                     // waiting to be passed on
+    bool packed_start;              // client packs the responses after this one
+#if DAP_STATS
+    uint32_t ready_time;
+#endif
 } dap_response_t;
 
+/*
+    request[n] and response[n] form one slot, a slot is owned by a client
+    from dap_requset() until its response buffer is handed back with
+    dap_response_done(). dap_task_t takes one request of each client in
+    turn and executes it into the response buffer of the slot,
+    dap_response_task_t passes the responses on in request order of each
+    client, so the wire keeps running while earlier responses are still
+    waiting for the IN endpoint, and a client slow to take its responses
+    does not hold up the others.
+
+    The buffers of the slots are the packet buffers of the usb class: an OUT
+    transfer receives into dap_request_buf(), a slot reserved for the client,
+    and the IN transfer sends straight out of the response buffer. A slot
+    holds one packet buffer, there is a single spare for the request in
+    execution: the response goes to the spare, and the request buffer, done
+    with, becomes the next spare. When the slot is freed its response buffer
+    takes the next request. A client
+    already holding slots only gets another one while a slot stays free for
+    each client holding none, so no client is locked out by a busy one.
+
+    A vendor command may stream its result over several responses. The slot
+    is then kept with more set. Each time a part is handed back, the next one
+    is made into the same response buffer in the round robin, like another
+    request of the client, so the other clients are served between the
+    parts. While a stream is pending, vendor commands of other clients that
+    would start one are refused.
+*/
 def_vsf_task(dap_task_t,
     def_params(
         dap_param_t* dap_param;
 
-        vsf_sem_t request_sem;
+        vsf_sem_t request_sem;      // requests waiting for execution
+        vsf_sem_t response_sem;     // responses waiting to be passed on
 
         dap_request_t request[DAP_PACKET_COUNT];
-        dap_response_t response;
+        dap_response_t response[DAP_PACKET_COUNT];
+        uint8_t buf[DAP_PACKET_COUNT + 1][DAP_PACKET_SIZE];
+        uint8_t *spare;             // response buffer of the next execution
+
+        dap_client_t *client_list;
+        dap_client_t *client;       // of the request in execution
+        uint8_t slot;
+    )
+);
 
-        uint8_t request_head;
-        uint8_t request_cnt;
+def_vsf_task(dap_response_task_t,
+    def_params(
+        dap_task_t *dap_task;
     )
 );
 
 typedef struct dap_t {
     dap_param_t dap_param;
     dap_task_t dap_task;
+    dap_response_task_t dap_response_task;
 } dap_t;
 
 void dap_init(dap_t *dap, vsf_prio_t prio);
-vsf_err_t dap_requset(dap_t *dap, vsf_sem_t *response_sem,
+void dap_client_init(dap_t *dap, dap_client_t *client,
         void (*response)(void* p, uint8_t* buf, uint16_t size),
-        void* response_param, uint8_t* buf, uint16_t pkt_size);
+        void* response_param);
+vsf_err_t dap_requset(dap_t *dap, dap_client_t *client, uint8_t* buf, uint16_t pkt_size);
+uint8_t *dap_request_buf(dap_t *dap, dap_client_t *client);
+void dap_response_done(dap_t *dap, uint8_t *buf);
 vsf_err_t dap_requset_sync(dap_t *dap, uint8_t *request_buf, uint8_t *response_buf, uint16_t pkt_size);
 void dap_test(dap_t *dap, uint8_t port, uint16_t speed_khz);
+uint8_t dap_swj_pins(dap_param_t* param, uint8_t value, uint8_t select, uint32_t delay_us);
+#if DAP_SWD
+void dap_swd_adapt_enable(dap_param_t* param, bool enable);
+void dap_swd_cache_enable(dap_param_t* param, bool enable);
+bool dap_swd_cache_access(dap_param_t* param, uint8_t request, uint8_t* data);
+void dap_swd_cache_forget(dap_param_t* param);
+void dap_swd_cache_reset(dap_param_t* param);
+#if VENDOR_MULTIDROP
+void dap_swd_cache_target(dap_param_t* param, uint32_t targetsel, bool answered);
+#endif
+#endif
+#if VENDOR_UART && SWO_UART
+void dap_vendor_usart_release_swo(dap_param_t* param);
+#endif
+#if SWO_UART && SWO_STREAM
+uint32_t dap_swo_stream_get(dap_param_t* param, uint8_t **buf);
+void dap_swo_stream_done(dap_param_t* param);
+#endif
+#ifdef JTAG_ASYNC
+uint16_t jtag_ir_to_raw(uint64_t *buf_tms, uint64_t *buf_tdi, uint32_t ir, uint8_t lr_length, uint16_t ir_before, uint16_t ir_after);
+uint16_t jtag_dr_to_raw(uint64_t *buf_tms, uint64_t *buf_tdi, uint8_t request, uint32_t dr, uint16_t dr_before, uint16_t dr_after, uint8_t idle);
+#endif
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,277 @@
+#include "vsf.h"
+#include "dap.h"
+#include "dap_rtt.h"
+
+#if VENDOR_RTT
+// vendor commands of dap_vendor.c
+#define RTT_CMD_FIND                    ID_DAP_Vendor16
+#define RTT_CMD_POLL                    ID_DAP_Vendor17
+#define RTT_FIND_BLOCK                  0x400UL         // RTT_FIND_MAX of dap_vendor.c
+
+#define RTT_STATE_OFF                   0
+#define RTT_STATE_FIND                  1
+#define RTT_STATE_POLL                  2
+#define RTT_STATE_CONNECT               3
+#define RTT_STATE_DISCONNECT            4
+
+#define DP_CTRL_STAT_PWRUPREQ           0x50000000UL    // CSYSPWRUPREQ | CDBGPWRUPREQ
+
+// wait between polls while the target is quiet, doubled from min to max
+#define RTT_POLL_MIN_US                 100
+#define RTT_POLL_MAX_US                 20000
+// before the scan starts over, or after the wire failed
+#define RTT_RETRY_US                    100000
+
+/*
+    No debugger has connected a port: SWD is connected here, switched from
+    JTAG, and the DP powered up, all in one DAP_ExecuteCommands. Without a
+    target answering the port is disconnected again before the next try.
+*/
+static uint16_t rtt_connect_request(uint8_t *buf)
+{
+    uint16_t pos = 0;
+
+    buf[pos++] = ID_DAP_ExecuteCommands;
+    buf[pos++] = 3;
+    buf[pos++] = ID_DAP_Connect;
+    buf[pos++] = DAP_PORT_SWD;
+    // line reset, JTAG to SWD, line reset, idle
+    buf[pos++] = ID_DAP_SWJ_Sequence;
+    buf[pos++] = 136;
+    memset(buf + pos, 0xFF, 7);
+    pos += 7;
+    buf[pos++] = 0x9E;
+    buf[pos++] = 0xE7;
+    memset(buf + pos, 0xFF, 7);
+    pos += 7;
+    buf[pos++] = 0x00;
+    buf[pos++] = ID_DAP_Transfer;
+    buf[pos++] = 0;
+    buf[pos++] = 4;
+    buf[pos++] = DP_IDCODE | DAP_TRANSFER_RnW;
+    buf[pos++] = DP_ABORT;
+    put_unaligned_le32(0x1E, buf + pos);        // clear the sticky errors
+    pos += 4;
+    buf[pos++] = DP_SELECT;
+    put_unaligned_le32(0, buf + pos);
+    pos += 4;
+    buf[pos++] = DP_CTRL_STAT;
+    put_unaligned_le32(DP_CTRL_STAT_PWRUPREQ, buf + pos);
+    return pos + 4;
+}
+
+static void rtt_request(dap_rtt_t *rtt)
+{
+    uint8_t *buf = dap_request_buf(rtt->dap, &rtt->client), *data;
+    uint32_t size;
+
+    // all slots are with the usb clients
+    if (!buf) {
+        vsf_callback_timer_add_us(&rtt->timer, RTT_POLL_MIN_US);
+        return;
+    }
+
+    if (rtt->state == RTT_STATE_CONNECT) {
+        dap_requset(rtt->dap, &rtt->client, buf, rtt_connect_request(buf));
+        return;
+    } else if (rtt->state == RTT_STATE_DISCONNECT) {
+        buf[0] = ID_DAP_Disconnect;
+        dap_requset(rtt->dap, &rtt->client, buf, 1);
+        return;
+    }
+
+    buf[1] = rtt->ap;
+    if (rtt->state == RTT_STATE_FIND) {
+        buf[0] = RTT_CMD_FIND;
+        put_unaligned_le32(rtt->addr, buf + 2);
+        put_unaligned_le32(rtt->scan_addr + rtt->scan_size - rtt->addr, buf + 6);
+    } else {
+        buf[0] = RTT_CMD_POLL;
+        put_unaligned_le32(rtt->cb, buf + 2);
+        buf[6] = rtt->up_channel;
+        // no more than one write to tx takes, a block of a block stream
+        size = min(VSF_STREAM_GET_WBUF(rtt->tx, NULL), DAP_PACKET_SIZE - 10);
+        put_unaligned_le16(size, buf + 7);
+        buf[9] = rtt->down_channel;
+        // rx is read a block at a time, when all of it reached the target
+        size = VSF_STREAM_GET_RBUF(rtt->rx, &data);
+        if (!rtt->down_size)
+            rtt->down_size = size;
+        size = min(rtt->down_size - rtt->down_pos, DAP_PACKET_SIZE - 12);
+        if (size)
+            memcpy(buf + 12, data + rtt->down_pos, size);
+        put_unaligned_le16(size, buf + 10);
+    }
+    dap_requset(rtt->dap, &rtt->client, buf, DAP_PACKET_SIZE);
+}
+
+static void rtt_down_done(dap_rtt_t *rtt, uint16_t len)
+{
+    rtt->down_pos = min(rtt->down_pos + len, rtt->down_size);
+    if (rtt->down_size && (rtt->down_pos == rtt->down_size)) {
+        VSF_STREAM_READ(rtt->rx, NULL, rtt->down_size);
+        rtt->down_pos = rtt->down_size = 0;
+    }
+}
+
+static void rtt_next(dap_rtt_t *rtt, uint32_t delay_us)
+{
+    vsf_gint_state_t orig = vsf_disable_interrupt();
+    bool run = rtt->state != RTT_STATE_OFF;
+
+    rtt->busy = run;
+    vsf_set_interrupt(orig);
+
+    if (!run)
+        return;
+    if (delay_us)
+        vsf_callback_timer_add_us(&rtt->timer, delay_us);
+    else
+        rtt_request(rtt);
+}
+
+static void rtt_on_timer(vsf_callback_timer_t *timer)
+{
+    rtt_next(container_of(timer, dap_rtt_t, timer), 0);
+}
+
+// wait before the next request
+static uint32_t rtt_on_find(dap_rtt_t *rtt, uint8_t *buf)
+{
+    uint32_t next;
+
+    if (buf[1] == DAP_TRANSFER_OK) {
+        next = get_unaligned_le32(buf + 2);
+        rtt->cb = get_unaligned_le32(buf + 6);
+        if (rtt->cb) {
+            rtt->addr = next;
+            rtt->state = RTT_STATE_POLL;
+            rtt->interval_us = RTT_POLL_MIN_US;
+            return 0;
+        }
+        // a partial match in the last words does not move on
+        rtt->addr = (next > rtt->addr) ? next : (rtt->scan_addr + rtt->scan_size);
+    } else if (buf[1] == DAP_TRANSFER_FAULT) {
+        // a hole in the memory map, go on after it
+        rtt->addr = (rtt->addr + RTT_FIND_BLOCK) & ~(RTT_FIND_BLOCK - 1);
+    } else if (buf[1] == DAP_ERROR) {
+        rtt->state = RTT_STATE_CONNECT;
+        return 0;
+    } else {
+        return RTT_RETRY_US;
+    }
+    if ((rtt->addr - rtt->scan_addr) < rtt->scan_size)
+        return 0;
+    rtt->addr = rtt->scan_addr & ~0x3UL;
+    return RTT_RETRY_US;
+}
+
+static uint32_t rtt_on_poll(dap_rtt_t *rtt, uint8_t *buf, uint16_t size)
+{
+    uint16_t down_len = get_unaligned_le16(buf + 2);
+    uint16_t up_len = get_unaligned_le16(buf + 8);
+    uint32_t delay_us;
+
+    // what moved counts even if the poll failed after it
+    rtt_down_done(rtt, down_len);
+    if (up_len && (size >= 10 + up_len))
+        VSF_STREAM_WRITE(rtt->tx, buf + 10, up_len);
+
+    if (buf[1] == DAP_TRANSFER_MISMATCH) {
+        // the target restarted, its control block may move
+        rtt->state = RTT_STATE_FIND;
+        rtt->addr = rtt->scan_addr & ~0x3UL;
+        return RTT_RETRY_US;
+    } else if (buf[1] == DAP_ERROR) {
+        // the debugger disconnected, the control block is still there
+        rtt->state = RTT_STATE_CONNECT;
+        return 0;
+    } else if (buf[1] != DAP_TRANSFER_OK) {
+        return RTT_RETRY_US;
+    }
+
+    if (down_len || up_len || get_unaligned_le32(buf + 4)) {
+        rtt->interval_us = RTT_POLL_MIN_US;
+        // data left for a full tx, no use asking again before it is read
+        return (down_len || up_len) ? 0 : RTT_POLL_MIN_US;
+    }
+    delay_us = rtt->interval_us;
+    rtt->interval_us = min(rtt->interval_us * 2, RTT_POLL_MAX_US);
+    return delay_us;
+}
+
+// DAP_Connect, DAP_SWJ_Sequence and DAP_Transfer responses of rtt_connect_request()
+static uint32_t rtt_on_connect(dap_rtt_t *rtt, uint8_t *buf, uint16_t size)
+{
+    if (    (size >= 9) && (buf[3] == DAP_PORT_SWD) && (buf[5] == DAP_OK)
+        &&  (buf[7] == 4) && (buf[8] == DAP_TRANSFER_OK)) {
+        rtt->state = RTT_STATE_FIND;
+        rtt->addr = rtt->scan_addr & ~0x3UL;
+    } else {
+        // no target, leave the port as found
+        rtt->state = RTT_STATE_DISCONNECT;
+    }
+    return 0;
+}
+
+static void rtt_on_response(void *p, uint8_t *buf, uint16_t size)
+{
+    dap_rtt_t *rtt = p;
+    uint32_t delay_us = RTT_RETRY_US;
+
+    // a response from before dap_rtt_stop() is only drained
+    if ((buf[0] == RTT_CMD_POLL) && (size >= 10)) {
+        if (rtt->state == RTT_STATE_POLL)
+            delay_us = rtt_on_poll(rtt, buf, size);
+        else
+            rtt_down_done(rtt, get_unaligned_le16(buf + 2));
+    } else if ((buf[0] == RTT_CMD_FIND) && (size >= 10)) {
+        if (rtt->state == RTT_STATE_FIND)
+            delay_us = rtt_on_find(rtt, buf);
+    } else if (buf[0] == ID_DAP_ExecuteCommands) {
+        if (rtt->state == RTT_STATE_CONNECT)
+            delay_us = rtt_on_connect(rtt, buf, size);
+    } else if (buf[0] == ID_DAP_Disconnect) {
+        // tried again after RTT_RETRY_US
+        if (rtt->state == RTT_STATE_DISCONNECT)
+            rtt->state = RTT_STATE_FIND;
+    }
+    dap_response_done(rtt->dap, buf);
+    rtt_next(rtt, delay_us);
+}
+
+void dap_rtt_init(dap_rtt_t *rtt, dap_t *dap)
+{
+    rtt->dap = dap;
+    rtt->state = RTT_STATE_OFF;
+    rtt->busy = false;
+    rtt->down_size = 0;
+    rtt->down_pos = 0;
+    rtt->timer.on_timer = rtt_on_timer;
+    vsf_callback_timer_init(&rtt->timer);
+    dap_client_init(dap, &rtt->client, rtt_on_response, rtt);
+}
+
+// scans from scan_addr again if running
+void dap_rtt_start(dap_rtt_t *rtt)
+{
+    vsf_gint_state_t orig = vsf_disable_interrupt();
+    bool busy = rtt->busy;
+
+    rtt->state = RTT_STATE_FIND;
+    rtt->addr = rtt->scan_addr & ~0x3UL;
+    rtt->busy = true;
+    vsf_set_interrupt(orig);
+
+    // else picked up when the pending request or timer is done
+    if (!busy)
+        rtt_request(rtt);
+}
+
+void dap_rtt_stop(dap_rtt_t *rtt)
+{
+    vsf_gint_state_t orig = vsf_disable_interrupt();
+    rtt->state = RTT_STATE_OFF;
+    vsf_set_interrupt(orig);
+}
+#endif
@@ -0,0 +1,57 @@
+#ifndef __DAP_RTT_H__
+#define __DAP_RTT_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if VENDOR_RTT
+/*
+    SEGGER RTT host on the probe, a client of the dap engine like the usb
+    interfaces. It scans scan_addr - scan_addr + scan_size for the control
+    block with VENDOR_ID_RTT_FIND and then polls the channels with
+    VENDOR_ID_RTT_POLL, passing up data to tx and data from rx down. The
+    requests are executed between those of the debugger, which finds its
+    SELECT, CSW and TAR untouched.
+
+    tx and rx can be block streams: a poll passes up no more than one write
+    to tx takes, and a block of rx is read when all of it is down.
+
+    Polling goes on back to back while data moves and slows down to
+    RTT_POLL_MAX_US while the target is quiet. A control block that turns
+    invalid, after a reset of the target, is looked for again. While no
+    debugger has a port connected, SWD is connected by the RTT host itself,
+    and disconnected again if no target answers.
+*/
+typedef struct dap_rtt_t {
+    // set up before dap_rtt_start()
+    uint8_t ap;
+    uint8_t up_channel;
+    uint8_t down_channel;
+    uint32_t scan_addr;
+    uint32_t scan_size;
+    vsf_stream_t *tx;               // up channel data
+    vsf_stream_t *rx;               // down channel data
+
+    dap_t *dap;
+    dap_client_t client;
+    vsf_callback_timer_t timer;
+    uint8_t state;
+    bool busy;                      // request with the dap engine or timer running
+    uint32_t addr;                  // next address to scan
+    uint32_t cb;                    // control block found
+    uint32_t interval_us;           // next wait while the target is quiet
+    uint16_t down_size;             // rx block on the way down
+    uint16_t down_pos;              // of it on the target
+} dap_rtt_t;
+
+void dap_rtt_init(dap_rtt_t *rtt, dap_t *dap);
+void dap_rtt_start(dap_rtt_t *rtt);
+void dap_rtt_stop(dap_rtt_t *rtt);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __DAP_RTT_H__
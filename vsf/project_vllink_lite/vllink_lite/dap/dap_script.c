@@ -0,0 +1,368 @@
+#include "vsf.h"
+#include "dap.h"
+#include "dap_vendor.h"
+#include "dap_script.h"
+
+#if VENDOR_SCRIPT
+#define __VSFVM_RUNTIME_CLASS_INHERIT__
+#include "component/3rd-party/vsfvm/raw/runtime/vsfvm_runtime.h"
+
+#define SCRIPT_ARG_NUM                  8
+
+// poll() backoff between reads, as VENDOR_ID_MEM_POLL
+#define SCRIPT_POLL_DELAY_MIN_US        8
+#define SCRIPT_POLL_DELAY_MAX_US        1024
+
+#define SCRIPT_REQUEST_MASK             (DAP_TRANSFER_APnDP | DAP_TRANSFER_A2 | DAP_TRANSFER_A3)
+
+// function ids of the "dap" extension, the host compiler has to use the same
+enum {
+    SCRIPT_FUNC_SWD_READ = 0,
+    SCRIPT_FUNC_SWD_WRITE,
+    SCRIPT_FUNC_POLL,
+    SCRIPT_FUNC_DELAY,
+    SCRIPT_FUNC_PINS,
+    SCRIPT_FUNC_RESULT,
+    SCRIPT_FUNC_ARG,
+    SCRIPT_FUNC_NUM,
+};
+
+typedef struct dap_script_t {
+    vsfvm_ext_t ext;
+    vsfvm_runtime_t runtime;
+    vsfvm_runtime_script_t script;
+    vsfvm_thread_t thread;          // the only one, scripts can not start others
+    vsfvm_thread_t *running;        // NULL if no script is started
+    bool thread_used;
+    bool full;                      // result() waits for the next part
+    bool select_set;                // the script wrote DP SELECT
+    uint32_t select;
+    uint8_t status;                 // DAP_TRANSFER_xxx, the first failure
+    uint8_t argc;
+    uint16_t size;                  // bytes loaded
+    dap_param_t* param;
+    uint8_t* result;                // RESULTS of the part being filled
+    uint16_t result_len;
+    uint16_t result_size;
+    uint32_t argv[SCRIPT_ARG_NUM];
+    uint32_t code[VENDOR_SCRIPT_SIZE / 4];
+} dap_script_t;
+
+static dap_script_t dap_script;
+
+// the first access that fails ends the script
+static vsfvm_ret_t script_fail(uint32_t ack)
+{
+    dap_script.status = ack;
+    return VSFVM_RET_ERROR;
+}
+
+static bool script_args(vsfvm_thread_t *thread, uint32_t* value, uint8_t num)
+{
+    vsfvm_var_t *var;
+    uint8_t i;
+
+    for (i = 0; i < num; i++) {
+        var = vsfvm_get_func_argu_ref(thread, i);
+        if (!var)
+            return false;
+        value[i] = var->uval32;
+    }
+    return true;
+}
+
+static vsfvm_ret_t script_return(vsfvm_thread_t *thread, uint32_t value)
+{
+    vsfvm_var_set(thread, vsfvm_get_func_argu(thread, 0), VSFVM_VAR_TYPE_VALUE, value);
+    return VSFVM_RET_FINISHED;
+}
+
+static uint32_t script_read(uint32_t request, uint32_t* data)
+{
+    dap_param_t* param = dap_script.param;
+    uint32_t ack;
+
+    request = (request & SCRIPT_REQUEST_MASK) | DAP_TRANSFER_RnW;
+    ack = dap_vendor_transfer(param, request, data);
+    // posted, the data comes with RDBUFF
+    if ((ack == DAP_TRANSFER_OK) && ((request & DAP_TRANSFER_APnDP) || (param->port == DAP_PORT_JTAG)))
+        ack = dap_vendor_transfer(param, DP_RDBUFF | DAP_TRANSFER_RnW, data);
+    return ack;
+}
+
+static vsfvm_ret_t script_swd_read(vsfvm_thread_t *thread)
+{
+    uint32_t arg[1], ack, data;
+
+    if (!script_args(thread, arg, 1))
+        return VSFVM_RET_ERROR;
+    ack = script_read(arg[0], &data);
+    if (ack != DAP_TRANSFER_OK)
+        return script_fail(ack);
+    return script_return(thread, data);
+}
+
+static vsfvm_ret_t script_swd_write(vsfvm_thread_t *thread)
+{
+    uint32_t arg[2], ack;
+
+    if (!script_args(thread, arg, 2))
+        return VSFVM_RET_ERROR;
+    ack = dap_vendor_transfer(dap_script.param, arg[0] & SCRIPT_REQUEST_MASK, &arg[1]);
+    if (ack != DAP_TRANSFER_OK)
+        return script_fail(ack);
+    if ((arg[0] & SCRIPT_REQUEST_MASK) == DP_SELECT) {
+        dap_script.select = arg[1];
+        dap_script.select_set = true;
+    }
+    return VSFVM_RET_FINISHED;
+}
+
+static vsfvm_ret_t script_poll(vsfvm_thread_t *thread)
+{
+    dap_param_t* param = dap_script.param;
+    uint32_t arg[4], ack, data, delay_us = SCRIPT_POLL_DELAY_MIN_US;
+    vsf_systimer_cnt_t start, elapsed, next, timeout;
+
+    if (!script_args(thread, arg, 4))
+        return VSFVM_RET_ERROR;
+
+    start = vsf_systimer_get_tick();
+    timeout = vsf_systimer_us_to_tick(arg[3]);
+    while (1) {
+        ack = script_read(arg[0], &data);
+        if (ack != DAP_TRANSFER_OK)
+            return script_fail(ack);
+        elapsed = vsf_systimer_get_tick() - start;
+        // a timeout is left to the script, it sees the data
+        if (((data & arg[1]) == arg[2]) || (elapsed >= timeout))
+            break;
+        if (param->do_abort)
+            return script_fail(DAP_TRANSFER_ERROR);
+
+        next = min(elapsed + vsf_systimer_us_to_tick(delay_us), timeout);
+        while (((vsf_systimer_get_tick() - start) < next) && !param->do_abort);
+        delay_us = min(delay_us * 2, SCRIPT_POLL_DELAY_MAX_US);
+    }
+    return script_return(thread, data);
+}
+
+static vsfvm_ret_t script_delay(vsfvm_thread_t *thread)
+{
+    uint32_t arg[1];
+    vsf_systimer_cnt_t start, delay;
+
+    if (!script_args(thread, arg, 1))
+        return VSFVM_RET_ERROR;
+    // DAP_TransferAbort ends the script with the next token
+    start = vsf_systimer_get_tick();
+    delay = vsf_systimer_us_to_tick(arg[0]);
+    while (((vsf_systimer_get_tick() - start) < delay) && !dap_script.param->do_abort);
+    return VSFVM_RET_FINISHED;
+}
+
+static vsfvm_ret_t script_pins(vsfvm_thread_t *thread)
+{
+    uint32_t arg[3];
+
+    if (!script_args(thread, arg, 3))
+        return VSFVM_RET_ERROR;
+    return script_return(thread, dap_swj_pins(dap_script.param, arg[0], arg[1], arg[2]));
+}
+
+// called again with the next part if this one is full
+static vsfvm_ret_t script_result(vsfvm_thread_t *thread)
+{
+    uint32_t arg[1];
+
+    if (!script_args(thread, arg, 1))
+        return VSFVM_RET_ERROR;
+    if (dap_script.result_len + 4 > dap_script.result_size) {
+        dap_script.full = true;
+        return VSFVM_RET_PEND;
+    }
+    put_unaligned_le32(arg[0], dap_script.result + dap_script.result_len);
+    dap_script.result_len += 4;
+    return VSFVM_RET_FINISHED;
+}
+
+static vsfvm_ret_t script_arg(vsfvm_thread_t *thread)
+{
+    uint32_t arg[1];
+
+    if (!script_args(thread, arg, 1) || (arg[0] >= dap_script.argc))
+        return VSFVM_RET_ERROR;
+    return script_return(thread, dap_script.argv[arg[0]]);
+}
+
+static const vsfvm_extfunc_t script_func[SCRIPT_FUNC_NUM] = {
+    [SCRIPT_FUNC_SWD_READ]  = VSFVM_EXTFUNC(script_swd_read, 1),
+    [SCRIPT_FUNC_SWD_WRITE] = VSFVM_EXTFUNC(script_swd_write, 2),
+    [SCRIPT_FUNC_POLL]      = VSFVM_EXTFUNC(script_poll, 4),
+    [SCRIPT_FUNC_DELAY]     = VSFVM_EXTFUNC(script_delay, 1),
+    [SCRIPT_FUNC_PINS]      = VSFVM_EXTFUNC(script_pins, 3),
+    [SCRIPT_FUNC_RESULT]    = VSFVM_EXTFUNC(script_result, 1),
+    [SCRIPT_FUNC_ARG]       = VSFVM_EXTFUNC(script_arg, 1),
+};
+
+#if VSFVM_CFG_COMPILER_EN == ENABLED
+extern const vsfvm_ext_op_t dap_script_op;
+static const vsfvm_lexer_sym_t script_sym[] = {
+    VSFVM_LEXERSYM_EXTFUNC("swd_read", &dap_script_op, NULL, NULL, 1, SCRIPT_FUNC_SWD_READ),
+    VSFVM_LEXERSYM_EXTFUNC("swd_write", &dap_script_op, NULL, NULL, 2, SCRIPT_FUNC_SWD_WRITE),
+    VSFVM_LEXERSYM_EXTFUNC("poll", &dap_script_op, NULL, NULL, 4, SCRIPT_FUNC_POLL),
+    VSFVM_LEXERSYM_EXTFUNC("delay", &dap_script_op, NULL, NULL, 1, SCRIPT_FUNC_DELAY),
+    VSFVM_LEXERSYM_EXTFUNC("pins", &dap_script_op, NULL, NULL, 3, SCRIPT_FUNC_PINS),
+    VSFVM_LEXERSYM_EXTFUNC("result", &dap_script_op, NULL, NULL, 1, SCRIPT_FUNC_RESULT),
+    VSFVM_LEXERSYM_EXTFUNC("arg", &dap_script_op, NULL, NULL, 1, SCRIPT_FUNC_ARG),
+};
+#endif
+
+const vsfvm_ext_op_t dap_script_op = {
+#if VSFVM_CFG_COMPILER_EN == ENABLED
+    .name = "dap",
+    .sym = script_sym,
+    .sym_num = dimof(script_sym),
+#endif
+    .init = NULL,
+    .fini = NULL,
+    .func = script_func,
+    .func_num = dimof(script_func),
+};
+
+// the runtime allocates threads and reads the bytecode through these
+vsfvm_thread_t * vsfvm_alloc_thread_imp(vsfvm_runtime_t *runtime)
+{
+    if (dap_script.thread_used)
+        return NULL;
+    dap_script.thread_used = true;
+    return &dap_script.thread;
+}
+
+void vsfvm_free_thread_imp(vsfvm_runtime_t *runtime, vsfvm_thread_t *thread)
+{
+    dap_script.thread_used = false;
+}
+
+vsfvm_bytecode_t vsfvm_get_bytecode_imp(const void *token, uint_fast32_t *pc)
+{
+    const uint32_t *code = token;
+
+    // also stops a loop without accesses
+    if (dap_script.param->do_abort) {
+        if (dap_script.status == DAP_TRANSFER_OK)
+            dap_script.status = DAP_TRANSFER_ERROR;
+        return VSFVM_EOF();
+    }
+    if (*pc >= dap_script.size / 4)
+        return VSFVM_EOF();
+    return code[(*pc)++];
+}
+
+void dap_script_init(void)
+{
+    memset(&dap_script, 0, sizeof(dap_script));
+    dap_script.ext.op = &dap_script_op;
+    vsfvm_register_ext(&dap_script.ext);
+}
+
+// OFFSET 0 starts a new script, the following data has to continue it
+bool dap_script_load(uint16_t offset, uint8_t* data, uint16_t length)
+{
+    dap_script_stop();
+    if (!offset)
+        dap_script.size = 0;
+    if ((offset != dap_script.size) || (length > VENDOR_SCRIPT_SIZE - offset))
+        return false;
+    memcpy((uint8_t *)dap_script.code + offset, data, length);
+    dap_script.size += length;
+    return true;
+}
+
+uint16_t dap_script_size(void)
+{
+    return dap_script.size;
+}
+
+bool dap_script_start(dap_param_t* param, uint8_t argc, uint8_t* argv)
+{
+    uint8_t i;
+
+    dap_script_stop();
+    if (!dap_script.size || (dap_script.size & 0x3) || (argc > SCRIPT_ARG_NUM))
+        return false;
+
+    for (i = 0; i < argc; i++)
+        dap_script.argv[i] = get_unaligned_le32(argv + 4 * i);
+    dap_script.argc = argc;
+    dap_script.param = param;
+    dap_script.status = DAP_TRANSFER_OK;
+    dap_script.select_set = false;
+    memset(&dap_script.runtime, 0, sizeof(dap_script.runtime));
+    memset(&dap_script.script, 0, sizeof(dap_script.script));
+    dap_script.script.token = dap_script.code;
+    dap_script.running = vsfvm_thread_init(&dap_script.runtime, &dap_script.script,
+            0, 0, NULL, NULL);
+    return dap_script.running != NULL;
+}
+
+// STATUS, MORE, RESULT LENGTH and RESULTS of one response
+uint16_t dap_script_run(uint8_t* response, uint16_t remaining_size)
+{
+    vsfvm_ret_t ret;
+    bool more = false;
+
+    if (remaining_size < 4) {
+        dap_script_stop();
+        return 0;
+    }
+
+    dap_script.result = response + 4;
+    dap_script.result_size = (remaining_size - 4) & ~0x3;
+    dap_script.result_len = 0;
+    dap_script.full = false;
+    if (dap_script.running) {
+        ret = vsfvm_thread_run(&dap_script.runtime, dap_script.running);
+        if ((ret == VSFVM_RET_PEND) && dap_script.full) {
+            more = true;
+        } else {
+            // bad bytecode, a breakpoint or a thread
+            if ((ret != VSFVM_RET_FINISHED) && (dap_script.status == DAP_TRANSFER_OK))
+                dap_script.status = DAP_TRANSFER_ERROR;
+            dap_script_stop();
+        }
+    }
+
+    response[0] = more ? DAP_TRANSFER_OK : dap_script.status;
+    response[1] = more;
+    put_unaligned_le16(dap_script.result_len, response + 2);
+    return 4 + dap_script.result_len;
+}
+
+// requests of other clients ran since the last part, they may have moved SELECT
+void dap_script_resume(void)
+{
+    uint32_t ack, data = dap_script.select;
+
+    if (dap_script.running && dap_script.select_set) {
+        ack = dap_vendor_transfer(dap_script.param, DP_SELECT, &data);
+        if (ack != DAP_TRANSFER_OK) {
+            dap_script.status = ack;
+            dap_script_stop();
+        }
+    }
+}
+
+bool dap_script_pending(void)
+{
+    return dap_script.running != NULL;
+}
+
+void dap_script_stop(void)
+{
+    if (dap_script.running) {
+        dap_script.running = NULL;
+        vsfvm_runtime_script_fini(&dap_script.runtime, &dap_script.script);
+    }
+}
+#endif
@@ -0,0 +1,43 @@
+#ifndef __DAP_SCRIPT_H__
+#define __DAP_SCRIPT_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if VENDOR_SCRIPT
+/*
+    vsfvm scripts of DAP accesses, loaded with VENDOR_ID_SCRIPT_LOAD and run
+    by VENDOR_ID_SCRIPT_RUN of dap_vendor.c. The bytecode is compiled on the
+    host with the "dap" extension registered as the only one, the probe has
+    no compiler:
+
+        swd_read(request)                   DP/AP register, returns the data
+        swd_write(request, data)
+        poll(request, mask, match, timeout_us)
+                                            reads until (data & mask) == match
+                                            or timeout_us, returns the last data
+        delay(us)
+        pins(value, select, wait_us)        as DAP_SWJ_Pins, returns the pins
+        result(data)                        4 bytes to the host
+        arg(index)                          argument of VENDOR_ID_SCRIPT_RUN
+
+    request is A2, A3 and APnDP of a DAP_Transfer request, on SWD and JTAG.
+    Reads return the data of this access, posted reads are completed with
+    DP RDBUFF. The first access that fails ends the script with its ack.
+*/
+void dap_script_init(void);
+bool dap_script_load(uint16_t offset, uint8_t* data, uint16_t length);
+uint16_t dap_script_size(void);
+bool dap_script_start(dap_param_t* param, uint8_t argc, uint8_t* argv);
+uint16_t dap_script_run(uint8_t* response, uint16_t remaining_size);
+void dap_script_resume(void);
+bool dap_script_pending(void);
+void dap_script_stop(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __DAP_SCRIPT_H__
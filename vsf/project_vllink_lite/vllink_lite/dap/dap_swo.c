@@ -2,6 +2,24 @@
 #include "dap.h"
 
 #if SWO_UART || SWO_MANCHESTER
+// error bits are reported once, then cleared
+static uint8_t get_trace_status(dap_param_t* param)
+{
+    uint8_t status;
+
+    #if SWO_UART
+    if (param->get_usart_dropped && param->get_usart_dropped(PERIPHERAL_UART_SWO_IDX))
+        param->trace_status |= DAP_SWO_BUFFER_OVERRUN;
+    #endif
+    #if SWO_MANCHESTER
+    if (param->get_manchester_dropped && param->get_manchester_dropped())
+        param->trace_status |= DAP_SWO_BUFFER_OVERRUN;
+    #endif
+    status = param->trace_status;
+    param->trace_status &= ~(DAP_SWO_STREAM_ERROR | DAP_SWO_BUFFER_OVERRUN);
+    return status;
+}
+
 uint32_t dap_swo_request_handler(dap_param_t* param, uint8_t* request,
         uint8_t* response, uint8_t cmd_id, uint16_t remaining_size)
 {
@@ -25,8 +43,14 @@ uint32_t dap_swo_request_handler(dap_param_t* param, uint8_t* request,
     } break;
     case ID_DAP_SWO_Mode: {
         uint8_t mode = request[req_ptr++];
-        // Note: not support DAP_SWO_MANCHESTER
-        if ((mode == DAP_SWO_OFF) || (mode == DAP_SWO_UART)) {
+        if (param->trace_status & DAP_SWO_CAPTURE_ACTIVE) {
+            // capture is stopped by the mode it was started with
+            response[resp_ptr++] = DAP_ERROR;
+        #if SWO_MANCHESTER
+        } else if ((mode == DAP_SWO_OFF) || (mode == DAP_SWO_UART) || (mode == DAP_SWO_MANCHESTER)) {
+        #else
+        } else if ((mode == DAP_SWO_OFF) || (mode == DAP_SWO_UART)) {
+        #endif
             param->trace_mode = mode;
             response[resp_ptr++] = DAP_OK;
         } else {
@@ -37,12 +61,23 @@ uint32_t dap_swo_request_handler(dap_param_t* param, uint8_t* request,
     case ID_DAP_SWO_Baudrate: {
         uint32_t baudrate = get_unaligned_le32(request + req_ptr);
         req_ptr += 4;
-        if (baudrate > SWO_UART_MAX_BAUDRATE)
-            baudrate = SWO_UART_MAX_BAUDRATE;
-        else if (baudrate < SWO_UART_MIN_BAUDRATE)
-            baudrate = SWO_UART_MIN_BAUDRATE;
-        if (param->get_usart_baud)
-            baudrate = param->get_usart_baud(PERIPHERAL_UART_SWO_IDX, baudrate);
+        #if SWO_MANCHESTER
+        // the decoder follows the bit clock of the target, no rounding
+        if (param->trace_mode == DAP_SWO_MANCHESTER) {
+            if (baudrate > SWO_MANCHESTER_MAX_BAUDRATE)
+                baudrate = SWO_MANCHESTER_MAX_BAUDRATE;
+            else if (baudrate < SWO_MANCHESTER_MIN_BAUDRATE)
+                baudrate = SWO_MANCHESTER_MIN_BAUDRATE;
+        } else
+        #endif
+        {
+            if (baudrate > SWO_UART_MAX_BAUDRATE)
+                baudrate = SWO_UART_MAX_BAUDRATE;
+            else if (baudrate < SWO_UART_MIN_BAUDRATE)
+                baudrate = SWO_UART_MIN_BAUDRATE;
+            if (param->get_usart_baud)
+                baudrate = param->get_usart_baud(PERIPHERAL_UART_SWO_IDX, baudrate);
+        }
         #if (SWO_UART != 0)
         param->swo_baudrate = baudrate;
         #endif
@@ -58,13 +93,40 @@ uint32_t dap_swo_request_handler(dap_param_t* param, uint8_t* request,
                 #if TIMESTAMP_CLOCK
                 param->trace_timestamp = 0;
                 #endif
-                if (param->config_usart) {
-                    param->config_usart(PERIPHERAL_UART_SWO_IDX, &mode, &param->swo_baudrate, NULL, (vsf_stream_t *)&param->swo_rx, true);
+                #if SWO_STREAM
+                param->swo_stream_size = 0;
+                #endif
+                #if VENDOR_UART && SWO_UART
+                dap_vendor_usart_release_swo(param);
+                #endif
+                VSF_STREAM_READ(&param->swo_rx, NULL, VSF_STREAM_GET_DATA_SIZE(&param->swo_rx));
+                #if SWO_MANCHESTER
+                if (param->trace_mode == DAP_SWO_MANCHESTER) {
+                    if (param->get_manchester_dropped)
+                        param->get_manchester_dropped();
+                    if (param->config_manchester)
+                        param->config_manchester(param->swo_baudrate, (vsf_stream_t *)&param->swo_rx);
+                } else
+                #endif
+                {
+                    if (param->get_usart_dropped)
+                        param->get_usart_dropped(PERIPHERAL_UART_SWO_IDX);
+                    if (param->config_usart) {
+                        param->config_usart(PERIPHERAL_UART_SWO_IDX, &mode, &param->swo_baudrate, NULL, (vsf_stream_t *)&param->swo_rx, true);
+                    }
                 }
                 VSF_STREAM_CONNECT_RX(&param->swo_rx);
             } else {
                 VSF_STREAM_DISCONNECT_RX(&param->swo_rx);
-                param->config_usart(PERIPHERAL_UART_SWO_IDX, NULL, NULL, NULL, NULL, false);
+                #if SWO_MANCHESTER
+                if (param->trace_mode == DAP_SWO_MANCHESTER) {
+                    if (param->config_manchester)
+                        param->config_manchester(0, NULL);
+                } else
+                #endif
+                {
+                    param->config_usart(PERIPHERAL_UART_SWO_IDX, NULL, NULL, NULL, NULL, false);
+                }
             }
             param->trace_status = active;
         }
@@ -72,7 +134,7 @@ uint32_t dap_swo_request_handler(dap_param_t* param, uint8_t* request,
     } break;
     case ID_DAP_SWO_Status: {
         uint32_t count = VSF_STREAM_GET_DATA_SIZE(&param->swo_rx);
-        response[resp_ptr++] = param->trace_status;
+        response[resp_ptr++] = get_trace_status(param);
         put_unaligned_le32(count, response + resp_ptr);
         resp_ptr += 4;
     } break;
@@ -80,7 +142,7 @@ uint32_t dap_swo_request_handler(dap_param_t* param, uint8_t* request,
         uint8_t sb_cmd = request[req_ptr++];
 
         if (sb_cmd & 0x1)
-            response[resp_ptr++] = param->trace_status;
+            response[resp_ptr++] = get_trace_status(param);
         if (sb_cmd & 0x2) {
             uint32_t count = VSF_STREAM_GET_DATA_SIZE(&param->swo_rx);
             put_unaligned_le32(count, response + resp_ptr);
@@ -98,7 +160,7 @@ uint32_t dap_swo_request_handler(dap_param_t* param, uint8_t* request,
         int32_t count = min(get_unaligned_le16(request + req_ptr),
                 VSF_STREAM_GET_DATA_SIZE(&param->swo_rx));
         req_ptr += 2;
-        response[resp_ptr++] = param->trace_status;
+        response[resp_ptr++] = get_trace_status(param);
         if (param->transport != 1)	// Read trace data via DAP_SWO_Data command
             count = 0;
         if (count > (remaining_size - 3))
@@ -115,4 +177,40 @@ uint32_t dap_swo_request_handler(dap_param_t* param, uint8_t* request,
     }
     return ((uint32_t)resp_ptr << 16) | req_ptr;
 }
+
+#if SWO_UART && SWO_STREAM
+/*
+    Transport 2: the trace endpoint sends straight out of swo_rx. It takes
+    one contiguous block at a time and hands it back with dap_swo_stream_done
+    when the IN transfer has finished, swo_rx stays free for the UART.
+*/
+uint32_t dap_swo_stream_get(dap_param_t* param, uint8_t **buf)
+{
+    uint32_t size = 0;
+
+    if ((param->transport == 2) && (param->trace_status & DAP_SWO_CAPTURE_ACTIVE)
+            && !param->swo_stream_size) {
+        size = VSF_STREAM_GET_RBUF(&param->swo_rx, buf);
+        param->swo_stream_size = size;
+        // kept in swo_rx if the UART overruns it meanwhile
+        if (size && param->hold_usart_rx)
+            param->hold_usart_rx(PERIPHERAL_UART_SWO_IDX, size);
+    }
+    return size;
+}
+
+void dap_swo_stream_done(dap_param_t* param)
+{
+    uint32_t size = param->swo_stream_size;
+
+    // size is dropped when capture restarts with a transfer still pending
+    if (size) {
+        param->swo_stream_size = 0;
+        VSF_STREAM_READ(&param->swo_rx, NULL, size);
+        if (param->hold_usart_rx)
+            param->hold_usart_rx(PERIPHERAL_UART_SWO_IDX, 0);
+        param->trace_o += size;
+    }
+}
+#endif  // SWO_UART && SWO_STREAM
 #endif
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "vsf.h"
 #include "dap.h"
+#include "dap_vendor.h"
+#include "dap_script.h"
 
 enum vender_id_rename_t {
     VENDOR_ID_GET_USART_INFO        = ID_DAP_Vendor0,
@@ -8,8 +10,112 @@ enum vender_id_rename_t {
     VENDOR_ID_GET_USART_STATUS      = ID_DAP_Vendor3,
     VENDOR_ID_READ_USART_DATA       = ID_DAP_Vendor4,
     VENDOR_ID_WRITE_USART_DATA      = ID_DAP_Vendor5,
+    VENDOR_ID_MEM_READ              = ID_DAP_Vendor6,
+    VENDOR_ID_MEM_WRITE             = ID_DAP_Vendor7,
+    VENDOR_ID_FLASH_SETUP           = ID_DAP_Vendor8,
+    VENDOR_ID_FLASH_INIT            = ID_DAP_Vendor9,
+    VENDOR_ID_FLASH_UNINIT          = ID_DAP_Vendor10,
+    VENDOR_ID_FLASH_ERASE           = ID_DAP_Vendor11,
+    VENDOR_ID_FLASH_PROGRAM         = ID_DAP_Vendor12,
+    VENDOR_ID_MEM_POLL              = ID_DAP_Vendor13,
+    VENDOR_ID_STATS                 = ID_DAP_Vendor14,
+    VENDOR_ID_SWD_ADAPT             = ID_DAP_Vendor15,
+    VENDOR_ID_RTT_FIND              = ID_DAP_Vendor16,
+    VENDOR_ID_RTT_POLL              = ID_DAP_Vendor17,
+    VENDOR_ID_MEM_CRC               = ID_DAP_Vendor18,
+    VENDOR_ID_SWD_TARGETSEL         = ID_DAP_Vendor19,
+    VENDOR_ID_SCRIPT_LOAD           = ID_DAP_Vendor20,
+    VENDOR_ID_SCRIPT_RUN            = ID_DAP_Vendor21,
+    VENDOR_ID_SWD_CACHE             = ID_DAP_Vendor22,
 };
 
+// MEM-AP registers, bank 0
+#define AP_CSW                          0x00U
+#define AP_TAR                          0x04U
+#define AP_DRW                          0x0CU
+
+#define CSW_SIZE_MASK                   0x00000007UL
+#define CSW_ADDRINC_MASK                0x00000030UL
+#define CSW_ADDRINC_SINGLE              0x00000010UL
+#define CSW_MODE_MASK                   0x00000F00UL
+
+#define CTRL_STAT_STICKY_MASK           0x000000B2UL    // STICKYORUN, STICKYCMP, STICKYERR, WDATAERR
+#define ABORT_CLEAR_STICKY              0x0000001EUL    // STKCMPCLR, STKERRCLR, WDERRCLR, ORUNERRCLR
+
+// TAR auto-increment is only guaranteed inside a 1KB block
+#define TAR_WRAP_SIZE                   0x400UL
+
+// Cortex-M core debug, DHCSR/DCRSR/DCRDR are BD0-BD2 with TAR at DHCSR
+#define SELECT_APBANK_BD                0x00000010UL
+#define AP_BD_DHCSR                     0x00U
+#define AP_BD_DCRSR                     0x04U
+#define AP_BD_DCRDR                     0x08U
+
+#define DHCSR                           0xE000EDF0UL
+#define DHCSR_DBGKEY                    0xA05F0000UL
+#define DHCSR_C_DEBUGEN                 0x00000001UL
+#define DHCSR_C_HALT                    0x00000002UL
+#define DHCSR_S_REGRDY                  0x00010000UL
+#define DHCSR_S_HALT                    0x00020000UL
+#define DCRSR_REGWNR                    0x00010000UL
+#define DCRSR_REGRDY_RETRY              100
+
+#define CORE_REG_R0                     0U
+#define CORE_REG_R1                     1U
+#define CORE_REG_R2                     2U
+#define CORE_REG_R9                     9U
+#define CORE_REG_SP                     13U
+#define CORE_REG_LR                     14U
+#define CORE_REG_PC                     15U
+#define CORE_REG_XPSR                   16U
+#define XPSR_T                          0x01000000UL
+
+// VENDOR_ID_MEM_POLL backoff between reads
+#define POLL_DELAY_MIN_US               8
+#define POLL_DELAY_MAX_US               1024
+
+// VENDOR_ID_STATS operations
+#define STATS_READ_SUMMARY              0
+#define STATS_READ_COMMANDS             1
+#define STATS_CLEAR                     2
+#define STATS_CMD_ENTRY_SIZE            17
+
+// VENDOR_ID_SWD_ADAPT modes
+#define SWD_ADAPT_OFF                   0
+#define SWD_ADAPT_ON                    1
+#define SWD_ADAPT_QUERY                 0xFF
+
+// VENDOR_ID_SWD_CACHE modes
+#define SWD_CACHE_OFF                   0
+#define SWD_CACHE_ON                    1
+#define SWD_CACHE_QUERY                 0xFF
+
+// SEGGER RTT control block: acID[16], MaxNumUpBuffers, MaxNumDownBuffers,
+// then the buffer descriptors, up ones first
+#define RTT_ID0                         0x47474553UL    // "SEGG"
+#define RTT_ID1                         0x52205245UL    // "ER R"
+#define RTT_ID2                         0x00005454UL    // "TT\0"
+#define RTT_ID2_MASK                    0x00FFFFFFUL
+#define RTT_CB_SIZE                     24
+#define RTT_DESC_SIZE                   24              // sName, pBuffer, SizeOfBuffer, WrOff, RdOff, Flags
+#define RTT_DESC_WROFF                  12
+#define RTT_DESC_RDOFF                  16
+#define RTT_FIND_MAX                    TAR_WRAP_SIZE   // scanned by one VENDOR_ID_RTT_FIND
+#define RTT_FIND_CHUNK                  64
+
+// VENDOR_ID_SWD_TARGETSEL, write DP 0xC: start, A2, A3, park
+#define SWD_TARGETSEL_REQUEST           0x99U
+
+// USART STATUS
+#define USART_STATUS_RX_DATA_MASK       0x0000FFFFUL
+#define USART_STATUS_TX_FREE_POS        16
+#define USART_STATUS_TX_FREE_MASK       0x3FFF0000UL
+#define USART_STATUS_RX_OVERRUN         0x40000000UL
+#define USART_STATUS_OPEN               0x80000000UL
+
+#define USART_VALID_CFG                 (PERIPHERAL_UART_PARITY_ODD | PERIPHERAL_UART_PARITY_EVEN \
+                                            | PERIPHERAL_UART_STOPBITS_1P5 | PERIPHERAL_UART_STOPBITS_2)
+
 /*
 VENDOR_ID_GET_USART_INFO:
     Request:                            Response:
@@ -70,35 +176,1958 @@ VENDOR_ID_WRITE_USART_DATA:
     WRITE1_LENGTH   [2 byte]            WRITE0_STATUS       [4 byte]
     WRITE1_DATA     [{LENGTH} byte]     ...
     ...
+
+    USART IDX is VENDOR_USART_EXT, or VENDOR_USART_SWO on probes with a SWO
+    UART, USART NUM the number of them. CFG is a PERIPHERAL_UART_xxx mode,
+    VALID_CFG the bits that may be set in it. SET_USART_CFG opens the port
+    with data going through ext_tx / ext_rx (swo_tx / swo_rx), BAUD 0
+    closes it, the actual settings are returned. The EXT UART is taken over
+    from the CDC interface until the host sets its line coding again, the
+    SWO UART is refused while SWO capture is active and closed by starting
+    it. STATUS is USART_STATUS_xxx: OPEN, RX_OVERRUN if received bytes were
+    lost since the last status, the free space of the tx buffer and the
+    bytes waiting in the rx buffer. An unknown or closed port returns
+    STATUS 0 and no data. READ / WRITE LENGTH is what was actually read or
+    buffered, reads are cut to what fits in the response packet. Entries
+    without room for their LENGTH and STATUS in the response are left out
+    of it, WRITE entries end at the first DATA past the request packet.
+    DAP_ERROR is returned for a bad USART IDX or CFG.
+
+VENDOR_ID_MEM_READ:
+    Request:                            Response (first):
+    CMD             [1 byte]            CMD                 [1 byte]
+    AP              [1 byte]            STATUS              [1 byte]
+    ACCESS SIZE     [1 byte]            DATA LENGTH         [2 byte]
+    ADDRESS         [4 byte]            DATA                [{DATA LENGTH} byte]
+    LENGTH          [4 byte]
+                                        Response (following, while LENGTH not reached):
+                                        CMD                 [1 byte]
+                                        STATUS              [1 byte]
+                                        DATA LENGTH         [2 byte]
+                                        DATA                [{DATA LENGTH} byte]
+
+VENDOR_ID_MEM_WRITE:
+    Request:                            Response:
+    CMD             [1 byte]            CMD                 [1 byte]
+    AP              [1 byte]            STATUS              [1 byte]
+    ACCESS SIZE     [1 byte]            WRITE LENGTH        [2 byte]
+    ADDRESS         [4 byte]
+    LENGTH          [2 byte]
+    DATA            [{LENGTH} byte]
+
+    ACCESS SIZE is 1, 2 or 4, ADDRESS and LENGTH are aligned to it. DATA is
+    packed, byte and halfword lanes are handled by the probe. DATA of
+    VENDOR_ID_MEM_WRITE has to be in the packet.
+    STATUS is a DAP_Transfer response: DAP_TRANSFER_OK, or DAP_TRANSFER_WAIT /
+    DAP_TRANSFER_FAULT from the target, or DAP_TRANSFER_ERROR for a bad
+    request or DAP_TransferAbort. A response with STATUS other than OK is the
+    last one, DATA LENGTH / WRITE LENGTH only covers data known to be good.
+    Sticky errors are cleared before a FAULT is returned. On JTAG the device
+    index of the last DAP_Transfer is used.
+    VENDOR_ID_MEM_READ must be the last command in a packet, commands after it
+    are dropped. SELECT and CSW are left as set up for the access. Requests
+    of other clients may be executed between the responses, SELECT and CSW
+    are set up again after them. Meanwhile the memory commands, SCRIPT_LOAD
+    and SCRIPT_RUN of the other clients fail with DAP_TRANSFER_ERROR
+    (DAP_ERROR for SCRIPT_LOAD), as they do while a script is running.
+
+VENDOR_ID_FLASH_SETUP:
+    Request:                            Response:
+    CMD             [1 byte]            CMD                 [1 byte]
+    AP              [1 byte]            STATUS              [1 byte]
+    BREAKPOINT      [4 byte]            RESULT              [4 byte]
+    STATIC BASE     [4 byte]
+    STACK POINTER   [4 byte]
+    INIT            [4 byte]
+    UNINIT          [4 byte]
+    ERASE SECTOR    [4 byte]
+    PROGRAM PAGE    [4 byte]
+    BUFFER0         [4 byte]
+    BUFFER1         [4 byte]
+    PAGE SIZE       [4 byte]
+    TIMEOUT         [4 byte]
+
+VENDOR_ID_FLASH_INIT:
+    Request:                            Response:
+    CMD             [1 byte]            CMD                 [1 byte]
+    ADDRESS         [4 byte]            STATUS              [1 byte]
+    CLOCK           [4 byte]            RESULT              [4 byte]
+    FUNCTION        [1 byte]
+
+VENDOR_ID_FLASH_UNINIT:
+    Request:                            Response:
+    CMD             [1 byte]            CMD                 [1 byte]
+    FUNCTION        [1 byte]            STATUS              [1 byte]
+                                        RESULT              [4 byte]
+
+VENDOR_ID_FLASH_ERASE:
+    Request:                            Response:
+    CMD             [1 byte]            CMD                 [1 byte]
+    ADDRESS         [4 byte]            STATUS              [1 byte]
+    SECTOR SIZE     [4 byte]            RESULT              [4 byte]
+    SECTOR NUM      [2 byte]
+
+VENDOR_ID_FLASH_PROGRAM:
+    Request:                            Response:
+    CMD             [1 byte]            CMD                 [1 byte]
+    ADDRESS         [4 byte]            STATUS              [1 byte]
+    LENGTH          [2 byte]            RESULT              [4 byte]
+    DATA            [{LENGTH} byte]
+
+    The flash algorithm (CMSIS-Pack FLM, loaded with VENDOR_ID_MEM_WRITE) is
+    called with the FLM calling convention: R0-R2 arguments, R9 STATIC BASE,
+    SP STACK POINTER, LR BREAKPOINT, and the probe polls DHCSR for the halt
+    at BREAKPOINT, for at most TIMEOUT ms. SETUP halts the core, which must
+    stay halted by the host until UNINIT.
+    Page data of VENDOR_ID_FLASH_PROGRAM is collected in BUFFER0 / BUFFER1
+    in turn. A buffer is programmed once its page is complete, or data that
+    does not continue it arrives, and the next one is filled meanwhile.
+    LENGTH 0 programs the collected data and waits for all pages. ADDRESS and
+    LENGTH are word aligned, DATA has to be in the packet. INIT, UNINIT and ERASE wait for all pages too.
+    STATUS is the first error since SETUP or INIT: a DAP_Transfer response
+    from the wire, DAP_TRANSFER_MISMATCH with RESULT from R0 if a function
+    failed, or DAP_TRANSFER_ERROR for a bad request or a timeout.
+
+VENDOR_ID_MEM_POLL:
+    Request:                            Response:
+    CMD             [1 byte]            CMD                 [1 byte]
+    AP              [1 byte]            STATUS              [1 byte]
+    ADDRESS         [4 byte]            VALUE               [4 byte]
+    MASK            [4 byte]            ELAPSED             [4 byte]
+    MATCH           [4 byte]
+    TIMEOUT         [4 byte]
+
+    Reads the word at ADDRESS until (VALUE & MASK) == MATCH, or for TIMEOUT
+    us. The wait between reads starts at POLL_DELAY_MIN_US and doubles up to
+    POLL_DELAY_MAX_US. STATUS is as for DAP_Transfer, DAP_TRANSFER_MISMATCH
+    is set on timeout or DAP_TransferAbort. VALUE is the last value read,
+    ELAPSED the us from the start to that read.
+
+VENDOR_ID_STATS:
+    Request:                            Response (STATS_READ_SUMMARY):
+    CMD             [1 byte]            CMD                 [1 byte]
+    OPERATION       [1 byte]            DAP_OK              [1 byte]
+    INDEX           [1 byte]            TIMESTAMP CLOCK     [4 byte]
+                                        REQUESTS            [4 byte]
+                                        RESP WAIT TOTAL     [4 byte]
+                                        RESP WAIT MAX       [4 byte]
+                                        SWD RETRIES         [4 byte]
+                                        JTAG RETRIES        [4 byte]
+                                        SWD BYTES           [4 byte]
+                                        JTAG BYTES          [4 byte]
+                                        DEPTH NUM           [1 byte]
+                                        DEPTH0              [4 byte]
+                                        DEPTH1              [4 byte]
+                                        ...
+                                        SWD CACHED          [4 byte]
+
+                                        Response (STATS_READ_COMMANDS):
+                                        CMD                 [1 byte]
+                                        DAP_OK              [1 byte]
+                                        NEXT INDEX          [1 byte]
+                                        ENTRY NUM           [1 byte]
+                                        ENTRY0_ID           [1 byte]
+                                        ENTRY0_COUNT        [4 byte]
+                                        ENTRY0_MIN          [4 byte]
+                                        ENTRY0_MAX          [4 byte]
+                                        ENTRY0_TOTAL        [4 byte]
+                                        ...
+
+                                        Response (STATS_CLEAR):
+                                        CMD                 [1 byte]
+                                        DAP_OK              [1 byte]
+
+    Only available with DAP_STATS, DAP_ERROR is returned otherwise. Times are
+    in TIMESTAMP CLOCK ticks. DEPTHn counts the requests executed with n + 1
+    packets queued, up to DAP_ID_PACKET_COUNT. STATS_READ_COMMANDS returns
+    the commands executed at least once, starting at table INDEX (0x00 -
+    0x1F for commands 0x00 - 0x1F, 0x20 - 0x3F for ID_DAP_Vendor0 -
+    ID_DAP_Vendor31) and as many as fit in the packet, NEXT INDEX is where
+    to continue, 0x40 once the table is done. Average is TOTAL / COUNT.
+    SWD / JTAG BYTES count the data of the DP/AP accesses done by
+    DAP_Transfer, DAP_TransferBlock and the vendor memory commands. SWD
+    CACHED counts the writes of them left out by the SWD write cache.
+
+VENDOR_ID_SWD_ADAPT:
+    Request:                            Response:
+    CMD             [1 byte]            CMD                 [1 byte]
+    MODE            [1 byte]            DAP_OK              [1 byte]
+                                        MODE                [1 byte]
+                                        CLOCK               [4 byte]
+                                        IDLE CYCLES         [1 byte]
+                                        PARITY ERRORS       [4 byte]
+                                        WAIT RETRIES        [4 byte]
+
+    MODE is SWD_ADAPT_OFF, SWD_ADAPT_ON, or SWD_ADAPT_QUERY to leave it as
+    it is. With SWD_ADAPT_ON the probe lowers the SWD clock on parity errors
+    and raises it again up to DAP_SWJ_Clock when the wire stays clean, and
+    adds idle cycles above DAP_TransferConfigure while WAIT retries are
+    frequent, see swd_adapt() in dap.c. DAP_SWJ_Clock and
+    DAP_TransferConfigure start it over from the new settings. CLOCK (Hz, as
+    in DAP_SWJ_Clock, rounded down by the driver) and IDLE CYCLES are the
+    settings in use, PARITY ERRORS and WAIT RETRIES count since it was
+    switched. DAP_ERROR without SWD support.
+
+VENDOR_ID_RTT_FIND:
+    Request:                            Response:
+    CMD             [1 byte]            CMD                 [1 byte]
+    AP              [1 byte]            STATUS              [1 byte]
+    ADDRESS         [4 byte]            NEXT ADDRESS        [4 byte]
+    LENGTH          [4 byte]            CB ADDRESS          [4 byte]
+
+VENDOR_ID_RTT_POLL:
+    Request:                            Response:
+    CMD             [1 byte]            CMD                 [1 byte]
+    AP              [1 byte]            STATUS              [1 byte]
+    CB ADDRESS      [4 byte]            DOWN LENGTH         [2 byte]
+    UP CHANNEL      [1 byte]            UP PENDING          [4 byte]
+    UP LENGTH       [2 byte]            UP LENGTH           [2 byte]
+    DOWN CHANNEL    [1 byte]            UP DATA             [{UP LENGTH} byte]
+    DOWN LENGTH     [2 byte]
+    DOWN DATA       [{DOWN LENGTH} byte]
+
+    Only with VENDOR_RTT. RTT_FIND looks for the ID of the SEGGER RTT
+    control block in word aligned memory from ADDRESS, at most RTT_FIND_MAX
+    bytes of LENGTH per command. CB ADDRESS is the control block found, 0 if
+    none, the scan goes on from NEXT ADDRESS.
+    RTT_POLL first writes DOWN DATA to the down buffer, as far as it has
+    room, then reads at most UP LENGTH bytes from the up buffer, cut to what
+    fits in the response packet. DOWN LENGTH in the response is what was
+    written, UP PENDING the bytes left in the up buffer. DOWN LENGTH 0 leaves
+    the down buffer alone.
+    STATUS is as for DAP_Transfer, DAP_TRANSFER_MISMATCH if there is no
+    valid control block or channel at CB ADDRESS, DAP_TRANSFER_ERROR for a
+    bad request or DAP_TransferAbort, DAP_ERROR while no port is connected,
+    see dap_rtt.c. Both leave SELECT, CSW and TAR as
+    set by the host, so they can be mixed with its requests, sticky errors
+    are cleared before a FAULT is returned.
+
+VENDOR_ID_MEM_CRC:
+    Request:                            Response:
+    CMD             [1 byte]            CMD                 [1 byte]
+    AP              [1 byte]            STATUS              [1 byte]
+    ACCESS SIZE     [1 byte]            CRC LENGTH          [4 byte]
+    ADDRESS         [4 byte]            CRC                 [4 byte]
+    LENGTH          [4 byte]
+    CRC             [4 byte]
+
+    Only with VENDOR_CRC. Reads LENGTH bytes from ADDRESS like
+    VENDOR_ID_MEM_READ and returns their CRC-32 (as zlib crc32()) instead of
+    the data, to verify a flash image without reading it back. CRC in the
+    request is 0 to start or the result of the previous part of the image.
+    CRC LENGTH is the data covered by CRC, less than LENGTH if STATUS is not
+    OK. STATUS is as for VENDOR_ID_MEM_READ, SELECT and CSW are left as set
+    up for the access.
+
+VENDOR_ID_SWD_TARGETSEL:
+    Request:                            Response:
+    CMD             [1 byte]            CMD                 [1 byte]
+    TARGETSEL       [4 byte]            STATUS              [1 byte]
+                                        DPIDR               [4 byte]
+
+    Only with VENDOR_MULTIDROP, on the SWD port. Line reset, TARGETSEL write
+    and DPIDR read to select one target of an SWD multi-drop bus (DPv2).
+    STATUS is as for DAP_Transfer. With VENDOR_ID_SWD_CACHE on, the SWD
+    write cache (dap.c) keeps what VENDOR_MULTIDROP_NUM targets selected
+    this way hold, so switching back to a target does not set up its
+    SELECT, CSW and TAR again. Any SWJ or SWD sequence of the host, a new
+    port or nRESET drops what is known of all targets.
+
+VENDOR_ID_SCRIPT_LOAD:
+    Request:                            Response:
+    CMD             [1 byte]            CMD                 [1 byte]
+    OFFSET          [2 byte]            DAP_OK              [1 byte]
+    LENGTH          [2 byte]            SIZE                [2 byte]
+    DATA            [{LENGTH} byte]
+
+VENDOR_ID_SCRIPT_RUN:
+    Request:                            Response (first):
+    CMD             [1 byte]            CMD                 [1 byte]
+    ARG NUM         [1 byte]            STATUS              [1 byte]
+    ARG0            [4 byte]            MORE                [1 byte]
+    ARG1            [4 byte]            RESULT LENGTH       [2 byte]
+    ...                                 RESULTS             [{RESULT LENGTH} byte]
+
+                                        Response (following, while MORE is 1):
+                                        CMD                 [1 byte]
+                                        STATUS              [1 byte]
+                                        MORE                [1 byte]
+                                        RESULT LENGTH       [2 byte]
+                                        RESULTS             [{RESULT LENGTH} byte]
+
+    Only with VENDOR_SCRIPT. A vsfvm script of DP/AP accesses, delays and
+    pin changes runs on the probe, so a connect or unlock sequence with
+    loops and branches takes one request, see dap_script.h for what it can
+    call. SCRIPT_LOAD puts DATA, the bytecode as little endian words, at
+    OFFSET of the script buffer (VENDOR_SCRIPT_SIZE bytes). OFFSET 0 starts
+    a new script, others have to follow the data loaded so far, SIZE is the
+    size loaded. DAP_ERROR if the data does not fit or does not follow.
+    SCRIPT_RUN starts the script from the beginning with up to 8 arguments.
+    RESULTS are the words passed to result() by the script, a response that
+    is full has MORE set and the script goes on with the next one, other
+    requests may be executed in between and the last SELECT written by the
+    script is written again after them. STATUS of the last response is
+    DAP_TRANSFER_OK, the ack of the first access that failed (sticky
+    errors are left to the host), or DAP_TRANSFER_ERROR for a bad script or
+    request, or DAP_TransferAbort. On JTAG the device index of the last
+    DAP_Transfer is used.
+
+VENDOR_ID_SWD_CACHE:
+    Request:                            Response:
+    CMD             [1 byte]            CMD                 [1 byte]
+    MODE            [1 byte]            DAP_OK              [1 byte]
+                                        MODE                [1 byte]
+
+    MODE is SWD_CACHE_OFF, SWD_CACHE_ON, or SWD_CACHE_QUERY to leave it as
+    it is. With SWD_CACHE_ON, DAP_Transfer and the vendor commands leave out
+    SWD writes of SELECT, CSW and TAR the target holds already, see the SWD
+    write cache in dap.c. Switching drops what is known of all targets. A
+    host that resets the target behind the probe has to switch it off, or
+    on again after the reset. SWD CACHED of VENDOR_ID_STATS counts the
+    writes left out. DAP_ERROR without SWD support.
 */
 
-// TODO
-uint32_t dap_vendor_request_handler(dap_param_t* param, uint8_t* request,
+static uint8_t vendor_jtag_ir;
+
+// LENGTH bytes of DATA after a HEADER have to be in the request packet
+static bool vendor_data_fits(uint16_t request_size, uint16_t header, uint32_t length)
+{
+    return (request_size >= header) && (length <= (uint32_t)(request_size - header));
+}
+
+#if VENDOR_UART
+static const struct {
+    enum usart_idx_t idx;
+    uint32_t baud_min;
+    uint32_t baud_max;
+} vendor_usart_port[VENDOR_USART_NUM] = {
+    {PERIPHERAL_UART_EXT_IDX, PERIPHERAL_UART_EXT_BAUD_MIN, PERIPHERAL_UART_EXT_BAUD_MAX},
+    #if SWO_UART
+    {PERIPHERAL_UART_SWO_IDX, SWO_UART_MIN_BAUDRATE, SWO_UART_MAX_BAUDRATE},
+    #endif
+};
+
+static void vendor_usart_get_stream(dap_param_t* param, uint8_t port,
+        vsf_stream_t **tx, vsf_stream_t **rx)
+{
+    #if SWO_UART
+    if (port == VENDOR_USART_SWO) {
+        *tx = (vsf_stream_t *)&param->swo_tx;
+        *rx = (vsf_stream_t *)&param->swo_rx;
+        return;
+    }
+    #endif
+    *tx = (vsf_stream_t *)&param->ext_tx;
+    *rx = (vsf_stream_t *)&param->ext_rx;
+}
+
+static bool vendor_usart_is_open(dap_param_t* param, uint8_t port)
+{
+    return (port < VENDOR_USART_NUM) && param->vendor_usart[port].baudrate;
+}
+
+static uint32_t vendor_usart_config(dap_param_t* param, uint8_t port,
+        uint32_t baudrate, uint32_t mode)
+{
+    vsf_stream_t *tx, *rx;
+    enum usart_idx_t idx = vendor_usart_port[port].idx;
+
+    vendor_usart_get_stream(param, port, &tx, &rx);
+    if (param->vendor_usart[port].baudrate) {
+        param->vendor_usart[port].baudrate = 0;
+        VSF_STREAM_DISCONNECT_RX(rx);
+    } else if (!baudrate) {
+        return 0;
+    }
+    // closed first, so the streams are attached even if the settings do not change
+    param->config_usart(idx, NULL, NULL, NULL, NULL, false);
+    if (!baudrate)
+        return 0;
+
+    if (baudrate > vendor_usart_port[port].baud_max)
+        baudrate = vendor_usart_port[port].baud_max;
+    else if (baudrate < vendor_usart_port[port].baud_min)
+        baudrate = vendor_usart_port[port].baud_min;
+
+    // data left from an earlier session is of no use
+    VSF_STREAM_READ(tx, NULL, VSF_STREAM_GET_DATA_SIZE(tx));
+    VSF_STREAM_READ(rx, NULL, VSF_STREAM_GET_DATA_SIZE(rx));
+    if (param->get_usart_dropped)
+        param->get_usart_dropped(idx);
+    param->config_usart(idx, &mode, &baudrate, tx, rx, true);
+    VSF_STREAM_CONNECT_RX(rx);
+
+    param->vendor_usart[port].baudrate = baudrate;
+    param->vendor_usart[port].mode = mode;
+    param->vendor_usart[port].overrun = false;
+    return baudrate;
+}
+
+static uint32_t vendor_usart_status(dap_param_t* param, uint8_t port)
+{
+    vsf_stream_t *tx, *rx;
+    uint32_t status, size;
+
+    if (!vendor_usart_is_open(param, port))
+        return 0;
+
+    vendor_usart_get_stream(param, port, &tx, &rx);
+    if (param->get_usart_dropped && param->get_usart_dropped(vendor_usart_port[port].idx))
+        param->vendor_usart[port].overrun = true;
+
+    status = USART_STATUS_OPEN;
+    if (param->vendor_usart[port].overrun)
+        status |= USART_STATUS_RX_OVERRUN;
+    param->vendor_usart[port].overrun = false;
+    size = VSF_STREAM_GET_FREE_SIZE(tx);
+    status |= min(size << USART_STATUS_TX_FREE_POS, USART_STATUS_TX_FREE_MASK);
+    size = VSF_STREAM_GET_DATA_SIZE(rx);
+    status |= min(size, USART_STATUS_RX_DATA_MASK);
+    return status;
+}
+
+#if SWO_UART
+// SWO capture takes the SWO UART back
+void dap_vendor_usart_release_swo(dap_param_t* param)
+{
+    if (param->vendor_usart[VENDOR_USART_SWO].baudrate) {
+        param->vendor_usart[VENDOR_USART_SWO].baudrate = 0;
+        VSF_STREAM_DISCONNECT_RX(&param->swo_rx);
+        param->config_usart(PERIPHERAL_UART_SWO_IDX, NULL, NULL, NULL, NULL, false);
+    }
+}
+#endif
+#endif  // VENDOR_UART
+
+// one DP/AP access, reads on AP and on JTAG are posted like in DAP_Transfer
+static uint32_t vendor_transfer(dap_param_t* param, uint32_t request, uint32_t* data)
+{
+    uint32_t ack = DAP_TRANSFER_ERROR;
+
+#if DAP_SWD
+    if (!(request & DAP_TRANSFER_RnW)) {
+        if (dap_swd_cache_access(param, request, (uint8_t *)data))
+            return DAP_TRANSFER_OK;
+    } else {
+        dap_swd_cache_access(param, request, NULL);
+    }
+#endif
+#if DAP_SWD
+    if (param->port == DAP_PORT_SWD) {
+        #ifdef SWD_ASYNC
+        vsfhal_swd_clear();
+        if (request & DAP_TRANSFER_RnW)
+            vsfhal_swd_read(request, (uint8_t *)data);
+        else
+            vsfhal_swd_write(request, (uint8_t *)data);
+        ack = vsfhal_swd_wait();
+        #else
+        if (request & DAP_TRANSFER_RnW)
+            ack = vsfhal_swd_read(request, (uint8_t *)data);
+        else
+            ack = vsfhal_swd_write(request, (uint8_t *)data);
+        #endif
+    }
+#endif
+#if DAP_JTAG
+    if (param->port == DAP_PORT_JTAG) {
+        uint8_t index = param->jtag_dev.index;
+        uint8_t request_ir = (request & DAP_TRANSFER_APnDP) ? JTAG_APACC : JTAG_DPACC;
+        #ifdef JTAG_ASYNC
+        uint64_t buf_tms[2], buf_tdi[2], buf_tdo[2];
+        uint16_t bitlen;
+
+        vsfhal_jtag_clear();
+        if (vendor_jtag_ir != request_ir) {
+            vendor_jtag_ir = request_ir;
+            bitlen = jtag_ir_to_raw(&buf_tms[0], &buf_tdi[0], request_ir, param->jtag_dev.ir_length[index],
+                    param->jtag_dev.ir_before[index], param->jtag_dev.ir_after[index]);
+            vsfhal_jtag_raw(0, bitlen, (uint8_t *)&buf_tms[0], (uint8_t *)&buf_tdi[0], (uint8_t *)&buf_tdo[0]);
+        }
+        bitlen = jtag_dr_to_raw(&buf_tms[1], &buf_tdi[1], request, (request & DAP_TRANSFER_RnW) ? 0 : *data,
+                index, param->jtag_dev.count - index - 1, param->transfer.idle_cycles);
+        vsfhal_jtag_raw(index + 3, bitlen, (uint8_t *)&buf_tms[1], (uint8_t *)&buf_tdi[1], (uint8_t *)&buf_tdo[1]);
+        ack = vsfhal_jtag_wait();
+        if (request & DAP_TRANSFER_RnW)
+            *data = buf_tdo[1] >> (index + 6);
+        #else
+        uint32_t tdo;
+
+        if (vendor_jtag_ir != request_ir) {
+            vendor_jtag_ir = request_ir;
+            vsfhal_jtag_ir(request_ir, param->jtag_dev.ir_length[index],
+                    param->jtag_dev.ir_before[index], param->jtag_dev.ir_after[index]);
+        }
+        ack = vsfhal_jtag_dr(request, (request & DAP_TRANSFER_RnW) ? 0 : *data,
+                index, param->jtag_dev.count - index - 1, (uint8_t *)&tdo);
+        if (request & DAP_TRANSFER_RnW)
+            *data = tdo;
+        #endif
+    }
+#endif
+#if DAP_SWD
+    if (ack != DAP_TRANSFER_OK)
+        dap_swd_cache_forget(param);
+#endif
+#if VENDOR_RTT
+    if ((ack == DAP_TRANSFER_OK) && (request == DP_SELECT))
+        param->dp_select = *data;
+#endif
+#if DAP_STATS
+    if (ack == DAP_TRANSFER_OK)
+        param->stats.port_bytes[param->port] += 4;
+#endif
+    return ack;
+}
+
+#if VENDOR_SCRIPT
+uint32_t dap_vendor_transfer(dap_param_t* param, uint32_t request, uint32_t* data)
+{
+    return vendor_transfer(param, request, data);
+}
+#endif
+
+static uint32_t vendor_dp_read(dap_param_t* param, uint32_t reg, uint32_t* data)
+{
+    uint32_t ack = vendor_transfer(param, reg | DAP_TRANSFER_RnW, data);
+
+    // JTAG-DP returns the result with the next DPACC scan
+    if ((ack == DAP_TRANSFER_OK) && (param->port == DAP_PORT_JTAG))
+        ack = vendor_transfer(param, DP_RDBUFF | DAP_TRANSFER_RnW, data);
+    return ack;
+}
+
+// wait for posted accesses and turn sticky errors into DAP_TRANSFER_FAULT
+static uint32_t vendor_mem_check(dap_param_t* param)
+{
+    uint32_t ack, data;
+
+    if (param->port == DAP_PORT_SWD)
+        return vendor_transfer(param, DP_RDBUFF | DAP_TRANSFER_RnW, &data);
+
+    // JTAG-DP does not fault AP accesses, sticky flags tell
+    ack = vendor_dp_read(param, DP_CTRL_STAT, &data);
+    if ((ack == DAP_TRANSFER_OK) && (data & CTRL_STAT_STICKY_MASK))
+        ack = DAP_TRANSFER_FAULT;
+    return ack;
+}
+
+static void vendor_mem_recover(dap_param_t* param)
+{
+    uint32_t data;
+
+    if (param->port == DAP_PORT_SWD) {
+        data = ABORT_CLEAR_STICKY;
+        vendor_transfer(param, DP_ABORT, &data);
+    } else if (vendor_dp_read(param, DP_CTRL_STAT, &data) == DAP_TRANSFER_OK) {
+        // sticky flags are write-one-to-clear in JTAG-DP CTRL/STAT
+        vendor_transfer(param, DP_CTRL_STAT, &data);
+    }
+}
+
+static uint32_t vendor_mem_setup(dap_param_t* param, uint8_t ap, uint8_t size)
+{
+    uint32_t ack, data = (uint32_t)ap << 24;
+
+    ack = vendor_transfer(param, DP_SELECT, &data);
+    if (ack != DAP_TRANSFER_OK)
+        return ack;
+
+    // keep Prot and implementation defined bits set up by the host
+    ack = vendor_transfer(param, DAP_TRANSFER_APnDP | DAP_TRANSFER_RnW | AP_CSW, &data);
+    if (ack != DAP_TRANSFER_OK)
+        return ack;
+    ack = vendor_transfer(param, DP_RDBUFF | DAP_TRANSFER_RnW, &data);
+    if (ack != DAP_TRANSFER_OK)
+        return ack;
+    data &= ~(CSW_SIZE_MASK | CSW_ADDRINC_MASK | CSW_MODE_MASK);
+    data |= CSW_ADDRINC_SINGLE | (size >> 1);
+    return vendor_transfer(param, DAP_TRANSFER_APnDP | AP_CSW, &data);
+}
+
+// read inside one TAR_WRAP_SIZE block, *done is the length of good data
+static uint32_t vendor_mem_read_block(dap_param_t* param, uint32_t addr,
+        uint8_t size, uint16_t length, uint8_t* buf, uint16_t* done)
+{
+    uint32_t ack, data = addr;
+    uint16_t ptr = 0;
+
+    *done = 0;
+    ack = vendor_transfer(param, DAP_TRANSFER_APnDP | AP_TAR, &data);
+    if (ack != DAP_TRANSFER_OK)
+        return ack;
+    // post first read
+    ack = vendor_transfer(param, DAP_TRANSFER_APnDP | DAP_TRANSFER_RnW | AP_DRW, &data);
+    if (ack != DAP_TRANSFER_OK)
+        return ack;
+
+    while (ptr < length) {
+        // read previous data and post next read, last one from RDBUFF
+        if ((ptr + size) < length)
+            ack = vendor_transfer(param, DAP_TRANSFER_APnDP | DAP_TRANSFER_RnW | AP_DRW, &data);
+        else
+            ack = vendor_transfer(param, DP_RDBUFF | DAP_TRANSFER_RnW, &data);
+        if (ack != DAP_TRANSFER_OK)
+            break;
+
+        data >>= ((addr + ptr) & 0x3) * 8;
+        if (size == 4)
+            put_unaligned_le32(data, buf + ptr);
+        else if (size == 2)
+            put_unaligned_le16(data, buf + ptr);
+        else
+            buf[ptr] = data;
+        ptr += size;
+    }
+
+    if (param->port == DAP_PORT_JTAG) {
+        if (ack == DAP_TRANSFER_OK)
+            ack = vendor_mem_check(param);
+        // not known which access set the sticky flag
+        if (ack != DAP_TRANSFER_OK)
+            ptr = 0;
+    }
+    *done = ptr;
+    return ack;
+}
+
+// write inside one TAR_WRAP_SIZE block, *done is the length known to be written
+static uint32_t vendor_mem_write_block(dap_param_t* param, uint32_t addr,
+        uint8_t size, uint16_t length, uint8_t* buf, uint16_t* done)
+{
+    uint32_t ack, data = addr;
+    uint16_t ptr;
+
+    *done = 0;
+    ack = vendor_transfer(param, DAP_TRANSFER_APnDP | AP_TAR, &data);
+    if (ack != DAP_TRANSFER_OK)
+        return ack;
+
+    for (ptr = 0; ptr < length; ptr += size) {
+        if (size == 4)
+            data = get_unaligned_le32(buf + ptr);
+        else if (size == 2)
+            data = get_unaligned_le16(buf + ptr);
+        else
+            data = buf[ptr];
+        data <<= ((addr + ptr) & 0x3) * 8;
+
+        ack = vendor_transfer(param, DAP_TRANSFER_APnDP | AP_DRW, &data);
+        if (ack != DAP_TRANSFER_OK)
+            return ack;
+    }
+
+    // writes are posted, a fault of the last one shows up here
+    ack = vendor_mem_check(param);
+    if (ack == DAP_TRANSFER_OK)
+        *done = length;
+    return ack;
+}
+
+static bool vendor_port_ready(dap_param_t* param)
+{
+#if DAP_SWD
+    if (param->port == DAP_PORT_SWD)
+        return true;
+#endif
+#if DAP_JTAG
+    if ((param->port == DAP_PORT_JTAG) && (param->jtag_dev.index < param->jtag_dev.count))
+        return true;
+#endif
+    return false;
+}
+
+static bool vendor_mem_start(dap_param_t* param, uint8_t cmd, uint8_t size,
+        uint32_t addr, uint32_t length)
+{
+    // the stream of another client is not done yet
+    if (dap_vendor_stream_pending(param))
+        return false;
+    param->do_abort = false;
+    param->vendor_mem.remain = 0;
+    vendor_jtag_ir = 0;
+
+    if ((size != 1) && (size != 2) && (size != 4))
+        return false;
+    if ((addr | length) & (size - 1))
+        return false;
+    if (!vendor_port_ready(param))
+        return false;
+
+    param->vendor_mem.cmd = cmd;
+    param->vendor_mem.size = size;
+    param->vendor_mem.addr = addr;
+    param->vendor_mem.remain = length;
+    return true;
+}
+
+static void vendor_mem_stop(dap_param_t* param, uint32_t ack)
+{
+    if (ack == DAP_TRANSFER_FAULT)
+        vendor_mem_recover(param);
+    param->vendor_mem.remain = 0;
+}
+
+// STATUS, DATA LENGTH and DATA of one read response
+static uint16_t vendor_mem_read(dap_param_t* param, uint8_t* response, uint16_t remaining_size)
+{
+    uint32_t ack = DAP_TRANSFER_OK;
+    uint8_t size = param->vendor_mem.size;
+    uint16_t ptr = 0, length, block, done;
+
+    if (remaining_size < 3)
+        return 0;
+    length = (remaining_size - 3) & ~(size - 1);
+    length = min(length, param->vendor_mem.remain);
+
+    while (ptr < length) {
+        if (param->do_abort) {
+            ack = DAP_TRANSFER_ERROR;
+            break;
+        }
+
+        block = TAR_WRAP_SIZE - (param->vendor_mem.addr & (TAR_WRAP_SIZE - 1));
+        block = min(block, length - ptr);
+        ack = vendor_mem_read_block(param, param->vendor_mem.addr, size, block,
+                response + 3 + ptr, &done);
+        ptr += done;
+        param->vendor_mem.addr += done;
+        param->vendor_mem.remain -= done;
+        if (ack != DAP_TRANSFER_OK)
+            break;
+    }
+    if (ack != DAP_TRANSFER_OK)
+        vendor_mem_stop(param, ack);
+
+    response[0] = ack;
+    put_unaligned_le16(ptr, response + 1);
+    return 3 + ptr;
+}
+
+// make the 16 bytes at addr reachable as BD0-BD3, without auto-increment
+static uint32_t vendor_select_bd(dap_param_t* param, uint8_t ap, uint32_t addr)
+{
+    uint32_t ack, data = (uint32_t)ap << 24;
+
+    ack = vendor_transfer(param, DP_SELECT, &data);
+    if (ack != DAP_TRANSFER_OK)
+        return ack;
+    data = addr & ~0xFUL;
+    ack = vendor_transfer(param, DAP_TRANSFER_APnDP | AP_TAR, &data);
+    if (ack != DAP_TRANSFER_OK)
+        return ack;
+    data = ((uint32_t)ap << 24) | SELECT_APBANK_BD;
+    return vendor_transfer(param, DP_SELECT, &data);
+}
+
+// back to bank 0, as the other commands leave SELECT
+static void vendor_unselect_bd(dap_param_t* param, uint8_t ap)
+{
+    uint32_t data = (uint32_t)ap << 24;
+
+    vendor_transfer(param, DP_SELECT, &data);
+}
+
+static uint32_t vendor_bd_read(dap_param_t* param, uint32_t reg, uint32_t* data)
+{
+    uint32_t ack = vendor_transfer(param, DAP_TRANSFER_APnDP | DAP_TRANSFER_RnW | reg, data);
+
+    if (ack == DAP_TRANSFER_OK)
+        ack = vendor_transfer(param, DP_RDBUFF | DAP_TRANSFER_RnW, data);
+    return ack;
+}
+
+static uint32_t vendor_core_wait_regrdy(dap_param_t* param)
+{
+    uint32_t ack, dhcsr, retry = DCRSR_REGRDY_RETRY;
+
+    do {
+        ack = vendor_bd_read(param, AP_BD_DHCSR, &dhcsr);
+        if (ack != DAP_TRANSFER_OK)
+            return ack;
+    } while (!(dhcsr & DHCSR_S_REGRDY) && --retry);
+    return retry ? DAP_TRANSFER_OK : DAP_TRANSFER_ERROR;
+}
+
+// with vendor_select_bd(DHCSR) done
+static uint32_t vendor_core_write_reg(dap_param_t* param, uint8_t reg, uint32_t value)
+{
+    uint32_t ack, data = reg | DCRSR_REGWNR;
+
+    ack = vendor_transfer(param, DAP_TRANSFER_APnDP | AP_BD_DCRDR, &value);
+    if (ack != DAP_TRANSFER_OK)
+        return ack;
+    ack = vendor_transfer(param, DAP_TRANSFER_APnDP | AP_BD_DCRSR, &data);
+    if (ack != DAP_TRANSFER_OK)
+        return ack;
+    return vendor_core_wait_regrdy(param);
+}
+
+static uint32_t vendor_core_read_reg(dap_param_t* param, uint8_t reg, uint32_t* value)
+{
+    uint32_t ack, data = reg;
+
+    ack = vendor_transfer(param, DAP_TRANSFER_APnDP | AP_BD_DCRSR, &data);
+    if (ack != DAP_TRANSFER_OK)
+        return ack;
+    ack = vendor_core_wait_regrdy(param);
+    if (ack != DAP_TRANSFER_OK)
+        return ack;
+    return vendor_bd_read(param, AP_BD_DCRDR, value);
+}
+
+static uint32_t vendor_core_halt(dap_param_t* param, uint32_t timeout_ms)
+{
+    uint32_t ack, dhcsr = DHCSR_DBGKEY | DHCSR_C_DEBUGEN | DHCSR_C_HALT;
+    vsf_systimer_cnt_t tick = vsf_systimer_get_tick() + vsf_systimer_ms_to_tick(timeout_ms);
+
+    ack = vendor_select_bd(param, param->vendor_flash.ap, DHCSR);
+    if (ack != DAP_TRANSFER_OK)
+        return ack;
+    ack = vendor_transfer(param, DAP_TRANSFER_APnDP | AP_BD_DHCSR, &dhcsr);
+    while (ack == DAP_TRANSFER_OK) {
+        ack = vendor_bd_read(param, AP_BD_DHCSR, &dhcsr);
+        if (dhcsr & DHCSR_S_HALT)
+            break;
+        if (tick <= vsf_systimer_get_tick())
+            ack = DAP_TRANSFER_ERROR;
+    }
+    return ack;
+}
+
+// start a flash algorithm function, the core is halted
+static uint32_t vendor_flash_call(dap_param_t* param, uint32_t entry,
+        uint32_t r0, uint32_t r1, uint32_t r2)
+{
+    uint32_t ack, i;
+    uint32_t reg[][2] = {
+        {CORE_REG_R0,   r0},
+        {CORE_REG_R1,   r1},
+        {CORE_REG_R2,   r2},
+        {CORE_REG_R9,   param->vendor_flash.static_base},
+        {CORE_REG_SP,   param->vendor_flash.stack_pointer},
+        {CORE_REG_LR,   param->vendor_flash.breakpoint | 1},
+        {CORE_REG_PC,   entry},
+        {CORE_REG_XPSR, XPSR_T},
+    };
+
+    if (!entry)
+        return DAP_TRANSFER_ERROR;
+
+    ack = vendor_select_bd(param, param->vendor_flash.ap, DHCSR);
+    for (i = 0; (ack == DAP_TRANSFER_OK) && (i < dimof(reg)); i++)
+        ack = vendor_core_write_reg(param, reg[i][0], reg[i][1]);
+    if (ack == DAP_TRANSFER_OK) {
+        // resume
+        uint32_t dhcsr = DHCSR_DBGKEY | DHCSR_C_DEBUGEN;
+        ack = vendor_transfer(param, DAP_TRANSFER_APnDP | AP_BD_DHCSR, &dhcsr);
+        if (ack == DAP_TRANSFER_OK)
+            ack = vendor_mem_check(param);
+    }
+    return ack;
+}
+
+// wait for the breakpoint and check R0
+static uint32_t vendor_flash_wait(dap_param_t* param)
+{
+    uint32_t ack, dhcsr;
+    vsf_systimer_cnt_t tick = vsf_systimer_get_tick()
+            + vsf_systimer_ms_to_tick(param->vendor_flash.timeout_ms);
+
+    ack = vendor_select_bd(param, param->vendor_flash.ap, DHCSR);
+    while (ack == DAP_TRANSFER_OK) {
+        ack = vendor_bd_read(param, AP_BD_DHCSR, &dhcsr);
+        if ((ack != DAP_TRANSFER_OK) || (dhcsr & DHCSR_S_HALT))
+            break;
+        if (param->do_abort || (tick <= vsf_systimer_get_tick())) {
+            // stop the algorithm, the next call needs a halted core
+            vendor_core_halt(param, param->vendor_flash.timeout_ms);
+            return DAP_TRANSFER_ERROR;
+        }
+    }
+    if (ack == DAP_TRANSFER_OK)
+        ack = vendor_core_read_reg(param, CORE_REG_R0, &param->vendor_flash.result);
+    if ((ack == DAP_TRANSFER_OK) && param->vendor_flash.result)
+        ack = DAP_TRANSFER_MISMATCH;
+    return ack;
+}
+
+static uint32_t vendor_flash_run(dap_param_t* param, uint32_t entry,
+        uint32_t r0, uint32_t r1, uint32_t r2)
+{
+    uint32_t ack = vendor_flash_call(param, entry, r0, r1, r2);
+
+    if (ack == DAP_TRANSFER_OK)
+        ack = vendor_flash_wait(param);
+    return ack;
+}
+
+// start ProgramPage on the page being filled, after the one running
+static uint32_t vendor_flash_flush(dap_param_t* param)
+{
+    uint32_t ack = DAP_TRANSFER_OK;
+
+    if (!param->vendor_flash.page_len)
+        return ack;
+
+    if (param->vendor_flash.busy) {
+        param->vendor_flash.busy = false;
+        ack = vendor_flash_wait(param);
+        if (ack != DAP_TRANSFER_OK)
+            return ack;
+    }
+    ack = vendor_flash_call(param, param->vendor_flash.program_page,
+            param->vendor_flash.page_addr, param->vendor_flash.page_len,
+            param->vendor_flash.buffer_addr[param->vendor_flash.buffer]);
+    param->vendor_flash.busy = ack == DAP_TRANSFER_OK;
+    param->vendor_flash.buffer ^= 1;
+    param->vendor_flash.page_len = 0;
+    return ack;
+}
+
+// program what is collected and wait for all pages
+static uint32_t vendor_flash_finish(dap_param_t* param)
+{
+    uint32_t ack = vendor_flash_flush(param);
+
+    if (param->vendor_flash.busy) {
+        param->vendor_flash.busy = false;
+        if (ack == DAP_TRANSFER_OK)
+            ack = vendor_flash_wait(param);
+    }
+    return ack;
+}
+
+// copy page data to the buffer being filled
+static uint32_t vendor_flash_fill(dap_param_t* param, uint8_t* data, uint16_t length)
+{
+    uint32_t ack, data_reg = (uint32_t)param->vendor_flash.ap << 24;
+    uint32_t addr = param->vendor_flash.buffer_addr[param->vendor_flash.buffer]
+            + param->vendor_flash.page_len;
+    uint16_t ptr = 0, block, done;
+
+    ack = vendor_transfer(param, DP_SELECT, &data_reg);
+    while ((ack == DAP_TRANSFER_OK) && (ptr < length)) {
+        block = TAR_WRAP_SIZE - (addr & (TAR_WRAP_SIZE - 1));
+        block = min(block, length - ptr);
+        ack = vendor_mem_write_block(param, addr, 4, block, data + ptr, &done);
+        ptr += done;
+        addr += done;
+    }
+    param->vendor_flash.page_len += ptr;
+    return ack;
+}
+
+static uint32_t vendor_flash_program(dap_param_t* param, uint32_t addr,
+        uint8_t* data, uint16_t length)
+{
+    uint32_t ack = DAP_TRANSFER_OK, room;
+    uint16_t ptr = 0;
+
+    if (!length)
+        return vendor_flash_finish(param);
+
+    while ((ack == DAP_TRANSFER_OK) && (ptr < length)) {
+        if (param->do_abort)
+            return DAP_TRANSFER_ERROR;
+
+        if (param->vendor_flash.page_len
+                && (addr != param->vendor_flash.page_addr + param->vendor_flash.page_len)) {
+            ack = vendor_flash_flush(param);
+            if (ack != DAP_TRANSFER_OK)
+                break;
+        }
+        if (!param->vendor_flash.page_len)
+            param->vendor_flash.page_addr = addr;
+
+        room = param->vendor_flash.page_size - (addr % param->vendor_flash.page_size);
+        room = min(room, length - ptr);
+        ack = vendor_flash_fill(param, data + ptr, room);
+        ptr += room;
+        addr += room;
+        // page complete
+        if ((ack == DAP_TRANSFER_OK) && !(addr % param->vendor_flash.page_size))
+            ack = vendor_flash_flush(param);
+    }
+    return ack;
+}
+
+// time base for polling, the DAP timestamp if there is one
+static uint32_t vendor_time_get(void)
+{
+#if TIMESTAMP_CLOCK
+    return vsfhal_timestamp_get();
+#else
+    return (uint32_t)vsf_systimer_get_tick();
+#endif
+}
+
+static uint32_t vendor_time_to_us(uint32_t time)
+{
+#if TIMESTAMP_CLOCK
+    return (uint64_t)time * 1000000 / TIMESTAMP_CLOCK;
+#else
+    return vsf_systimer_tick_to_us(time);
+#endif
+}
+
+static uint32_t vendor_mem_poll(dap_param_t* param, uint8_t ap, uint32_t addr,
+        uint32_t mask, uint32_t match, uint32_t timeout_us, uint32_t* value,
+        uint32_t* elapsed_us)
+{
+    uint32_t ack, next, delay_us = POLL_DELAY_MIN_US, start = vendor_time_get();
+
+    ack = vendor_select_bd(param, ap, addr);
+    while (ack == DAP_TRANSFER_OK) {
+        ack = vendor_bd_read(param, addr & 0xC, value);
+        *elapsed_us = vendor_time_to_us(vendor_time_get() - start);
+        if ((ack != DAP_TRANSFER_OK) || ((*value & mask) == match))
+            break;
+        if ((*elapsed_us >= timeout_us) || param->do_abort) {
+            ack |= DAP_TRANSFER_MISMATCH;
+            break;
+        }
+
+        // back off, but not past the timeout
+        next = min(*elapsed_us + delay_us, timeout_us);
+        while ((vendor_time_to_us(vendor_time_get() - start) < next) && !param->do_abort);
+        delay_us = min(delay_us * 2, POLL_DELAY_MAX_US);
+    }
+    vendor_unselect_bd(param, ap);
+    return ack;
+}
+
+#if VENDOR_CRC
+// the free part of the response packet holds the data until it is added
+static uint32_t vendor_mem_crc(dap_param_t* param, uint8_t* buf, uint16_t buf_size,
+        uint32_t* crc, uint32_t* crc_length)
+{
+    uint32_t ack = DAP_TRANSFER_OK;
+    uint8_t size = param->vendor_mem.size;
+    uint16_t block, done;
+
+    buf_size &= ~(size - 1);
+    while (param->vendor_mem.remain) {
+        if (param->do_abort)
+            return DAP_TRANSFER_ERROR;
+
+        block = TAR_WRAP_SIZE - (param->vendor_mem.addr & (TAR_WRAP_SIZE - 1));
+        block = min(block, buf_size);
+        block = min(block, param->vendor_mem.remain);
+        ack = vendor_mem_read_block(param, param->vendor_mem.addr, size, block, buf, &done);
+        *crc = param->crc32(*crc, buf, done);
+        *crc_length += done;
+        param->vendor_mem.addr += done;
+        param->vendor_mem.remain -= done;
+        if (ack != DAP_TRANSFER_OK)
+            break;
+    }
+    return ack;
+}
+#endif  // VENDOR_CRC
+
+#if VENDOR_MULTIDROP
+// line reset, TARGETSEL and the DPIDR read it needs
+static uint32_t vendor_swd_targetsel(dap_param_t* param, uint32_t targetsel, uint32_t* dpidr)
+{
+    // 56 ones, 8 idle cycles
+    uint8_t seq[8] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00};
+    uint8_t i, parity = 0;
+    uint32_t ack;
+
+    for (i = 0; i < 32; i++)
+        parity ^= (targetsel >> i) & 0x1;
+
+    #ifdef SWD_ASYNC
+    vsfhal_swd_clear();
+    #endif
+    vsfhal_swd_seqout(seq, 64);
+    seq[0] = SWD_TARGETSEL_REQUEST;
+    vsfhal_swd_seqout(seq, 8);
+    // no target drives the ACK of TARGETSEL
+    vsfhal_swd_seqin(seq, param->swd_conf.turnaround * 2 + 3);
+    put_unaligned_le32(targetsel, seq);
+    seq[4] = parity;
+    vsfhal_swd_seqout(seq, 33);
+    #ifdef SWD_ASYNC
+    vsfhal_swd_wait();
+    #endif
+
+    ack = vendor_transfer(param, DP_IDCODE | DAP_TRANSFER_RnW, dpidr);
+    dap_swd_cache_target(param, targetsel, ack == DAP_TRANSFER_OK);
+    return ack;
+}
+#endif  // VENDOR_MULTIDROP
+
+#if VENDOR_RTT
+// what the host had set up, put back when the command is done
+typedef struct rtt_ctx_t {
+    uint32_t select;
+    uint32_t csw;
+    uint32_t tar;
+    uint8_t size;           // access size CSW is set to, 0 if not changed
+    bool saved;
+} rtt_ctx_t;
+
+typedef struct rtt_buffer_t {
+    uint32_t desc;
+    uint32_t buffer;
+    uint32_t size;
+    uint32_t wr_off;
+    uint32_t rd_off;
+} rtt_buffer_t;
+
+static uint32_t rtt_begin(dap_param_t* param, rtt_ctx_t* ctx, uint8_t ap)
+{
+    uint32_t ack, data = (uint32_t)ap << 24;
+
+    ctx->select = param->dp_select;
+    ctx->size = 0;
+    ctx->saved = false;
+    ack = vendor_transfer(param, DP_SELECT, &data);
+    if (ack != DAP_TRANSFER_OK)
+        return ack;
+    ack = vendor_transfer(param, DAP_TRANSFER_APnDP | DAP_TRANSFER_RnW | AP_CSW, &data);
+    if (ack != DAP_TRANSFER_OK)
+        return ack;
+    ack = vendor_transfer(param, DAP_TRANSFER_APnDP | DAP_TRANSFER_RnW | AP_TAR, &ctx->csw);
+    if (ack != DAP_TRANSFER_OK)
+        return ack;
+    ack = vendor_transfer(param, DP_RDBUFF | DAP_TRANSFER_RnW, &ctx->tar);
+    ctx->saved = ack == DAP_TRANSFER_OK;
+    return ack;
+}
+
+static uint32_t rtt_end(dap_param_t* param, rtt_ctx_t* ctx, uint32_t ack)
+{
+    uint32_t ret = DAP_TRANSFER_OK;
+
+    if (ack == DAP_TRANSFER_FAULT)
+        vendor_mem_recover(param);
+    if (ctx->saved) {
+        if (ctx->size)
+            ret = vendor_transfer(param, DAP_TRANSFER_APnDP | AP_CSW, &ctx->csw);
+        if (ret == DAP_TRANSFER_OK)
+            ret = vendor_transfer(param, DAP_TRANSFER_APnDP | AP_TAR, &ctx->tar);
+    }
+    if (ret == DAP_TRANSFER_OK)
+        ret = vendor_transfer(param, DP_SELECT, &ctx->select);
+    if (ret == DAP_TRANSFER_OK)
+        ret = vendor_mem_check(param);
+    return (ack == DAP_TRANSFER_OK) ? ret : ack;
+}
+
+static uint32_t rtt_set_size(dap_param_t* param, rtt_ctx_t* ctx, uint8_t size)
+{
+    uint32_t data = ctx->csw & ~(CSW_SIZE_MASK | CSW_ADDRINC_MASK | CSW_MODE_MASK);
+
+    if (ctx->size == size)
+        return DAP_TRANSFER_OK;
+    ctx->size = size;
+    data |= CSW_ADDRINC_SINGLE | (size >> 1);
+    return vendor_transfer(param, DAP_TRANSFER_APnDP | AP_CSW, &data);
+}
+
+// RTT data is not aligned, bytes up to a word boundary and words after it
+static uint32_t rtt_mem_access(dap_param_t* param, rtt_ctx_t* ctx, uint32_t addr,
+        uint32_t length, uint8_t* buf, bool write)
+{
+    uint32_t ack = DAP_TRANSFER_OK, block;
+    uint16_t done;
+    uint8_t size;
+
+    while (length) {
+        if (param->do_abort)
+            return DAP_TRANSFER_ERROR;
+
+        if (addr & 0x3) {
+            size = 1;
+            block = min(4 - (addr & 0x3), length);
+        } else if (length < 4) {
+            size = 1;
+            block = length;
+        } else {
+            size = 4;
+            block = length & ~0x3UL;
+        }
+        block = min(block, TAR_WRAP_SIZE - (addr & (TAR_WRAP_SIZE - 1)));
+
+        ack = rtt_set_size(param, ctx, size);
+        if (ack != DAP_TRANSFER_OK)
+            break;
+        if (write)
+            ack = vendor_mem_write_block(param, addr, size, block, buf, &done);
+        else
+            ack = vendor_mem_read_block(param, addr, size, block, buf, &done);
+        if (ack != DAP_TRANSFER_OK)
+            break;
+        addr += block;
+        buf += block;
+        length -= block;
+    }
+    return ack;
+}
+
+static uint32_t rtt_find(dap_param_t* param, rtt_ctx_t* ctx, uint32_t* addr,
+        uint32_t length, uint32_t* cb)
+{
+    uint8_t buf[RTT_FIND_CHUNK];
+    uint32_t ack = DAP_TRANSFER_OK, block, i, word;
+    uint8_t state = 0;      // words of the ID matched
+
+    *cb = 0;
+    while (length) {
+        block = min(length, RTT_FIND_CHUNK);
+        ack = rtt_mem_access(param, ctx, *addr, block, buf, false);
+        if (ack != DAP_TRANSFER_OK)
+            break;
+
+        for (i = 0; i < block; i += 4) {
+            word = get_unaligned_le32(buf + i);
+            if ((state == 1) && (word == RTT_ID1)) {
+                state = 2;
+            } else if ((state == 2) && ((word & RTT_ID2_MASK) == RTT_ID2)) {
+                *cb = *addr + i - 8;
+                i += 4;
+                break;
+            } else {
+                state = (word == RTT_ID0) ? 1 : 0;
+            }
+        }
+        *addr += i;
+        length -= i;
+        if (*cb)
+            return ack;
+    }
+    // a partial match is looked at again by the next command
+    *addr -= state * 4;
+    return ack;
+}
+
+// descriptor of an up or down buffer, DAP_TRANSFER_MISMATCH if it makes no sense
+static uint32_t rtt_buffer_get(dap_param_t* param, rtt_ctx_t* ctx, uint32_t cb,
+        uint8_t channel, bool up, rtt_buffer_t* rb)
+{
+    uint8_t buf[RTT_CB_SIZE];
+    uint32_t ack, num_up, num_down;
+
+    ack = rtt_mem_access(param, ctx, cb, RTT_CB_SIZE, buf, false);
+    if (ack != DAP_TRANSFER_OK)
+        return ack;
+    num_up = get_unaligned_le32(buf + 16);
+    num_down = get_unaligned_le32(buf + 20);
+    if ((get_unaligned_le32(buf) != RTT_ID0) || (get_unaligned_le32(buf + 4) != RTT_ID1)
+            || ((get_unaligned_le32(buf + 8) & RTT_ID2_MASK) != RTT_ID2)
+            || (channel >= (up ? num_up : num_down)) || (num_up > 0xFF))
+        return DAP_TRANSFER_MISMATCH;
+
+    rb->desc = cb + RTT_CB_SIZE + RTT_DESC_SIZE * (up ? channel : (num_up + channel));
+    ack = rtt_mem_access(param, ctx, rb->desc, RTT_DESC_SIZE, buf, false);
+    if (ack != DAP_TRANSFER_OK)
+        return ack;
+    rb->buffer = get_unaligned_le32(buf + 4);
+    rb->size = get_unaligned_le32(buf + 8);
+    rb->wr_off = get_unaligned_le32(buf + RTT_DESC_WROFF);
+    rb->rd_off = get_unaligned_le32(buf + RTT_DESC_RDOFF);
+    if (!rb->size || (rb->wr_off >= rb->size) || (rb->rd_off >= rb->size))
+        return DAP_TRANSFER_MISMATCH;
+    return DAP_TRANSFER_OK;
+}
+
+// length bytes at offset off of the ring buffer, wrapping at most once
+static uint32_t rtt_buffer_access(dap_param_t* param, rtt_ctx_t* ctx, rtt_buffer_t* rb,
+        uint32_t off, uint32_t length, uint8_t* buf, bool write)
+{
+    uint32_t ack, part = min(length, rb->size - off);
+
+    ack = rtt_mem_access(param, ctx, rb->buffer + off, part, buf, write);
+    if ((ack == DAP_TRANSFER_OK) && (length > part))
+        ack = rtt_mem_access(param, ctx, rb->buffer, length - part, buf + part, write);
+    return ack;
+}
+
+static uint32_t rtt_buffer_set_off(dap_param_t* param, rtt_ctx_t* ctx, rtt_buffer_t* rb,
+        uint32_t reg, uint32_t off)
+{
+    uint8_t buf[4];
+
+    put_unaligned_le32(off, buf);
+    return rtt_mem_access(param, ctx, rb->desc + reg, 4, buf, true);
+}
+
+// the target writes WrOff of up buffers and RdOff of down buffers, the host the others
+static uint32_t rtt_poll(dap_param_t* param, rtt_ctx_t* ctx, uint32_t cb,
+        uint8_t* request, uint16_t* down_len, uint8_t* response,
+        uint16_t* up_len, uint32_t* up_pending)
+{
+    rtt_buffer_t rb;
+    uint32_t ack = DAP_TRANSFER_OK, avail, length;
+
+    length = *down_len;
+    *down_len = 0;
+    if (length) {
+        ack = rtt_buffer_get(param, ctx, cb, request[3], false, &rb);
+        if (ack != DAP_TRANSFER_OK)
+            return ack;
+        // one byte stays free, WrOff == RdOff is empty
+        avail = (rb.rd_off > rb.wr_off) ? (rb.rd_off - rb.wr_off - 1)
+                : (rb.size - rb.wr_off + rb.rd_off - 1);
+        length = min(length, avail);
+        if (length) {
+            ack = rtt_buffer_access(param, ctx, &rb, rb.wr_off, length, request + 6, true);
+            if (ack == DAP_TRANSFER_OK)
+                ack = rtt_buffer_set_off(param, ctx, &rb, RTT_DESC_WROFF,
+                        (rb.wr_off + length) % rb.size);
+            if (ack != DAP_TRANSFER_OK)
+                return ack;
+            *down_len = length;
+        }
+    }
+
+    length = *up_len;
+    *up_len = 0;
+    ack = rtt_buffer_get(param, ctx, cb, request[0], true, &rb);
+    if (ack != DAP_TRANSFER_OK)
+        return ack;
+    avail = (rb.wr_off >= rb.rd_off) ? (rb.wr_off - rb.rd_off)
+            : (rb.size - rb.rd_off + rb.wr_off);
+    length = min(length, avail);
+    if (length) {
+        ack = rtt_buffer_access(param, ctx, &rb, rb.rd_off, length, response, false);
+        if (ack == DAP_TRANSFER_OK)
+            ack = rtt_buffer_set_off(param, ctx, &rb, RTT_DESC_RDOFF,
+                    (rb.rd_off + length) % rb.size);
+        if (ack != DAP_TRANSFER_OK)
+            return ack;
+        *up_len = length;
+    }
+    *up_pending = avail - length;
+    return ack;
+}
+#endif  // VENDOR_RTT
+
+uint32_t dap_vendor_request_handler(dap_param_t* param, uint8_t* request, uint16_t request_size,
         uint8_t* response, uint8_t cmd_id, uint16_t remaining_size)
 {
     uint16_t req_ptr = 0, resp_ptr = 0;
 
     switch (cmd_id) {
+    #if VENDOR_UART
     case VENDOR_ID_GET_USART_INFO: {
-        
+        uint8_t port;
+
+        if (!param->config_usart) {
+            response[resp_ptr++] = DAP_ERROR;
+            break;
+        }
+        response[resp_ptr++] = DAP_OK;
+        response[resp_ptr++] = VENDOR_USART_NUM;
+        for (port = 0; port < VENDOR_USART_NUM; port++) {
+            put_unaligned_le32(vendor_usart_port[port].baud_min, response + resp_ptr);
+            put_unaligned_le32(vendor_usart_port[port].baud_max, response + resp_ptr + 4);
+            put_unaligned_le32(USART_VALID_CFG, response + resp_ptr + 8);
+            resp_ptr += 12;
+        }
     } break;
     case VENDOR_ID_GET_USART_CFG: {
-        
+        uint8_t port = request[0];
+
+        req_ptr = 1;
+        if (port >= VENDOR_USART_NUM) {
+            response[resp_ptr++] = DAP_ERROR;
+            break;
+        }
+        response[resp_ptr++] = DAP_OK;
+        put_unaligned_le32(param->vendor_usart[port].baudrate, response + resp_ptr);
+        put_unaligned_le32(param->vendor_usart[port].mode, response + resp_ptr + 4);
+        resp_ptr += 8;
     } break;
     case VENDOR_ID_SET_USART_CFG: {
-        
+        uint8_t port = request[0];
+        uint32_t baudrate = get_unaligned_le32(request + 1);
+        uint32_t mode = get_unaligned_le32(request + 5);
+
+        req_ptr = 9;
+        if ((port >= VENDOR_USART_NUM) || (mode & ~USART_VALID_CFG) || !param->config_usart
+            #if SWO_UART
+                || ((port == VENDOR_USART_SWO) && (param->trace_status & DAP_SWO_CAPTURE_ACTIVE))
+            #endif
+                ) {
+            response[resp_ptr++] = DAP_ERROR;
+            break;
+        }
+        baudrate = vendor_usart_config(param, port, baudrate, mode);
+        response[resp_ptr++] = DAP_OK;
+        put_unaligned_le32(baudrate, response + resp_ptr);
+        put_unaligned_le32(baudrate ? mode : 0, response + resp_ptr + 4);
+        resp_ptr += 8;
     } break;
     case VENDOR_ID_GET_USART_STATUS: {
-        
+        uint8_t num = request[0], i;
+
+        if (num >= request_size)
+            num = request_size ? request_size - 1 : 0;
+        req_ptr = 1 + num;
+        response[resp_ptr++] = DAP_OK;
+        for (i = 0; (i < num) && (resp_ptr + 4 <= remaining_size); i++) {
+            put_unaligned_le32(vendor_usart_status(param, request[1 + i]), response + resp_ptr);
+            resp_ptr += 4;
+        }
     } break;
     case VENDOR_ID_READ_USART_DATA: {
-        
+        uint8_t num = request[0], port, i;
+        uint16_t length;
+        int32_t space;
+        vsf_stream_t *tx, *rx;
+
+        num = min(num, (request_size - 1) / 3);
+        req_ptr = 1 + num * 3;
+        response[resp_ptr++] = DAP_OK;
+        // entries without room for their length and status are not answered,
+        // the data gets what is left once they are in
+        num = min(num, (remaining_size - resp_ptr) / (2 + 4));
+        space = remaining_size - resp_ptr - num * (2 + 4);
+        for (i = 0; i < num; i++) {
+            port = request[1 + i * 3];
+            length = get_unaligned_le16(request + 2 + i * 3);
+            if (!vendor_usart_is_open(param, port) || (space <= 0)) {
+                length = 0;
+            } else {
+                vendor_usart_get_stream(param, port, &tx, &rx);
+                length = min(length, space);
+                length = VSF_STREAM_READ(rx, response + resp_ptr + 2, length);
+                space -= length;
+            }
+            put_unaligned_le16(length, response + resp_ptr);
+            resp_ptr += 2 + length;
+        }
+        for (i = 0; i < num; i++) {
+            put_unaligned_le32(vendor_usart_status(param, request[1 + i * 3]), response + resp_ptr);
+            resp_ptr += 4;
+        }
     } break;
     case VENDOR_ID_WRITE_USART_DATA: {
-        
+        uint8_t num = request[0], answered, port, i;
+        uint16_t length, done;
+        uint16_t ptr = 1;
+        vsf_stream_t *tx, *rx;
+
+        response[resp_ptr++] = DAP_OK;
+        // entries without room for their length and status are skipped
+        answered = min(num, (remaining_size - resp_ptr) / (2 + 4));
+        for (i = 0; i < num; i++) {
+            if (ptr + 3 > request_size)
+                break;
+            length = get_unaligned_le16(request + ptr + 1);
+            if (!vendor_data_fits(request_size, ptr + 3, length))
+                break;
+            if (i < answered) {
+                port = request[ptr];
+                done = 0;
+                if (vendor_usart_is_open(param, port)) {
+                    vendor_usart_get_stream(param, port, &tx, &rx);
+                    done = min(length, VSF_STREAM_GET_FREE_SIZE(tx));
+                    if (done)
+                        done = VSF_STREAM_WRITE(tx, request + ptr + 3, done);
+                }
+                put_unaligned_le16(done, response + resp_ptr);
+                resp_ptr += 2;
+            }
+            ptr += 3 + length;
+        }
+        if (i < num) {
+            // an entry past the packet, the rest of it can not be parsed
+            answered = min(answered, i);
+            ptr = request_size;
+        }
+        req_ptr = ptr;
+        ptr = 1;
+        for (i = 0; i < answered; i++) {
+            put_unaligned_le32(vendor_usart_status(param, request[ptr]), response + resp_ptr);
+            resp_ptr += 4;
+            ptr += 3 + get_unaligned_le16(request + ptr + 1);
+        }
+    } break;
+    #endif  // VENDOR_UART
+    case VENDOR_ID_MEM_READ: {
+        uint8_t ap = request[0], size = request[1];
+        uint32_t addr = get_unaligned_le32(request + 2);
+        uint32_t length = get_unaligned_le32(request + 6);
+        uint32_t ack = DAP_TRANSFER_ERROR;
+
+        req_ptr = 10;
+        if (vendor_mem_start(param, cmd_id, size, addr, length)) {
+            param->vendor_mem.ap = ap;
+            ack = vendor_mem_setup(param, ap, size);
+            if (ack == DAP_TRANSFER_OK) {
+                resp_ptr = vendor_mem_read(param, response, remaining_size);
+                break;
+            }
+            vendor_mem_stop(param, ack);
+        }
+        response[resp_ptr++] = ack;
+        put_unaligned_le16(0, response + resp_ptr);
+        resp_ptr += 2;
+    } break;
+    case VENDOR_ID_MEM_WRITE: {
+        uint8_t ap = request[0], size = request[1];
+        uint32_t addr = get_unaligned_le32(request + 2);
+        uint16_t length = get_unaligned_le16(request + 6), ptr = 0, block, done;
+        uint32_t ack = DAP_TRANSFER_ERROR;
+
+        req_ptr = 8 + length;
+        if (!vendor_data_fits(request_size, 8, length)) {
+            // DATA past the packet, the rest of it can not be parsed
+            req_ptr = request_size;
+        } else if (vendor_mem_start(param, cmd_id, size, addr, length)) {
+            ack = vendor_mem_setup(param, ap, size);
+            while ((ack == DAP_TRANSFER_OK) && (ptr < length)) {
+                if (param->do_abort) {
+                    ack = DAP_TRANSFER_ERROR;
+                    break;
+                }
+
+                block = TAR_WRAP_SIZE - (addr & (TAR_WRAP_SIZE - 1));
+                block = min(block, length - ptr);
+                ack = vendor_mem_write_block(param, addr, size, block,
+                        request + 8 + ptr, &done);
+                ptr += done;
+                addr += done;
+            }
+            vendor_mem_stop(param, ack);
+        }
+        response[resp_ptr++] = ack;
+        put_unaligned_le16(ptr, response + resp_ptr);
+        resp_ptr += 2;
+    } break;
+    case VENDOR_ID_FLASH_SETUP:
+    case VENDOR_ID_FLASH_INIT:
+    case VENDOR_ID_FLASH_UNINIT:
+    case VENDOR_ID_FLASH_ERASE:
+    case VENDOR_ID_FLASH_PROGRAM: {
+        uint32_t ack;
+
+        switch (cmd_id) {
+        case VENDOR_ID_FLASH_SETUP:
+            req_ptr = 45;
+            break;
+        case VENDOR_ID_FLASH_INIT:
+            req_ptr = 9;
+            break;
+        case VENDOR_ID_FLASH_UNINIT:
+            req_ptr = 1;
+            break;
+        case VENDOR_ID_FLASH_ERASE:
+            req_ptr = 10;
+            break;
+        default:
+            req_ptr = 6 + get_unaligned_le16(request + 4);
+            if (!vendor_data_fits(request_size, 6, get_unaligned_le16(request + 4)))
+                req_ptr = request_size;
+            break;
+        }
+
+        if (cmd_id == VENDOR_ID_FLASH_SETUP) {
+            memset(&param->vendor_flash, 0, sizeof(param->vendor_flash));
+            param->vendor_flash.ap = request[0];
+            param->vendor_flash.breakpoint = get_unaligned_le32(request + 1);
+            param->vendor_flash.static_base = get_unaligned_le32(request + 5);
+            param->vendor_flash.stack_pointer = get_unaligned_le32(request + 9);
+            param->vendor_flash.init = get_unaligned_le32(request + 13);
+            param->vendor_flash.uninit = get_unaligned_le32(request + 17);
+            param->vendor_flash.erase_sector = get_unaligned_le32(request + 21);
+            param->vendor_flash.program_page = get_unaligned_le32(request + 25);
+            param->vendor_flash.buffer_addr[0] = get_unaligned_le32(request + 29);
+            param->vendor_flash.buffer_addr[1] = get_unaligned_le32(request + 33);
+            param->vendor_flash.page_size = get_unaligned_le32(request + 37);
+            param->vendor_flash.timeout_ms = get_unaligned_le32(request + 41);
+            if (param->vendor_flash.page_size & 0x3)
+                param->vendor_flash.page_size = 0;
+            param->vendor_flash.status = DAP_TRANSFER_OK;
+        } else if (cmd_id == VENDOR_ID_FLASH_INIT) {
+            param->vendor_flash.status = DAP_TRANSFER_OK;
+            param->vendor_flash.result = 0;
+        }
+
+        param->do_abort = false;
+        vendor_jtag_ir = 0;
+        if (!vendor_port_ready(param) || !param->vendor_flash.page_size) {
+            ack = DAP_TRANSFER_ERROR;
+            goto flash_exit;
+        } else if (param->vendor_flash.status != DAP_TRANSFER_OK) {
+            ack = param->vendor_flash.status;
+            goto flash_exit;
+        }
+
+        ack = vendor_mem_setup(param, param->vendor_flash.ap, 4);
+        if (ack == DAP_TRANSFER_OK) {
+            switch (cmd_id) {
+            case VENDOR_ID_FLASH_SETUP:
+                ack = vendor_core_halt(param, param->vendor_flash.timeout_ms);
+                break;
+            case VENDOR_ID_FLASH_INIT:
+                ack = vendor_flash_finish(param);
+                if (ack == DAP_TRANSFER_OK)
+                    ack = vendor_flash_run(param, param->vendor_flash.init,
+                            get_unaligned_le32(request), get_unaligned_le32(request + 4), request[8]);
+                break;
+            case VENDOR_ID_FLASH_UNINIT:
+                ack = vendor_flash_finish(param);
+                if (ack == DAP_TRANSFER_OK)
+                    ack = vendor_flash_run(param, param->vendor_flash.uninit, request[0], 0, 0);
+                break;
+            case VENDOR_ID_FLASH_ERASE: {
+                uint32_t addr = get_unaligned_le32(request);
+                uint32_t size = get_unaligned_le32(request + 4);
+                uint16_t num = get_unaligned_le16(request + 8);
+
+                ack = vendor_flash_finish(param);
+                while ((ack == DAP_TRANSFER_OK) && num--) {
+                    if (param->do_abort) {
+                        ack = DAP_TRANSFER_ERROR;
+                        break;
+                    }
+                    ack = vendor_flash_run(param, param->vendor_flash.erase_sector, addr, 0, 0);
+                    addr += size;
+                }
+            } break;
+            default: {
+                uint32_t addr = get_unaligned_le32(request);
+                uint16_t length = get_unaligned_le16(request + 4);
+
+                if (((addr | length) & 0x3) || !vendor_data_fits(request_size, 6, length))
+                    ack = DAP_TRANSFER_ERROR;
+                else
+                    ack = vendor_flash_program(param, addr, request + 6, length);
+            } break;
+            }
+        }
+        if (ack == DAP_TRANSFER_FAULT)
+            vendor_mem_recover(param);
+        vendor_unselect_bd(param, param->vendor_flash.ap);
+        param->vendor_flash.status = ack;
+
+    flash_exit:
+        response[resp_ptr++] = ack;
+        put_unaligned_le32(param->vendor_flash.result, response + resp_ptr);
+        resp_ptr += 4;
+    } break;
+    case VENDOR_ID_MEM_POLL: {
+        uint8_t ap = request[0];
+        uint32_t addr = get_unaligned_le32(request + 1);
+        uint32_t ack = DAP_TRANSFER_ERROR, value = 0, elapsed_us = 0;
+
+        req_ptr = 17;
+        if (vendor_mem_start(param, cmd_id, 4, addr, 0)) {
+            ack = vendor_mem_setup(param, ap, 4);
+            if (ack == DAP_TRANSFER_OK)
+                ack = vendor_mem_poll(param, ap, addr, get_unaligned_le32(request + 5),
+                        get_unaligned_le32(request + 9), get_unaligned_le32(request + 13),
+                        &value, &elapsed_us);
+            vendor_mem_stop(param, ack);
+        }
+        response[resp_ptr++] = ack;
+        put_unaligned_le32(value, response + resp_ptr);
+        resp_ptr += 4;
+        put_unaligned_le32(elapsed_us, response + resp_ptr);
+        resp_ptr += 4;
+    } break;
+    case VENDOR_ID_STATS: {
+        req_ptr = 2;
+        #if DAP_STATS
+        dap_stats_t *stats = &param->stats;
+        uint8_t op = request[0];
+        uint32_t i;
+
+        if ((op == STATS_READ_SUMMARY) && (remaining_size >= 38 + 4 * DAP_PACKET_COUNT)) {
+            response[resp_ptr++] = DAP_OK;
+            put_unaligned_le32(TIMESTAMP_CLOCK, response + resp_ptr);
+            put_unaligned_le32(stats->requests, response + resp_ptr + 4);
+            put_unaligned_le32(stats->resp_wait_total, response + resp_ptr + 8);
+            put_unaligned_le32(stats->resp_wait_max, response + resp_ptr + 12);
+            put_unaligned_le32(stats->swd_retries, response + resp_ptr + 16);
+            put_unaligned_le32(stats->jtag_retries, response + resp_ptr + 20);
+            put_unaligned_le32(stats->port_bytes[DAP_PORT_SWD], response + resp_ptr + 24);
+            put_unaligned_le32(stats->port_bytes[DAP_PORT_JTAG], response + resp_ptr + 28);
+            resp_ptr += 32;
+            response[resp_ptr++] = DAP_PACKET_COUNT;
+            for (i = 0; i < DAP_PACKET_COUNT; i++) {
+                put_unaligned_le32(stats->queue_depth[i], response + resp_ptr);
+                resp_ptr += 4;
+            }
+            put_unaligned_le32(stats->swd_cached, response + resp_ptr);
+            resp_ptr += 4;
+            break;
+        } else if ((op == STATS_READ_COMMANDS) && (remaining_size >= 3)) {
+            uint8_t num = 0;
+
+            response[resp_ptr++] = DAP_OK;
+            resp_ptr += 2;
+            for (i = request[1]; (i < DAP_STATS_CMD_NUM) && (resp_ptr + STATS_CMD_ENTRY_SIZE <= remaining_size); i++) {
+                if (!stats->cmd[i].count)
+                    continue;
+                response[resp_ptr] = (i < 0x20) ? i : (i - 0x20 + ID_DAP_Vendor0);
+                put_unaligned_le32(stats->cmd[i].count, response + resp_ptr + 1);
+                put_unaligned_le32(stats->cmd[i].min, response + resp_ptr + 5);
+                put_unaligned_le32(stats->cmd[i].max, response + resp_ptr + 9);
+                put_unaligned_le32(stats->cmd[i].total, response + resp_ptr + 13);
+                resp_ptr += STATS_CMD_ENTRY_SIZE;
+                num++;
+            }
+            response[1] = i;
+            response[2] = num;
+            break;
+        } else if (op == STATS_CLEAR) {
+            memset(stats, 0, sizeof(*stats));
+            #if DAP_SWD
+            vsfhal_swd_get_retries();
+            #endif
+            #if DAP_JTAG
+            vsfhal_jtag_get_retries();
+            #endif
+            response[resp_ptr++] = DAP_OK;
+            break;
+        }
+        #endif
+        response[resp_ptr++] = DAP_ERROR;
+    } break;
+    case VENDOR_ID_SWD_ADAPT: {
+        req_ptr = 1;
+        #if DAP_SWD
+        uint8_t mode = request[0];
+
+        if (mode != SWD_ADAPT_QUERY)
+            dap_swd_adapt_enable(param, mode == SWD_ADAPT_ON);
+        response[resp_ptr++] = DAP_OK;
+        if (param->swd_adapt.enable) {
+            response[resp_ptr++] = SWD_ADAPT_ON;
+            put_unaligned_le32(param->swd_adapt.khz * 1000, response + resp_ptr);
+            response[resp_ptr + 4] = param->swd_adapt.idle;
+        } else {
+            response[resp_ptr++] = SWD_ADAPT_OFF;
+            put_unaligned_le32(param->speed_khz * 1000, response + resp_ptr);
+            response[resp_ptr + 4] = param->transfer.idle_cycles;
+        }
+        put_unaligned_le32(param->swd_adapt.parity_errors, response + resp_ptr + 5);
+        put_unaligned_le32(param->swd_adapt.wait_retries, response + resp_ptr + 9);
+        resp_ptr += 13;
+        #else
+        response[resp_ptr++] = DAP_ERROR;
+        #endif
+    } break;
+    #if VENDOR_RTT
+    case VENDOR_ID_RTT_FIND: {
+        uint8_t ap = request[0];
+        uint32_t addr = get_unaligned_le32(request + 1);
+        uint32_t length = get_unaligned_le32(request + 5);
+        uint32_t ack = DAP_TRANSFER_ERROR, cb = 0;
+        rtt_ctx_t ctx;
+
+        req_ptr = 9;
+        param->do_abort = false;
+        vendor_jtag_ir = 0;
+        if (param->port == DAP_PORT_DISABLED) {
+            ack = DAP_ERROR;
+        } else if (!(addr & 0x3) && vendor_port_ready(param)) {
+            ack = rtt_begin(param, &ctx, ap);
+            if (ack == DAP_TRANSFER_OK)
+                ack = rtt_find(param, &ctx, &addr, min(length & ~0x3UL, RTT_FIND_MAX), &cb);
+            ack = rtt_end(param, &ctx, ack);
+        }
+        response[resp_ptr++] = ack;
+        put_unaligned_le32(addr, response + resp_ptr);
+        put_unaligned_le32(cb, response + resp_ptr + 4);
+        resp_ptr += 8;
+    } break;
+    case VENDOR_ID_RTT_POLL: {
+        uint8_t ap = request[0];
+        uint32_t cb = get_unaligned_le32(request + 1);
+        uint16_t up_max = get_unaligned_le16(request + 6);
+        uint16_t down_max = get_unaligned_le16(request + 9);
+        uint16_t up_len = 0, down_len = 0;
+        uint32_t ack = DAP_TRANSFER_ERROR, up_pending = 0;
+        rtt_ctx_t ctx;
+
+        req_ptr = 11 + down_max;
+        param->do_abort = false;
+        vendor_jtag_ir = 0;
+        if (!vendor_data_fits(request_size, 11, down_max)) {
+            // DOWN DATA past the packet, the rest of it can not be parsed
+            req_ptr = request_size;
+        } else if (param->port == DAP_PORT_DISABLED) {
+            ack = DAP_ERROR;
+        } else if ((remaining_size >= 9) && vendor_port_ready(param)) {
+            ack = rtt_begin(param, &ctx, ap);
+            if (ack == DAP_TRANSFER_OK) {
+                // what was moved is returned even if a later access fails
+                down_len = down_max;
+                up_len = min(up_max, remaining_size - 9);
+                ack = rtt_poll(param, &ctx, cb, request + 5, &down_len,
+                        response + resp_ptr + 9, &up_len, &up_pending);
+            }
+            ack = rtt_end(param, &ctx, ack);
+        }
+        response[resp_ptr++] = ack;
+        put_unaligned_le16(down_len, response + resp_ptr);
+        put_unaligned_le32(up_pending, response + resp_ptr + 2);
+        put_unaligned_le16(up_len, response + resp_ptr + 6);
+        resp_ptr += 8 + up_len;
+    } break;
+    #endif  // VENDOR_RTT
+    #if VENDOR_CRC
+    case VENDOR_ID_MEM_CRC: {
+        uint8_t ap = request[0], size = request[1];
+        uint32_t addr = get_unaligned_le32(request + 2);
+        uint32_t length = get_unaligned_le32(request + 6);
+        uint32_t crc = get_unaligned_le32(request + 10), crc_length = 0;
+        uint32_t ack = DAP_TRANSFER_ERROR;
+        // word aligned for the CRC unit
+        uint8_t *buf = (uint8_t *)(((uintptr_t)response + 9 + 3) & ~(uintptr_t)3);
+        uint16_t buf_size = (remaining_size > (buf - response)) ? (remaining_size - (buf - response)) : 0;
+
+        req_ptr = 14;
+        if ((buf_size >= 4) && param->crc32
+                && vendor_mem_start(param, cmd_id, size, addr, length)) {
+            ack = vendor_mem_setup(param, ap, size);
+            if (ack == DAP_TRANSFER_OK)
+                ack = vendor_mem_crc(param, buf, buf_size, &crc, &crc_length);
+            vendor_mem_stop(param, ack);
+        }
+        response[resp_ptr++] = ack;
+        put_unaligned_le32(crc_length, response + resp_ptr);
+        put_unaligned_le32(crc, response + resp_ptr + 4);
+        resp_ptr += 8;
+    } break;
+    #endif  // VENDOR_CRC
+    #if VENDOR_MULTIDROP
+    case VENDOR_ID_SWD_TARGETSEL: {
+        uint32_t targetsel = get_unaligned_le32(request);
+        uint32_t ack = DAP_TRANSFER_ERROR, dpidr = 0;
+
+        req_ptr = 4;
+        if (param->port == DAP_PORT_SWD)
+            ack = vendor_swd_targetsel(param, targetsel, &dpidr);
+        response[resp_ptr++] = ack;
+        put_unaligned_le32(dpidr, response + resp_ptr);
+        resp_ptr += 4;
+    } break;
+    #endif  // VENDOR_MULTIDROP
+    #if VENDOR_SCRIPT
+    case VENDOR_ID_SCRIPT_LOAD: {
+        uint16_t offset = get_unaligned_le16(request);
+        uint16_t length = get_unaligned_le16(request + 2);
+
+        req_ptr = 4 + length;
+        if (!vendor_data_fits(request_size, 4, length)) {
+            // DATA past the packet, the rest of it can not be parsed
+            req_ptr = request_size;
+            response[resp_ptr++] = DAP_ERROR;
+        } else if (dap_vendor_stream_pending(param)) {
+            // not under a script running for another client
+            response[resp_ptr++] = DAP_ERROR;
+        } else {
+            response[resp_ptr++] = dap_script_load(offset, request + 4, length) ? DAP_OK : DAP_ERROR;
+        }
+        put_unaligned_le16(dap_script_size(), response + resp_ptr);
+        resp_ptr += 2;
+    } break;
+    case VENDOR_ID_SCRIPT_RUN: {
+        uint8_t num = request[0];
+
+        req_ptr = 1 + 4 * num;
+        if (dap_vendor_stream_pending(param)) {
+            response[resp_ptr++] = DAP_TRANSFER_ERROR;
+            response[resp_ptr++] = 0;
+            put_unaligned_le16(0, response + resp_ptr);
+            resp_ptr += 2;
+            break;
+        }
+        param->do_abort = false;
+        param->vendor_mem.remain = 0;
+        vendor_jtag_ir = 0;
+        if ((remaining_size >= 4) && vendor_port_ready(param)
+                && dap_script_start(param, num, request + 1)) {
+            param->vendor_mem.cmd = cmd_id;
+            resp_ptr = dap_script_run(response, remaining_size);
+            break;
+        }
+        response[resp_ptr++] = DAP_TRANSFER_ERROR;
+        response[resp_ptr++] = 0;
+        put_unaligned_le16(0, response + resp_ptr);
+        resp_ptr += 2;
+    } break;
+    #endif  // VENDOR_SCRIPT
+    case VENDOR_ID_SWD_CACHE: {
+        req_ptr = 1;
+        #if DAP_SWD
+        uint8_t mode = request[0];
+
+        if (mode != SWD_CACHE_QUERY)
+            dap_swd_cache_enable(param, mode == SWD_CACHE_ON);
+        response[resp_ptr++] = DAP_OK;
+        response[resp_ptr++] = param->swd_cache.enable ? SWD_CACHE_ON : SWD_CACHE_OFF;
+        #else
+        response[resp_ptr++] = DAP_ERROR;
+        #endif
     } break;
     default:
         break;
     }
     return ((uint32_t)resp_ptr << 16) | req_ptr;
 }
+
+bool dap_vendor_stream_pending(dap_param_t* param)
+{
+#if VENDOR_SCRIPT
+    if (param->vendor_mem.cmd == VENDOR_ID_SCRIPT_RUN)
+        return dap_script_pending();
+#endif
+    return param->vendor_mem.remain != 0;
+}
+
+// resume: requests of other clients ran since the last part
+uint16_t dap_vendor_stream_handler(dap_param_t* param, uint8_t* response,
+        uint16_t pkt_size, bool resume)
+{
+    uint16_t resp_ptr = 0;
+    uint32_t ack;
+
+    response[resp_ptr++] = param->vendor_mem.cmd;
+    switch (param->vendor_mem.cmd) {
+    case VENDOR_ID_MEM_READ:
+        vendor_jtag_ir = 0;
+        if (resume) {
+            ack = vendor_mem_setup(param, param->vendor_mem.ap, param->vendor_mem.size);
+            if (ack != DAP_TRANSFER_OK) {
+                vendor_mem_stop(param, ack);
+                response[resp_ptr++] = ack;
+                put_unaligned_le16(0, response + resp_ptr);
+                resp_ptr += 2;
+                break;
+            }
+        }
+        resp_ptr += vendor_mem_read(param, response + resp_ptr, pkt_size - resp_ptr);
+        break;
+    #if VENDOR_SCRIPT
+    case VENDOR_ID_SCRIPT_RUN:
+        vendor_jtag_ir = 0;
+        if (resume)
+            dap_script_resume();
+        resp_ptr += dap_script_run(response + resp_ptr, pkt_size - resp_ptr);
+        break;
+    #endif
+    default:
+        param->vendor_mem.remain = 0;
+        response[resp_ptr++] = DAP_TRANSFER_ERROR;
+        break;
+    }
+    return resp_ptr;
+}
+
+void dap_vendor_stream_cancel(dap_param_t* param)
+{
+    param->vendor_mem.remain = 0;
+#if VENDOR_SCRIPT
+    dap_script_stop();
+#endif
+}
@@ -5,8 +5,15 @@
 extern "C" {
 #endif
 
-uint32_t dap_vendor_request_handler(dap_param_t* param, uint8_t* request,
+uint32_t dap_vendor_request_handler(dap_param_t* param, uint8_t* request, uint16_t request_size,
         uint8_t* response, uint8_t cmd_id, uint16_t remaining_size);
+bool dap_vendor_stream_pending(dap_param_t* param);
+uint16_t dap_vendor_stream_handler(dap_param_t* param, uint8_t* response,
+        uint16_t pkt_size, bool resume);
+void dap_vendor_stream_cancel(dap_param_t* param);
+#if VENDOR_SCRIPT
+uint32_t dap_vendor_transfer(dap_param_t* param, uint32_t request, uint32_t* data);
+#endif
 
 #ifdef __cplusplus
 }
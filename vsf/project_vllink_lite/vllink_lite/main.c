@@ -7,20 +7,31 @@
 #include "dap/dap.h"
 #include "vsf_usbd_cmsis_dap_v2.h"
 #include "vsf_usbd_webusb_usr.h"
+#include "vsf_usbd_cmsis_dap_v1.h"
 
 #ifdef APP_CFG_CDCSHELL_SUPPORT
+#ifdef APP_CFG_CDCSHELL_DAPHOST
+#include "dap/dap_rtt.h"
+#else
 #include "shell/extrauart.h"
 #include "shell/help.h"
 #endif
+#endif
 
 /*============================ PROTOTYPES ====================================*/
 
 static uint16_t usrapp_get_serial(uint8_t *serial);
 static void usrapp_config_usart(enum usart_idx_t idx, uint32_t *mode, uint32_t *baudrate, vsf_stream_t *tx, vsf_stream_t *rx, bool return_actual_baud);
 static uint32_t usrapp_get_usart_baud(enum usart_idx_t idx, uint32_t baudrate);
+#if SWO_MANCHESTER
+static void usrapp_config_manchester(uint32_t baudrate, vsf_stream_t *rx);
+#endif
 static vsf_err_t usrapp_cdcext_set_line_coding(usb_cdcacm_line_coding_t *line_coding);
 static vsf_err_t usrapp_cdcext_set_control_line(uint8_t control_line);
 static vsf_err_t usrapp_cdcshell_set_line_coding(usb_cdcacm_line_coding_t *line_coding);
+#ifdef APP_CFG_CDCSHELL_DAPHOST
+static vsf_err_t usrapp_cdcshell_set_control_line(uint8_t control_line);
+#endif
 
 /*============================ MACROS ========================================*/
 /*============================ MACROFIED FUNCTIONS ===========================*/
@@ -32,14 +43,17 @@ typedef struct usrapp_t {
     uint32_t usart_ext_mode;
     uint32_t usart_ext_baud;
     #if SWO_UART
-    //uint32_t usart_swo_mode;
-    //uint32_t usart_swo_baud;
+    uint32_t usart_swo_mode;
+    uint32_t usart_swo_baud;
     #endif
 
     #ifdef APP_CFG_CDCSHELL_SUPPORT
     uint32_t cdc_shell_usart_mode;
     uint32_t cdc_shell_usart_baud;
     #endif
+    #ifdef APP_CFG_CDCSHELL_DAPHOST
+    dap_rtt_t rtt;
+    #endif
 } usrapp_t;
 
 /*============================ GLOBAL VARIABLES ==============================*/
@@ -51,6 +65,17 @@ usrapp_t usrapp                 = {
         .get_serial             = usrapp_get_serial,
         .config_usart           = usrapp_config_usart,
         .get_usart_baud         = usrapp_get_usart_baud,
+        .get_usart_dropped      = vsfhal_usart_stream_get_dropped,
+        #endif
+        #if SWO_UART && SWO_STREAM && defined(USART_STREAM_RX_DIRECT)
+        .hold_usart_rx          = vsfhal_usart_stream_rx_hold,
+        #endif
+        #if SWO_MANCHESTER
+        .config_manchester      = usrapp_config_manchester,
+        .get_manchester_dropped = vsfhal_swo_manchester_get_dropped,
+        #endif
+        #if VENDOR_CRC
+        .crc32                  = vsfhal_crc32,
         #endif
         #if VENDOR_UART
         .ext_tx = {
@@ -78,6 +103,15 @@ usrapp_t usrapp                 = {
         #endif
         .do_abort               = false,
     },
+    #ifdef APP_CFG_CDCSHELL_DAPHOST
+    .rtt                        = {
+        .ap                     = 0,
+        .up_channel             = 0,
+        .down_channel           = 0,
+        .scan_addr              = VENDOR_RTT_SCAN_ADDR,
+        .scan_size              = VENDOR_RTT_SCAN_SIZE,
+    },
+    #endif
 };
 
 /*============================ PROTOTYPES ====================================*/
@@ -194,6 +228,13 @@ static uint32_t usrapp_get_usart_baud(enum usart_idx_t idx, uint32_t baudrate)
     return vsfhal_usart_config(idx, baudrate, USART_GET_BAUD_ONLY);
 }
 
+#if SWO_MANCHESTER
+static void usrapp_config_manchester(uint32_t baudrate, vsf_stream_t *rx)
+{
+    vsfhal_swo_manchester_config(baudrate, USART_STREAM_EDA_PRIORITY, PERIPHERAL_SWO_MANCHESTER_PRIORITY, rx);
+}
+#endif
+
 static vsf_callback_timer_t cb_timer;
 
 #define DAP_TEST_PORT                   0   // 0, DAP_PORT_SWD, DAP_PORT_JTAG
@@ -342,8 +383,16 @@ static vsf_err_t usrapp_cdcshell_set_line_coding(usb_cdcacm_line_coding_t *line_
 }
 #endif
 
-#ifdef APP_CFG_CDCSHELL_SUPPORT
-
+#ifdef APP_CFG_CDCSHELL_DAPHOST
+// the terminal opening the port starts RTT, a new scan each time
+static vsf_err_t usrapp_cdcshell_set_control_line(uint8_t control_line)
+{
+    if (control_line & (0x1 << 0))
+        dap_rtt_start(&usrapp.rtt);
+    else
+        dap_rtt_stop(&usrapp.rtt);
+    return VSF_ERR_NONE;
+}
 #endif
 
 #if 0
@@ -455,7 +504,15 @@ int main(void)
     #endif
 
     dap_init(&usrapp.dap, vsf_prio_0);
+    #ifdef APP_CFG_CDCSHELL_DAPHOST
+    usrapp.rtt.tx = (vsf_stream_t *)&cdcshell_shell2usb_stream;
+    usrapp.rtt.rx = (vsf_stream_t *)&cdcshell_usb2shell_stream;
+    dap_rtt_init(&usrapp.rtt, &usrapp.dap);
+    #endif
 
+    #ifdef APP_CFG_USBD_HS_SUPPORT
+    usrapp_usbd_init_speed_desc(false);
+    #endif
     vk_usbd_init(&__usrapp_usbd_vllinklite.usbd.dev);
     vk_usbd_disconnect(&__usrapp_usbd_vllinklite.usbd.dev);
     
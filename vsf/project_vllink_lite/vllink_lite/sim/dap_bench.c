@@ -0,0 +1,754 @@
+/*
+    DAP command stream replay and throughput benchmark.
+
+    Usage: dap_bench [options] stream.dap [stream.dap ...]
+        -k kHz      replace the SWJ clock set by the streams
+        -n count    replay every stream count times
+        -w permille WAIT injection on AP/RDBUFF accesses
+        -f permille bus fault injection on memory accesses
+        -p permille parity error injection on SWD read data
+        -l clocks   AP access latency
+        -s seed     random seed for the injections
+        -q          queue requests back to back instead of waiting for each
+                    response, exercises the request/response ring
+        -d          dump every response in stream format
+        -v          print the command table of every stream
+        -S          read the probe side statistics (DAP_STATS, vendor command
+                    VENDOR_ID_STATS) after the last stream
+        -a          adaptive SWD clock on (VENDOR_ID_SWD_ADAPT), prints the
+                    settings it ends up with
+        -m kHz      SWCLK limit of the wiring, faster SWD reads get parity
+                    errors, for -a
+        -c 0|1      SWD write cache off or on (VENDOR_ID_SWD_CACHE) before the
+                    first stream
+
+    Stream format, one item per line:
+        # comment
+        @ tap <ir_length> <idcode>      append a TAP to the JTAG chain, first is at TDO
+        @ dap <index>                   which TAP is the JTAG-DP, default 0
+        @ targetsel <value>             SWD multi-drop DPv2 answering to this TARGETSEL
+        > <hex bytes>                   DAP request
+        < <hex bytes>                   expected response prefix, "??" matches any byte
+                                        a further "<" is the next part of a streamed
+                                        response (vendor memory read as first command)
+
+    Expected responses are only checked when no injection is active. Speeds
+    are calculated from simulated wire time (SWCLK/TCK cycles at the selected
+    speed plus busy waits), host time is reported separately to catch CPU
+    regressions in the transfer loops.
+*/
+
+/*============================ INCLUDES ======================================*/
+
+#include "vsf.h"
+#include "dap/dap.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <time.h>
+
+/*============================ MACROS ========================================*/
+
+#define BENCH_LINE_SIZE                 (DAP_PACKET_SIZE * 3 + 64)
+#define BENCH_CMD_NUM                   256
+
+/*============================ TYPES =========================================*/
+
+typedef struct bench_item_t {
+    uint8_t req[DAP_PACKET_SIZE];
+    uint16_t req_size;
+    uint8_t expect[DAP_PACKET_SIZE];
+    uint8_t expect_mask[DAP_PACKET_SIZE];
+    uint16_t expect_size;
+    uint32_t line;
+} bench_item_t;
+
+typedef struct bench_stream_t {
+    const char *name;
+    sim_target_cfg_t target;
+    bench_item_t *item;
+    uint32_t item_num;
+} bench_stream_t;
+
+typedef struct bench_cmd_stat_t {
+    uint32_t count;
+    uint64_t host_ns;
+    uint64_t clocks;
+    uint64_t time_ps;
+    uint64_t mem_bytes;
+    uint64_t xfer_bytes;
+} bench_cmd_stat_t;
+
+typedef struct bench_t {
+    dap_t dap;
+    dap_client_t client;            // replays the streams
+    dap_client_t vendor_client;     // requests outside of the streams
+
+    // stream being replayed, responses arrive in request order
+    const bench_stream_t *stream;
+    bench_cmd_stat_t *stream_cmd;
+    uint32_t resp_idx;
+    uint32_t part_idx;              // item of the streamed response in progress
+    uint32_t part_left;             // bytes still to come in further parts
+    uint32_t stream_mismatch;
+    bool check;
+    sim_hal_stat_t last_hal;
+    sim_target_stat_t last_target;
+    uint64_t last_ns;
+
+    sim_target_cfg_t inject;
+    uint32_t repeat;
+    uint16_t khz;
+    int8_t swd_cache;               // -1 to leave it to the probe
+    bool queue;
+    bool dump;
+    bool verbose;
+    bool probe_stats;
+    bool swd_adapt;
+
+    uint8_t vendor_buf[DAP_PACKET_SIZE];
+    uint16_t vendor_size;
+
+    bench_cmd_stat_t cmd[BENCH_CMD_NUM];
+    bench_cmd_stat_t total;
+    uint32_t mismatch;
+} bench_t;
+
+/*============================ LOCAL VARIABLES ===============================*/
+
+static bench_t bench;
+
+/*============================ IMPLEMENTATION ================================*/
+
+static const char *bench_cmd_name(uint8_t id)
+{
+    static const char *const name[] = {
+        [ID_DAP_Info]               = "Info",
+        [ID_DAP_HostStatus]         = "HostStatus",
+        [ID_DAP_Connect]            = "Connect",
+        [ID_DAP_Disconnect]         = "Disconnect",
+        [ID_DAP_TransferConfigure]  = "TransferConfigure",
+        [ID_DAP_Transfer]           = "Transfer",
+        [ID_DAP_TransferBlock]      = "TransferBlock",
+        [ID_DAP_TransferAbort]      = "TransferAbort",
+        [ID_DAP_WriteABORT]         = "WriteABORT",
+        [ID_DAP_Delay]              = "Delay",
+        [ID_DAP_ResetTarget]        = "ResetTarget",
+        [ID_DAP_SWJ_Pins]           = "SWJ_Pins",
+        [ID_DAP_SWJ_Clock]          = "SWJ_Clock",
+        [ID_DAP_SWJ_Sequence]       = "SWJ_Sequence",
+        [ID_DAP_SWD_Configure]      = "SWD_Configure",
+        [ID_DAP_JTAG_Sequence]      = "JTAG_Sequence",
+        [ID_DAP_JTAG_Configure]     = "JTAG_Configure",
+        [ID_DAP_JTAG_IDCODE]        = "JTAG_IDCODE",
+        [ID_DAP_SWO_Transport]      = "SWO_Transport",
+        [ID_DAP_SWO_Mode]           = "SWO_Mode",
+        [ID_DAP_SWO_Baudrate]       = "SWO_Baudrate",
+        [ID_DAP_SWO_Control]        = "SWO_Control",
+        [ID_DAP_SWO_Status]         = "SWO_Status",
+        [ID_DAP_SWO_Data]           = "SWO_Data",
+        [ID_DAP_SWD_Sequence]       = "SWD_Sequence",
+        [ID_DAP_SWO_ExtendedStatus] = "SWO_ExtendedStatus",
+        [ID_DAP_QueueCommands]      = "QueueCommands",
+        [ID_DAP_ExecuteCommands]    = "ExecuteCommands",
+    };
+    static char vendor[16];
+
+    if ((id < dimof(name)) && (name[id] != NULL))
+        return name[id];
+    if (id >= ID_DAP_Vendor0) {
+        snprintf(vendor, sizeof(vendor), "Vendor%d", id - ID_DAP_Vendor0);
+        return vendor;
+    }
+    return "Unknown";
+}
+
+static uint64_t bench_host_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static uint16_t bench_parse_hex(const char *s, uint8_t *buf, uint8_t *mask, uint16_t size, bool *err)
+{
+    uint16_t len = 0;
+    char *end;
+
+    while (*s) {
+        if (isspace((unsigned char)*s) || (*s == ',')) {
+            s++;
+            continue;
+        }
+        if (len >= size) {
+            *err = true;
+            break;
+        }
+        if ((s[0] == '?') && (s[1] == '?')) {
+            buf[len] = 0;
+            if (mask)
+                mask[len] = 0;
+            len++;
+            s += 2;
+            continue;
+        }
+        unsigned long v = strtoul(s, &end, 16);
+        if ((end == s) || (v > 0xff)) {
+            *err = true;
+            break;
+        }
+        buf[len] = v;
+        if (mask)
+            mask[len] = 0xff;
+        len++;
+        s = end;
+    }
+    return len;
+}
+
+static bench_item_t *bench_new_item(bench_stream_t *stream, uint32_t *item_size, uint32_t line_num)
+{
+    bench_item_t *item;
+
+    if (stream->item_num >= *item_size) {
+        *item_size = *item_size ? *item_size * 2 : 64;
+        stream->item = realloc(stream->item, *item_size * sizeof(bench_item_t));
+    }
+    item = &stream->item[stream->item_num++];
+    memset(item, 0, sizeof(*item));
+    item->line = line_num;
+    return item;
+}
+
+static bool bench_load(bench_stream_t *stream, const char *name)
+{
+    char line[BENCH_LINE_SIZE], *s;
+    uint32_t line_num = 0, item_size = 0;
+    bench_item_t *item = NULL;
+    bool err = false;
+    FILE *f;
+
+    f = fopen(name, "r");
+    if (f == NULL) {
+        fprintf(stderr, "%s: cannot open\n", name);
+        return false;
+    }
+
+    memset(stream, 0, sizeof(*stream));
+    stream->name = name;
+
+    while (!err && fgets(line, sizeof(line), f)) {
+        line_num++;
+        for (s = line; isspace((unsigned char)*s); s++);
+        if ((*s == '\0') || (*s == '#'))
+            continue;
+
+        switch (*s++) {
+        case '@': {
+            char key[12];
+            long a = 0, b = 0;
+            int n = sscanf(s, "%11s %li %li", key, &a, &b);
+
+            if ((n >= 3) && !strcmp(key, "tap") && (stream->target.tap_count < SIM_TARGET_TAP_MAX)) {
+                stream->target.tap_ir_length[stream->target.tap_count] = a;
+                stream->target.tap_idcode[stream->target.tap_count] = b;
+                stream->target.tap_count++;
+            } else if ((n >= 2) && !strcmp(key, "dap")) {
+                stream->target.tap_dap = a;
+            } else if ((n >= 2) && !strcmp(key, "targetsel")) {
+                stream->target.targetsel = a;
+            } else {
+                err = true;
+            }
+            break;
+        }
+        case '>':
+            item = bench_new_item(stream, &item_size, line_num);
+            item->req_size = bench_parse_hex(s, item->req, NULL, sizeof(item->req), &err);
+            if (!item->req_size)
+                err = true;
+            else if ((item->req[0] == ID_DAP_SWJ_Clock) && bench.khz)
+                put_unaligned_le32(bench.khz * 1000, &item->req[1]);
+            break;
+        case '<':
+            if (item == NULL) {
+                err = true;
+                break;
+            }
+            // next part of a streamed response, nothing to send
+            if (item->expect_size)
+                item = bench_new_item(stream, &item_size, line_num);
+            item->expect_size = bench_parse_hex(s, item->expect, item->expect_mask, sizeof(item->expect), &err);
+            break;
+        default:
+            err = true;
+            break;
+        }
+    }
+    fclose(f);
+
+    if (err)
+        fprintf(stderr, "%s:%u: syntax error\n", name, line_num);
+    return !err;
+}
+
+static void bench_print_hex(const char *prefix, const uint8_t *buf, uint16_t size)
+{
+    uint16_t i;
+
+    printf("%s", prefix);
+    for (i = 0; i < size; i++)
+        printf(" %02x", buf[i]);
+    printf("\n");
+}
+
+static bool bench_check(const bench_stream_t *stream, const bench_item_t *item,
+        const uint8_t *buf, uint16_t size)
+{
+    uint16_t i;
+
+    if (size >= item->expect_size) {
+        for (i = 0; i < item->expect_size; i++) {
+            if ((buf[i] ^ item->expect[i]) & item->expect_mask[i])
+                break;
+        }
+        if (i == item->expect_size)
+            return true;
+    }
+
+    fprintf(stderr, "%s:%u: response mismatch\n", stream->name, item->line);
+    bench_print_hex("    expect  <", item->expect, item->expect_size);
+    bench_print_hex("    actual  <", buf, size);
+    return false;
+}
+
+static void bench_stat_add(bench_cmd_stat_t *dst, const bench_cmd_stat_t *src)
+{
+    dst->count += src->count;
+    dst->host_ns += src->host_ns;
+    dst->clocks += src->clocks;
+    dst->time_ps += src->time_ps;
+    dst->mem_bytes += src->mem_bytes;
+    dst->xfer_bytes += src->xfer_bytes;
+}
+
+static void bench_stat_print(const char *name, const bench_cmd_stat_t *s)
+{
+    double sec = s->time_ps / 1e12;
+
+    printf("%-20s %8u", name, s->count);
+    if (sec)
+        printf(" %10.0f %12.0f %12.0f", s->count / sec, s->xfer_bytes / sec, s->mem_bytes / sec);
+    else
+        printf(" %10s %12s %12s", "-", "-", "-");
+    // wire efficiency: memory payload bits per SWCLK/TCK cycle
+    if (s->clocks)
+        printf(" %7.1f%%", s->mem_bytes * 800.0 / s->clocks);
+    else
+        printf(" %8s", "-");
+    printf(" %9.2f\n", s->count ? s->host_ns / 1000.0 / s->count : 0);
+}
+
+static void bench_table(const char *title, const bench_cmd_stat_t *cmd, const bench_cmd_stat_t *total)
+{
+    uint32_t i;
+
+    printf("\n%s\n", title);
+    printf("%-20s %8s %10s %12s %12s %8s %9s\n", "command", "count",
+            "cmd/s", "usb B/s", "mem B/s", "wire", "host us");
+    for (i = 0; i < BENCH_CMD_NUM; i++) {
+        if (cmd[i].count)
+            bench_stat_print(bench_cmd_name(i), &cmd[i]);
+    }
+    bench_stat_print("total", total);
+}
+
+// TransferAbort is handled in dap_requset() and never answered, items without
+// request only hold the expected further parts of a streamed response
+static bool bench_has_response(const bench_item_t *item)
+{
+    return item->req_size && (item->req[0] != ID_DAP_TransferAbort);
+}
+
+// vendor memory read answers until LENGTH is sent or STATUS is not OK,
+// response is CMD, STATUS, DATA LENGTH[2], DATA. A script answers while
+// MORE is set, response is CMD, STATUS, MORE, RESULT LENGTH[2], RESULTS
+static uint32_t bench_part_left(const uint8_t *req, uint32_t left, const uint8_t *buf, uint16_t size)
+{
+    uint16_t length;
+
+    if (req[0] == ID_DAP_Vendor21)
+        return (size >= 3) && buf[2];
+    if (req[0] != ID_DAP_Vendor6)
+        return 0;
+    if (!left)
+        left = get_unaligned_le32(&req[7]);
+    if ((size < 4) || (buf[1] != DAP_TRANSFER_OK))
+        return 0;
+    length = get_unaligned_le16(&buf[2]);
+    return (length < left) ? left - length : 0;
+}
+
+// wire and host time since the previous response is charged to this command
+static void bench_response(void *p, uint8_t *buf, uint16_t size)
+{
+    bench_t *b = p;
+    const bench_stream_t *stream = b->stream;
+    const bench_item_t *item, *expect = NULL;
+    bench_cmd_stat_t *s;
+    uint64_t ns = bench_host_ns();
+    bool part = b->part_left != 0;
+
+    if (part) {
+        item = &stream->item[b->part_idx];
+        if ((b->resp_idx < stream->item_num) && !stream->item[b->resp_idx].req_size)
+            expect = &stream->item[b->resp_idx++];
+    } else {
+        while ((b->resp_idx < stream->item_num) && !bench_has_response(&stream->item[b->resp_idx]))
+            b->resp_idx++;
+        if (b->resp_idx >= stream->item_num) {
+            fprintf(stderr, "%s: unexpected response\n", stream->name);
+            b->stream_mismatch++;
+            dap_response_done(&b->dap, buf);
+            return;
+        }
+        b->part_idx = b->resp_idx;
+        item = expect = &stream->item[b->resp_idx++];
+    }
+    b->part_left = bench_part_left(item->req, b->part_left, buf, size);
+
+    // a streamed response counts as one command
+    s = &b->stream_cmd[item->req[0]];
+    if (!part) {
+        s->count++;
+        s->xfer_bytes += item->req_size;
+    }
+    s->host_ns += ns - b->last_ns;
+    s->clocks += sim_hal_stat.clocks - b->last_hal.clocks;
+    s->time_ps += (sim_hal_stat.wire_ps + sim_hal_stat.idle_ps)
+            - (b->last_hal.wire_ps + b->last_hal.idle_ps);
+    s->mem_bytes += (sim_target_stat.mem_read_bytes + sim_target_stat.mem_write_bytes)
+            - (b->last_target.mem_read_bytes + b->last_target.mem_write_bytes);
+    s->xfer_bytes += size;
+
+    if (b->dump) {
+        if (!part)
+            bench_print_hex(">", item->req, item->req_size);
+        bench_print_hex("<", buf, size);
+    }
+    if (b->check && expect && expect->expect_size && !bench_check(stream, expect, buf, size))
+        b->stream_mismatch++;
+
+    b->last_hal = sim_hal_stat;
+    b->last_target = sim_target_stat;
+    b->last_ns = bench_host_ns();
+
+    // the IN endpoint is free again at once
+    dap_response_done(&b->dap, buf);
+}
+
+static uint32_t bench_run(const bench_stream_t *stream, bool check)
+{
+    bench_cmd_stat_t cmd[BENCH_CMD_NUM], total;
+    sim_target_cfg_t cfg = bench.inject;
+    uint32_t i;
+    uint8_t *buf;
+
+    cfg.tap_count = stream->target.tap_count;
+    cfg.tap_dap = stream->target.tap_dap;
+    memcpy(cfg.tap_ir_length, stream->target.tap_ir_length, sizeof(cfg.tap_ir_length));
+    memcpy(cfg.tap_idcode, stream->target.tap_idcode, sizeof(cfg.tap_idcode));
+    cfg.targetsel = stream->target.targetsel;
+    sim_target_init(&cfg);
+    sim_hal_reset();
+
+    memset(cmd, 0, sizeof(cmd));
+    bench.stream = stream;
+    bench.stream_cmd = cmd;
+    bench.resp_idx = 0;
+    bench.part_left = 0;
+    bench.stream_mismatch = 0;
+    bench.check = check;
+    bench.last_hal = sim_hal_stat;
+    bench.last_target = sim_target_stat;
+    bench.last_ns = bench_host_ns();
+
+    for (i = 0; i < stream->item_num; i++) {
+        const bench_item_t *item = &stream->item[i];
+
+        if (!item->req_size)
+            continue;
+        // like the usb class, receive the whole (zero padded) packet into
+        // the next dap slot, and hold it while dap has no free slot
+        while (!(buf = dap_request_buf(&bench.dap, &bench.client)))
+            vsf_sim_poll();
+        memcpy(buf, item->req, sizeof(item->req));
+        dap_requset(&bench.dap, &bench.client, buf, sizeof(item->req));
+        if (!bench.queue)
+            vsf_sim_poll();
+    }
+    vsf_sim_poll();
+
+    for (i = bench.resp_idx; i < stream->item_num; i++) {
+        if (bench_has_response(&stream->item[i]) || (check && stream->item[i].expect_size)) {
+            fprintf(stderr, "%s:%u: no response\n", stream->name, stream->item[i].line);
+            bench.stream_mismatch++;
+        }
+    }
+
+    memset(&total, 0, sizeof(total));
+    for (i = 0; i < BENCH_CMD_NUM; i++) {
+        bench_stat_add(&total, &cmd[i]);
+        bench_stat_add(&bench.cmd[i], &cmd[i]);
+    }
+    bench_stat_add(&bench.total, &total);
+
+    if (bench.verbose)
+        bench_table(stream->name, cmd, &total);
+    return bench.stream_mismatch;
+}
+
+static void bench_vendor_response(void *p, uint8_t *buf, uint16_t size)
+{
+    bench_t *b = p;
+
+    memcpy(b->vendor_buf, buf, size);
+    b->vendor_size = size;
+    dap_response_done(&b->dap, buf);
+}
+
+// one vendor request outside of the streams, returns the response size if OK
+#if VENDOR_UART
+/*
+    The EXT UART has its TX wired to RX: ext_tx hands the bytes straight to
+    ext_rx, so a VENDOR_ID_WRITE_USART_DATA is read back by the next
+    VENDOR_ID_READ_USART_DATA whether the requests are queued or not.
+*/
+static void bench_loopback_init(vsf_stream_t *stream)
+{
+}
+
+static uint_fast32_t bench_loopback_write(vsf_stream_t *stream, uint8_t *buf, uint_fast32_t size)
+{
+    return VSF_STREAM_WRITE(&bench.dap.dap_param.ext_rx, buf, size);
+}
+
+static uint_fast32_t bench_loopback_read(vsf_stream_t *stream, uint8_t *buf, uint_fast32_t size)
+{
+    return 0;
+}
+
+static uint_fast32_t bench_loopback_get_buff_length(vsf_stream_t *stream)
+{
+    return VSF_STREAM_GET_BUFF_SIZE(&bench.dap.dap_param.ext_rx);
+}
+
+static uint_fast32_t bench_loopback_get_data_length(vsf_stream_t *stream)
+{
+    return 0;
+}
+
+static uint_fast32_t bench_loopback_get_avail_length(vsf_stream_t *stream)
+{
+    return VSF_STREAM_GET_FREE_SIZE(&bench.dap.dap_param.ext_rx);
+}
+
+static uint_fast32_t bench_loopback_get_rbuf(vsf_stream_t *stream, uint8_t **ptr)
+{
+    return 0;
+}
+
+static const vsf_stream_op_t bench_loopback_op = {
+    .init               = bench_loopback_init,
+    .write              = bench_loopback_write,
+    .read               = bench_loopback_read,
+    .get_buff_length    = bench_loopback_get_buff_length,
+    .get_data_length    = bench_loopback_get_data_length,
+    .get_avail_length   = bench_loopback_get_avail_length,
+    .get_rbuf           = bench_loopback_get_rbuf,
+};
+
+// the settings are taken as they are, the wire has no baudrate
+static void bench_config_usart(enum usart_idx_t idx, uint32_t *mode, uint32_t *baudrate,
+        vsf_stream_t *tx, vsf_stream_t *rx, bool return_actual_baud)
+{
+}
+#endif
+
+static uint16_t bench_vendor_request(uint8_t cmd, uint8_t op, uint8_t index)
+{
+    uint8_t req[DAP_PACKET_SIZE] = {cmd, op, index};
+
+    bench.vendor_size = 0;
+    dap_requset(&bench.dap, &bench.vendor_client, req, sizeof(req));
+    vsf_sim_poll();
+    if ((bench.vendor_size < 2) || (bench.vendor_buf[0] != cmd) || (bench.vendor_buf[1] != DAP_OK))
+        return 0;
+    return bench.vendor_size;
+}
+
+// reference decoder of the probe statistics, times in TIMESTAMP_CLOCK ticks
+static void bench_probe_stats(void)
+{
+    const uint8_t *buf = bench.vendor_buf;
+    uint32_t clock, requests, i, index = 0;
+    double us;
+
+    if (bench_vendor_request(ID_DAP_Vendor14, 0, 0) < 35) {
+        printf("\nprobe statistics not available, build with DAP_STATS\n");
+        return;
+    }
+    clock = get_unaligned_le32(&buf[2]);
+    requests = get_unaligned_le32(&buf[6]);
+    us = 1000000.0 / clock;
+    printf("\nprobe statistics\n");
+    printf("requests %u, response wait total %.1f us max %.1f us\n", requests,
+            get_unaligned_le32(&buf[10]) * us, get_unaligned_le32(&buf[14]) * us);
+    printf("WAIT retries swd %u jtag %u, bytes swd %u jtag %u\n",
+            (uint32_t)get_unaligned_le32(&buf[18]), (uint32_t)get_unaligned_le32(&buf[22]),
+            (uint32_t)get_unaligned_le32(&buf[26]), (uint32_t)get_unaligned_le32(&buf[30]));
+    printf("queue depth");
+    for (i = 0; i < buf[34]; i++)
+        printf(" %u:%u", i + 1, (uint32_t)get_unaligned_le32(&buf[35 + i * 4]));
+    printf("\nSWD writes cached %u", (uint32_t)get_unaligned_le32(&buf[35 + i * 4]));
+    printf("\n%-20s %8s %10s %10s %10s\n", "command", "count", "min us", "avg us", "max us");
+
+    while (index < 0x40) {
+        if (bench_vendor_request(ID_DAP_Vendor14, 1, index) < 4)
+            break;
+        for (i = 0; i < buf[3]; i++) {
+            const uint8_t *entry = &buf[4 + i * 17];
+            uint32_t count = get_unaligned_le32(&entry[1]);
+
+            printf("%-20s %8u %10.1f %10.1f %10.1f\n", bench_cmd_name(entry[0]), count,
+                    get_unaligned_le32(&entry[5]) * us,
+                    get_unaligned_le32(&entry[13]) * us / count,
+                    get_unaligned_le32(&entry[9]) * us);
+        }
+        index = buf[2];
+    }
+}
+
+static void bench_swd_adapt(void)
+{
+    const uint8_t *buf = bench.vendor_buf;
+
+    if (bench_vendor_request(ID_DAP_Vendor15, 0xff, 0) < 16) {
+        printf("\nadaptive SWD clock not available\n");
+        return;
+    }
+    printf("\nadaptive SWD clock %u kHz, idle %u, parity errors %u, WAIT retries %u\n",
+            (uint32_t)get_unaligned_le32(&buf[3]) / 1000, buf[7],
+            (uint32_t)get_unaligned_le32(&buf[8]), (uint32_t)get_unaligned_le32(&buf[12]));
+}
+
+static void bench_usage(void)
+{
+    fprintf(stderr, "usage: dap_bench [-k kHz] [-n count] [-w permille] [-f permille] [-p permille]\n"
+                    "                 [-l clocks] [-s seed] [-m kHz] [-c 0|1] [-q] [-d] [-v] [-S] [-a]\n"
+                    "                 stream.dap ...\n");
+    exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+    bench_stream_t stream;
+    bool check;
+    int i, r, streams;
+
+    bench.repeat = 1;
+    bench.inject.seed = 1;
+    bench.khz = 0;
+    bench.swd_cache = -1;
+
+    for (i = 1; (i < argc) && (argv[i][0] == '-'); i++) {
+        char opt = argv[i][1];
+
+        if (opt == 'q') {
+            bench.queue = true;
+            continue;
+        } else if (opt == 'd') {
+            bench.dump = true;
+            continue;
+        } else if (opt == 'v') {
+            bench.verbose = true;
+            continue;
+        } else if (opt == 'S') {
+            bench.probe_stats = true;
+            continue;
+        } else if (opt == 'a') {
+            bench.swd_adapt = true;
+            continue;
+        }
+        if (++i >= argc)
+            bench_usage();
+
+        unsigned long v = strtoul(argv[i], NULL, 0);
+        switch (opt) {
+        case 'k':   bench.khz = v;                      break;
+        case 'n':   bench.repeat = max(v, 1);           break;
+        case 'w':   bench.inject.wait_permille = v;     break;
+        case 'f':   bench.inject.fault_permille = v;    break;
+        case 'p':   bench.inject.parity_permille = v;   break;
+        case 'l':   bench.inject.ap_latency = v;        break;
+        case 's':   bench.inject.seed = v;              break;
+        case 'm':   bench.inject.wire_khz = v;          break;
+        case 'c':   bench.swd_cache = !!v;              break;
+        default:    bench_usage();
+        }
+    }
+    if (i >= argc)
+        bench_usage();
+
+    check = !bench.inject.wait_permille && !bench.inject.fault_permille
+            && !bench.inject.parity_permille && !bench.inject.wire_khz;
+
+    bench.dap.dap_param.swo_rx.op = &vsf_fifo_stream_op;
+    bench.dap.dap_param.swo_rx.buffer = bench.dap.dap_param.swo_rx_buf;
+    bench.dap.dap_param.swo_rx.size = sizeof(bench.dap.dap_param.swo_rx_buf);
+    VSF_STREAM_INIT(&bench.dap.dap_param.swo_rx);
+    #if VENDOR_UART
+    bench.dap.dap_param.ext_tx.op = &bench_loopback_op;
+    VSF_STREAM_INIT(&bench.dap.dap_param.ext_tx);
+    bench.dap.dap_param.ext_rx.op = &vsf_fifo_stream_op;
+    bench.dap.dap_param.ext_rx.buffer = bench.dap.dap_param.ext_rx_buf;
+    bench.dap.dap_param.ext_rx.size = sizeof(bench.dap.dap_param.ext_rx_buf);
+    VSF_STREAM_INIT(&bench.dap.dap_param.ext_rx);
+    bench.dap.dap_param.swo_tx.op = &vsf_fifo_stream_op;
+    bench.dap.dap_param.swo_tx.buffer = bench.dap.dap_param.swo_tx_buf;
+    bench.dap.dap_param.swo_tx.size = sizeof(bench.dap.dap_param.swo_tx_buf);
+    VSF_STREAM_INIT(&bench.dap.dap_param.swo_tx);
+    bench.dap.dap_param.config_usart = bench_config_usart;
+    #endif
+    #if VENDOR_CRC
+    bench.dap.dap_param.crc32 = vsfhal_crc32;
+    #endif
+    dap_init(&bench.dap, vsf_prio_0);
+    dap_client_init(&bench.dap, &bench.client, bench_response, &bench);
+    dap_client_init(&bench.dap, &bench.vendor_client, bench_vendor_response, &bench);
+    if (bench.swd_adapt)
+        bench_vendor_request(ID_DAP_Vendor15, 1, 0);
+    if (bench.swd_cache >= 0)
+        bench_vendor_request(ID_DAP_Vendor22, bench.swd_cache, 0);
+
+    streams = argc - i;
+    for (; i < argc; i++) {
+        if (!bench_load(&stream, argv[i]))
+            return 2;
+
+        for (r = 0; r < bench.repeat; r++)
+            bench.mismatch += bench_run(&stream, check && !r);
+        free(stream.item);
+    }
+
+    if (!bench.verbose || (streams > 1))
+        bench_table("all streams", bench.cmd, &bench.total);
+    if (bench.probe_stats)
+        bench_probe_stats();
+    if (bench.swd_adapt)
+        bench_swd_adapt();
+    if (bench.mismatch)
+        printf("\n%u mismatch\n", bench.mismatch);
+    return bench.mismatch ? 1 : 0;
+}
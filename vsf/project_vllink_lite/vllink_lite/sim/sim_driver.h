@@ -0,0 +1,11 @@
+/*============================ INCLUDES ======================================*/
+
+// VSF_DRIVER_HEADER of the USB/IP board: the linux driver, plus the simulated
+// SWD/JTAG/GPIO/UART of sim_hal.c in place of a chip driver
+#include "hal/driver/x86/driver.h"
+
+#ifndef __VSF_HEADER_ONLY_SHOW_ARCH_INFO__
+#   include "sim_hal.h"
+#endif
+
+/* EOF */
@@ -0,0 +1,929 @@
+/*
+    Simulated SWD/JTAG HAL for the host build.
+
+    Mirrors the call semantics and the clock count of the GD32F3X0 SWD_SYNC (or
+    SWD_ASYNC, see SIM_SWD_ASYNC) and JTAG_SYNC (or JTAG_ASYNC, see
+    SIM_JTAG_ASYNC) drivers (retry on WAIT, data phase forcing, turnaround and
+    idle cycles, bit layout of IR/DR scans), with the wire connected to sim_target.c
+    instead of GPIO/SPI. Time is derived from the clocks sent at the configured
+    speed, so the results do not depend on the speed of the host.
+*/
+
+/*============================ INCLUDES ======================================*/
+
+#include "vsf.h"
+#include "dap/dap.h"
+
+/*============================ MACROS ========================================*/
+
+#define SWD_SUCCESS                     0x00
+#define SWD_PARITY_ERROR                0x10
+
+#define SWD_ACK_OK                      0x01
+#define SWD_ACK_WAIT                    0x02
+#define SWD_ACK_FAULT                   0x04
+
+#define SWD_TRANS_TIMESTAMP             (1 << 7)
+
+#define SIM_DEFAULT_KHZ                 1000
+
+/*============================ TYPES =========================================*/
+
+typedef struct swd_control_t {
+    uint8_t idle;
+    uint8_t trn;
+    bool data_force;
+    uint16_t retry_limit;
+    uint32_t wait_retries;      // for vsfhal_swd_get_retries
+    uint32_t parity_errors;     // for vsfhal_swd_get_parity_errors
+
+    #if TIMESTAMP_CLOCK
+    uint32_t dap_timestamp;
+    #endif
+
+    #ifdef SWD_ASYNC
+    uint32_t status;
+    bool finish;
+    uint32_t finish_request;
+    uint32_t finish_value;
+    uint8_t *finish_data;
+    #endif
+} swd_control_t;
+
+typedef struct jtag_control_t {
+    uint8_t idle;
+    uint16_t retry_limit;
+    uint32_t wait_retries;      // for vsfhal_jtag_get_retries
+
+    #if TIMESTAMP_CLOCK
+    uint32_t dap_timestamp;
+    #endif
+
+    #ifdef JTAG_ASYNC
+    uint32_t status;
+    bool finish;
+    uint8_t finish_ack_pos;
+    uint8_t finish_bitlen;
+    uint8_t *finish_tms;
+    uint8_t *finish_tdi;
+    uint8_t *finish_tdo;
+    #endif
+} jtag_control_t;
+
+/*============================ GLOBAL VARIABLES ==============================*/
+
+sim_hal_stat_t sim_hal_stat;
+
+/*============================ LOCAL VARIABLES ===============================*/
+
+static swd_control_t swd_control;
+static jtag_control_t jtag_control;
+static uint32_t gpio_latch[GPIO_IDX_NUM];
+// set up for vendor requests before the first sim_hal_reset()
+static uint32_t sim_khz = SIM_DEFAULT_KHZ;
+static uint64_t sim_ps_per_clock = 1000000000ull / SIM_DEFAULT_KHZ;
+static uint64_t sim_idle_rem_ps;
+
+// same fixed APB table as the GD32F3X0 drivers
+static const uint16_t sim_khz_table[] = {
+    32000, 16000, 8000, 4000, 2000, 1000, 500, 250,
+};
+
+/*============================ IMPLEMENTATION ================================*/
+
+static void sim_set_khz(uint32_t kHz)
+{
+    uint32_t i;
+
+    if (kHz < sim_khz_table[dimof(sim_khz_table) - 1])
+        kHz = sim_khz_table[dimof(sim_khz_table) - 1];
+    for (i = 0; i < dimof(sim_khz_table); i++) {
+        if (kHz >= sim_khz_table[i]) {
+            kHz = sim_khz_table[i];
+            break;
+        }
+    }
+    sim_khz = kHz;
+    sim_ps_per_clock = 1000000000ull / kHz;
+}
+
+static void sim_clock(uint32_t cycles)
+{
+    sim_hal_stat.clocks += cycles;
+    sim_hal_stat.wire_ps += cycles * sim_ps_per_clock;
+    sim_target_clock(cycles);
+}
+
+// the target keeps running while the probe waits, in clocks at the current speed
+static void sim_idle(uint64_t ps)
+{
+    sim_hal_stat.idle_ps += ps;
+    sim_idle_rem_ps += ps;
+    sim_target_clock(sim_idle_rem_ps / sim_ps_per_clock);
+    sim_idle_rem_ps %= sim_ps_per_clock;
+}
+
+static uint64_t sim_now_ps(void)
+{
+    return sim_hal_stat.wire_ps + sim_hal_stat.idle_ps;
+}
+
+void sim_hal_reset(void)
+{
+    uint32_t i;
+
+    memset(&sim_hal_stat, 0, sizeof(sim_hal_stat));
+    memset(&swd_control, 0, sizeof(swd_control));
+    memset(&jtag_control, 0, sizeof(jtag_control));
+    sim_idle_rem_ps = 0;
+    // pins not driven by the probe are pulled up on the target side
+    for (i = 0; i < GPIO_IDX_NUM; i++)
+        gpio_latch[i] = 0xffffffff;
+    sim_set_khz(SIM_DEFAULT_KHZ);
+}
+
+uint32_t sim_hal_get_khz(void)
+{
+    return sim_khz;
+}
+
+/*----------------------------------------------------------------------------*
+ * GPIO                                                                       *
+ *----------------------------------------------------------------------------*/
+
+void vsfhal_gpio_init(enum gpio_idx_t idx)
+{
+}
+
+void vsfhal_gpio_fini(enum gpio_idx_t idx)
+{
+}
+
+void vsfhal_gpio_config(enum gpio_idx_t idx, uint32_t pin_mask, uint32_t config)
+{
+}
+
+uint32_t vsfhal_gpio_read(enum gpio_idx_t idx, uint32_t pin_mask)
+{
+    return (idx < GPIO_IDX_NUM) ? gpio_latch[idx] & pin_mask : 0;
+}
+
+void vsfhal_gpio_write(enum gpio_idx_t idx, uint32_t pin_value, uint32_t pin_mask)
+{
+    if (idx < GPIO_IDX_NUM)
+        gpio_latch[idx] = (gpio_latch[idx] & ~pin_mask) | (pin_value & pin_mask);
+}
+
+void vsfhal_gpio_set(enum gpio_idx_t idx, uint32_t pin_mask)
+{
+    if (idx < GPIO_IDX_NUM)
+        gpio_latch[idx] |= pin_mask;
+}
+
+void vsfhal_gpio_clear(enum gpio_idx_t idx, uint32_t pin_mask)
+{
+    if (idx < GPIO_IDX_NUM)
+        gpio_latch[idx] &= ~pin_mask;
+}
+
+/*----------------------------------------------------------------------------*
+ * Timer                                                                      *
+ *----------------------------------------------------------------------------*/
+
+#ifndef BRD_CFG_VLLINKLITE_USBIP
+vsf_systimer_cnt_t vsf_systimer_get_tick(void)
+{
+    // every poll costs 1us, so busy waits in dap.c finish in simulated time
+    sim_idle(1000000);
+    return sim_now_ps() / 1000000;
+}
+#endif
+
+void vsfhal_timestamp_init(uint32_t timestamp, int32_t int_priority)
+{
+}
+
+uint32_t vsfhal_timestamp_get(void)
+{
+    // same as vsf_systimer_get_tick(), polling takes time
+    sim_idle(1000000);
+    #if TIMESTAMP_CLOCK
+    return (uint32_t)((sim_now_ps() / 1000) * (TIMESTAMP_CLOCK / 1000) / 1000000);
+    #else
+    return 0;
+    #endif
+}
+
+/*----------------------------------------------------------------------------*
+ * SWD                                                                        *
+ *----------------------------------------------------------------------------*/
+
+#ifdef SWD_ASYNC
+static uint32_t swd_transfer_data(uint32_t request, uint8_t *data, uint32_t value);
+
+// clock out the frame left on the wire by the last read/write
+static void swd_finish(void)
+{
+    uint32_t ack;
+
+    if (swd_control.finish) {
+        swd_control.finish = false;
+        ack = swd_transfer_data(swd_control.finish_request, swd_control.finish_data, swd_control.finish_value);
+        if (ack != (SWD_ACK_OK | SWD_SUCCESS))
+            swd_control.status = ack;
+    }
+}
+#endif
+
+void vsfhal_swd_init(int32_t int_priority)
+{
+    PERIPHERAL_GPIO_TMS_INIT();
+    PERIPHERAL_GPIO_TCK_INIT();
+    PERIPHERAL_GPIO_SRST_INIT();
+    vsfhal_swd_io_reconfig();
+
+    memset(&swd_control, 0, sizeof(swd_control_t));
+    #ifdef SWD_ASYNC
+    swd_control.status = SWD_ACK_OK | SWD_SUCCESS;
+    #endif
+}
+
+void vsfhal_swd_fini(void)
+{
+}
+
+void vsfhal_swd_io_reconfig(void)
+{
+}
+
+void vsfhal_swd_config(uint16_t kHz, uint16_t retry, uint8_t idle, uint8_t trn, bool data_force)
+{
+    #ifdef SWD_ASYNC
+    swd_finish();
+    #endif
+
+    sim_set_khz(kHz);
+
+    if (idle <= (32 * 6))
+        swd_control.idle = idle;
+    else
+        swd_control.idle = 32 * 6;
+    if (trn <= 14)
+        swd_control.trn = trn;
+    else
+        swd_control.trn = 14;
+    swd_control.data_force = data_force;
+    swd_control.retry_limit = retry;
+}
+
+void vsfhal_swd_seqout(uint8_t *data, uint32_t bitlen)
+{
+    #ifdef SWD_ASYNC
+    swd_finish();
+    #endif
+    sim_target_swj_bits(data, bitlen);
+    sim_clock(bitlen);
+}
+
+void vsfhal_swd_seqin(uint8_t *data, uint32_t bitlen)
+{
+    uint32_t bytes = (bitlen + 7) >> 3;
+
+    #ifdef SWD_ASYNC
+    swd_finish();
+    #endif
+
+    // nobody drives SWDIO here, the pull-up reads as ones
+    memset(data, 0xff, bytes);
+    if (bitlen & 0x7)
+        data[bytes - 1] &= (1 << (bitlen & 0x7)) - 1;
+    sim_clock(bitlen);
+}
+
+// Data phase of an OK frame, left on the wire until the next call in SWD_ASYNC
+static uint32_t swd_transfer_data(uint32_t request, uint8_t *data, uint32_t value)
+{
+    // read:  Data:[R]*32 --> Parity:[R]*1 -> Trn:[C]*trn --> Idle:[C]*idle
+    // write: Trn:[C]*trn --> Data:[W]*32 --> Parity:[W]*1 -> Idle:[C]*idle
+    sim_clock(swd_control.trn + 33 + swd_control.idle);
+
+    #if TIMESTAMP_CLOCK
+    if (request & SWD_TRANS_TIMESTAMP)
+        swd_control.dap_timestamp = vsfhal_timestamp_get();
+    #endif
+
+    if (request & DAP_TRANSFER_RnW) {
+        if (data)
+            put_unaligned_le32(value, data);
+        if (sim_target_parity_glitch(sim_khz)) {
+            swd_control.parity_errors++;
+            return SWD_ACK_OK | SWD_PARITY_ERROR;
+        }
+    }
+    return SWD_ACK_OK | SWD_SUCCESS;
+}
+
+static uint32_t swd_transfer(uint32_t request, uint8_t *data)
+{
+    bool read = request & DAP_TRANSFER_RnW;
+    uint32_t ack, value, retry = 0;
+
+    while (1) {
+        sim_hal_stat.swd_transfers++;
+
+        // Request:[W]*8 --> TRN:[C]*trn --> ACK:[R]*3
+        sim_clock(8 + swd_control.trn + 3);
+        value = (!read && data) ? get_unaligned_le32(data) : 0;
+        ack = sim_target_swd_transfer(request & 0xf, &value);
+
+        if (ack == SWD_ACK_OK) {
+            #ifdef SWD_ASYNC
+            swd_control.finish_request = request;
+            swd_control.finish_value = value;
+            swd_control.finish_data = data;
+            swd_control.finish = true;
+            return SWD_ACK_OK | SWD_SUCCESS;
+            #else
+            return swd_transfer_data(request, data, value);
+            #endif
+        } else if ((ack == SWD_ACK_WAIT) || (ack == SWD_ACK_FAULT)) {
+            // [Data:[C]*32 --> Parity:[C]*1] -> Trn:[C]*trn
+            sim_clock(swd_control.trn + (swd_control.data_force ? 33 : 0));
+
+            if ((ack == SWD_ACK_WAIT) && (retry++ < swd_control.retry_limit)) {
+                sim_hal_stat.swd_retries++;
+                swd_control.wait_retries++;
+                continue;
+            }
+            return ack;
+        } else {
+            // Data:[C]*32 --> Parity:[C]*1
+            sim_clock(33);
+            return ack;
+        }
+    }
+}
+
+#ifdef SWD_ASYNC
+uint32_t vsfhal_swd_read(uint32_t request, uint8_t *r_data)
+{
+    uint32_t ack;
+
+    swd_finish();
+    if (swd_control.status == (SWD_ACK_OK | SWD_SUCCESS)) {
+        ack = swd_transfer(request | DAP_TRANSFER_RnW, r_data);
+        if (ack != (SWD_ACK_OK | SWD_SUCCESS))
+            swd_control.status = ack;
+    }
+    return swd_control.status;
+}
+
+uint32_t vsfhal_swd_write(uint32_t request, uint8_t *w_data)
+{
+    uint32_t ack;
+
+    swd_finish();
+    if (swd_control.status == (SWD_ACK_OK | SWD_SUCCESS)) {
+        ack = swd_transfer(request & ~DAP_TRANSFER_RnW, w_data);
+        if (ack != (SWD_ACK_OK | SWD_SUCCESS))
+            swd_control.status = ack;
+    }
+    return swd_control.status;
+}
+
+uint32_t vsfhal_swd_wait(void)
+{
+    swd_finish();
+    return swd_control.status;
+}
+
+void vsfhal_swd_clear(void)
+{
+    swd_finish();
+    swd_control.status = SWD_ACK_OK | SWD_SUCCESS;
+}
+#else
+uint32_t vsfhal_swd_read(uint32_t request, uint8_t *r_data)
+{
+    return swd_transfer(request | DAP_TRANSFER_RnW, r_data);
+}
+
+uint32_t vsfhal_swd_write(uint32_t request, uint8_t *w_data)
+{
+    return swd_transfer(request & ~DAP_TRANSFER_RnW, w_data);
+}
+#endif
+
+#ifdef SWD_BLOCK
+// Same frames as the block mode of the drivers: with data_force the data phase
+// is clocked before the ACK is looked at, a WAIT is redone by swd_transfer().
+static uint32_t swd_transfer_block(uint32_t request, uint8_t *data, uint16_t count, uint16_t *done)
+{
+    bool read = request & DAP_TRANSFER_RnW;
+    uint32_t ack = SWD_ACK_OK, value;
+    uint16_t n;
+
+    for (n = 0; n < count; n++, data += 4) {
+        sim_hal_stat.swd_transfers++;
+
+        // Request:[W]*8 --> TRN:[C]*trn --> ACK:[R]*3
+        sim_clock(8 + swd_control.trn + 3);
+        value = read ? 0 : get_unaligned_le32(data);
+        ack = sim_target_swd_transfer(request & 0xf, &value);
+
+        if ((ack == SWD_ACK_OK) || swd_control.data_force) {
+            sim_clock(swd_control.trn + 33 + swd_control.idle);
+        } else if ((ack == SWD_ACK_WAIT) || (ack == SWD_ACK_FAULT)) {
+            sim_clock(swd_control.trn);
+        } else {
+            sim_clock(33);
+        }
+
+        if (ack == SWD_ACK_OK) {
+            if (read) {
+                put_unaligned_le32(value, data);
+                if (sim_target_parity_glitch(sim_khz)) {
+                    swd_control.parity_errors++;
+                    ack = SWD_ACK_OK | SWD_PARITY_ERROR;
+                    break;
+                }
+            }
+        } else if (ack == SWD_ACK_WAIT) {
+            sim_hal_stat.swd_retries++;
+            swd_control.wait_retries++;
+            ack = swd_transfer(request, data);
+            #ifdef SWD_ASYNC
+            swd_finish();
+            if (ack == (SWD_ACK_OK | SWD_SUCCESS))
+                ack = swd_control.status;
+            #endif
+            if (ack != (SWD_ACK_OK | SWD_SUCCESS))
+                break;
+        } else {
+            break;
+        }
+    }
+    *done = n;
+    return ack;
+}
+
+#ifdef SWD_ASYNC
+// the frame left on the wire goes first, the block is done on return
+uint32_t vsfhal_swd_read_block(uint32_t request, uint8_t *r_data, uint16_t count, uint16_t *done)
+{
+    swd_finish();
+    *done = 0;
+    if (swd_control.status == (SWD_ACK_OK | SWD_SUCCESS))
+        swd_control.status = swd_transfer_block(request | DAP_TRANSFER_RnW, r_data, count, done);
+    return swd_control.status;
+}
+
+uint32_t vsfhal_swd_write_block(uint32_t request, uint8_t *w_data, uint16_t count, uint16_t *done)
+{
+    swd_finish();
+    *done = 0;
+    if (swd_control.status == (SWD_ACK_OK | SWD_SUCCESS))
+        swd_control.status = swd_transfer_block(request & ~DAP_TRANSFER_RnW, w_data, count, done);
+    return swd_control.status;
+}
+#else
+uint32_t vsfhal_swd_read_block(uint32_t request, uint8_t *r_data, uint16_t count, uint16_t *done)
+{
+    return swd_transfer_block(request | DAP_TRANSFER_RnW, r_data, count, done);
+}
+
+uint32_t vsfhal_swd_write_block(uint32_t request, uint8_t *w_data, uint16_t count, uint16_t *done)
+{
+    return swd_transfer_block(request & ~DAP_TRANSFER_RnW, w_data, count, done);
+}
+#endif
+#endif
+
+uint32_t vsfhal_swd_get_retries(void)
+{
+    uint32_t retries = swd_control.wait_retries;
+    swd_control.wait_retries = 0;
+    return retries;
+}
+
+uint32_t vsfhal_swd_get_parity_errors(void)
+{
+    uint32_t errors = swd_control.parity_errors;
+    swd_control.parity_errors = 0;
+    return errors;
+}
+
+#if TIMESTAMP_CLOCK
+uint32_t vsfhal_swd_get_timestamp(void)
+{
+    #ifdef SWD_ASYNC
+    swd_finish();
+    #endif
+    return swd_control.dap_timestamp;
+}
+#endif
+
+/*----------------------------------------------------------------------------*
+ * JTAG                                                                       *
+ *----------------------------------------------------------------------------*/
+
+static void jtag_rw(uint32_t bitlen, uint8_t *tms, uint8_t *tdi, uint8_t *tdo)
+{
+    uint32_t i;
+    bool bit;
+
+    if (tdo)
+        memset(tdo, 0, (bitlen + 7) >> 3);
+    for (i = 0; i < bitlen; i++) {
+        sim_clock(1);
+        bit = sim_target_jtag_clock((tms[i >> 3] >> (i & 0x7)) & 0x1,
+                (tdi[i >> 3] >> (i & 0x7)) & 0x1);
+        if (tdo && bit)
+            tdo[i >> 3] |= 0x1 << (i & 0x7);
+    }
+}
+
+#ifdef JTAG_ASYNC
+static uint32_t jtag_get_ack(uint8_t *tdo, uint32_t ack_pos)
+{
+    uint32_t ack;
+
+    ack = tdo[ack_pos >> 3] | ((uint32_t)tdo[(ack_pos >> 3) + 1] << 8);
+    ack = (ack >> (ack_pos & 0x7)) & 0x7;
+    return (ack & 0x4) | ((ack & 0x2) >> 1) | ((ack & 0x1) << 1);
+}
+
+// clock the scan left on the wire by the last vsfhal_jtag_raw, repeat on WAIT
+static void jtag_finish(void)
+{
+    uint_fast32_t ack, retry = 0;
+
+    if (!jtag_control.finish)
+        return;
+    jtag_control.finish = false;
+
+    do {
+        if (retry)
+            jtag_control.wait_retries++;
+        sim_hal_stat.jtag_scans++;
+        jtag_rw(jtag_control.finish_bitlen, jtag_control.finish_tms,
+                jtag_control.finish_tdi, jtag_control.finish_tdo);
+        if (!jtag_control.finish_ack_pos)
+            return;
+        ack = jtag_get_ack(jtag_control.finish_tdo, jtag_control.finish_ack_pos);
+        if (ack != DAP_TRANSFER_WAIT)
+            break;
+        sim_hal_stat.jtag_retries++;
+    } while (retry++ < jtag_control.retry_limit);
+
+    if (ack != DAP_TRANSFER_OK)
+        jtag_control.status = ack;
+}
+#endif
+
+void vsfhal_jtag_init(int32_t int_priority)
+{
+    PERIPHERAL_GPIO_TDI_INIT();
+    PERIPHERAL_GPIO_TMS_INIT();
+    PERIPHERAL_GPIO_TCK_INIT();
+    PERIPHERAL_GPIO_TDO_INIT();
+    PERIPHERAL_GPIO_SRST_INIT();
+    PERIPHERAL_GPIO_TRST_INIT();
+    vsfhal_jtag_io_reconfig();
+
+    memset(&jtag_control, 0, sizeof(jtag_control_t));
+    #ifdef JTAG_ASYNC
+    jtag_control.status = DAP_TRANSFER_OK;
+    #endif
+}
+
+void vsfhal_jtag_fini(void)
+{
+}
+
+void vsfhal_jtag_io_reconfig(void)
+{
+}
+
+void vsfhal_jtag_config(uint16_t kHz, uint16_t retry, uint8_t idle)
+{
+    #ifdef JTAG_ASYNC
+    jtag_finish();
+    #endif
+    sim_set_khz(kHz);
+    jtag_control.idle = idle;
+    jtag_control.retry_limit = retry;
+}
+
+#ifdef JTAG_ASYNC
+uint32_t vsfhal_jtag_raw(uint8_t ack_pos, uint8_t bitlen, uint8_t *tms, uint8_t *tdi, uint8_t *tdo)
+{
+    jtag_finish();
+    if (jtag_control.status == DAP_TRANSFER_OK) {
+        #if TIMESTAMP_CLOCK
+        if (ack_pos)     // DAP transfer
+            jtag_control.dap_timestamp = vsfhal_timestamp_get();
+        #endif
+        jtag_control.finish_ack_pos = ack_pos;
+        jtag_control.finish_bitlen = bitlen;
+        jtag_control.finish_tms = tms;
+        jtag_control.finish_tdi = tdi;
+        jtag_control.finish_tdo = tdo;
+        jtag_control.finish = true;
+    }
+    return jtag_control.status;
+}
+
+uint32_t vsfhal_jtag_raw_less_8bit(uint32_t bitlen, uint32_t tms, uint32_t tdi)
+{
+    uint8_t tms_byte = tms, tdi_byte = tdi, tdo_byte;
+
+    jtag_finish();
+    sim_hal_stat.jtag_scans++;
+    jtag_rw(bitlen, &tms_byte, &tdi_byte, &tdo_byte);
+    return tdo_byte;
+}
+
+uint32_t vsfhal_jtag_raw_1bit(uint32_t tms, uint32_t tdi)
+{
+    return vsfhal_jtag_raw_less_8bit(1, tms ? 0x1 : 0x0, tdi ? 0x1 : 0x0);
+}
+
+uint32_t vsfhal_jtag_wait(void)
+{
+    jtag_finish();
+    return jtag_control.status;
+}
+
+void vsfhal_jtag_clear(void)
+{
+    jtag_finish();
+    jtag_control.status = DAP_TRANSFER_OK;
+}
+#else
+void vsfhal_jtag_raw(uint32_t bitlen, uint8_t *tms, uint8_t *tdi, uint8_t *tdo)
+{
+    sim_hal_stat.jtag_scans++;
+    jtag_rw(bitlen, tms, tdi, tdo);
+}
+
+void vsfhal_jtag_ir(uint32_t ir, uint32_t lr_length, uint32_t ir_before, uint32_t ir_after)
+{
+    uint_fast32_t bitlen;
+    uint64_t buf_tms, buf_tdi, buf_tdo;
+
+    buf_tdi = 0;
+    lr_length--;
+
+    // Select-DR-Scan, Select-IR-Scan, Capture-IR, Shift-IR
+    buf_tms = 0x3;
+    bitlen = 4;
+
+    // Bypass before data
+    if (ir_before) {
+        buf_tdi |= (((uint64_t)0x1 << ir_before) - 1) << bitlen;
+        bitlen += ir_before;
+    }
+
+    // Set IR bitlen
+    if (lr_length) {
+        buf_tdi |= (ir & (((uint64_t)0x1 << lr_length) - 1)) << bitlen;
+        bitlen += lr_length;
+    }
+
+    // Bypass after data
+    if (ir_after) {
+        buf_tdi |= ((ir >> lr_length) & 0x1) << bitlen;
+        bitlen++;
+        ir_after--;
+        if (ir_after) {
+            buf_tdi |= (((uint64_t)0x1 << ir_after) - 1) << bitlen;
+            bitlen += ir_after;
+        }
+        buf_tms |= (uint64_t)0x1 << bitlen;
+        buf_tdi |= (uint64_t)0x1 << bitlen;
+        bitlen++;
+    } else {
+        buf_tms |= (uint64_t)0x1 << bitlen;
+        buf_tdi |= ((ir >> lr_length) & 0x1) << bitlen;
+        bitlen++;
+    }
+
+    // Exit1-IR, Update-IR
+    buf_tms |= (uint64_t)0x1 << bitlen;
+    bitlen++;
+    // idle
+    buf_tdi |= (uint64_t)0x1 << bitlen;	// keep tdi high
+    bitlen++;
+
+    sim_hal_stat.jtag_scans++;
+    jtag_rw(bitlen, (uint8_t *)&buf_tms, (uint8_t *)&buf_tdi, (uint8_t *)&buf_tdo);
+}
+
+/*
+Read:	vsfhal_jtag_dr(request, 0, dr_before, dr_after, *read_buf)
+Write:	vsfhal_jtag_dr(request, write_value, dr_before, dr_after, NULL)
+*/
+uint32_t vsfhal_jtag_dr(uint32_t request, uint32_t dr, uint32_t dr_before, uint32_t dr_after, uint8_t *data)
+{
+    uint_fast32_t ack, retry, bitlen;
+    uint64_t buf_tms, buf_tdi, buf_tdo;
+
+    retry = 0;
+    buf_tdi = 0;
+
+    // Select-DR-Scan, Capture-DR, Shift-DR
+    buf_tms = 0x1;
+    bitlen = 3;
+
+    // Bypass before data
+    bitlen += dr_before;
+
+    // RnW, A2, A3
+    buf_tdi |= (uint64_t)((request >> 1) & 0x7) << bitlen;
+    bitlen += 3;
+
+    // Data Transfer
+    if (!(request & DAP_TRANSFER_RnW))
+        buf_tdi |= (uint64_t)dr << bitlen;
+    bitlen += 31 + dr_after;
+    buf_tms |= (uint64_t)0x1 << bitlen;
+    bitlen++;
+
+    // Update-DR, Idle
+    buf_tms |= (uint64_t)0x1 << bitlen;
+    bitlen += 1 + jtag_control.idle;
+    buf_tdi |= (uint64_t)0x1 << bitlen;	// keep tdi high
+    bitlen++;
+
+    #if TIMESTAMP_CLOCK
+    if (request & DAP_TRANSFER_TIMESTAMP)
+        jtag_control.dap_timestamp = vsfhal_timestamp_get();
+    #endif
+
+    do
+    {
+        if (retry)
+            jtag_control.wait_retries++;
+        sim_hal_stat.jtag_scans++;
+        jtag_rw(bitlen, (uint8_t *)&buf_tms, (uint8_t *)&buf_tdi, (uint8_t *)&buf_tdo);
+        ack = (buf_tdo >> (dr_before + 3)) & 0x7;
+        ack = (ack & 0x4) | ((ack & 0x2) >> 1) | ((ack & 0x1) << 1);
+        if (ack != DAP_TRANSFER_WAIT)
+            break;
+        sim_hal_stat.jtag_retries++;
+    } while (retry++ < jtag_control.retry_limit);
+
+    if (data)
+        put_unaligned_le32(buf_tdo >> (dr_before + 6), data);
+    return ack;
+}
+#endif
+
+uint32_t vsfhal_jtag_get_retries(void)
+{
+    uint32_t retries = jtag_control.wait_retries;
+    jtag_control.wait_retries = 0;
+    return retries;
+}
+
+#if TIMESTAMP_CLOCK
+uint32_t vsfhal_jtag_get_timestamp(void)
+{
+    return jtag_control.dap_timestamp;
+}
+#endif
+
+/*----------------------------------------------------------------------------*
+ * CRC                                                                        *
+ *----------------------------------------------------------------------------*/
+
+// the CRC unit of the GD32 takes no simulated time
+uint32_t vsfhal_crc32(uint32_t crc, uint8_t *buff, uint32_t size)
+{
+    crc = ~crc;
+    while (size--) {
+        crc ^= *buff++;
+        for (uint32_t i = 0; i < 8; i++)
+            crc = (crc & 1) ? ((crc >> 1) ^ 0xEDB88320UL) : (crc >> 1);
+    }
+    return ~crc;
+}
+
+#ifdef BRD_CFG_VLLINKLITE_USBIP
+/*----------------------------------------------------------------------------*
+ * USB/IP build: UART loopback, uid and start-up                              *
+ *----------------------------------------------------------------------------*/
+
+typedef struct usart_control_t {
+    uint32_t baudrate;
+    vsf_stream_t *tx;
+    vsf_stream_t *rx;
+    uint32_t dropped;
+    bool busy;
+} usart_control_t;
+
+static usart_control_t usart_control[USART_IDX_NUM];
+
+// the wire does not wait: what does not fit into rx is lost, as on the chip
+static void usart_loopback(usart_control_t *ctrl)
+{
+    uint8_t buf[64];
+    uint32_t size, written;
+
+    if (ctrl->busy || !ctrl->tx)
+        return;
+    ctrl->busy = true;
+    while ((size = VSF_STREAM_READ(ctrl->tx, buf, sizeof(buf))) > 0) {
+        written = ctrl->rx ? VSF_STREAM_WRITE(ctrl->rx, buf, size) : 0;
+        ctrl->dropped += size - written;
+    }
+    ctrl->busy = false;
+}
+
+static void tx_stream_rx_evthandler(void *param, vsf_stream_evt_t evt)
+{
+    if (evt == VSF_STREAM_ON_RX)
+        usart_loopback((usart_control_t *)param);
+}
+
+void vsfhal_usart_init(enum usart_idx_t idx)
+{
+}
+
+void vsfhal_usart_fini(enum usart_idx_t idx)
+{
+    vsfhal_usart_stream_config(idx, 0, 0, NULL, NULL);
+}
+
+uint32_t vsfhal_usart_config(enum usart_idx_t idx, uint32_t baudrate, uint32_t mode)
+{
+    // any baudrate is exact
+    if (!(mode & USART_GET_BAUD_ONLY))
+        usart_control[idx].baudrate = baudrate;
+    return baudrate;
+}
+
+void vsfhal_usart_config_cb(enum usart_idx_t idx, int32_t int_priority, void *p, void (*ontx)(void *), void (*onrx)(void *))
+{
+}
+
+uint16_t vsfhal_usart_tx_bytes(enum usart_idx_t idx, uint8_t *data, uint16_t size)
+{
+    usart_control_t *ctrl = &usart_control[idx];
+    uint32_t written = ctrl->rx ? VSF_STREAM_WRITE(ctrl->rx, data, size) : 0;
+
+    ctrl->dropped += size - written;
+    return size;
+}
+
+void vsfhal_usart_stream_config(enum usart_idx_t idx, int32_t eda_priority, int32_t int_priority, vsf_stream_t *tx, vsf_stream_t *rx)
+{
+    usart_control_t *ctrl = &usart_control[idx];
+
+    if (ctrl->tx) {
+        VSF_STREAM_DISCONNECT_RX(ctrl->tx);
+        ctrl->tx->rx.evthandler = NULL;
+    }
+    if (ctrl->rx)
+        VSF_STREAM_DISCONNECT_TX(ctrl->rx);
+    ctrl->tx = tx;
+    ctrl->rx = rx;
+
+    if (rx)
+        VSF_STREAM_CONNECT_TX(rx);
+    if (tx) {
+        tx->rx.evthandler = tx_stream_rx_evthandler;
+        tx->rx.param = ctrl;
+        VSF_STREAM_CONNECT_RX(tx);
+        usart_loopback(ctrl);
+    }
+}
+
+uint32_t vsfhal_usart_stream_get_dropped(enum usart_idx_t idx)
+{
+    uint32_t dropped = usart_control[idx].dropped;
+    usart_control[idx].dropped = 0;
+    return dropped;
+}
+
+uint32_t vsfhal_uid_read(uint8_t *buffer, uint32_t size)
+{
+    static const uint8_t uid[12] = "VLLINK-USBIP";
+
+    size = min(size, sizeof(uid));
+    memcpy(buffer, uid, size);
+    return size;
+}
+
+// the default target of sim_target.c, before vsf_main_entry(), constructor(255),
+// starts the kernel and main()
+__attribute__((constructor(254)))
+static void sim_hal_usbip_init(void)
+{
+    static const sim_target_cfg_t cfg = {0};
+
+    sim_target_init(&cfg);
+    sim_hal_reset();
+}
+#endif
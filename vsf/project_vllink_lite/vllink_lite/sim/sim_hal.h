@@ -0,0 +1,145 @@
+#ifndef __SIM_HAL_H__
+#define __SIM_HAL_H__
+
+/*============================ INCLUDES ======================================*/
+
+#include "sim_target.h"
+
+/*============================ MACROS ========================================*/
+
+#ifdef SIM_SWD_ASYNC
+#   define SWD_ASYNC
+#else
+#   define SWD_SYNC
+#endif
+#define SWD_BLOCK
+#ifdef SIM_JTAG_ASYNC
+#   define JTAG_ASYNC
+#else
+#   define JTAG_SYNC
+#endif
+
+#define IO_INPUT_FLOAT                  (0x0ul << 0)
+#define IO_INPUT_PULL_UP                (0x1ul << 0)
+#define IO_INPUT_PULL_DOWN              (0x2ul << 0)
+#define IO_OUTPUT_PP                    (0x4ul << 0)
+#define IO_OUTPUT_OD                    (0x8ul << 0)
+#define IO_SPEED_50M                    (0x1ul << 8)
+
+/*============================ TYPES =========================================*/
+
+enum gpio_idx_t {
+    GPIOA_IDX = 0,
+    GPIOB_IDX = 1,
+    GPIO_IDX_NUM,
+    GPIO_INVALID_IDX,
+};
+
+enum usart_idx_t {
+    USART0_IDX = 0,
+    USART1_IDX = 1,
+    USART_IDX_NUM,
+    USART_INVALID_IDX,
+};
+
+enum usart_mode_t {
+    USART_PARITY_NONE       = 0x0 << 9,
+    USART_PARITY_ODD        = 0x3 << 9,
+    USART_PARITY_EVEN       = 0x2 << 9,
+    USART_STOPBITS_1        = 0x0 << 12,
+    USART_STOPBITS_1P5      = 0x3 << 12,
+    USART_STOPBITS_2        = 0x2 << 12,
+
+    USART_GET_BAUD_ONLY     = 0x1ul << 30,
+    USART_RESET_BAUD_ONLY   = 0x1ul << 31,
+};
+
+// wire statistics, cleared by sim_hal_reset()
+typedef struct sim_hal_stat_t {
+    uint64_t clocks;            // SWCLK/TCK cycles
+    uint64_t wire_ps;           // time spent clocking, at the configured speed
+    uint64_t idle_ps;           // time spent in busy waits (DAP_Delay, SWJ_Pins)
+    uint32_t swd_transfers;     // SWD packets, retries included
+    uint32_t swd_retries;       // packets repeated after WAIT
+    uint32_t jtag_scans;        // IR/DR scans and raw sequences
+    uint32_t jtag_retries;      // DR scans repeated after WAIT
+} sim_hal_stat_t;
+
+/*============================ GLOBAL VARIABLES ==============================*/
+
+extern sim_hal_stat_t sim_hal_stat;
+
+/*============================ PROTOTYPES ====================================*/
+
+extern void sim_hal_reset(void);
+extern uint32_t sim_hal_get_khz(void);
+
+extern void vsfhal_gpio_init(enum gpio_idx_t idx);
+extern void vsfhal_gpio_fini(enum gpio_idx_t idx);
+extern void vsfhal_gpio_config(enum gpio_idx_t idx, uint32_t pin_mask, uint32_t config);
+extern uint32_t vsfhal_gpio_read(enum gpio_idx_t idx, uint32_t pin_mask);
+extern void vsfhal_gpio_write(enum gpio_idx_t idx, uint32_t pin_value, uint32_t pin_mask);
+extern void vsfhal_gpio_set(enum gpio_idx_t idx, uint32_t pin_mask);
+extern void vsfhal_gpio_clear(enum gpio_idx_t idx, uint32_t pin_mask);
+
+extern void vsfhal_timestamp_init(uint32_t timestamp, int32_t int_priority);
+extern uint32_t vsfhal_timestamp_get(void);
+
+extern void vsfhal_swd_init(int32_t int_priority);
+extern void vsfhal_swd_fini(void);
+extern void vsfhal_swd_io_reconfig(void);
+extern void vsfhal_swd_config(uint16_t kHz, uint16_t retry, uint8_t idle, uint8_t trn, bool data_force);
+extern void vsfhal_swd_seqout(uint8_t *data, uint32_t bitlen);
+extern void vsfhal_swd_seqin(uint8_t *data, uint32_t bitlen);
+extern uint32_t vsfhal_swd_read(uint32_t request, uint8_t *r_data);
+extern uint32_t vsfhal_swd_write(uint32_t request, uint8_t *w_data);
+#ifdef SWD_BLOCK
+extern uint32_t vsfhal_swd_read_block(uint32_t request, uint8_t *r_data, uint16_t count, uint16_t *done);
+extern uint32_t vsfhal_swd_write_block(uint32_t request, uint8_t *w_data, uint16_t count, uint16_t *done);
+#endif
+#ifdef SWD_ASYNC
+extern uint32_t vsfhal_swd_wait(void);
+extern void vsfhal_swd_clear(void);
+#endif
+extern uint32_t vsfhal_swd_get_retries(void);
+extern uint32_t vsfhal_swd_get_parity_errors(void);
+#if TIMESTAMP_CLOCK
+extern uint32_t vsfhal_swd_get_timestamp(void);
+#endif
+
+extern void vsfhal_jtag_init(int32_t int_priority);
+extern void vsfhal_jtag_fini(void);
+extern void vsfhal_jtag_io_reconfig(void);
+extern void vsfhal_jtag_config(uint16_t kHz, uint16_t retry, uint8_t idle);
+#ifdef JTAG_SYNC
+extern void vsfhal_jtag_raw(uint32_t bitlen, uint8_t *tms, uint8_t *tdi, uint8_t *tdo);
+extern void vsfhal_jtag_ir(uint32_t ir, uint32_t lr_length, uint32_t ir_before, uint32_t ir_after);
+extern uint32_t vsfhal_jtag_dr(uint32_t request, uint32_t dr, uint32_t dr_before, uint32_t dr_after, uint8_t *data);
+#else
+extern uint32_t vsfhal_jtag_raw(uint8_t ack_pos, uint8_t bitlen, uint8_t *tms, uint8_t *tdi, uint8_t *tdo);
+extern uint32_t vsfhal_jtag_raw_less_8bit(uint32_t bitlen, uint32_t tms, uint32_t tdi);
+extern uint32_t vsfhal_jtag_raw_1bit(uint32_t tms, uint32_t tdi);
+extern uint32_t vsfhal_jtag_wait(void);
+extern void vsfhal_jtag_clear(void);
+#endif
+extern uint32_t vsfhal_jtag_get_retries(void);
+#if TIMESTAMP_CLOCK
+extern uint32_t vsfhal_jtag_get_timestamp(void);
+#endif
+
+extern uint32_t vsfhal_crc32(uint32_t crc, uint8_t *buff, uint32_t size);
+
+#ifdef BRD_CFG_VLLINKLITE_USBIP
+// UARTs looped back, tx to rx, on the streams of the real kernel
+extern void vsfhal_usart_init(enum usart_idx_t idx);
+extern void vsfhal_usart_fini(enum usart_idx_t idx);
+extern uint32_t vsfhal_usart_config(enum usart_idx_t idx, uint32_t baudrate, uint32_t mode);
+extern void vsfhal_usart_config_cb(enum usart_idx_t idx, int32_t int_priority, void *p, void (*ontx)(void *), void (*onrx)(void *));
+extern uint16_t vsfhal_usart_tx_bytes(enum usart_idx_t idx, uint8_t *data, uint16_t size);
+extern void vsfhal_usart_stream_config(enum usart_idx_t idx, int32_t eda_priority, int32_t int_priority, vsf_stream_t *tx, vsf_stream_t *rx);
+extern uint32_t vsfhal_usart_stream_get_dropped(enum usart_idx_t idx);
+
+extern uint32_t vsfhal_uid_read(uint8_t *buffer, uint32_t size);
+#endif
+
+#endif      // __SIM_HAL_H__
@@ -0,0 +1,911 @@
+/*============================ INCLUDES ======================================*/
+
+#include <string.h>
+#include "sim_target.h"
+
+/*============================ MACROS ========================================*/
+
+#define SWJ_PROTOCOL_JTAG               0
+#define SWJ_PROTOCOL_SWD                1
+
+#define SWJ_SELECT_JTAG_TO_SWD          0xE79E
+#define SWJ_SELECT_SWD_TO_JTAG          0xE73C
+#define SWJ_LINE_RESET_ONES             50
+#define SWD_TARGETSEL_REQUEST           0x99
+#define SWD_TARGETSEL_BITS              (8 + 33)
+
+#define CTRL_STICKYORUN                 (1ul << 1)
+#define CTRL_STICKYCMP                  (1ul << 4)
+#define CTRL_STICKYERR                  (1ul << 5)
+#define CTRL_WDATAERR                   (1ul << 7)
+#define CTRL_CDBGPWRUPREQ               (1ul << 28)
+#define CTRL_CDBGPWRUPACK               (1ul << 29)
+#define CTRL_CSYSPWRUPREQ               (1ul << 30)
+#define CTRL_CSYSPWRUPACK               (1ul << 31)
+#define CTRL_STICKY_MASK                (CTRL_STICKYORUN | CTRL_STICKYCMP | CTRL_STICKYERR | CTRL_WDATAERR)
+#define CTRL_ACK_MASK                   (CTRL_CDBGPWRUPACK | CTRL_CSYSPWRUPACK)
+
+#define ABORT_DAPABORT                  (1ul << 0)
+#define ABORT_STKCMPCLR                 (1ul << 1)
+#define ABORT_STKERRCLR                 (1ul << 2)
+#define ABORT_WDERRCLR                  (1ul << 3)
+#define ABORT_ORUNERRCLR                (1ul << 4)
+
+#define DP_REG_DPIDR                    0x0
+#define DP_REG_CTRL_STAT                0x4
+#define DP_REG_SELECT                   0x8
+#define DP_REG_RDBUFF                   0xC
+
+#define AP_REG_CSW                      0x00
+#define AP_REG_TAR                      0x04
+#define AP_REG_DRW                      0x0C
+#define AP_REG_BD0                      0x10
+#define AP_REG_BD3                      0x1C
+#define AP_REG_CFG                      0xF4
+#define AP_REG_BASE                     0xF8
+#define AP_REG_IDR                      0xFC
+
+#define AP_BASE_VALUE                   0xE00FF003ul
+#define AP_IDR_VALUE                    0x24770011ul
+
+#define CSW_SIZE_MASK                   0x7ul
+#define CSW_ADDRINC_SHIFT               4
+#define CSW_ADDRINC_PACKED              2
+#define CSW_DEVICEEN                    (1ul << 6)
+#define CSW_TRINPROG                    (1ul << 7)
+
+#define PPB_ADDR                        0xE0000000ul
+#define PPB_SIZE                        0x00100000ul
+#define PPB_STORE_SIZE                  64
+
+#define CPUID_ADDR                      0xE000ED00ul
+#define DHCSR_ADDR                      0xE000EDF0ul
+#define DCRSR_ADDR                      0xE000EDF4ul
+#define DCRDR_ADDR                      0xE000EDF8ul
+#define DHCSR_DBGKEY                    0xA05Ful
+#define DHCSR_C_DEBUGEN                 (1ul << 0)
+#define DHCSR_C_HALT                    (1ul << 1)
+#define DHCSR_S_REGRDY                  (1ul << 16)
+#define DHCSR_S_HALT                    (1ul << 17)
+#define DCRSR_REGWNR                    (1ul << 16)
+
+#define CORE_REG_R0                     0
+#define CORE_REG_R1                     1
+#define CORE_REG_R2                     2
+#define CORE_REG_LR                     14
+#define CORE_REG_PC                     15
+
+// flash algorithm run time, in SWCLK/TCK cycles
+#define ALGO_CALL_CLOCKS                200
+#define ALGO_ERASE_CLOCKS               20000
+#define ALGO_PROGRAM_CLOCKS_PER_WORD    20
+
+#define JTAG_IR_ABORT                   0x8
+#define JTAG_IR_DPACC                   0xA
+#define JTAG_IR_APACC                   0xB
+#define JTAG_IR_IDCODE                  0xE
+#define JTAG_IR_BYPASS                  0xF
+
+#define JTAG_ACK_OK_FAULT               0x2
+#define JTAG_ACK_WAIT                   0x1
+
+/*============================ TYPES =========================================*/
+
+enum tap_state_t {
+    TAP_RESET = 0,
+    TAP_IDLE,
+    TAP_DRSELECT,
+    TAP_DRCAPTURE,
+    TAP_DRSHIFT,
+    TAP_DREXIT1,
+    TAP_DRPAUSE,
+    TAP_DREXIT2,
+    TAP_DRUPDATE,
+    TAP_IRSELECT,
+    TAP_IRCAPTURE,
+    TAP_IRSHIFT,
+    TAP_IREXIT1,
+    TAP_IRPAUSE,
+    TAP_IREXIT2,
+    TAP_IRUPDATE,
+};
+
+typedef struct sim_tap_t {
+    uint8_t ir_length;
+    uint8_t dr_length;
+    uint32_t ir;
+    uint32_t ir_shift;
+    uint64_t dr_shift;
+    uint32_t idcode;
+} sim_tap_t;
+
+typedef struct sim_ppb_reg_t {
+    uint32_t addr;
+    uint32_t value;
+} sim_ppb_reg_t;
+
+typedef struct sim_target_t {
+    sim_target_cfg_t cfg;
+    uint64_t clock;
+    uint32_t rng;
+
+    // SWJ-DP
+    uint8_t protocol;
+    uint8_t swj_ones;
+    uint8_t swj_capture_cnt;
+    uint16_t swj_capture;
+    bool swd_lockout;
+    bool swd_deselected;            // by TARGETSEL, until line reset
+    uint8_t targetsel_cnt;
+    uint64_t targetsel_shift;
+
+    // DP
+    uint32_t ctrl_stat;
+    uint32_t select;
+    uint32_t rdbuff;
+    uint32_t resend;
+    uint64_t ap_busy_until;
+
+    // MEM-AP
+    uint32_t csw;
+    uint32_t tar;
+
+    // JTAG-DP and scan chain
+    uint8_t tap_state;
+    bool jtag_wait;
+    uint32_t jtag_result;
+    sim_tap_t tap[SIM_TARGET_TAP_MAX];
+
+    // Core debug and PPB
+    uint32_t dhcsr;
+    uint32_t dcrdr;
+    uint32_t core_reg[32];
+    uint32_t core_algo;             // algorithm function running, 0 if none
+    uint64_t core_done;             // clock when it returns
+    uint8_t ppb_num;
+    sim_ppb_reg_t ppb[PPB_STORE_SIZE];
+
+    uint8_t ram[SIM_TARGET_RAM_SIZE];
+    uint8_t flash[SIM_TARGET_FLASH_SIZE];
+} sim_target_t;
+
+/*============================ GLOBAL VARIABLES ==============================*/
+
+sim_target_stat_t sim_target_stat;
+
+/*============================ LOCAL VARIABLES ===============================*/
+
+static sim_target_t sim_target;
+
+static const uint8_t tap_next_state[16][2] = {
+    [TAP_RESET]     = {TAP_IDLE,        TAP_RESET},
+    [TAP_IDLE]      = {TAP_IDLE,        TAP_DRSELECT},
+    [TAP_DRSELECT]  = {TAP_DRCAPTURE,   TAP_IRSELECT},
+    [TAP_DRCAPTURE] = {TAP_DRSHIFT,     TAP_DREXIT1},
+    [TAP_DRSHIFT]   = {TAP_DRSHIFT,     TAP_DREXIT1},
+    [TAP_DREXIT1]   = {TAP_DRPAUSE,     TAP_DRUPDATE},
+    [TAP_DRPAUSE]   = {TAP_DRPAUSE,     TAP_DREXIT2},
+    [TAP_DREXIT2]   = {TAP_DRSHIFT,     TAP_DRUPDATE},
+    [TAP_DRUPDATE]  = {TAP_IDLE,        TAP_DRSELECT},
+    [TAP_IRSELECT]  = {TAP_IRCAPTURE,   TAP_RESET},
+    [TAP_IRCAPTURE] = {TAP_IRSHIFT,     TAP_IREXIT1},
+    [TAP_IRSHIFT]   = {TAP_IRSHIFT,     TAP_IREXIT1},
+    [TAP_IREXIT1]   = {TAP_IRPAUSE,     TAP_IRUPDATE},
+    [TAP_IRPAUSE]   = {TAP_IRPAUSE,     TAP_IREXIT2},
+    [TAP_IREXIT2]   = {TAP_IRSHIFT,     TAP_IRUPDATE},
+    [TAP_IRUPDATE]  = {TAP_IDLE,        TAP_DRSELECT},
+};
+
+// Cortex-M4 style ROM table: SCS, DWT, FPB, ITM
+static const sim_ppb_reg_t ppb_rom[] = {
+    {0xE00FF000, 0xFFF0F003},
+    {0xE00FF004, 0xFFF02003},
+    {0xE00FF008, 0xFFF03003},
+    {0xE00FF00C, 0xFFF01003},
+    {0xE00FF010, 0x00000000},
+    {0xE00FFFCC, 0x00000001},
+    {0xE00FFFE0, 0x000000C4},
+    {0xE00FFFE4, 0x000000B4},
+    {0xE00FFFE8, 0x0000000B},
+    {0xE00FFFF0, 0x0000000D},
+    {0xE00FFFF4, 0x00000010},
+    {0xE00FFFF8, 0x00000005},
+    {0xE00FFFFC, 0x000000B1},
+    {CPUID_ADDR, 0x410FC241},
+};
+
+/*============================ IMPLEMENTATION ================================*/
+
+static uint32_t sim_rand(void)
+{
+    uint32_t x = sim_target.rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    sim_target.rng = x;
+    return x;
+}
+
+bool sim_target_chance(uint16_t permille)
+{
+    return permille && ((sim_rand() % 1000) < permille);
+}
+
+// beyond wire_khz one read in eight is hit
+bool sim_target_parity_glitch(uint32_t khz)
+{
+    uint32_t permille = sim_target.cfg.parity_permille;
+
+    if (sim_target.cfg.wire_khz && (khz > sim_target.cfg.wire_khz) && (permille < 125))
+        permille = 125;
+    if (sim_target_chance(permille)) {
+        sim_target_stat.parity_errors++;
+        return true;
+    }
+    return false;
+}
+
+void sim_target_clock(uint32_t cycles)
+{
+    sim_target.clock += cycles;
+}
+
+void sim_target_reset_stat(void)
+{
+    memset(&sim_target_stat, 0, sizeof(sim_target_stat));
+}
+
+static bool ap_is_busy(void)
+{
+    return sim_target.clock < sim_target.ap_busy_until;
+}
+
+/*----------------------------------------------------------------------------*
+ * System bus                                                                 *
+ *----------------------------------------------------------------------------*/
+
+static uint8_t *mem_map(uint32_t addr, uint32_t size, bool write)
+{
+    if ((addr >= SIM_TARGET_RAM_ADDR) && ((addr - SIM_TARGET_RAM_ADDR) + size <= SIM_TARGET_RAM_SIZE))
+        return &sim_target.ram[addr - SIM_TARGET_RAM_ADDR];
+    if (!write && (addr >= SIM_TARGET_FLASH_ADDR) && ((addr - SIM_TARGET_FLASH_ADDR) + size <= SIM_TARGET_FLASH_SIZE))
+        return &sim_target.flash[addr - SIM_TARGET_FLASH_ADDR];
+    return NULL;
+}
+
+uint8_t *sim_target_mem(uint32_t addr, uint32_t size)
+{
+    return mem_map(addr, size, false);
+}
+
+static bool core_is_halted(void)
+{
+    return (sim_target.dhcsr & (DHCSR_C_DEBUGEN | DHCSR_C_HALT)) == (DHCSR_C_DEBUGEN | DHCSR_C_HALT);
+}
+
+static uint32_t algo_erase_sector(uint32_t addr)
+{
+    if ((addr < SIM_TARGET_FLASH_ADDR) || (addr - SIM_TARGET_FLASH_ADDR >= SIM_TARGET_FLASH_SIZE))
+        return 1;
+    addr = (addr - SIM_TARGET_FLASH_ADDR) & ~(SIM_TARGET_FLASH_SECTOR - 1);
+    memset(&sim_target.flash[addr], 0xff, SIM_TARGET_FLASH_SECTOR);
+    return 0;
+}
+
+static uint32_t algo_program_page(uint32_t addr, uint32_t size, uint32_t buf)
+{
+    uint8_t *src = mem_map(buf, size, false);
+    uint32_t i;
+
+    if ((src == NULL) || (addr < SIM_TARGET_FLASH_ADDR) || ((addr - SIM_TARGET_FLASH_ADDR) + size > SIM_TARGET_FLASH_SIZE))
+        return 1;
+    // NOR flash only clears bits
+    addr -= SIM_TARGET_FLASH_ADDR;
+    for (i = 0; i < size; i++)
+        sim_target.flash[addr + i] &= src[i];
+    return 0;
+}
+
+// resumed: look for an algorithm stub at PC
+static void core_run(void)
+{
+    uint32_t *reg = sim_target.core_reg;
+    uint8_t *entry = mem_map(reg[CORE_REG_PC] & ~1ul, 4, false);
+    uint32_t word = entry ? entry[0] | (entry[1] << 8) | (entry[2] << 16) | ((uint32_t)entry[3] << 24) : 0;
+    uint64_t clocks = ALGO_CALL_CLOCKS;
+
+    switch (word) {
+    case SIM_TARGET_ALGO_ERASE_SECTOR:
+        clocks += ALGO_ERASE_CLOCKS;
+        break;
+    case SIM_TARGET_ALGO_PROGRAM_PAGE:
+        clocks += (reg[CORE_REG_R1] / 4) * ALGO_PROGRAM_CLOCKS_PER_WORD;
+        break;
+    case SIM_TARGET_ALGO_INIT:
+    case SIM_TARGET_ALGO_UNINIT:
+        break;
+    default:
+        word = 0;
+        break;
+    }
+    sim_target.core_algo = word;
+    sim_target.core_done = sim_target.clock + clocks;
+}
+
+// the algorithm works on memory when it returns, so a buffer overwritten
+// while it runs shows up in flash
+static void core_update(void)
+{
+    uint32_t *reg = sim_target.core_reg;
+
+    if (!sim_target.core_algo || (sim_target.clock < sim_target.core_done))
+        return;
+
+    switch (sim_target.core_algo) {
+    case SIM_TARGET_ALGO_ERASE_SECTOR:
+        reg[CORE_REG_R0] = algo_erase_sector(reg[CORE_REG_R0]);
+        break;
+    case SIM_TARGET_ALGO_PROGRAM_PAGE:
+        reg[CORE_REG_R0] = algo_program_page(reg[CORE_REG_R0], reg[CORE_REG_R1], reg[CORE_REG_R2]);
+        break;
+    default:
+        reg[CORE_REG_R0] = 0;
+        break;
+    }
+    // BKPT at LR
+    reg[CORE_REG_PC] = reg[CORE_REG_LR] & ~1ul;
+    sim_target.dhcsr |= DHCSR_C_HALT;
+    sim_target.core_algo = 0;
+}
+
+static uint32_t ppb_read(uint32_t addr)
+{
+    uint32_t i;
+
+    core_update();
+
+    switch (addr) {
+    case DHCSR_ADDR: {
+        uint32_t value = sim_target.dhcsr | DHCSR_S_REGRDY;
+        if (core_is_halted())
+            value |= DHCSR_S_HALT;
+        return value;
+    }
+    case DCRDR_ADDR:
+        return sim_target.dcrdr;
+    }
+    for (i = 0; i < sizeof(ppb_rom) / sizeof(ppb_rom[0]); i++) {
+        if (ppb_rom[i].addr == addr)
+            return ppb_rom[i].value;
+    }
+    for (i = 0; i < sim_target.ppb_num; i++) {
+        if (sim_target.ppb[i].addr == addr)
+            return sim_target.ppb[i].value;
+    }
+    return 0;
+}
+
+static void ppb_write(uint32_t addr, uint32_t value)
+{
+    uint32_t i;
+    bool halted;
+
+    core_update();
+    switch (addr) {
+    case DHCSR_ADDR:
+        if ((value >> 16) == DHCSR_DBGKEY) {
+            halted = core_is_halted();
+            sim_target.dhcsr = value & 0xf;
+            if (core_is_halted())
+                sim_target.core_algo = 0;
+            else if (halted)
+                core_run();
+        }
+        return;
+    case DCRSR_ADDR:
+        if (value & DCRSR_REGWNR)
+            sim_target.core_reg[value & 0x1f] = sim_target.dcrdr;
+        else
+            sim_target.dcrdr = sim_target.core_reg[value & 0x1f];
+        return;
+    case DCRDR_ADDR:
+        sim_target.dcrdr = value;
+        return;
+    }
+    for (i = 0; i < sizeof(ppb_rom) / sizeof(ppb_rom[0]); i++) {
+        if (ppb_rom[i].addr == addr)
+            return;
+    }
+    for (i = 0; i < sim_target.ppb_num; i++) {
+        if (sim_target.ppb[i].addr == addr) {
+            sim_target.ppb[i].value = value;
+            return;
+        }
+    }
+    if (sim_target.ppb_num < PPB_STORE_SIZE) {
+        sim_target.ppb[sim_target.ppb_num].addr = addr;
+        sim_target.ppb[sim_target.ppb_num].value = value;
+        sim_target.ppb_num++;
+    }
+}
+
+// size is 1, 2 or 4 and value is right aligned
+static bool mem_access(uint32_t addr, uint32_t size, uint32_t *value, bool write)
+{
+    uint32_t i;
+    uint8_t *mem;
+
+    if (sim_target_chance(sim_target.cfg.fault_permille))
+        goto bus_error;
+
+    addr &= ~(size - 1);
+    if ((addr >= PPB_ADDR) && (addr - PPB_ADDR < PPB_SIZE)) {
+        uint32_t shift = (addr & 0x3) * 8;
+        uint32_t mask = (size == 4) ? 0xfffffffful : (((1ul << (size * 8)) - 1) << shift);
+        uint32_t word = ppb_read(addr & ~0x3ul);
+
+        if (write)
+            ppb_write(addr & ~0x3ul, (word & ~mask) | ((*value << shift) & mask));
+        else
+            *value = (word & mask) >> shift;
+    } else {
+        mem = mem_map(addr, size, write);
+        if (!mem)
+            goto bus_error;
+        if (write) {
+            for (i = 0; i < size; i++)
+                mem[i] = (uint8_t)(*value >> (i * 8));
+        } else {
+            *value = 0;
+            for (i = 0; i < size; i++)
+                *value |= (uint32_t)mem[i] << (i * 8);
+        }
+    }
+
+    if (write)
+        sim_target_stat.mem_write_bytes += size;
+    else
+        sim_target_stat.mem_read_bytes += size;
+    return true;
+
+bus_error:
+    sim_target_stat.bus_errors++;
+    return false;
+}
+
+/*----------------------------------------------------------------------------*
+ * MEM-AP                                                                     *
+ *----------------------------------------------------------------------------*/
+
+static void tar_increase(uint32_t size)
+{
+    // auto-increment is only guaranteed inside a 1KB boundary
+    sim_target.tar = (sim_target.tar & ~0x3fful) | ((sim_target.tar + size) & 0x3ff);
+}
+
+static bool drw_access(uint32_t *value, bool write)
+{
+    uint32_t size = sim_target.csw & CSW_SIZE_MASK;
+    uint32_t addrinc = (sim_target.csw >> CSW_ADDRINC_SHIFT) & 0x3;
+    uint32_t count, shift, item;
+
+    size = (size <= 2) ? (1ul << size) : 4;
+    count = ((addrinc == CSW_ADDRINC_PACKED) && (size < 4)) ? 4 / size : 1;
+    if (!write)
+        *value = 0;
+
+    while (count--) {
+        shift = (sim_target.tar & 0x3 & ~(size - 1)) * 8;
+        item = (size == 4) ? *value : (*value >> shift) & ((1ul << (size * 8)) - 1);
+        if (!mem_access(sim_target.tar, size, &item, write))
+            return false;
+        if (!write)
+            *value |= item << shift;
+        if (addrinc)
+            tar_increase(size);
+    }
+    return true;
+}
+
+static bool ap_access(uint32_t addr, uint32_t *value, bool write)
+{
+    // only APSEL 0 is implemented, the rest read as zero so IDR ends AP scans
+    if (sim_target.select >> 24) {
+        if (!write)
+            *value = 0;
+        return true;
+    }
+
+    switch (addr) {
+    case AP_REG_CSW:
+        if (write)
+            sim_target.csw = *value & ~(CSW_DEVICEEN | CSW_TRINPROG);
+        else
+            *value = sim_target.csw | CSW_DEVICEEN;
+        break;
+    case AP_REG_TAR:
+        if (write)
+            sim_target.tar = *value;
+        else
+            *value = sim_target.tar;
+        break;
+    case AP_REG_DRW:
+        return drw_access(value, write);
+    case AP_REG_CFG:
+        if (!write)
+            *value = 0;
+        break;
+    case AP_REG_BASE:
+        if (!write)
+            *value = AP_BASE_VALUE;
+        break;
+    case AP_REG_IDR:
+        if (!write)
+            *value = AP_IDR_VALUE;
+        break;
+    default:
+        if ((addr >= AP_REG_BD0) && (addr <= AP_REG_BD3))
+            return mem_access((sim_target.tar & ~0xful) | (addr & 0xc), 4, value, write);
+        if (!write)
+            *value = 0;
+        break;
+    }
+    return true;
+}
+
+// AP access started from SWD or JTAG, a bus error sets STICKYERR
+static uint32_t ap_transfer(uint32_t addr, uint32_t value, bool write)
+{
+    addr = (sim_target.select & 0xf0) | (addr & 0xc);
+    if (!ap_access(addr, &value, write)) {
+        sim_target.ctrl_stat |= CTRL_STICKYERR;
+        value = 0;
+    }
+    sim_target.ap_busy_until = sim_target.clock + sim_target.cfg.ap_latency;
+    return write ? 0 : value;
+}
+
+/*----------------------------------------------------------------------------*
+ * DP                                                                         *
+ *----------------------------------------------------------------------------*/
+
+static void dp_abort(uint32_t value)
+{
+    if (value & ABORT_DAPABORT)
+        sim_target.ap_busy_until = sim_target.clock;
+    if (value & ABORT_STKCMPCLR)
+        sim_target.ctrl_stat &= ~CTRL_STICKYCMP;
+    if (value & ABORT_STKERRCLR)
+        sim_target.ctrl_stat &= ~CTRL_STICKYERR;
+    if (value & ABORT_WDERRCLR)
+        sim_target.ctrl_stat &= ~CTRL_WDATAERR;
+    if (value & ABORT_ORUNERRCLR)
+        sim_target.ctrl_stat &= ~CTRL_STICKYORUN;
+}
+
+static uint32_t dp_read(uint32_t addr)
+{
+    bool swd = sim_target.protocol == SWJ_PROTOCOL_SWD;
+
+    switch (addr) {
+    case DP_REG_DPIDR:
+        return sim_target.cfg.targetsel ? SIM_TARGET_DPIDR_V2 : SIM_TARGET_DPIDR;
+    case DP_REG_CTRL_STAT:
+        return (sim_target.select & 0xf) ? 0 : sim_target.ctrl_stat;
+    case DP_REG_SELECT:
+        return swd ? sim_target.resend : sim_target.select;
+    default:
+        return swd ? sim_target.rdbuff : 0;
+    }
+}
+
+static void dp_write(uint32_t addr, uint32_t value)
+{
+    switch (addr) {
+    case DP_REG_CTRL_STAT:
+        if (sim_target.select & 0xf)
+            break;
+        if (sim_target.protocol == SWJ_PROTOCOL_JTAG)
+            sim_target.ctrl_stat &= ~(value & (CTRL_STICKYORUN | CTRL_STICKYCMP | CTRL_STICKYERR));
+        value &= ~(CTRL_STICKY_MASK | CTRL_ACK_MASK);
+        sim_target.ctrl_stat = (sim_target.ctrl_stat & CTRL_STICKY_MASK) | value;
+        sim_target.ctrl_stat |= (value & (CTRL_CDBGPWRUPREQ | CTRL_CSYSPWRUPREQ)) << 1;
+        break;
+    case DP_REG_SELECT:
+        sim_target.select = value;
+        break;
+    }
+}
+
+/*----------------------------------------------------------------------------*
+ * SWJ-DP                                                                     *
+ *----------------------------------------------------------------------------*/
+
+static void swj_break(void)
+{
+    sim_target.swj_ones = 0;
+    sim_target.swj_capture_cnt = 0;
+    sim_target.targetsel_cnt = 0;
+    sim_target.targetsel_shift = 0;
+}
+
+// Host driven bits in lockout, a TARGETSEL packet is the only one in them.
+// The turnaround and ACK between request and data are not seen, nobody
+// drives them.
+static void swd_targetsel_bit(bool bit)
+{
+    uint32_t value;
+
+    // idle until the start bit
+    if (!sim_target.targetsel_cnt && !bit)
+        return;
+    sim_target.targetsel_shift |= (uint64_t)bit << sim_target.targetsel_cnt;
+    sim_target.targetsel_cnt++;
+
+    if ((sim_target.targetsel_cnt == 8) && (sim_target.targetsel_shift != SWD_TARGETSEL_REQUEST)) {
+        sim_target.targetsel_cnt = 0;
+    } else if (sim_target.targetsel_cnt == SWD_TARGETSEL_BITS) {
+        value = sim_target.targetsel_shift >> 8;
+        if (__builtin_parity(value) == ((sim_target.targetsel_shift >> 40) & 0x1))
+            sim_target.swd_deselected = value != sim_target.cfg.targetsel;
+        sim_target.targetsel_cnt = 0;
+    }
+    if (!sim_target.targetsel_cnt)
+        sim_target.targetsel_shift = 0;
+}
+
+static void swj_bit(bool bit)
+{
+    if (sim_target.cfg.targetsel && (sim_target.protocol == SWJ_PROTOCOL_SWD) && sim_target.swd_lockout)
+        swd_targetsel_bit(bit);
+
+    if (sim_target.swj_capture_cnt) {
+        sim_target.swj_capture |= (uint16_t)bit << sim_target.swj_capture_cnt;
+        if (++sim_target.swj_capture_cnt == 16) {
+            sim_target.swj_capture_cnt = 0;
+            if (sim_target.swj_capture == SWJ_SELECT_JTAG_TO_SWD) {
+                sim_target.protocol = SWJ_PROTOCOL_SWD;
+                sim_target.swd_lockout = true;
+            } else if (sim_target.swj_capture == SWJ_SELECT_SWD_TO_JTAG) {
+                sim_target.protocol = SWJ_PROTOCOL_JTAG;
+                sim_target.tap_state = TAP_RESET;
+            }
+        }
+    }
+
+    if (bit) {
+        if (sim_target.swj_ones < 0xff)
+            sim_target.swj_ones++;
+    } else {
+        if (sim_target.swj_ones >= SWJ_LINE_RESET_ONES) {
+            // line reset, this zero may also start a select sequence
+            if (sim_target.protocol == SWJ_PROTOCOL_SWD)
+                sim_target.swd_lockout = true;
+            sim_target.swd_deselected = false;
+            sim_target.targetsel_cnt = 0;
+            sim_target.targetsel_shift = 0;
+            sim_target.swj_capture = 0;
+            sim_target.swj_capture_cnt = 1;
+        }
+        sim_target.swj_ones = 0;
+    }
+}
+
+void sim_target_swj_bits(const uint8_t *data, uint32_t bitlen)
+{
+    uint32_t i;
+
+    for (i = 0; i < bitlen; i++)
+        swj_bit((data[i >> 3] >> (i & 0x7)) & 0x1);
+}
+
+uint32_t sim_target_swd_transfer(uint32_t request, uint32_t *data)
+{
+    bool ap = request & 0x1, read = request & 0x2;
+    uint32_t addr = request & 0xc;
+
+    swj_break();
+
+    if ((sim_target.protocol != SWJ_PROTOCOL_SWD) || sim_target.swd_deselected)
+        goto no_ack;
+    if (sim_target.swd_lockout) {
+        // only a DPIDR read is answered after line reset
+        if (ap || !read || (addr != DP_REG_DPIDR))
+            goto no_ack;
+        sim_target.swd_lockout = false;
+    }
+
+    if (ap || (read && (addr == DP_REG_RDBUFF))) {
+        if (ap_is_busy() || sim_target_chance(sim_target.cfg.wait_permille)) {
+            sim_target_stat.ack_wait++;
+            return SIM_ACK_WAIT;
+        }
+    }
+    if (sim_target.ctrl_stat & CTRL_STICKY_MASK) {
+        if (ap || (read && (addr > DP_REG_CTRL_STAT)) || (!read && (addr != DP_REG_DPIDR))) {
+            sim_target_stat.ack_fault++;
+            return SIM_ACK_FAULT;
+        }
+    }
+
+    if (ap) {
+        if (read) {
+            // posted read, data of the previous AP read is returned
+            *data = sim_target.rdbuff;
+            sim_target.rdbuff = ap_transfer(addr, 0, false);
+        } else {
+            ap_transfer(addr, *data, true);
+        }
+    } else if (read) {
+        *data = dp_read(addr);
+    } else if (addr == DP_REG_DPIDR) {
+        dp_abort(*data);
+    } else {
+        dp_write(addr, *data);
+    }
+    if (read)
+        sim_target.resend = *data;
+    return SIM_ACK_OK;
+
+no_ack:
+    sim_target_stat.ack_none++;
+    return SIM_ACK_NONE;
+}
+
+/*----------------------------------------------------------------------------*
+ * JTAG                                                                       *
+ *----------------------------------------------------------------------------*/
+
+static bool tap_is_dap(uint32_t index)
+{
+    return index == sim_target.cfg.tap_dap;
+}
+
+static void tap_capture_dr(uint32_t index)
+{
+    sim_tap_t *tap = &sim_target.tap[index];
+
+    if (tap->ir == JTAG_IR_IDCODE) {
+        tap->dr_length = 32;
+        tap->dr_shift = tap->idcode;
+    } else if (tap_is_dap(index) && ((tap->ir == JTAG_IR_DPACC) || (tap->ir == JTAG_IR_APACC))) {
+        tap->dr_length = 35;
+        if (ap_is_busy() || ((tap->ir == JTAG_IR_APACC) && sim_target_chance(sim_target.cfg.wait_permille))) {
+            // this scan is ignored at Update-DR
+            sim_target.jtag_wait = true;
+            sim_target_stat.ack_wait++;
+            tap->dr_shift = JTAG_ACK_WAIT;
+        } else {
+            sim_target.jtag_wait = false;
+            tap->dr_shift = ((uint64_t)sim_target.jtag_result << 3) | JTAG_ACK_OK_FAULT;
+        }
+    } else if (tap_is_dap(index) && (tap->ir == JTAG_IR_ABORT)) {
+        tap->dr_length = 35;
+        tap->dr_shift = 0;
+    } else {
+        tap->dr_length = 1;
+        tap->dr_shift = 0;
+    }
+}
+
+static void tap_update_dr(uint32_t index)
+{
+    sim_tap_t *tap = &sim_target.tap[index];
+    bool read = tap->dr_shift & 0x1;
+    uint32_t addr = (uint32_t)(tap->dr_shift << 1) & 0xc;
+    uint32_t data = (uint32_t)(tap->dr_shift >> 3);
+
+    if (!tap_is_dap(index))
+        return;
+
+    if (tap->ir == JTAG_IR_ABORT) {
+        if (data & ABORT_DAPABORT)
+            sim_target.ap_busy_until = sim_target.clock;
+    } else if ((tap->ir == JTAG_IR_DPACC) || (tap->ir == JTAG_IR_APACC)) {
+        if (sim_target.jtag_wait) {
+            sim_target.jtag_wait = false;
+            return;
+        }
+        if (tap->ir == JTAG_IR_APACC) {
+            // JTAG-DP discards AP accesses while a sticky flag is set
+            if (sim_target.ctrl_stat & CTRL_STICKY_MASK)
+                sim_target.jtag_result = 0;
+            else
+                sim_target.jtag_result = ap_transfer(addr, data, !read);
+        } else if (read) {
+            sim_target.jtag_result = dp_read(addr);
+        } else {
+            dp_write(addr, data);
+            sim_target.jtag_result = 0;
+        }
+    }
+}
+
+bool sim_target_jtag_clock(bool tms, bool tdi)
+{
+    uint32_t i, n = sim_target.cfg.tap_count;
+    uint8_t state = sim_target.tap_state;
+    bool bit = tdi, out;
+
+    // SWJ-DP watches TMS/SWDIO for select sequences in every mode
+    swj_bit(tms);
+    if (sim_target.protocol != SWJ_PROTOCOL_JTAG)
+        return false;
+
+    switch (state) {
+    case TAP_RESET:
+        for (i = 0; i < n; i++)
+            sim_target.tap[i].ir = JTAG_IR_IDCODE;
+        break;
+    case TAP_DRCAPTURE:
+        for (i = 0; i < n; i++)
+            tap_capture_dr(i);
+        break;
+    case TAP_DRSHIFT:
+        // TDI -> tap[n - 1] -> ... -> tap[0] -> TDO
+        for (i = n; i > 0; i--) {
+            sim_tap_t *tap = &sim_target.tap[i - 1];
+            out = tap->dr_shift & 0x1;
+            tap->dr_shift = (tap->dr_shift >> 1) | ((uint64_t)bit << (tap->dr_length - 1));
+            bit = out;
+        }
+        break;
+    case TAP_DRUPDATE:
+        for (i = 0; i < n; i++)
+            tap_update_dr(i);
+        break;
+    case TAP_IRCAPTURE:
+        for (i = 0; i < n; i++)
+            sim_target.tap[i].ir_shift = 0x1;
+        break;
+    case TAP_IRSHIFT:
+        for (i = n; i > 0; i--) {
+            sim_tap_t *tap = &sim_target.tap[i - 1];
+            out = tap->ir_shift & 0x1;
+            tap->ir_shift = (tap->ir_shift >> 1) | ((uint32_t)bit << (tap->ir_length - 1));
+            bit = out;
+        }
+        break;
+    case TAP_IRUPDATE:
+        for (i = 0; i < n; i++) {
+            sim_tap_t *tap = &sim_target.tap[i];
+            tap->ir = tap->ir_shift & ((1ul << tap->ir_length) - 1);
+        }
+        break;
+    }
+
+    sim_target.tap_state = tap_next_state[state][tms ? 1 : 0];
+    return ((state == TAP_DRSHIFT) || (state == TAP_IRSHIFT)) ? bit : false;
+}
+
+/*----------------------------------------------------------------------------*
+ * Init                                                                       *
+ *----------------------------------------------------------------------------*/
+
+void sim_target_init(const sim_target_cfg_t *cfg)
+{
+    uint32_t i;
+
+    memset(&sim_target, 0, sizeof(sim_target));
+    memset(sim_target.flash, 0xff, sizeof(sim_target.flash));
+    sim_target.cfg = *cfg;
+    sim_target.rng = cfg->seed ? cfg->seed : 1;
+
+    if (!sim_target.cfg.tap_count || (sim_target.cfg.tap_count > SIM_TARGET_TAP_MAX)) {
+        sim_target.cfg.tap_count = 1;
+        sim_target.cfg.tap_dap = 0;
+        sim_target.cfg.tap_ir_length[0] = 4;
+        sim_target.cfg.tap_idcode[0] = SIM_TARGET_JTAG_IDCODE;
+    }
+    for (i = 0; i < sim_target.cfg.tap_count; i++) {
+        sim_target.tap[i].ir_length = sim_target.cfg.tap_ir_length[i];
+        sim_target.tap[i].idcode = sim_target.cfg.tap_idcode[i];
+        sim_target.tap[i].ir = JTAG_IR_IDCODE;
+        sim_target.tap[i].dr_length = 32;
+    }
+
+    sim_target.protocol = SWJ_PROTOCOL_JTAG;
+    sim_target.tap_state = TAP_RESET;
+    sim_target.csw = 0x03000002;
+    sim_target_reset_stat();
+}
@@ -0,0 +1,97 @@
+#ifndef __SIM_TARGET_H__
+#define __SIM_TARGET_H__
+
+/*============================ INCLUDES ======================================*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*============================ MACROS ========================================*/
+
+#define SIM_TARGET_TAP_MAX              4
+
+#define SIM_TARGET_RAM_ADDR             0x20000000ul
+#define SIM_TARGET_RAM_SIZE             (64 * 1024ul)
+#define SIM_TARGET_FLASH_ADDR           0x08000000ul
+#define SIM_TARGET_FLASH_SIZE           (256 * 1024ul)
+#define SIM_TARGET_FLASH_SECTOR         (1024ul)
+
+#define SIM_TARGET_DPIDR                0x2BA01477ul
+#define SIM_TARGET_DPIDR_V2             0x0BC12477ul    // multi-drop, cfg.targetsel set
+#define SIM_TARGET_JTAG_IDCODE          0x4BA00477ul
+
+// The core does not execute code. Resumed at an entry point holding one of
+// these words, it runs that flash algorithm function with the FLM calling
+// convention (R0-R2 in, R0 out) and halts at LR after the time it takes.
+// At any other PC it spins until halted.
+#define SIM_TARGET_ALGO_INIT            0x5AA50001ul
+#define SIM_TARGET_ALGO_UNINIT          0x5AA50002ul
+#define SIM_TARGET_ALGO_ERASE_SECTOR    0x5AA50003ul
+#define SIM_TARGET_ALGO_PROGRAM_PAGE    0x5AA50004ul
+
+// SWD ACK as seen on the wire
+#define SIM_ACK_OK                      0x1
+#define SIM_ACK_WAIT                    0x2
+#define SIM_ACK_FAULT                   0x4
+#define SIM_ACK_NONE                    0x7
+
+/*============================ TYPES =========================================*/
+
+/*
+    Model of a single Cortex-M class target behind an SWJ-DP (ADIv5.2).
+
+    Wire protocol starts as JTAG and is switched by the usual SWJ select
+    sequences. With targetsel set it is a DPv2 on a multi-drop bus, a
+    TARGETSEL write after line reset with any other value leaves it silent
+    until the next line reset. The MEM-AP at APSEL 0 reaches RAM, a flash that is read-only
+    on the bus, and a sparse PPB with working DHCSR/DCRSR/DCRDR. Everything
+    else bus-faults. Flash is erased and programmed by algorithm stubs.
+*/
+typedef struct sim_target_cfg_t {
+    uint16_t wait_permille;         // extra WAIT on AP and RDBUFF accesses
+    uint16_t fault_permille;        // bus error on memory accesses
+    uint16_t parity_permille;       // bad parity on SWD read data
+    uint16_t wire_khz;              // SWCLK limit of the wiring, faster reads get bad parity
+    uint16_t ap_latency;            // AP busy time after an access, in clocks
+    uint32_t seed;
+    uint32_t targetsel;             // SWD multi-drop, 0 for a DPv1 ignoring TARGETSEL
+
+    // JTAG chain, index 0 at TDO
+    uint8_t tap_count;
+    uint8_t tap_dap;                // which TAP is the JTAG-DP
+    uint8_t tap_ir_length[SIM_TARGET_TAP_MAX];
+    uint32_t tap_idcode[SIM_TARGET_TAP_MAX];
+} sim_target_cfg_t;
+
+typedef struct sim_target_stat_t {
+    uint64_t mem_read_bytes;
+    uint64_t mem_write_bytes;
+    uint32_t ack_wait;
+    uint32_t ack_fault;
+    uint32_t ack_none;
+    uint32_t bus_errors;
+    uint32_t parity_errors;
+} sim_target_stat_t;
+
+/*============================ GLOBAL VARIABLES ==============================*/
+
+extern sim_target_stat_t sim_target_stat;
+
+/*============================ PROTOTYPES ====================================*/
+
+extern void sim_target_init(const sim_target_cfg_t *cfg);
+extern void sim_target_reset_stat(void);
+extern void sim_target_clock(uint32_t cycles);
+extern bool sim_target_chance(uint16_t permille);
+extern bool sim_target_parity_glitch(uint32_t khz);
+
+// host driven SWDIO/TMS bits outside of SWD packets, for line reset and SWJ select
+extern void sim_target_swj_bits(const uint8_t *data, uint32_t bitlen);
+// one SWD packet from request to ACK, data is in or out depending on RnW
+extern uint32_t sim_target_swd_transfer(uint32_t request, uint32_t *data);
+// one TCK edge, returns TDO sampled before the edge
+extern bool sim_target_jtag_clock(bool tms, bool tdi);
+
+extern uint8_t *sim_target_mem(uint32_t addr, uint32_t size);
+
+#endif      // __SIM_TARGET_H__
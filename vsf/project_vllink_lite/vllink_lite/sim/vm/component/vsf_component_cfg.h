@@ -0,0 +1,9 @@
+#ifndef __VSF_SIM_COMPONENT_CFG_H__
+#define __VSF_SIM_COMPONENT_CFG_H__
+
+// sim stand-in for the vsfvm runtime, VSFVM_CFG_xxx are in proj_cfg.h
+#include "vsf.h"
+
+#define VSF_COMPONENT_ASSERT(...)                       ASSERT(__VA_ARGS__)
+
+#endif      // __VSF_SIM_COMPONENT_CFG_H__
@@ -0,0 +1,2 @@
+// sim stand-in for the vsfvm runtime, the eda and list pieces are in sim/vsf.h
+#include "vsf.h"
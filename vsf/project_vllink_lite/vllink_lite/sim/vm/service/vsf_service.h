@@ -0,0 +1,2 @@
+// sim stand-in for the vsfvm runtime, the heap is malloc() of sim/vsf.h
+#include "vsf.h"
@@ -0,0 +1,8 @@
+#ifndef __VSF_SIM_UTILITIES_H__
+#define __VSF_SIM_UTILITIES_H__
+
+// sim stand-in for the vsfvm runtime, plooc is the real one
+#include "vsf.h"
+#include "utilities/3rd-party/PLOOC/raw/plooc.h"
+
+#endif      // __VSF_SIM_UTILITIES_H__
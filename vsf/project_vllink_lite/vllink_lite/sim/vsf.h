@@ -0,0 +1,360 @@
+#ifdef BRD_CFG_VLLINKLITE_USBIP
+// sim_hal.c runs on the real kernel there, see cmake_vllinklite_usbip
+#   include "../../../vsf/vsf.h"
+#elif !defined(__VSF_SIM_H__)
+#define __VSF_SIM_H__
+
+/*
+    Host stand-in for "vsf.h", used by cmake_vllinklite_sim only.
+
+    It provides the small part of the VSF kernel, utilities and simple stream
+    service that dap/ depends on, so dap.c, dap_swo.c, dap_vendor.c and
+    dap_script.c can be compiled unmodified for the host and driven by the
+    simulated HAL in sim_hal.c. Tasks are run cooperatively from
+    vsf_sim_poll(). The vsfvm runtime of dap_script.c includes kernel and
+    utility headers by name, sim/vm has them and they come back here.
+*/
+
+/*============================ INCLUDES ======================================*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*============================ MACROS ========================================*/
+
+#ifndef ENABLED
+#   define ENABLED                                      1
+#endif
+#ifndef DISABLED
+#   define DISABLED                                     0
+#endif
+
+#define VSF_USE_SIMPLE_STREAM                           ENABLED
+
+#ifndef max
+#   define max(__A, __B)                                (((__A) > (__B)) ? (__A) : (__B))
+#endif
+#ifndef min
+#   define min(__A, __B)                                (((__A) < (__B)) ? (__A) : (__B))
+#endif
+#ifndef dimof
+#   define dimof(arr)                                   (sizeof(arr) / sizeof((arr)[0]))
+#endif
+
+#define ASSERT(...)
+
+/*============================ TYPES =========================================*/
+
+typedef enum {
+    VSF_ERR_NOT_READY                       =1,
+    VSF_ERR_NONE                            =0,
+    VSF_ERR_UNKNOWN                         =-1,
+    VSF_ERR_NOT_SUPPORT                     =-2,
+    VSF_ERR_NOT_AVAILABLE                   =-4,
+    VSF_ERR_NOT_ACCESSABLE                  =-5,
+    VSF_ERR_NOT_ENOUGH_RESOURCES            =-6,
+    VSF_ERR_FAIL                            =-7,
+    VSF_ERR_INVALID_PARAMETER               =-8,
+    VSF_ERR_INVALID_RANGE                   =-9,
+    VSF_ERR_INVALID_PTR                     =-10,
+    VSF_ERR_IO                              =-12,
+    VSF_ERR_BUG                             =-14,
+    VSF_ERR_OVERRUN                         =-15,
+} vsf_err_t;
+
+typedef enum vsf_prio_t {
+    vsf_prio_inherit                        = -1,
+    vsf_prio_0                              = 0,
+    vsf_prio_1,
+    vsf_prio_highest                        = vsf_prio_1,
+} vsf_prio_t;
+
+typedef enum vsf_arch_prio_t {
+    vsf_arch_prio_invalid                   = -1,
+    vsf_arch_prio_0                         = 0,
+    vsf_arch_prio_1,
+    vsf_arch_prio_2,
+    vsf_arch_prio_3,
+} vsf_arch_prio_t;
+
+typedef bool vsf_gint_state_t;
+typedef uint64_t vsf_systimer_cnt_t;
+
+/*----------------------------------------------------------------------------*
+ * Kernel: event, semaphore and task                                          *
+ *----------------------------------------------------------------------------*/
+
+typedef int_fast32_t vsf_evt_t;
+enum {
+    VSF_EVT_INVALID                         = -1,
+    VSF_EVT_NONE                            = 0,
+    VSF_EVT_SYSTEM                          = 0x100,
+    VSF_EVT_INIT                            = VSF_EVT_SYSTEM + 1,
+    VSF_EVT_FINI                            = VSF_EVT_SYSTEM + 2,
+    VSF_EVT_SYNC                            = VSF_EVT_SYSTEM + 6,
+    VSF_EVT_USER                            = 0x200,
+};
+
+typedef enum vsf_sync_reason_t {
+    VSF_SYNC_FAIL,
+    VSF_SYNC_TIMEOUT,
+    VSF_SYNC_PENDING,
+    VSF_SYNC_GET,
+    VSF_SYNC_CANCEL,
+} vsf_sync_reason_t;
+
+typedef struct vsf_sem_t {
+    int32_t cur_value;
+} vsf_sem_t;
+
+typedef struct vsf_task_t vsf_task_t;
+struct vsf_task_t {
+    void (*evthandler)(void *task, vsf_evt_t evt);
+    vsf_prio_t priority;
+    vsf_task_t *next;
+};
+
+/*----------------------------------------------------------------------------*
+ * Simple stream                                                              *
+ *----------------------------------------------------------------------------*/
+
+typedef struct vsf_stream_op_t vsf_stream_op_t;
+typedef struct vsf_stream_t {
+    vsf_stream_op_t const *op;
+    bool rx_ready;
+    bool tx_ready;
+} vsf_stream_t;
+
+typedef struct vsf_fifo_stream_t {
+    union {
+        vsf_stream_t use_as__vsf_stream_t;
+        struct {
+            vsf_stream_op_t const *op;
+            bool rx_ready;
+            bool tx_ready;
+        };
+    };
+    uint8_t *buffer;
+    uint32_t size;
+    uint32_t head;
+    uint32_t tail;
+} vsf_fifo_stream_t;
+
+struct vsf_stream_op_t {
+    void (*init)(vsf_stream_t *stream);
+    uint_fast32_t (*write)(vsf_stream_t *stream, uint8_t *buf, uint_fast32_t size);
+    uint_fast32_t (*read)(vsf_stream_t *stream, uint8_t *buf, uint_fast32_t size);
+    uint_fast32_t (*get_buff_length)(vsf_stream_t *stream);
+    uint_fast32_t (*get_data_length)(vsf_stream_t *stream);
+    uint_fast32_t (*get_avail_length)(vsf_stream_t *stream);
+    uint_fast32_t (*get_rbuf)(vsf_stream_t *stream, uint8_t **ptr);
+};
+
+/*----------------------------------------------------------------------------*
+ * What the vsfvm runtime of VENDOR_SCRIPT takes from the kernel, see sim/vm  *
+ *----------------------------------------------------------------------------*/
+
+typedef uint_fast32_t vsf_protect_t;
+
+typedef struct vsf_mem_t {
+    union {
+        uint8_t *buffer;
+        void *obj;
+    };
+    int32_t size;
+} vsf_mem_t;
+
+// a thread of the runtime is an eda, the sim runs it from dap_script.c only
+typedef struct vsf_eda_t {
+    uint8_t state;
+} vsf_eda_t;
+
+// next is the host of the next node, as vsf_list.h
+typedef struct vsf_slist_node_t {
+    void *next;
+} vsf_slist_node_t;
+
+typedef struct vsf_slist_t {
+    void *head;
+} vsf_slist_t;
+
+/*============================ MACROFIED FUNCTIONS ===========================*/
+
+#define this                                            (*this_ptr)
+
+#define def_params(...)                                 __VA_ARGS__
+
+#define declare_vsf_task(__name)                                                \
+            typedef struct __name __name;                                       \
+            typedef struct task_cb_##__name task_cb_##__name;
+
+// anonymous struct member needs -fms-extensions, same as the target builds
+#define def_vsf_task(__name, ...)                                               \
+            struct task_cb_##__name {                                           \
+                uint8_t fsm_state;                                              \
+                __VA_ARGS__                                                     \
+            };                                                                  \
+            struct __name {                                                     \
+                vsf_task_t use_as__vsf_task_t;                                  \
+                union {                                                         \
+                    struct task_cb_##__name param;                              \
+                    struct task_cb_##__name;                                    \
+                };                                                              \
+            };                                                                  \
+            extern void vsf_task_func_##__name(struct __name *obj_ptr, vsf_evt_t evt);
+
+#define implement_vsf_task(__name)                                              \
+            void vsf_task_func_##__name(__name *obj_ptr, vsf_evt_t evt)         \
+            {                                                                   \
+                task_cb_##__name *this_ptr = &(obj_ptr->param);
+
+#define vsf_task_begin()
+#define vsf_task_end()                  } vsf_eda_yield();
+#define vsf_task_state                  (this_ptr->fsm_state)
+
+#define on_vsf_task_init()              if (VSF_EVT_INIT == evt)
+#define on_vsf_task_fini()              if (VSF_EVT_FINI == evt)
+#define on_vsf_task_evt(__evt)          if ((__evt) == evt)
+
+#define vsf_task_wait_until(...)                                                \
+            __VA_ARGS__ {} else {                                               \
+                return;                                                         \
+            }
+
+#define init_vsf_task(__name, __task, __pri)                                    \
+            do {                                                                \
+                (__task)->param.fsm_state = 0;                                  \
+                __vsf_sim_task_start(&(__task)->use_as__vsf_task_t,             \
+                    (void (*)(void *, vsf_evt_t))vsf_task_func_##__name,        \
+                    (__pri));                                                   \
+            } while (0)
+
+#define vsf_sem_init(__psem, __cnt)     ((__psem)->cur_value = (__cnt))
+#define vsf_sem_post(__psem)            vsf_eda_sem_post((__psem))
+#define vsf_sem_pend(__psem)                                                    \
+            for (   vsf_sync_reason_t reason = VSF_SYNC_CANCEL;                 \
+                    reason == VSF_SYNC_CANCEL;)                                 \
+                if ((reason = __vsf_sem_pend((__psem), (-1)),                   \
+                    reason == VSF_SYNC_GET))
+
+#define WEAK(...)                                       __attribute__((weak))
+
+#define VSF_KERNEL_CFG_EDA_SUPPORT_TIMER                DISABLED
+#define vsf_eda_fini(__eda)                             ((void)(__eda))
+#define vsf_protect_scheduler()                         ((vsf_protect_t)0)
+#define vsf_unprotect_scheduler(__level)                ((void)(__level))
+#define vsf_heap_malloc(__size)                         malloc((__size))
+#define vsf_heap_free(__ptr)                            free((__ptr))
+
+#define vsf_slist_init(__list_ptr)                      ((__list_ptr)->head = NULL)
+#define vsf_slist_is_empty(__list_ptr)                  (NULL == (__list_ptr)->head)
+#define vsf_slist_init_node(__host_type, __member, __item_ptr)                  \
+            ((__item_ptr)->__member.next = NULL)
+#define vsf_slist_add_to_head(__host_type, __member, __list_ptr, __item_ptr)    \
+            __vsf_sim_slist_add_to_head((vsf_slist_t *)(__list_ptr),            \
+                (__item_ptr), offsetof(__host_type, __member))
+#define vsf_slist_append(__host_type, __member, __list_ptr, __item_ptr)         \
+            __vsf_sim_slist_append((vsf_slist_t *)(__list_ptr),                 \
+                (__item_ptr), offsetof(__host_type, __member))
+#define vsf_slist_remove(__host_type, __member, __list_ptr, __item_ptr)         \
+            __vsf_sim_slist_remove((vsf_slist_t *)(__list_ptr),                 \
+                (__item_ptr), offsetof(__host_type, __member))
+#define __vsf_slist_foreach_unsafe(__host_type, __member, __list_ptr)           \
+            for (   __host_type *_ = (__host_type *)((__list_ptr)->head);       \
+                    _ != NULL;                                                  \
+                    _ = (__host_type *)(_->__member.next))
+#define __vsf_slist_foreach_next_unsafe(__host_type, __member, __list_ptr)      \
+            for (   __host_type *_ = (__host_type *)((__list_ptr)->head),       \
+                        *__ = _ ? (__host_type *)(_->__member.next) : NULL;     \
+                    _ != NULL;                                                  \
+                    _ = __, __ = _ ? (__host_type *)(_->__member.next) : NULL)
+
+#define VSF_STREAM_INIT(__stream)                       vsf_stream_init((vsf_stream_t *)(__stream))
+#define VSF_STREAM_WRITE(__stream, __buf, __size)       vsf_stream_write((vsf_stream_t *)(__stream), (__buf), (__size))
+#define VSF_STREAM_READ(__stream, __buf, __size)        vsf_stream_read((vsf_stream_t *)(__stream), (__buf), (__size))
+#define VSF_STREAM_GET_BUFF_SIZE(__stream)              vsf_stream_get_buff_size((vsf_stream_t *)(__stream))
+#define VSF_STREAM_GET_DATA_SIZE(__stream)              vsf_stream_get_data_size((vsf_stream_t *)(__stream))
+#define VSF_STREAM_GET_FREE_SIZE(__stream)              vsf_stream_get_free_size((vsf_stream_t *)(__stream))
+#define VSF_STREAM_GET_RBUF(__stream, p)                vsf_stream_get_rbuf((vsf_stream_t *)(__stream), (p))
+#define VSF_STREAM_CONNECT_RX(__stream)                 vsf_stream_connect_rx((vsf_stream_t *)(__stream))
+#define VSF_STREAM_CONNECT_TX(__stream)                 vsf_stream_connect_tx((vsf_stream_t *)(__stream))
+#define VSF_STREAM_DISCONNECT_RX(__stream)              vsf_stream_disconnect_rx((vsf_stream_t *)(__stream))
+#define VSF_STREAM_DISCONNECT_TX(__stream)              vsf_stream_disconnect_tx((vsf_stream_t *)(__stream))
+
+/*============================ GLOBAL VARIABLES ==============================*/
+
+extern const vsf_stream_op_t vsf_fifo_stream_op;
+
+/*============================ PROTOTYPES ====================================*/
+
+extern void __vsf_sim_task_start(vsf_task_t *task, void (*evthandler)(void *, vsf_evt_t), vsf_prio_t priority);
+extern vsf_sync_reason_t __vsf_sem_pend(vsf_sem_t *sem, int_fast32_t timeout);
+extern vsf_err_t vsf_eda_sem_post(vsf_sem_t *sem);
+extern vsf_err_t vsf_eda_sem_pend(vsf_sem_t *sem, int_fast32_t timeout);
+extern void vsf_eda_yield(void);
+// run all started tasks until none of them can make progress
+extern void vsf_sim_poll(void);
+
+extern void __vsf_sim_slist_add_to_head(vsf_slist_t *list, void *item, size_t offset);
+extern void __vsf_sim_slist_append(vsf_slist_t *list, void *item, size_t offset);
+extern void __vsf_sim_slist_remove(vsf_slist_t *list, void *item, size_t offset);
+
+extern vsf_gint_state_t vsf_disable_interrupt(void);
+extern void vsf_set_interrupt(vsf_gint_state_t level);
+
+extern vsf_systimer_cnt_t vsf_systimer_get_tick(void);
+extern vsf_systimer_cnt_t vsf_systimer_us_to_tick(uint_fast32_t time_us);
+extern vsf_systimer_cnt_t vsf_systimer_ms_to_tick(uint_fast32_t time_ms);
+extern uint_fast32_t vsf_systimer_tick_to_us(vsf_systimer_cnt_t tick);
+
+extern vsf_err_t vsf_stream_init(vsf_stream_t *stream);
+extern uint_fast32_t vsf_stream_write(vsf_stream_t *stream, uint8_t *buf, uint_fast32_t size);
+extern uint_fast32_t vsf_stream_read(vsf_stream_t *stream, uint8_t *buf, uint_fast32_t size);
+extern uint_fast32_t vsf_stream_get_buff_size(vsf_stream_t *stream);
+extern uint_fast32_t vsf_stream_get_data_size(vsf_stream_t *stream);
+extern uint_fast32_t vsf_stream_get_free_size(vsf_stream_t *stream);
+extern uint_fast32_t vsf_stream_get_rbuf(vsf_stream_t *stream, uint8_t **ptr);
+extern void vsf_stream_connect_rx(vsf_stream_t *stream);
+extern void vsf_stream_connect_tx(vsf_stream_t *stream);
+extern void vsf_stream_disconnect_rx(vsf_stream_t *stream);
+extern void vsf_stream_disconnect_tx(vsf_stream_t *stream);
+
+static inline uint_fast16_t get_unaligned_le16(const void *p)
+{
+    const uint8_t *b = (const uint8_t *)p;
+    return (uint_fast16_t)b[0] | ((uint_fast16_t)b[1] << 8);
+}
+
+static inline uint_fast32_t get_unaligned_le32(const void *p)
+{
+    const uint8_t *b = (const uint8_t *)p;
+    return (uint_fast32_t)b[0] | ((uint_fast32_t)b[1] << 8)
+        | ((uint_fast32_t)b[2] << 16) | ((uint_fast32_t)b[3] << 24);
+}
+
+static inline void put_unaligned_le16(uint_fast16_t v, void *p)
+{
+    uint8_t *b = (uint8_t *)p;
+    b[0] = (uint8_t)v;
+    b[1] = (uint8_t)(v >> 8);
+}
+
+static inline void put_unaligned_le32(uint_fast32_t v, void *p)
+{
+    uint8_t *b = (uint8_t *)p;
+    b[0] = (uint8_t)v;
+    b[1] = (uint8_t)(v >> 8);
+    b[2] = (uint8_t)(v >> 16);
+    b[3] = (uint8_t)(v >> 24);
+}
+
+/*============================ INCLUDES ======================================*/
+
+#include "proj_cfg.h"
+#include "brd_cfg.h"
+#include "sim_hal.h"
+
+#endif      // __VSF_SIM_H__
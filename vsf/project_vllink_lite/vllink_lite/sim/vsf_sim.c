@@ -0,0 +1,254 @@
+/*============================ INCLUDES ======================================*/
+
+#include "vsf.h"
+
+/*============================ LOCAL VARIABLES ===============================*/
+
+static vsf_task_t *__sim_task_list;
+static bool __sim_task_progress;
+
+/*============================ IMPLEMENTATION ================================*/
+
+/*----------------------------------------------------------------------------*
+ * Kernel                                                                     *
+ *----------------------------------------------------------------------------*/
+
+void __vsf_sim_task_start(vsf_task_t *task, void (*evthandler)(void *, vsf_evt_t), vsf_prio_t priority)
+{
+    vsf_task_t *t;
+
+    task->evthandler = evthandler;
+    task->priority = priority;
+    for (t = __sim_task_list; t != NULL; t = t->next) {
+        if (t == task)
+            break;
+    }
+    if (t == NULL) {
+        task->next = __sim_task_list;
+        __sim_task_list = task;
+    }
+    evthandler(task, VSF_EVT_INIT);
+}
+
+void vsf_sim_poll(void)
+{
+    vsf_task_t *task;
+
+    do {
+        __sim_task_progress = false;
+        for (task = __sim_task_list; task != NULL; task = task->next)
+            task->evthandler(task, VSF_EVT_SYNC);
+    } while (__sim_task_progress);
+}
+
+vsf_sync_reason_t __vsf_sem_pend(vsf_sem_t *sem, int_fast32_t timeout)
+{
+    if (sem->cur_value > 0) {
+        sem->cur_value--;
+        __sim_task_progress = true;
+        return VSF_SYNC_GET;
+    }
+    return VSF_SYNC_PENDING;
+}
+
+vsf_err_t vsf_eda_sem_pend(vsf_sem_t *sem, int_fast32_t timeout)
+{
+    return (__vsf_sem_pend(sem, timeout) == VSF_SYNC_GET) ? VSF_ERR_NONE : VSF_ERR_NOT_READY;
+}
+
+vsf_err_t vsf_eda_sem_post(vsf_sem_t *sem)
+{
+    sem->cur_value++;
+    return VSF_ERR_NONE;
+}
+
+void vsf_eda_yield(void)
+{
+    __sim_task_progress = true;
+}
+
+vsf_gint_state_t vsf_disable_interrupt(void)
+{
+    return true;
+}
+
+void vsf_set_interrupt(vsf_gint_state_t level)
+{
+}
+
+vsf_systimer_cnt_t vsf_systimer_us_to_tick(uint_fast32_t time_us)
+{
+    return time_us;
+}
+
+vsf_systimer_cnt_t vsf_systimer_ms_to_tick(uint_fast32_t time_ms)
+{
+    return (vsf_systimer_cnt_t)time_ms * 1000;
+}
+
+uint_fast32_t vsf_systimer_tick_to_us(vsf_systimer_cnt_t tick)
+{
+    return tick;
+}
+
+/*----------------------------------------------------------------------------*
+ * Fifo stream                                                                *
+ *----------------------------------------------------------------------------*/
+
+static void __vsf_fifo_stream_init(vsf_stream_t *stream)
+{
+    vsf_fifo_stream_t *fifo = (vsf_fifo_stream_t *)stream;
+    fifo->head = fifo->tail = 0;
+}
+
+static uint_fast32_t __vsf_fifo_stream_get_data_length(vsf_stream_t *stream)
+{
+    vsf_fifo_stream_t *fifo = (vsf_fifo_stream_t *)stream;
+    return fifo->head - fifo->tail;
+}
+
+static uint_fast32_t __vsf_fifo_stream_get_avail_length(vsf_stream_t *stream)
+{
+    vsf_fifo_stream_t *fifo = (vsf_fifo_stream_t *)stream;
+    return fifo->size - (fifo->head - fifo->tail);
+}
+
+static uint_fast32_t __vsf_fifo_stream_get_buff_length(vsf_stream_t *stream)
+{
+    return ((vsf_fifo_stream_t *)stream)->size;
+}
+
+static uint_fast32_t __vsf_fifo_stream_write(vsf_stream_t *stream, uint8_t *buf, uint_fast32_t size)
+{
+    vsf_fifo_stream_t *fifo = (vsf_fifo_stream_t *)stream;
+    uint_fast32_t i;
+
+    size = min(size, __vsf_fifo_stream_get_avail_length(stream));
+    for (i = 0; i < size; i++)
+        fifo->buffer[fifo->head++ % fifo->size] = buf[i];
+    return size;
+}
+
+static uint_fast32_t __vsf_fifo_stream_read(vsf_stream_t *stream, uint8_t *buf, uint_fast32_t size)
+{
+    vsf_fifo_stream_t *fifo = (vsf_fifo_stream_t *)stream;
+    uint_fast32_t i;
+
+    size = min(size, __vsf_fifo_stream_get_data_length(stream));
+    for (i = 0; i < size; i++) {
+        uint8_t byte = fifo->buffer[fifo->tail++ % fifo->size];
+        if (buf != NULL)
+            buf[i] = byte;
+    }
+    return size;
+}
+
+static uint_fast32_t __vsf_fifo_stream_get_rbuf(vsf_stream_t *stream, uint8_t **ptr)
+{
+    vsf_fifo_stream_t *fifo = (vsf_fifo_stream_t *)stream;
+    uint_fast32_t pos = fifo->tail % fifo->size;
+
+    if (ptr != NULL)
+        *ptr = &fifo->buffer[pos];
+    return min(fifo->size - pos, __vsf_fifo_stream_get_data_length(stream));
+}
+
+const vsf_stream_op_t vsf_fifo_stream_op = {
+    .init               = __vsf_fifo_stream_init,
+    .write              = __vsf_fifo_stream_write,
+    .read               = __vsf_fifo_stream_read,
+    .get_buff_length    = __vsf_fifo_stream_get_buff_length,
+    .get_data_length    = __vsf_fifo_stream_get_data_length,
+    .get_avail_length   = __vsf_fifo_stream_get_avail_length,
+    .get_rbuf           = __vsf_fifo_stream_get_rbuf,
+};
+
+vsf_err_t vsf_stream_init(vsf_stream_t *stream)
+{
+    stream->rx_ready = stream->tx_ready = false;
+    stream->op->init(stream);
+    return VSF_ERR_NONE;
+}
+
+uint_fast32_t vsf_stream_write(vsf_stream_t *stream, uint8_t *buf, uint_fast32_t size)
+{
+    return stream->op->write(stream, buf, size);
+}
+
+uint_fast32_t vsf_stream_read(vsf_stream_t *stream, uint8_t *buf, uint_fast32_t size)
+{
+    return stream->op->read(stream, buf, size);
+}
+
+uint_fast32_t vsf_stream_get_buff_size(vsf_stream_t *stream)
+{
+    return stream->op->get_buff_length(stream);
+}
+
+uint_fast32_t vsf_stream_get_data_size(vsf_stream_t *stream)
+{
+    return stream->op->get_data_length(stream);
+}
+
+uint_fast32_t vsf_stream_get_free_size(vsf_stream_t *stream)
+{
+    return stream->op->get_avail_length(stream);
+}
+
+uint_fast32_t vsf_stream_get_rbuf(vsf_stream_t *stream, uint8_t **ptr)
+{
+    return stream->op->get_rbuf(stream, ptr);
+}
+
+void vsf_stream_connect_rx(vsf_stream_t *stream)
+{
+    stream->rx_ready = true;
+}
+
+void vsf_stream_connect_tx(vsf_stream_t *stream)
+{
+    stream->tx_ready = true;
+}
+
+void vsf_stream_disconnect_rx(vsf_stream_t *stream)
+{
+    stream->rx_ready = false;
+}
+
+void vsf_stream_disconnect_tx(vsf_stream_t *stream)
+{
+    stream->tx_ready = false;
+}
+
+/*----------------------------------------------------------------------------*
+ * Single list, for the vsfvm runtime                                         *
+ *----------------------------------------------------------------------------*/
+
+#define __SIM_SLIST_NODE(__item, __offset)                                      \
+            ((vsf_slist_node_t *)((uint8_t *)(__item) + (__offset)))
+
+void __vsf_sim_slist_add_to_head(vsf_slist_t *list, void *item, size_t offset)
+{
+    __SIM_SLIST_NODE(item, offset)->next = list->head;
+    list->head = item;
+}
+
+void __vsf_sim_slist_append(vsf_slist_t *list, void *item, size_t offset)
+{
+    void **next = &list->head;
+
+    while (*next != NULL)
+        next = &__SIM_SLIST_NODE(*next, offset)->next;
+    __SIM_SLIST_NODE(item, offset)->next = NULL;
+    *next = item;
+}
+
+void __vsf_sim_slist_remove(vsf_slist_t *list, void *item, size_t offset)
+{
+    void **next = &list->head;
+
+    while ((*next != NULL) && (*next != item))
+        next = &__SIM_SLIST_NODE(*next, offset)->next;
+    if (*next != NULL)
+        *next = __SIM_SLIST_NODE(item, offset)->next;
+}
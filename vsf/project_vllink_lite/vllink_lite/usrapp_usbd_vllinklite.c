@@ -7,7 +7,10 @@ typedef struct usbd_vllinklite_nonconst_t {
 typedef struct usbd_vllinklite_const_t {
     struct {
         uint8_t dev_desc[18];
-        uint8_t config_desc[APP_CFG_USBD_CONFIGDESC_LENGTH];
+        #ifdef APP_CFG_USBD_HS_SUPPORT
+        uint8_t qualifier_desc[USB_DT_DEVICE_QUALIFIER_SIZE];
+        #endif
+        uint8_t config_desc[APP_CFG_USBD_CONFIGDESC_LENGTH];     // full speed
         uint8_t winusb_desc[APP_CFG_USBD_WINUSB_DESC_LENGTH];
         uint8_t bos_desc[APP_CFG_USBD_BOS_DESC_LENGTH];
         uint8_t str_lanid[4];
@@ -19,10 +22,25 @@ typedef struct usbd_vllinklite_const_t {
         #ifdef APP_CFG_CDCSHELL_SUPPORT
         uint8_t str_cdcshell[32];
         #endif
+        #ifdef APP_CFG_CMSIS_DAP_V1_SUPPORT
+        uint8_t str_cmsis_dap_v1[26];
+        uint8_t cmsis_dap_v1_report_desc[33];
+        vk_usbd_desc_t cmsis_dap_v1_desc[1];
+        #endif
         vk_usbd_desc_t std_desc[APP_CFG_USBD_DESC_COUNT];
     } usbd;
 } usbd_vllinklite_const_t;
 
+#ifdef APP_CFG_USBD_HS_SUPPORT
+// config descriptors for the enumerated speed, built from the full speed one
+typedef struct usbd_vllinklite_speed_t {
+    struct {
+        uint8_t config_desc[APP_CFG_USBD_CONFIGDESC_LENGTH];
+        uint8_t other_speed_desc[APP_CFG_USBD_CONFIGDESC_LENGTH];
+    } usbd;
+} usbd_vllinklite_speed_t;
+#endif
+
 #ifdef APP_CFG_CDCEXT_SUPPORT
 describe_block_stream(cdcext_ext2usb_stream, APP_CFG_CDCEXT_EXT2USB_PKT_NUM, APP_CFG_CDCEXT_PKT_SIZE)
 describe_block_stream(cdcext_usb2ext_stream, APP_CFG_CDCEXT_USB2EXT_PKT_NUM, APP_CFG_CDCEXT_PKT_SIZE)
@@ -52,6 +70,9 @@ typedef struct usbd_vllinklite_t {
         #ifdef APP_CFG_CDCSHELL_SUPPORT
         vk_usbd_cdcacm_t cdcshell;
         #endif
+        #ifdef APP_CFG_CMSIS_DAP_V1_SUPPORT
+        vk_usbd_cmsis_dap_v1_t cmsis_dap_v1;
+        #endif
     } usbd;
 } usbd_vllinklite_t;
 
@@ -69,6 +90,10 @@ static const usbd_vllinklite_nonconst_t __usrapp_usbd_vllinklite_nonconst = {
 };
 #endif
 
+#ifdef APP_CFG_USBD_HS_SUPPORT
+static usbd_vllinklite_speed_t __usrapp_usbd_vllinklite_speed;
+#endif
+
 static const usbd_vllinklite_const_t __usrapp_usbd_vllinklite_const = {
     .usbd                       = {
         .dev_desc               = {
@@ -90,6 +115,11 @@ static const usbd_vllinklite_const_t __usrapp_usbd_vllinklite_const = {
             3,                      // serial number
             1,                      // number of configuration
         },
+        #ifdef APP_CFG_USBD_HS_SUPPORT
+        .qualifier_desc         = {
+            USB_DESC_QUALIFIER(0x0200, 0xEF, 0x02, 0x01, 64, 1)
+        },
+        #endif
         .config_desc            = {
             USB_DT_CONFIG_SIZE,
             USB_DT_CONFIG,
@@ -103,12 +133,16 @@ static const usbd_vllinklite_const_t __usrapp_usbd_vllinklite_const = {
             0xFA,                   // MaxPower
             
             #ifdef APP_CFG_CMSIS_DAP_V2_SUPPORT
-            /* CMSIS-DAP V2, Length: 23 */ 
+            /* CMSIS-DAP V2, Length: 23, 30 with SWO_STREAM */ 
             0x09,        // bLength
             0x04,        // bDescriptorType (Interface)
             0x00,        // bInterfaceNumber 0
             0x00,        // bAlternateSetting
+            #if SWO_STREAM
+            0x03,        // bNumEndpoints 3
+            #else
             0x02,        // bNumEndpoints 2
+            #endif
             0xFF,        // bInterfaceClass
             0x00,        // bInterfaceSubClass
             0x00,        // bInterfaceProtocol
@@ -118,15 +152,28 @@ static const usbd_vllinklite_const_t __usrapp_usbd_vllinklite_const = {
             0x05,        // bDescriptorType (Endpoint)
             0x01,        // bEndpointAddress (OUT/H2D)
             0x02,        // bmAttributes (Bulk)
-            0x40, 0x00,  // wMaxPacketSize 64
+            USB_DESC_WORD(CMSIS_DAP_V2_FS_EP_SIZE),
+                         // wMaxPacketSize, 512 at high speed
             0x00,        // bInterval 0 (unit depends on device speed)
 
             0x07,        // bLength
             0x05,        // bDescriptorType (Endpoint)
             0x81,        // bEndpointAddress (IN/D2H)
             0x02,        // bmAttributes (Bulk)
-            0x40, 0x00,  // wMaxPacketSize 64
+            USB_DESC_WORD(CMSIS_DAP_V2_FS_EP_SIZE),
+                         // wMaxPacketSize, 512 at high speed
             0x00,        // bInterval 0 (unit depends on device speed)
+
+            #if SWO_STREAM
+            0x07,        // bLength
+            0x05,        // bDescriptorType (Endpoint)
+            0x80 | APP_CFG_CMSIS_DAP_V2_SWO_EP,
+                         // bEndpointAddress (IN/D2H), SWO trace
+            0x02,        // bmAttributes (Bulk)
+            USB_DESC_WORD(CMSIS_DAP_V2_FS_EP_SIZE),
+                         // wMaxPacketSize, 512 at high speed
+            0x00,        // bInterval 0 (unit depends on device speed)
+            #endif
             #endif	// APP_CFG_CMSIS_DAP_V2_SUPPORT
             
             #ifdef APP_CFG_WEBUSB_SUPPORT
@@ -327,6 +374,49 @@ static const usbd_vllinklite_const_t __usrapp_usbd_vllinklite_const = {
             0x00,
             0xFF,	// bInterval:
             #endif	// APP_CFG_CDCSHELL_SUPPORT
+
+            #ifdef APP_CFG_CMSIS_DAP_V1_SUPPORT
+            /* CMSIS-DAP V1, Length: 32 */
+            0x09,        // bLength
+            0x04,        // bDescriptorType (Interface)
+            CMSIS_DAP_V2_INTERFACE_COUNT + WEBUSB_INTERFACE_COUNT + CDCEXT_INTERFACE_COUNT + CDCSHELL_INTERFACE_COUNT,
+                         // bInterfaceNumber
+            0x00,        // bAlternateSetting
+            0x02,        // bNumEndpoints 2
+            0x03,        // bInterfaceClass (HID)
+            0x00,        // bInterfaceSubClass
+            0x00,        // bInterfaceProtocol
+            0x08,        // iInterface (String Index)
+
+            0x09,        // bLength
+            USB_HID_DT_HID,
+                         // bDescriptorType (HID)
+            0x11, 0x01,  // bcdHID 1.11
+            0x00,        // bCountryCode
+            0x01,        // bNumDescriptors
+            USB_HID_DT_REPORT,
+                         // bDescriptorType[0] (Report)
+            USB_DESC_WORD(sizeof(__usrapp_usbd_vllinklite_const.usbd.cmsis_dap_v1_report_desc)),
+                         // wDescriptorLength[0]
+
+            0x07,        // bLength
+            0x05,        // bDescriptorType (Endpoint)
+            0x80 | APP_CFG_CMSIS_DAP_V1_EP,
+                         // bEndpointAddress (IN/D2H)
+            0x03,        // bmAttributes (Interrupt)
+            DAP_HID_PACKET_SIZE, 0x00,
+                         // wMaxPacketSize
+            0x01,        // bInterval 1 (unit depends on device speed)
+
+            0x07,        // bLength
+            0x05,        // bDescriptorType (Endpoint)
+            APP_CFG_CMSIS_DAP_V1_EP,
+                         // bEndpointAddress (OUT/H2D)
+            0x03,        // bmAttributes (Interrupt)
+            DAP_HID_PACKET_SIZE, 0x00,
+                         // wMaxPacketSize
+            0x01,        // bInterval 1 (unit depends on device speed)
+            #endif	// APP_CFG_CMSIS_DAP_V1_SUPPORT
         },
         .winusb_desc            = {
             USB_DESC_WORD(10),
@@ -490,9 +580,46 @@ static const usbd_vllinklite_const_t __usrapp_usbd_vllinklite_const = {
            'D', 0, 'C', 0, 'S', 0, 'h', 0, 'e', 0, 'l', 0, 'l', 0,
         },
         #endif
+        #ifdef APP_CFG_CMSIS_DAP_V1_SUPPORT
+        .str_cmsis_dap_v1            = {
+            26,
+            USB_DT_STRING,
+            'C', 0, 'M', 0, 'S', 0, 'I', 0, 'S', 0, '-', 0, 'D', 0, 'A', 0,
+            'P', 0, ' ', 0, 'v', 0, '1', 0,
+        },
+        .cmsis_dap_v1_report_desc    = {
+            0x06, 0x00, 0xFF,   // Usage Page (Vendor Defined 0xFF00)
+            0x09, 0x01,         // Usage (0x01)
+            0xA1, 0x01,         // Collection (Application)
+            0x15, 0x00,         //   Logical Minimum (0)
+            0x26, 0xFF, 0x00,   //   Logical Maximum (255)
+            0x75, 0x08,         //   Report Size (8)
+            0x95, DAP_HID_PACKET_SIZE,
+                                //   Report Count
+            0x09, 0x01,         //   Usage (0x01)
+            0x81, 0x02,         //   Input (Data,Var,Abs)
+            0x95, DAP_HID_PACKET_SIZE,
+                                //   Report Count
+            0x09, 0x01,         //   Usage (0x01)
+            0x91, 0x02,         //   Output (Data,Var,Abs,Non-volatile)
+            0x95, 0x01,         //   Report Count (1)
+            0x09, 0x01,         //   Usage (0x01)
+            0xB1, 0x02,         //   Feature (Data,Var,Abs,Non-volatile)
+            0xC0,               // End Collection
+        },
+        .cmsis_dap_v1_desc          = {
+            VSF_USBD_DESC_HID_REPORT(__usrapp_usbd_vllinklite_const.usbd.cmsis_dap_v1_report_desc, sizeof(__usrapp_usbd_vllinklite_const.usbd.cmsis_dap_v1_report_desc)),
+        },
+        #endif
         .std_desc               = {
             VSF_USBD_DESC_DEVICE(__usrapp_usbd_vllinklite_const.usbd.dev_desc, sizeof(__usrapp_usbd_vllinklite_const.usbd.dev_desc)),
+            #ifdef APP_CFG_USBD_HS_SUPPORT
+            VSF_USBD_DESC_QUALIFIER(__usrapp_usbd_vllinklite_const.usbd.qualifier_desc),
+            VSF_USBD_DESC_CONFIG(0, __usrapp_usbd_vllinklite_speed.usbd.config_desc, sizeof(__usrapp_usbd_vllinklite_speed.usbd.config_desc)),
+            {USB_DT_OTHER_SPEED_CONFIG, 0, 0, sizeof(__usrapp_usbd_vllinklite_speed.usbd.other_speed_desc), __usrapp_usbd_vllinklite_speed.usbd.other_speed_desc},
+            #else
             VSF_USBD_DESC_CONFIG(0, __usrapp_usbd_vllinklite_const.usbd.config_desc, sizeof(__usrapp_usbd_vllinklite_const.usbd.config_desc)),
+            #endif
             {USB_DT_BOS, 0, 0, sizeof(__usrapp_usbd_vllinklite_const.usbd.bos_desc), (uint8_t*)__usrapp_usbd_vllinklite_const.usbd.bos_desc},
             VSF_USBD_DESC_STRING(0, 0, __usrapp_usbd_vllinklite_const.usbd.str_lanid, sizeof(__usrapp_usbd_vllinklite_const.usbd.str_lanid)),
             VSF_USBD_DESC_STRING(0x0409, 1, __usrapp_usbd_vllinklite_const.usbd.str_vendor, sizeof(__usrapp_usbd_vllinklite_const.usbd.str_vendor)),
@@ -511,13 +638,16 @@ static const usbd_vllinklite_const_t __usrapp_usbd_vllinklite_const = {
             #ifdef APP_CFG_CDCSHELL_SUPPORT
             VSF_USBD_DESC_STRING(0x0409, 7, __usrapp_usbd_vllinklite_const.usbd.str_cdcshell, sizeof(__usrapp_usbd_vllinklite_const.usbd.str_cdcshell)),
             #endif
+            #ifdef APP_CFG_CMSIS_DAP_V1_SUPPORT
+            VSF_USBD_DESC_STRING(0x0409, 8, __usrapp_usbd_vllinklite_const.usbd.str_cmsis_dap_v1, sizeof(__usrapp_usbd_vllinklite_const.usbd.str_cmsis_dap_v1)),
+            #endif
         },
     },
 };
 
 usbd_vllinklite_t __usrapp_usbd_vllinklite = {
     .usbd                       = {
-        .dev.speed              = USB_DC_SPEED_HIGH,
+        .dev.speed              = APP_CFG_USBD_SPEED,
         .dev.num_of_config      = dimof(__usrapp_usbd_vllinklite.usbd.config),
         .dev.num_of_desc        = dimof(__usrapp_usbd_vllinklite_const.usbd.std_desc),
         .dev.desc               = (vk_usbd_desc_t *)__usrapp_usbd_vllinklite_const.usbd.std_desc,
@@ -557,11 +687,20 @@ usbd_vllinklite_t __usrapp_usbd_vllinklite = {
         .ifs[1 + CMSIS_DAP_V2_INTERFACE_COUNT + WEBUSB_INTERFACE_COUNT + CDCEXT_INTERFACE_COUNT].\
                 class_param     = &__usrapp_usbd_vllinklite.usbd.cdcshell,
         #endif
+        #ifdef APP_CFG_CMSIS_DAP_V1_SUPPORT
+        .ifs[0 + CMSIS_DAP_V2_INTERFACE_COUNT + WEBUSB_INTERFACE_COUNT + CDCEXT_INTERFACE_COUNT + CDCSHELL_INTERFACE_COUNT].\
+                class_op        = &vk_usbd_cmsis_dap_v1_class,
+        .ifs[0 + CMSIS_DAP_V2_INTERFACE_COUNT + WEBUSB_INTERFACE_COUNT + CDCEXT_INTERFACE_COUNT + CDCSHELL_INTERFACE_COUNT].\
+                class_param     = &__usrapp_usbd_vllinklite.usbd.cmsis_dap_v1,
+        #endif
 
         #ifdef APP_CFG_CMSIS_DAP_V2_SUPPORT
         .cmsis_dap_v2           = {
             .ep_out             = 1,
             .ep_in              = 1,
+            #if SWO_STREAM
+            .ep_swo             = APP_CFG_CMSIS_DAP_V2_SWO_EP,
+            #endif
             .dap                = &usrapp.dap,
         },
         #endif
@@ -603,10 +742,21 @@ usbd_vllinklite_t __usrapp_usbd_vllinklite = {
                 .datalen        = 8,
             },
             .callback.set_line_coding   = usrapp_cdcshell_set_line_coding,
+            #ifdef APP_CFG_CDCSHELL_DAPHOST
+            .callback.set_control_line  = usrapp_cdcshell_set_control_line,
+            #endif
             .stream.tx.stream   = (vsf_stream_t *)&cdcshell_shell2usb_stream, 
             .stream.rx.stream   = (vsf_stream_t *)&cdcshell_usb2shell_stream,
         },
         #endif
+        #ifdef APP_CFG_CMSIS_DAP_V1_SUPPORT
+        .cmsis_dap_v1           = {
+            .ep_in              = APP_CFG_CMSIS_DAP_V1_EP,
+            .ep_out             = APP_CFG_CMSIS_DAP_V1_EP,
+            .desc               = (vk_usbd_desc_t *)__usrapp_usbd_vllinklite_const.usbd.cmsis_dap_v1_desc,
+            .dap                = &usrapp.dap,
+        },
+        #endif
     },
 };
 
@@ -625,6 +775,56 @@ vsf_err_t vsf_usbd_vendor_prepare(vk_usbd_dev_t *dev)
     return VSF_ERR_FAIL;
 }
 
+#ifdef APP_CFG_USBD_HS_SUPPORT
+// bulk endpoints take 512 bytes and interrupt intervals count in microframes at high speed
+static void usrapp_usbd_build_config_desc(uint8_t *desc, uint8_t type, bool hs)
+{
+    uint_fast16_t pos;
+    uint8_t *ep;
+
+    memcpy(desc, __usrapp_usbd_vllinklite_const.usbd.config_desc, APP_CFG_USBD_CONFIGDESC_LENGTH);
+    desc[1] = type;
+    if (!hs)
+        return;
+
+    for (pos = desc[0]; pos < APP_CFG_USBD_CONFIGDESC_LENGTH; pos += desc[pos]) {
+        ep = desc + pos;
+        if (ep[1] != USB_DT_ENDPOINT)
+            continue;
+
+        switch (ep[3] & 0x03) {
+        case USB_EP_TYPE_BULK:
+            ep[4] = 512 & 0xFF;
+            ep[5] = 512 >> 8;
+            break;
+        case USB_EP_TYPE_INTERRUPT: {
+                // 2 ^ (bInterval - 1) microframes, rounded up to no shorter than
+                //  the bInterval ms at full speed
+                uint_fast8_t interval = 4;
+                while ((interval < 16) && ((1 << (interval - 4)) < ep[6]))
+                    interval++;
+                ep[6] = interval;
+            }
+            break;
+        }
+    }
+}
+
+static void usrapp_usbd_init_speed_desc(bool hs)
+{
+    usrapp_usbd_build_config_desc(__usrapp_usbd_vllinklite_speed.usbd.config_desc, USB_DT_CONFIG, hs);
+    usrapp_usbd_build_config_desc(__usrapp_usbd_vllinklite_speed.usbd.other_speed_desc, USB_DT_OTHER_SPEED_CONFIG, !hs);
+}
+
+vsf_err_t vsf_usbd_notify_user(vk_usbd_dev_t *dev, usb_evt_t evt, void *param)
+{
+    // the host reads the config descriptor only after the bus reset
+    if (USB_ON_RESET == evt)
+        usrapp_usbd_init_speed_desc(vk_usbd_get_speed(dev) == USB_DC_SPEED_HIGH);
+    return VSF_ERR_NONE;
+}
+#endif
+
 // double tx ep fifo size
 uint_fast16_t vsf_dwcotg_dcd_get_fifo_size(uint_fast8_t ep, usb_ep_type_t type, uint_fast16_t size)
 {
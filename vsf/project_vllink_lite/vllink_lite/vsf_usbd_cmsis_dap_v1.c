@@ -0,0 +1,151 @@
+/*============================ INCLUDES ======================================*/
+
+#include "component/usb/vsf_usb_cfg.h"
+
+#if VSF_USE_USB_DEVICE == ENABLED && VSF_USBD_USE_HID == ENABLED
+
+#define __VSF_EDA_CLASS_INHERIT__
+#define __VSF_USBD_CLASS_INHERIT__
+#define __VSF_USBD_HID_CLASS_INHERIT
+#define __VSF_USBD_CMSIS_DAP_V1_IMPLEMENT
+
+#include "vsf.h"
+#include "vsf_usbd_cmsis_dap_v1.h"
+
+/*============================ MACROS ========================================*/
+
+// responses are sent out of the dap slots
+#if DAP_HID_PACKET_SIZE > DAP_PACKET_SIZE
+#   error "DAP_HID_PACKET_SIZE does not fit into a dap slot"
+#endif
+
+/*============================ MACROFIED FUNCTIONS ===========================*/
+/*============================ TYPES =========================================*/
+/*============================ PROTOTYPES ====================================*/
+
+static vk_usbd_desc_t * __vk_usbd_cmsis_dap_v1_get_desc(vk_usbd_dev_t *dev,
+            uint_fast8_t type, uint_fast8_t index, uint_fast16_t lanid);
+static vsf_err_t __vk_usbd_cmsis_dap_v1_request_prepare(vk_usbd_dev_t *dev, vk_usbd_ifs_t *ifs);
+static vsf_err_t __vk_usbd_cmsis_dap_v1_request_process(vk_usbd_dev_t *dev, vk_usbd_ifs_t *ifs);
+static vsf_err_t __vk_usbd_cmsis_dap_v1_class_init(vk_usbd_dev_t *dev, vk_usbd_ifs_t *ifs);
+static vsf_err_t __vk_usbd_cmsis_dap_v1_class_fini(vk_usbd_dev_t *dev, vk_usbd_ifs_t *ifs);
+
+/*============================ GLOBAL VARIABLES ==============================*/
+
+// vk_usbd_hid underneath, class_param is the vk_usbd_hid_t it implements
+const vk_usbd_class_op_t vk_usbd_cmsis_dap_v1_class = {
+    .get_desc =             __vk_usbd_cmsis_dap_v1_get_desc,
+    .request_prepare =      __vk_usbd_cmsis_dap_v1_request_prepare,
+    .request_process =      __vk_usbd_cmsis_dap_v1_request_process,
+    .init =                 __vk_usbd_cmsis_dap_v1_class_init,
+    .fini =                 __vk_usbd_cmsis_dap_v1_class_fini,
+};
+
+/*============================ LOCAL VARIABLES ===============================*/
+/*============================ IMPLEMENTATION ================================*/
+
+static vsf_err_t request_queue(vk_usbd_cmsis_dap_v1_t *cmsis_dap_v1)
+{
+    vk_usbd_hid_t *hid = &cmsis_dap_v1->use_as__vk_usbd_hid_t;
+    vk_usbd_hid_report_t *report = &cmsis_dap_v1->report[1];
+    vsf_err_t err;
+
+    err = dap_requset(cmsis_dap_v1->dap, &cmsis_dap_v1->client,
+            cmsis_dap_v1->request_buff, DAP_HID_PACKET_SIZE);
+    // no dap slot for this client: hold the report and leave OUT endpoint
+    // NAKing, on_report retries after the response is sent
+    cmsis_dap_v1->request_pending = err != VSF_ERR_NONE;
+    if (!cmsis_dap_v1->request_pending)
+        vk_usbh_hid_out_report_processed(hid, report);
+    return err;
+}
+
+static void on_response_ready(void *p, uint8_t *buf, uint16_t size)
+{
+    vk_usbd_cmsis_dap_v1_t *cmsis_dap_v1 = p;
+    vk_usbd_hid_report_t *report = &cmsis_dap_v1->report[0];
+
+    // a report is always sent in full
+    report->mem.buffer = buf;
+    cmsis_dap_v1->response_busy = true;
+    vk_usbd_hid_in_report_changed(&cmsis_dap_v1->use_as__vk_usbd_hid_t, report);
+}
+
+static vsf_err_t on_report(vk_usbd_hid_t *hid, vk_usbd_hid_report_t *report)
+{
+    vk_usbd_cmsis_dap_v1_t *cmsis_dap_v1 = container_of(hid, vk_usbd_cmsis_dap_v1_t, use_as__vk_usbd_hid_t);
+
+    if (report->type == USB_HID_REPORT_OUTPUT) {
+        request_queue(cmsis_dap_v1);
+    } else {
+        uint8_t *buf = report->mem.buffer;
+
+        // GET_REPORT has nothing to return once the slot is released
+        report->mem.buffer = NULL;
+        cmsis_dap_v1->response_busy = false;
+        dap_response_done(cmsis_dap_v1->dap, buf);
+        if (cmsis_dap_v1->request_pending)
+            request_queue(cmsis_dap_v1);
+    }
+    return VSF_ERR_NONE;
+}
+
+static vk_usbd_desc_t * __vk_usbd_cmsis_dap_v1_get_desc(vk_usbd_dev_t *dev,
+            uint_fast8_t type, uint_fast8_t index, uint_fast16_t lanid)
+{
+    return vk_usbd_hid.get_desc(dev, type, index, lanid);
+}
+
+static vsf_err_t __vk_usbd_cmsis_dap_v1_request_prepare(vk_usbd_dev_t *dev, vk_usbd_ifs_t *ifs)
+{
+    return vk_usbd_hid.request_prepare(dev, ifs);
+}
+
+static vsf_err_t __vk_usbd_cmsis_dap_v1_request_process(vk_usbd_dev_t *dev, vk_usbd_ifs_t *ifs)
+{
+    return vk_usbd_hid.request_process(dev, ifs);
+}
+
+static vsf_err_t __vk_usbd_cmsis_dap_v1_class_init(vk_usbd_dev_t *dev, vk_usbd_ifs_t *ifs)
+{
+    vk_usbd_cmsis_dap_v1_t *cmsis_dap_v1 = ifs->class_param;
+    vk_usbd_hid_t *hid = &cmsis_dap_v1->use_as__vk_usbd_hid_t;
+    vk_usbd_hid_report_t *report;
+
+    dap_client_init(cmsis_dap_v1->dap, &cmsis_dap_v1->client, on_response_ready, cmsis_dap_v1);
+
+    // a response pending over a bus reset is lost, its slot is released
+    report = &cmsis_dap_v1->report[0];
+    if (cmsis_dap_v1->response_busy) {
+        cmsis_dap_v1->response_busy = false;
+        dap_response_done(cmsis_dap_v1->dap, report->mem.buffer);
+    }
+    report->type = USB_HID_REPORT_INPUT;
+    report->changed = false;
+    report->mem.buffer = NULL;
+    report->mem.size = DAP_HID_PACKET_SIZE;
+
+    // and so is a request held for a slot
+    cmsis_dap_v1->request_pending = false;
+    report = &cmsis_dap_v1->report[1];
+    report->type = USB_HID_REPORT_OUTPUT;
+    report->changed = false;
+    report->mem.buffer = NULL;
+    report->mem.size = DAP_HID_PACKET_SIZE;
+
+    hid->num_of_report = dimof(cmsis_dap_v1->report);
+    hid->reports = cmsis_dap_v1->report;
+    hid->rx_buffer.buffer = cmsis_dap_v1->request_buff;
+    hid->rx_buffer.size = sizeof(cmsis_dap_v1->request_buff);
+    hid->has_report_id = 0;
+    hid->notify_eda = 0;
+    hid->on_report = on_report;
+    return vk_usbd_hid.init(dev, ifs);
+}
+
+static vsf_err_t __vk_usbd_cmsis_dap_v1_class_fini(vk_usbd_dev_t *dev, vk_usbd_ifs_t *ifs)
+{
+    return vk_usbd_hid.fini(dev, ifs);
+}
+
+#endif      // VSF_USE_USB_DEVICE && VSF_USBD_USE_HID
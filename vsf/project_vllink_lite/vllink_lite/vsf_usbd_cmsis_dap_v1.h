@@ -0,0 +1,59 @@
+#ifndef __VSF_USBD_CMSIS_DAP_V1_H__
+#define __VSF_USBD_CMSIS_DAP_V1_H__
+
+/*============================ INCLUDES ======================================*/
+
+#include "component/usb/vsf_usb_cfg.h"
+#include "dap/dap.h"
+
+#if VSF_USE_USB_DEVICE == ENABLED && VSF_USBD_USE_HID == ENABLED
+
+#include "component/usb/device/class/HID/vsf_usbd_HID.h"
+
+#if     defined(__VSF_USBD_CMSIS_DAP_V1_IMPLEMENT)
+#   define __PLOOC_CLASS_IMPLEMENT__
+#elif   defined(__VSF_USBD_CMSIS_DAP_V1_INHERIT__)
+#   define __PLOOC_CLASS_INHERIT__
+#endif
+#include "utilities/ooc_class.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*============================ MACROS ========================================*/
+/*============================ MACROFIED FUNCTIONS ===========================*/
+/*============================ TYPES =========================================*/
+
+declare_simple_class(vk_usbd_cmsis_dap_v1_t)
+
+// CMSIS-DAP v1, one DAP_HID_PACKET_SIZE report each way without report id
+def_simple_class(vk_usbd_cmsis_dap_v1_t) {
+
+    public_member(
+        implement(vk_usbd_hid_t)
+
+        dap_t *dap;
+    )
+
+    private_member(
+        dap_client_t client;
+        vk_usbd_hid_report_t report[2];
+        uint8_t request_buff[DAP_HID_PACKET_SIZE];
+        bool request_pending;       // OUT report held until dap has a free slot
+        bool response_busy;         // input report sent out of a dap slot
+    )
+};
+
+/*============================ GLOBAL VARIABLES ==============================*/
+
+extern const vk_usbd_class_op_t vk_usbd_cmsis_dap_v1_class;
+
+/*============================ PROTOTYPES ====================================*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif      // VSF_USE_USB_DEVICE && VSF_USBD_USE_HID
+#endif      // __VSF_USBD_CMSIS_DAP_V1_H__
@@ -6,12 +6,19 @@
 
 #define __VSF_EDA_CLASS_INHERIT__
 #define __VSF_USBD_CLASS_INHERIT__
+#define __VSF_SIMPLE_STREAM_CLASS_INHERIT__
 #define __VSF_USBD_CMSIS_DAP_V2_IMPLEMENT
 
 #include "vsf.h"
 #include "vsf_usbd_cmsis_dap_v2.h"
 
 /*============================ MACROS ========================================*/
+
+// packets are received into and sent out of the dap slots
+#if CMSIS_DAP_V2_PACKET_SIZE > DAP_PACKET_SIZE
+#   error "CMSIS_DAP_V2_PACKET_SIZE does not fit into a dap slot"
+#endif
+
 /*============================ MACROFIED FUNCTIONS ===========================*/
 /*============================ TYPES =========================================*/
 /*============================ PROTOTYPES ====================================*/
@@ -28,25 +35,140 @@ const vk_usbd_class_op_t vk_usbd_cmsis_dap_v2_class = {
 /*============================ IMPLEMENTATION ================================*/
 
 
+static void on_response_ready(void *p, uint8_t *buf, uint16_t size);
+
+/*
+    The OUT transfer receives straight into the dap slot queued next. While
+    the client may not take another slot, the OUT endpoint still takes one
+    packet into peek_buf, so DAP_TransferAbort reaches the dap task while all
+    slots are busy. Any other packet waits there, the endpoint NAKs until a
+    slot is free, on_response_finish retries after a slot is released.
+*/
+static void request_recv(vk_usbd_cmsis_dap_v2_t *cmsis_dap_v2)
+{
+    vk_usbd_trans_t *trans = &cmsis_dap_v2->transact_out;
+    uint16_t peek_size = cmsis_dap_v2->peek_size;
+    uint8_t *buf;
+
+    if (cmsis_dap_v2->request_buf || cmsis_dap_v2->peek_busy)
+        return;
+
+    buf = dap_request_buf(cmsis_dap_v2->dap, &cmsis_dap_v2->client);
+    if (!buf) {
+        if (!peek_size) {
+            cmsis_dap_v2->peek_busy = true;
+            trans->use_as__vsf_mem_t.buffer = cmsis_dap_v2->peek_buf;
+            trans->use_as__vsf_mem_t.size = cmsis_dap_v2->ep_size;
+            vk_usbd_ep_recv(cmsis_dap_v2->dev, trans);
+        }
+        return;
+    }
+
+    cmsis_dap_v2->peek_size = 0;
+    if (peek_size) {
+        memcpy(buf, cmsis_dap_v2->peek_buf, peek_size);
+        // a short packet ends the request
+        if (peek_size < cmsis_dap_v2->ep_size) {
+            dap_requset(cmsis_dap_v2->dap, &cmsis_dap_v2->client, buf, cmsis_dap_v2->pkt_size);
+            request_recv(cmsis_dap_v2);
+            return;
+        }
+    }
+    cmsis_dap_v2->request_buf = buf;
+    trans->use_as__vsf_mem_t.buffer = buf + peek_size;
+    trans->use_as__vsf_mem_t.size = cmsis_dap_v2->pkt_size - peek_size;
+    vk_usbd_ep_recv(cmsis_dap_v2->dev, trans);
+}
+
+#if CMSIS_DAP_V2_PACKED
+/*
+    Packed responses: once the host has read DAP_Info DAP_ID_PACKED_SIZE, each
+    response is copied into a packed buffer behind its 16-bit little endian
+    length and its dap slot is released at once. A buffer goes out as soon as
+    the IN endpoint is idle, responses completed meanwhile collect in the
+    other one, so a run of small responses takes one transfer. A transfer
+    ending on a full packet is terminated by a ZLP instead of padding.
+*/
+static void packed_send(vk_usbd_cmsis_dap_v2_t *cmsis_dap_v2)
+{
+    vk_usbd_trans_t *trans = &cmsis_dap_v2->transact_in;
+
+    trans->use_as__vsf_mem_t.buffer = cmsis_dap_v2->packed_buf[cmsis_dap_v2->packed_fill];
+    trans->use_as__vsf_mem_t.size = cmsis_dap_v2->packed_len;
+    trans->zlp = true;
+    cmsis_dap_v2->packed_fill ^= 1;
+    cmsis_dap_v2->packed_len = 0;
+    cmsis_dap_v2->response_busy = true;
+    vk_usbd_ep_send(cmsis_dap_v2->dev, trans);
+}
+
+static void packed_add(vk_usbd_cmsis_dap_v2_t *cmsis_dap_v2, uint8_t *buf, uint16_t size)
+{
+    uint8_t *packed = cmsis_dap_v2->packed_buf[cmsis_dap_v2->packed_fill];
+    uint16_t len = cmsis_dap_v2->packed_len;
+
+    size = min(size, cmsis_dap_v2->pkt_size);
+    // no room only while a transfer is in flight, the buffer is sent when idle
+    if (len + 2 + size > cmsis_dap_v2->pkt_size + 2) {
+        cmsis_dap_v2->held = buf;
+        cmsis_dap_v2->held_size = size;
+        return;
+    }
+    if (size) {
+        put_unaligned_le16(size, packed + len);
+        memcpy(packed + len + 2, buf, size);
+        cmsis_dap_v2->packed_len = len + 2 + size;
+        if (!cmsis_dap_v2->response_busy)
+            packed_send(cmsis_dap_v2);
+    }
+    dap_response_done(cmsis_dap_v2->dap, buf);
+}
+#endif
+
 static void on_response_finish(void *param)
 {
     vk_usbd_cmsis_dap_v2_t *cmsis_dap_v2 = param;
-    vsf_sem_post(&cmsis_dap_v2->response_sem);
+    uint8_t *buf = cmsis_dap_v2->transact_in.use_as__vsf_mem_t.buffer;
+
+    cmsis_dap_v2->response_busy = false;
+#if CMSIS_DAP_V2_PACKED
+    if ((buf != cmsis_dap_v2->packed_buf[0]) && (buf != cmsis_dap_v2->packed_buf[1]))
+        dap_response_done(cmsis_dap_v2->dap, buf);
+    if (cmsis_dap_v2->packed_len)
+        packed_send(cmsis_dap_v2);
+    buf = cmsis_dap_v2->held;
+    if (buf) {
+        cmsis_dap_v2->held = NULL;
+        packed_add(cmsis_dap_v2, buf, cmsis_dap_v2->held_size);
+    }
+#else
+    dap_response_done(cmsis_dap_v2->dap, buf);
+#endif
+    request_recv(cmsis_dap_v2);
 }
 
+// the IN transfer sends straight out of the dap slot, it is handed back when done
 static void on_response_ready(void *p, uint8_t *buf, uint16_t size)
 {
     vk_usbd_cmsis_dap_v2_t *cmsis_dap_v2 = p;
     vk_usbd_trans_t *trans = &cmsis_dap_v2->transact_in;
-    
+
+#if CMSIS_DAP_V2_PACKED
+    if (cmsis_dap_v2->client.packed) {
+        packed_add(cmsis_dap_v2, buf, size);
+        return;
+    }
+    trans->zlp = false;
+#endif
+    trans->use_as__vsf_mem_t.buffer = buf;
     if (size) {
-        if (size < sizeof(cmsis_dap_v2->response_buff)) {
-            if (!(size % 64))
+        if (size < cmsis_dap_v2->pkt_size) {
+            if (!(size % cmsis_dap_v2->ep_size))
                 size += 1;
         } else {
-            size = sizeof(cmsis_dap_v2->response_buff);
+            size = cmsis_dap_v2->pkt_size;
         }
-        memcpy(cmsis_dap_v2->response_buff, buf, size);
+        cmsis_dap_v2->response_busy = true;
         trans->use_as__vsf_mem_t.size = size;
         vk_usbd_ep_send(cmsis_dap_v2->dev, trans);
     } else {
@@ -57,23 +179,59 @@ static void on_response_ready(void *p, uint8_t *buf, uint16_t size)
 static void on_request_finish(void *param)
 {
     vk_usbd_cmsis_dap_v2_t *cmsis_dap_v2 = param;
-    vk_usbd_trans_t *trans = &cmsis_dap_v2->transact_out;
+    uint8_t *buf = cmsis_dap_v2->request_buf;
+    uint16_t size;
 
-    vsf_err_t ret = dap_requset(cmsis_dap_v2->dap, &cmsis_dap_v2->response_sem,
-                on_response_ready, cmsis_dap_v2,
-                trans->use_as__vsf_mem_t.buffer, sizeof(cmsis_dap_v2->request_buff));
-    if (ret != VSF_ERR_NONE) {
-        if (vsf_eda_sem_pend(&cmsis_dap_v2->response_sem, 0) == VSF_ERR_NONE) {
-            uint8_t buf[1] = {ID_DAP_Invalid};
-            on_response_ready(cmsis_dap_v2, buf, 1);
-        } else {
-            // Not Support this case, response will lost
+    if (cmsis_dap_v2->peek_busy) {
+        cmsis_dap_v2->peek_busy = false;
+        size = cmsis_dap_v2->ep_size - cmsis_dap_v2->transact_out.use_as__vsf_mem_t.size;
+        buf = cmsis_dap_v2->peek_buf;
+        // an abort takes no slot
+        if (size && (buf[0] == ID_DAP_TransferAbort))
+            dap_requset(cmsis_dap_v2->dap, &cmsis_dap_v2->client, buf, size);
+        else
+            cmsis_dap_v2->peek_size = size;
+    } else {
+        cmsis_dap_v2->request_buf = NULL;
+        dap_requset(cmsis_dap_v2->dap, &cmsis_dap_v2->client, buf, cmsis_dap_v2->pkt_size);
+    }
+    request_recv(cmsis_dap_v2);
+}
+
+#if SWO_UART && SWO_STREAM
+// trace data goes out of swo_rx without a copy, one block per IN transfer
+static void swo_send(vk_usbd_cmsis_dap_v2_t *cmsis_dap_v2)
+{
+    vk_usbd_trans_t *trans = &cmsis_dap_v2->transact_swo;
+    uint8_t *buf;
+    uint32_t size;
+
+    if (!cmsis_dap_v2->swo_busy) {
+        size = dap_swo_stream_get(&cmsis_dap_v2->dap->dap_param, &buf);
+        if (size) {
+            cmsis_dap_v2->swo_busy = true;
+            trans->use_as__vsf_mem_t.buffer = buf;
+            trans->use_as__vsf_mem_t.size = size;
+            vk_usbd_ep_send(cmsis_dap_v2->dev, trans);
         }
     }
+}
 
-    trans->use_as__vsf_mem_t.size = sizeof(cmsis_dap_v2->request_buff);
-    vk_usbd_ep_recv(cmsis_dap_v2->dev, trans);
+static void on_swo_finish(void *param)
+{
+    vk_usbd_cmsis_dap_v2_t *cmsis_dap_v2 = param;
+
+    cmsis_dap_v2->swo_busy = false;
+    dap_swo_stream_done(&cmsis_dap_v2->dap->dap_param);
+    swo_send(cmsis_dap_v2);
+}
+
+static void on_swo_stream(void *param, vsf_stream_evt_t evt)
+{
+    if (evt == VSF_STREAM_ON_RX)
+        swo_send(param);
 }
+#endif
 
 static vsf_err_t __vk_usbd_cmsis_dap_v2_class_init(vk_usbd_dev_t *dev, vk_usbd_ifs_t *ifs)
 {
@@ -82,28 +240,72 @@ static vsf_err_t __vk_usbd_cmsis_dap_v2_class_init(vk_usbd_dev_t *dev, vk_usbd_i
 
     cmsis_dap_v2->dev = dev;
     cmsis_dap_v2->ifs = ifs;
-    
-    vsf_sem_init(&cmsis_dap_v2->response_sem, 1);
-    
+
+    // packet size is reported per request, so it follows the enumerated speed
+    if (vk_usbd_get_speed(dev) == USB_DC_SPEED_HIGH) {
+        cmsis_dap_v2->pkt_size = CMSIS_DAP_V2_PACKET_SIZE;
+        cmsis_dap_v2->ep_size = 512;
+    } else {
+        cmsis_dap_v2->pkt_size = CMSIS_DAP_V2_FS_PACKET_SIZE;
+        cmsis_dap_v2->ep_size = CMSIS_DAP_V2_FS_EP_SIZE;
+    }
+
+    // a response pending over a bus reset is lost, its slot is released
+    if (cmsis_dap_v2->response_busy) {
+        cmsis_dap_v2->response_busy = false;
+        dap_response_done(cmsis_dap_v2->dap, cmsis_dap_v2->transact_in.use_as__vsf_mem_t.buffer);
+    }
+#if CMSIS_DAP_V2_PACKED
+    cmsis_dap_v2->packed_fill = 0;
+    cmsis_dap_v2->packed_len = 0;
+    if (cmsis_dap_v2->held) {
+        dap_response_done(cmsis_dap_v2->dap, cmsis_dap_v2->held);
+        cmsis_dap_v2->held = NULL;
+    }
+#endif
+    dap_client_init(cmsis_dap_v2->dap, &cmsis_dap_v2->client, on_response_ready, cmsis_dap_v2);
+#if CMSIS_DAP_V2_PACKED
+    cmsis_dap_v2->client.packed_size = cmsis_dap_v2->pkt_size + 2;
+#endif
+
+    trans = &cmsis_dap_v2->transact_in;
+    trans->ep = cmsis_dap_v2->ep_in;
+    trans->zlp = false;
+    trans->notify_eda = false;
+    trans->on_finish = on_response_finish;
+    trans->param = cmsis_dap_v2;
+
+    // and so is a request being received, its slot stays reserved
+    cmsis_dap_v2->request_buf = NULL;
+    cmsis_dap_v2->peek_busy = false;
+    cmsis_dap_v2->peek_size = 0;
     trans = &cmsis_dap_v2->transact_out;
     trans->ep = cmsis_dap_v2->ep_out;
     trans->zlp = false;
     trans->notify_eda = false;
-    trans->use_as__vsf_mem_t.buffer = cmsis_dap_v2->request_buff;
-    trans->use_as__vsf_mem_t.size = sizeof(cmsis_dap_v2->request_buff);
     trans->on_finish = on_request_finish;
     trans->param = cmsis_dap_v2;
-    vk_usbd_ep_recv(dev, trans);
+    request_recv(cmsis_dap_v2);
 
-    trans = &cmsis_dap_v2->transact_in;
-    trans->ep = cmsis_dap_v2->ep_in;
-    trans->zlp = false;
+#if SWO_UART && SWO_STREAM
+    vsf_stream_t *swo_rx = (vsf_stream_t *)&cmsis_dap_v2->dap->dap_param.swo_rx;
+
+    // a block pending over a bus reset is lost
+    cmsis_dap_v2->swo_busy = false;
+    dap_swo_stream_done(&cmsis_dap_v2->dap->dap_param);
+
+    trans = &cmsis_dap_v2->transact_swo;
+    trans->ep = cmsis_dap_v2->ep_swo;
+    trans->zlp = true;              // end the host read on a full packet too
     trans->notify_eda = false;
-    trans->use_as__vsf_mem_t.buffer = cmsis_dap_v2->response_buff;
-    trans->use_as__vsf_mem_t.size = sizeof(cmsis_dap_v2->response_buff);
-    trans->on_finish = on_response_finish;
+    trans->on_finish = on_swo_finish;
     trans->param = cmsis_dap_v2;
 
+    swo_rx->rx.param = cmsis_dap_v2;
+    swo_rx->rx.evthandler = on_swo_stream;
+    swo_send(cmsis_dap_v2);
+#endif
+
     return VSF_ERR_NONE;
 }
 
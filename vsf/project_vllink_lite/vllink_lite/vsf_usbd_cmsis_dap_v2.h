@@ -20,6 +20,16 @@ extern "C" {
 #endif
 
 /*============================ MACROS ========================================*/
+
+#ifndef CMSIS_DAP_V2_PACKED
+#   define CMSIS_DAP_V2_PACKED              0
+#endif
+#ifdef APP_CFG_USBD_HS_SUPPORT
+#   define CMSIS_DAP_V2_PEEK_SIZE           512
+#else
+#   define CMSIS_DAP_V2_PEEK_SIZE           CMSIS_DAP_V2_FS_EP_SIZE
+#endif
+
 /*============================ MACROFIED FUNCTIONS ===========================*/
 /*============================ TYPES =========================================*/
 
@@ -30,18 +40,33 @@ def_simple_class(vk_usbd_cmsis_dap_v2_t) {
     public_member(
         uint8_t ep_out;
         uint8_t ep_in;
+        uint8_t ep_swo;             // SWO trace, used with SWO_STREAM
 
         dap_t *dap;
     )
 
     private_member(
-        vsf_sem_t response_sem;
+        dap_client_t client;
+        bool peek_busy;             // OUT endpoint receiving into peek_buf
+        uint16_t peek_size;         // part of a request waiting for a free slot
+        uint8_t *request_buf;       // dap slot the OUT endpoint receives into
+        bool response_busy;         // IN endpoint sending out of a dap slot
+        bool swo_busy;
+        uint16_t pkt_size;          // CMSIS-DAP packet at the enumerated speed
+        uint16_t ep_size;
+#if CMSIS_DAP_V2_PACKED
+        uint8_t packed_fill;        // buffer being filled, the other one may be in flight
+        uint16_t packed_len;
+        uint16_t held_size;
+        uint8_t *held;              // response not fitting in, kept in its dap slot
+        uint8_t packed_buf[2][CMSIS_DAP_V2_PACKET_SIZE + 2];
+#endif
 
-        uint8_t request_buff[CMSIS_DAP_V2_PACKET_SIZE];
-        uint8_t response_buff[CMSIS_DAP_V2_PACKET_SIZE];
+        uint8_t peek_buf[CMSIS_DAP_V2_PEEK_SIZE];
 
         vk_usbd_trans_t transact_in;
         vk_usbd_trans_t transact_out;
+        vk_usbd_trans_t transact_swo;
         vk_usbd_dev_t *dev;
         vk_usbd_ifs_t *ifs;
     )
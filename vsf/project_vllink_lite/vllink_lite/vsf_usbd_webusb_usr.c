@@ -12,6 +12,16 @@
 #include "vsf_usbd_webusb_usr.h"
 
 /*============================ MACROS ========================================*/
+
+// class requests of the interface, as used by the WebUSB transport of DAPjs
+#define WEBUSB_DAP_GET_REPORT           0x01
+#define WEBUSB_DAP_SET_REPORT           0x09
+
+// packets are received into and sent out of the dap slots
+#if WEBUSB_DAP_PACKET_SIZE > DAP_PACKET_SIZE
+#   error "WEBUSB_DAP_PACKET_SIZE does not fit into a dap slot"
+#endif
+
 /*============================ MACROFIED FUNCTIONS ===========================*/
 /*============================ TYPES =========================================*/
 /*============================ PROTOTYPES ====================================*/
@@ -31,13 +41,87 @@ const vk_usbd_class_op_t vk_usbd_webusb_class = {
 /*============================ LOCAL VARIABLES ===============================*/
 /*============================ IMPLEMENTATION ================================*/
 
+// the response is held until GET_REPORT has sent it
+static void __vk_usbd_webusb_response_release(vk_usbd_webusb_t *webusb)
+{
+    uint8_t *buf = webusb->response_buf;
+
+    if (buf) {
+        webusb->response_buf = NULL;
+        dap_response_done(webusb->dap, buf);
+    }
+}
+
+static void __vk_usbd_webusb_on_response(void *p, uint8_t *buf, uint16_t size)
+{
+    vk_usbd_webusb_t *webusb = p;
+    bool reply, request;
+
+    vsf_protect_t orig = vsf_protect_int();
+    webusb->response_buf = buf;
+    webusb->response_size = size;
+    reply = webusb->reply_pending;
+    webusb->reply_pending = false;
+    request = webusb->request_pending;
+    vsf_unprotect_int(orig);
+
+    // a failed reply leaves the response to the next GET_REPORT
+    if (reply)
+        vk_usbd_ctrl_reply(webusb->dev, buf, size);
+
+    // a SET_REPORT came before this response, which is dropped, so the slot
+    // of the client is free for its data
+    if (request) {
+        __vk_usbd_webusb_response_release(webusb);
+        buf = dap_request_buf(webusb->dap, &webusb->client);
+        if (buf) {
+            webusb->request_pending = false;
+            webusb->request_buf = buf;
+            vk_usbd_ctrl_reply(webusb->dev, buf, WEBUSB_DAP_PACKET_SIZE);
+        }
+    }
+}
+
 static vsf_err_t __vk_usbd_webusb_request_prepare(vk_usbd_dev_t *dev, vk_usbd_ifs_t *ifs)
 {
     vk_usbd_webusb_t *webusb = ifs->class_param;
     vk_usbd_ctrl_handler_t *ctrl_handler = &dev->ctrl_handler;
     struct usb_ctrlrequest_t *request = &ctrl_handler->request;
-
-    // TODO
+    uint8_t *buffer = NULL;
+    uint_fast32_t size = 0;
+
+    switch (request->bRequest) {
+    case WEBUSB_DAP_SET_REPORT:
+        // a response the host did not read is dropped
+        webusb->reply_pending = false;
+        webusb->request_pending = false;
+        __vk_usbd_webusb_response_release(webusb);
+
+        buffer = dap_request_buf(webusb->dap, &webusb->client);
+        if (!buffer) {
+            // received by __vk_usbd_webusb_on_response, the request of the
+            // client still in execution holds the slot
+            webusb->request_pending = true;
+            return VSF_ERR_NOT_READY;
+        }
+        webusb->request_buf = buffer;
+        size = WEBUSB_DAP_PACKET_SIZE;
+        break;
+    case WEBUSB_DAP_GET_REPORT:
+        webusb->request_pending = false;
+        if (!webusb->response_buf) {
+            // sent by __vk_usbd_webusb_on_response
+            webusb->reply_pending = true;
+            return VSF_ERR_NOT_READY;
+        }
+        buffer = webusb->response_buf;
+        size = webusb->response_size;
+        break;
+    default:
+        return VSF_ERR_FAIL;
+    }
+    ctrl_handler->trans.buffer = buffer;
+    ctrl_handler->trans.size = size;
     return VSF_ERR_NONE;
 }
 
@@ -47,7 +131,14 @@ static vsf_err_t __vk_usbd_webusb_request_process(vk_usbd_dev_t *dev, vk_usbd_if
     vk_usbd_ctrl_handler_t *ctrl_handler = &dev->ctrl_handler;
     struct usb_ctrlrequest_t *request = &ctrl_handler->request;
 
-    // TODO
+    switch (request->bRequest) {
+    case WEBUSB_DAP_SET_REPORT:
+        dap_requset(webusb->dap, &webusb->client, webusb->request_buf, WEBUSB_DAP_PACKET_SIZE);
+        break;
+    case WEBUSB_DAP_GET_REPORT:
+        __vk_usbd_webusb_response_release(webusb);
+        break;
+    }
     return VSF_ERR_NONE;
 }
 
@@ -55,7 +146,13 @@ static vsf_err_t __vk_usbd_webusb_class_init(vk_usbd_dev_t *dev, vk_usbd_ifs_t *
 {
     vk_usbd_webusb_t *webusb = ifs->class_param;
 
-    vsf_sem_init(&webusb->response_sem, 1);
+    webusb->dev = dev;
+    dap_client_init(webusb->dap, &webusb->client, __vk_usbd_webusb_on_response, webusb);
+
+    // a response pending over a bus reset is lost, its slot is released
+    webusb->reply_pending = false;
+    webusb->request_pending = false;
+    __vk_usbd_webusb_response_release(webusb);
     return VSF_ERR_NONE;
 }
 
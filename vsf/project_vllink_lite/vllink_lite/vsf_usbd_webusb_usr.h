@@ -32,10 +32,12 @@ def_simple_class(vk_usbd_webusb_t) {
     )
 
     private_member(
-        vsf_sem_t response_sem;
-
-        uint8_t request_buff[WEBUSB_DAP_PACKET_SIZE];
-        uint8_t response_buff[WEBUSB_DAP_PACKET_SIZE];
+        dap_client_t client;
+        uint8_t *request_buf;       // SET_REPORT received into this dap slot
+        uint8_t *response_buf;      // response for GET_REPORT, a dap slot
+        uint16_t response_size;
+        bool reply_pending;         // GET_REPORT came before the response
+        bool request_pending;       // SET_REPORT data waits for a dap slot
 
         vk_usbd_dev_t *dev;
     )
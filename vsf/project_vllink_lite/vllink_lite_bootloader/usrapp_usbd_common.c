@@ -1,10 +1,10 @@
 #if VSF_USE_USB_DEVICE == ENABLED &&                    \
         (VSF_USE_USB_DEVICE_DCD_MUSB_FDRC == ENABLED || \
             VSF_USBD_USE_DCD_DWCOTG == ENABLED || \
-            VSF_USE_USB_DEVICE_DCD_USBIP == ENABLED)
+            VSF_USBD_USE_DCD_USBIP == ENABLED)
 
 struct usrapp_usbd_common_const_t {
-#if VSF_USE_USB_DEVICE_DCD_USBIP == ENABLED
+#if VSF_USBD_USE_DCD_USBIP == ENABLED
     vk_usbip_dcd_param_t usbip_dcd_param;
 #endif
 #if VSF_USE_USB_DEVICE_DCD_MUSB_FDRC == ENABLED
@@ -17,7 +17,7 @@ struct usrapp_usbd_common_const_t {
 typedef struct usrapp_usbd_common_const_t usrapp_usbd_common_const_t;
 
 struct usrapp_usbd_common_t {
-#if VSF_USE_USB_DEVICE_DCD_USBIP == ENABLED
+#if VSF_USBD_USE_DCD_USBIP == ENABLED
     vk_usbip_dcd_t usbip_dcd;
 #endif
 #if VSF_USE_USB_DEVICE_DCD_MUSB_FDRC == ENABLED
@@ -44,7 +44,7 @@ const usrapp_usbd_common_const_t usrapp_usbd_common_const = {
 };
 
 usrapp_usbd_common_t usrapp_usbd_common = {
-#if VSF_USE_USB_DEVICE_DCD_USBIP == ENABLED
+#if VSF_USBD_USE_DCD_USBIP == ENABLED
     .usbip_dcd.param        = &usrapp_usbd_common_const.usbip_dcd_param,
 #endif
 #if VSF_USE_USB_DEVICE_DCD_MUSB_FDRC == ENABLED
@@ -55,7 +55,7 @@ usrapp_usbd_common_t usrapp_usbd_common = {
 #endif
 };
 
-#if VSF_USE_USB_DEVICE_DCD_USBIP == ENABLED
+#if VSF_USBD_USE_DCD_USBIP == ENABLED
 vsf_usb_dc_from_usbip_ip(0, usrapp_usbd_common.usbip_dcd, VSF_USB_DC0)
 #elif VSF_USE_USB_DEVICE_DCD_MUSB_FDRC == ENABLED
 vsf_usb_dc_from_musbfdrc_ip(0, usrapp_usbd_common.musb_fdrc_dcd, VSF_USB_DC0)
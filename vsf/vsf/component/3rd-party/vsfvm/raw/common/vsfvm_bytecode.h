@@ -47,7 +47,7 @@
 #define VSFVM_EOF()                         VSFVM_CODE(VSFVM_CODE_TYPE_EOF, 0)
 
 #define VSFVM_CODE_TYPE(code)               ((uint32_t)(code) >> VSFVM_CODE_LENGTH)
-#define VSFVM_CODE_VALUE(code)              (((int32_t)(code) << (32 - VSFVM_CODE_LENGTH)) >> (32 - VSFVM_CODE_LENGTH))
+#define VSFVM_CODE_VALUE(code)              ((int32_t)((uint32_t)(code) << (32 - VSFVM_CODE_LENGTH)) >> (32 - VSFVM_CODE_LENGTH))
 #define VSFVM_CODE_ID(code)                 (((uint32_t)(code) >> 24) & ((1UL << (VSFVM_CODE_LENGTH - 24)) - 1))
 #define VSFVM_CODE_ARG8(code)               (((uint32_t)(code) >> 16) & 0xFF)
 #define VSFVM_CODE_ARG16(code)              (((uint32_t)(code) >> 0) & 0xFFFF)
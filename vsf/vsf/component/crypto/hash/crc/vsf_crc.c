@@ -21,6 +21,8 @@
 
 #if VSF_HASH_USE_CRC == ENABLED
 
+#include "hal/vsf_hal.h"
+
 /*============================ MACROS ========================================*/
 /*============================ MACROFIED FUNCTIONS ===========================*/
 /*============================ TYPES =========================================*/
@@ -31,26 +33,174 @@ const vsf_crc_t vsf_crc8_ccitt = {
     .poly   = 0x07,
 };
 
+const vsf_crc_t vsf_crc16_ccitt = {
+    .bitlen = 16,
+    .poly   = 0x1021,
+};
+
+const vsf_crc_t vsf_crc16_ibm = {
+    .bitlen = 16,
+    .poly   = 0x8005,
+    .reflect= true,
+};
+
+const vsf_crc_t vsf_crc32 = {
+    .bitlen = 32,
+    .poly   = 0x04C11DB7,
+    .reflect= true,
+};
+
+const vsf_crc_t vsf_crc32_mpeg2 = {
+    .bitlen = 32,
+    .poly   = 0x04C11DB7,
+};
+
 /*============================ LOCAL VARIABLES ===============================*/
 /*============================ PROTOTYPES ====================================*/
 /*============================ IMPLEMENTATION ================================*/
 
+/*
+    All methods run on a 32-bit register, so one table type serves every
+    bitlen: MSB first crcs are kept in the upper bits, LSB first ones in the
+    lower bits with the poly reflected.
+*/
+
+static uint_fast32_t __vsf_crc_reflect(uint_fast32_t value, uint_fast8_t bitlen)
+{
+    uint_fast32_t result = 0;
+
+    for (uint_fast8_t i = 0; i < bitlen; i++) {
+        result = (result << 1) | (value & 1);
+        value >>= 1;
+    }
+    return result;
+}
+
+static uint_fast32_t __vsf_crc_poly(const vsf_crc_t *crc)
+{
+    return crc->reflect ? __vsf_crc_reflect(crc->poly, crc->bitlen)
+                        : (uint_fast32_t)crc->poly << (32 - crc->bitlen);
+}
+
+static uint32_t __vsf_crc_shift(const vsf_crc_t *crc, uint_fast32_t poly, uint32_t reg, uint_fast8_t bits)
+{
+    if (crc->reflect) {
+        while (bits--) {
+            reg = (reg & 1) ? ((reg >> 1) ^ poly) : (reg >> 1);
+        }
+    } else {
+        while (bits--) {
+            reg = (reg & 0x80000000UL) ? ((reg << 1) ^ poly) : (reg << 1);
+        }
+    }
+    return reg;
+}
+
+void vsf_crc_table_init(const vsf_crc_t *crc, uint32_t *table)
+{
+    uint_fast32_t poly = __vsf_crc_poly(crc);
+    uint_fast16_t num = (crc->method == VSF_CRC_NIBBLE) ? 16 : 256;
+    uint_fast8_t bits = (crc->method == VSF_CRC_NIBBLE) ? 4 : 8;
+    uint_fast8_t slices = (crc->method == VSF_CRC_SLICE8) ? 8 :
+                          (crc->method == VSF_CRC_SLICE4) ? 4 : 1;
+
+    VSF_CRYPTO_ASSERT(crc->method != VSF_CRC_BITWISE);
+    for (uint_fast16_t i = 0; i < num; i++) {
+        table[i] = __vsf_crc_shift(crc, poly,
+                        crc->reflect ? i : (uint32_t)i << (32 - bits), bits);
+    }
+    // table k is table 0 followed by k zero bytes
+    for (uint_fast16_t i = 256; i < slices * 256; i++) {
+        uint32_t prev = table[i - 256];
+        table[i] = crc->reflect ? ((prev >> 8) ^ table[prev & 0xFF])
+                                : ((prev << 8) ^ table[prev >> 24]);
+    }
+}
+
+static uint32_t __vsf_crc_slice(const vsf_crc_t *crc, uint32_t reg, uint8_t *buff, uint_fast8_t slices)
+{
+    const uint32_t *t = crc->table;
+    uint32_t next;
+
+    if (crc->reflect) {
+        reg ^= get_unaligned_le32(buff);
+        next = (slices == 8) ? get_unaligned_le32(buff + 4) : 0;
+        reg =   t[(slices - 1) * 256 + (reg & 0xFF)]
+            ^   t[(slices - 2) * 256 + ((reg >> 8) & 0xFF)]
+            ^   t[(slices - 3) * 256 + ((reg >> 16) & 0xFF)]
+            ^   t[(slices - 4) * 256 + (reg >> 24)];
+    } else {
+        reg ^= get_unaligned_be32(buff);
+        next = (slices == 8) ? get_unaligned_be32(buff + 4) : 0;
+        reg =   t[(slices - 1) * 256 + (reg >> 24)]
+            ^   t[(slices - 2) * 256 + ((reg >> 16) & 0xFF)]
+            ^   t[(slices - 3) * 256 + ((reg >> 8) & 0xFF)]
+            ^   t[(slices - 4) * 256 + (reg & 0xFF)];
+    }
+    if (slices == 8) {
+        if (crc->reflect) {
+            reg ^=  t[3 * 256 + (next & 0xFF)]
+                ^   t[2 * 256 + ((next >> 8) & 0xFF)]
+                ^   t[1 * 256 + ((next >> 16) & 0xFF)]
+                ^   t[next >> 24];
+        } else {
+            reg ^=  t[3 * 256 + (next >> 24)]
+                ^   t[2 * 256 + ((next >> 16) & 0xFF)]
+                ^   t[1 * 256 + ((next >> 8) & 0xFF)]
+                ^   t[next & 0xFF];
+        }
+    }
+    return reg;
+}
+
 uint_fast32_t vsf_crc(const vsf_crc_t *crc, uint_fast32_t initial, uint8_t *buff, uint_fast32_t bytesize)
 {
-    uint_fast8_t shift = crc->bitlen - 8;
-    uint_fast32_t msb = 1UL << (crc->bitlen - 1);
-
-	while (bytesize--) {
-        initial ^= *buff++ << shift;
-		for (uint_fast8_t i = 0; i < 8; i++) {
-            if (initial & msb) {
-                initial = (initial << 1) ^ crc->poly;
+    uint_fast8_t shift = 32 - crc->bitlen;
+    uint_fast32_t mask = 0xFFFFFFFFUL >> shift;
+    uint_fast32_t poly;
+    const uint32_t *t = crc->table;
+    uint32_t reg = crc->reflect ? (initial & mask) : ((initial & mask) << shift);
+    uint_fast8_t slices;
+
+    switch (crc->method) {
+    case VSF_CRC_BITWISE:
+        poly = __vsf_crc_poly(crc);
+        while (bytesize--) {
+            reg ^= crc->reflect ? *buff++ : ((uint32_t)*buff++ << 24);
+            reg = __vsf_crc_shift(crc, poly, reg, 8);
+        }
+        break;
+    case VSF_CRC_NIBBLE:
+        while (bytesize--) {
+            if (crc->reflect) {
+                reg ^= *buff++;
+                reg = (reg >> 4) ^ t[reg & 0x0F];
+                reg = (reg >> 4) ^ t[reg & 0x0F];
+            } else {
+                reg ^= (uint32_t)*buff++ << 24;
+                reg = (reg << 4) ^ t[reg >> 28];
+                reg = (reg << 4) ^ t[reg >> 28];
+            }
+        }
+        break;
+    case VSF_CRC_SLICE4:
+    case VSF_CRC_SLICE8:
+        slices = (crc->method == VSF_CRC_SLICE8) ? 8 : 4;
+        for (; bytesize >= slices; bytesize -= slices, buff += slices) {
+            reg = __vsf_crc_slice(crc, reg, buff, slices);
+        }
+        // fall through, table 0 is the byte table for the rest
+    case VSF_CRC_BYTE:
+        while (bytesize--) {
+            if (crc->reflect) {
+                reg = (reg >> 8) ^ t[(reg ^ *buff++) & 0xFF];
             } else {
-                initial <<= 1;
+                reg = (reg << 8) ^ t[(reg >> 24) ^ *buff++];
             }
-		}
-	}
-    return initial & ((1UL << crc->bitlen) - 1);
+        }
+        break;
+    }
+    return crc->reflect ? reg : (reg >> shift);
 }
 
 #endif
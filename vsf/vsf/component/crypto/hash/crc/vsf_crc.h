@@ -30,8 +30,25 @@ extern "C" {
 
 /*============================ MACROS ========================================*/
 /*============================ MACROFIED FUNCTIONS ===========================*/
+
+//! number of uint32_t entries of the table used by __method
+#define VSF_CRC_TABLE_SIZE(__method)                                            \
+            (   ((__method) == VSF_CRC_NIBBLE) ? 16 :                           \
+                ((__method) == VSF_CRC_BYTE) ? 256 :                            \
+                ((__method) == VSF_CRC_SLICE4) ? 4 * 256 :                      \
+                ((__method) == VSF_CRC_SLICE8) ? 8 * 256 : 0)
+
 /*============================ TYPES =========================================*/
 
+/*! \brief crc descriptor
+ *! poly is always in normal (MSB first) form, reflect selects the LSB first
+ *! variants (input and output reflected), eg. CRC-16/MODBUS and CRC-32.
+ *! initial value and final xor are left to the caller, so a crc can be
+ *! computed piece by piece, passing the last result as initial value.
+ *!
+ *! The table methods need a table filled by vsf_crc_table_init(), faster for
+ *! more memory: nibble 64 bytes, byte 1K, slice4 4K, slice8 8K.
+ */
 typedef struct vsf_crc_t {
     enum {
         VSF_CRC_BITLEN8 = 8,
@@ -39,14 +56,29 @@ typedef struct vsf_crc_t {
         VSF_CRC_BITLEN32 = 32,
     } bitlen;
     uint32_t poly;
+    bool reflect;
+    enum {
+        VSF_CRC_BITWISE = 0,
+        VSF_CRC_NIBBLE,
+        VSF_CRC_BYTE,
+        VSF_CRC_SLICE4,
+        VSF_CRC_SLICE8,
+    } method;
+    const uint32_t *table;
 } vsf_crc_t;
 
 /*============================ GLOBAL VARIABLES ==============================*/
 
-extern const vsf_crc_t vsf_crc8_ccitt;
+// bitwise, copy one with a table for the faster methods
+extern const vsf_crc_t vsf_crc8_ccitt;      // CRC-8: initial 0x00
+extern const vsf_crc_t vsf_crc16_ccitt;     // CRC-16/CCITT-FALSE: initial 0xFFFF, XMODEM: initial 0
+extern const vsf_crc_t vsf_crc16_ibm;       // CRC-16/MODBUS: initial 0xFFFF, ARC: initial 0
+extern const vsf_crc_t vsf_crc32;           // CRC-32 of zlib: initial and final xor 0xFFFFFFFF
+extern const vsf_crc_t vsf_crc32_mpeg2;     // CRC-32/MPEG-2: initial 0xFFFFFFFF
 
 /*============================ PROTOTYPES ====================================*/
 
+extern void vsf_crc_table_init(const vsf_crc_t *crc, uint32_t *table);
 extern uint_fast32_t vsf_crc(const vsf_crc_t *crc, uint_fast32_t initial, uint8_t *buff, uint_fast32_t bytesize);
 
 #ifdef __cplusplus
@@ -639,6 +639,46 @@ static void __vk_usbd_setup_status_callback(void *param)
     vk_usbd_drv_status_stage(out);
 }
 
+static void __vk_usbd_ctrl_send(vk_usbd_dev_t *dev)
+{
+    vk_usbd_ctrl_handler_t *ctrl_handler = &dev->ctrl_handler;
+    vk_usbd_trans_t *trans = &ctrl_handler->trans;
+
+    trans->on_finish = __vk_usbd_setup_status_callback;
+    trans->zlp = trans->use_as__vsf_mem_t.size < ctrl_handler->request.wLength;
+    vk_usbd_ep_send(dev, trans);
+}
+
+#if VSF_USBD_CFG_RAW_MODE != ENABLED
+// data stage of a request whose request_prepare returned VSF_ERR_NOT_READY,
+//  IN data is sent from buffer, OUT data received into it, fails if the host
+//  has moved on to another request in the meantime
+vsf_err_t vk_usbd_ctrl_reply(vk_usbd_dev_t *dev, uint8_t *buffer, uint_fast32_t size)
+{
+    vk_usbd_ctrl_handler_t *ctrl_handler = &dev->ctrl_handler;
+    vsf_err_t err = VSF_ERR_FAIL;
+
+    vsf_protect_t orig = vsf_protect_int();
+    if (ctrl_handler->reply_pending) {
+        ctrl_handler->reply_pending = false;
+        err = VSF_ERR_NONE;
+    }
+    vsf_unprotect_int(orig);
+
+    if (VSF_ERR_NONE == err) {
+        ctrl_handler->trans.use_as__vsf_mem_t.buffer = buffer;
+        ctrl_handler->trans.use_as__vsf_mem_t.size = min(size, ctrl_handler->request.wLength);
+        if ((ctrl_handler->request.bRequestType & USB_DIR_MASK) == USB_DIR_OUT) {
+            ctrl_handler->trans.on_finish = __vk_usbd_setup_status_callback;
+            vk_usbd_ep_recv(dev, &ctrl_handler->trans);
+        } else {
+            __vk_usbd_ctrl_send(dev);
+        }
+    }
+    return err;
+}
+#endif
+
 #ifndef WEAK_VSF_USBD_NOTIFY_USER
 WEAK(vsf_usbd_notify_user)
 vsf_err_t vsf_usbd_notify_user(vk_usbd_dev_t *dev, usb_evt_t evt, void *param)
@@ -719,6 +759,9 @@ static void __vk_usbd_evthandler(vsf_eda_t *eda, vsf_evt_t evt_eda)
             dev->feature = 0;
 #endif
 
+            // drivers which do not know the enumerated speed report 0
+            dev->cur_speed = value ? (usb_dc_speed_t)value : dev->speed;
+
             // reset usb hw
             __vk_usbd_hw_init_reset(dev, true);
 
@@ -751,12 +794,26 @@ static void __vk_usbd_evthandler(vsf_eda_t *eda, vsf_evt_t evt_eda)
             struct usb_ctrlrequest_t *request = &ctrl_handler->request;
             vk_usbd_trans_t *trans = &ctrl_handler->trans;
 
+            vsf_err_t err;
+
             vk_usbd_drv_get_setup(request);
-            if (    VSF_ERR_NONE != vsf_usbd_notify_user(dev, evt, request)
+            err = vsf_usbd_notify_user(dev, evt, request);
 #if VSF_USBD_CFG_RAW_MODE != ENABLED
-                ||  (VSF_ERR_NONE != __vk_usbd_ctrl_prepare(dev))
+            ctrl_handler->reply_pending = false;
+            if (VSF_ERR_NONE == err) {
+                err = __vk_usbd_ctrl_prepare(dev);
+            }
+            // IN data not available yet, or no buffer for OUT data yet, the
+            //  class goes on with vk_usbd_ctrl_reply and the data stage is
+            //  NAKed till then
+            if (    (VSF_ERR_NOT_READY == err)
+                &&  (   ((request->bRequestType & USB_DIR_MASK) == USB_DIR_IN)
+                    ||  (request->wLength != 0))) {
+                ctrl_handler->reply_pending = true;
+                break;
+            }
 #endif
-                ) {
+            if (VSF_ERR_NONE != err) {
                 vk_usbd_drv_ep_set_stall(0 | USB_DIR_OUT);
                 vk_usbd_drv_ep_set_stall(0 | USB_DIR_IN);
                 break;
@@ -774,9 +831,7 @@ static void __vk_usbd_evthandler(vsf_eda_t *eda, vsf_evt_t evt_eda)
                     vk_usbd_ep_recv(dev, trans);
                 }
             } else {
-                trans->on_finish = __vk_usbd_setup_status_callback;
-                trans->zlp = ctrl_handler->trans.use_as__vsf_mem_t.size < request->wLength;
-                vk_usbd_ep_send(dev, trans);
+                __vk_usbd_ctrl_send(dev);
             }
             break;
         }
@@ -859,6 +914,12 @@ void vk_usbd_wakeup(vk_usbd_dev_t *dev)
     vk_usbd_drv_wakeup();
 }
 
+// speed the device is running at, valid after bus reset
+usb_dc_speed_t vk_usbd_get_speed(vk_usbd_dev_t *dev)
+{
+    return dev->cur_speed;
+}
+
 #if VSF_USBD_CFG_RAW_MODE != ENABLED
 vk_usbd_cfg_t * vk_usbd_get_cur_cfg(vk_usbd_dev_t *dev)
 {
@@ -889,6 +950,7 @@ void vk_usbd_init(vk_usbd_dev_t *dev)
 
     dev->ctrl_handler.trans.ep = 0;
     dev->ctrl_handler.trans.param = dev;
+    dev->cur_speed = dev->speed;
 
 #if VSF_USBD_CFG_RAW_MODE != ENABLED
     vk_usbd_desc_t *desc;
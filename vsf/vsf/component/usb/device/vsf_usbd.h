@@ -407,6 +407,9 @@ typedef struct vk_usbd_ctrl_handler_t {
     struct usb_ctrlrequest_t request;
     vk_usbd_trans_t trans;
     uint8_t reply_buffer[4];
+#if VSF_USBD_CFG_RAW_MODE != ENABLED
+    bool reply_pending;         // data stage left to vk_usbd_ctrl_reply
+#endif
 } vk_usbd_ctrl_handler_t;
 
 #if VSF_USBD_CFG_RAW_MODE != ENABLED
@@ -474,6 +477,7 @@ def_simple_class(vk_usbd_dev_t) {
         uint8_t feature;
         bool configured;
 #endif
+        usb_dc_speed_t cur_speed;
         vsf_slist_t trans_list;
 #if VSF_USBD_CFG_USE_EDA == ENABLED
         vsf_eda_t eda;
@@ -541,6 +545,7 @@ extern void vk_usbd_fini(vk_usbd_dev_t *dev);
 extern void vk_usbd_connect(vk_usbd_dev_t *dev);
 extern void vk_usbd_disconnect(vk_usbd_dev_t *dev);
 extern void vk_usbd_wakeup(vk_usbd_dev_t *dev);
+extern usb_dc_speed_t vk_usbd_get_speed(vk_usbd_dev_t *dev);
 
 #if defined(__VSF_USBD_CLASS_IMPLEMENT) || defined(__VSF_USBD_CLASS_INHERIT__)
 
@@ -551,6 +556,7 @@ extern vk_usbd_desc_t * vk_usbd_get_descriptor(vk_usbd_desc_t *desc,
 
 extern vk_usbd_cfg_t * vk_usbd_get_cur_cfg(vk_usbd_dev_t *dev);
 extern vk_usbd_ifs_t * vk_usbd_get_ifs(vk_usbd_dev_t *dev, uint_fast8_t ifs_no);
+extern vsf_err_t vk_usbd_ctrl_reply(vk_usbd_dev_t *dev, uint8_t *buffer, uint_fast32_t size);
 #endif
 
 extern vsf_err_t vk_usbd_ep_stall(vk_usbd_dev_t *dev, uint_fast8_t ep);
@@ -28,12 +28,33 @@
 #include "kernel/vsf_kernel.h"
 #include "./vsf_usbip_dcd.h"
 
-#include <Windows.h>
+#if VSF_USBIP_DCD_CFG_BACKEND == VSF_USBIP_DCD_CFG_BACKEND_WIN
+#   include <Windows.h>
+#elif VSF_USBIP_DCD_CFG_BACKEND == VSF_USBIP_DCD_CFG_BACKEND_LINUX
+#   include <unistd.h>
+#   include <sys/socket.h>
+#   include <netinet/in.h>
+#   include <netinet/tcp.h>
+#endif
 
 /*============================ MACROS ========================================*/
 
 #define VSF_USBIP_VERSION                       0x0111
 
+#if     VSF_USBIP_DCD_CFG_BACKEND == VSF_USBIP_DCD_CFG_BACKEND_WIN
+#   define __VSF_USBIP_SOCKET_BACKEND           ENABLED
+#   define __VSF_USBIP_SEND_FLAGS               0
+#elif   VSF_USBIP_DCD_CFG_BACKEND == VSF_USBIP_DCD_CFG_BACKEND_LINUX
+#   define __VSF_USBIP_SOCKET_BACKEND           ENABLED
+// a host going away must not kill the whole process with SIGPIPE
+#   define __VSF_USBIP_SEND_FLAGS               MSG_NOSIGNAL
+#   define INVALID_SOCKET                       (-1)
+#   define SOCKET_ERROR                         (-1)
+#   define closesocket                          close
+#else
+#   define __VSF_USBIP_SOCKET_BACKEND           DISABLED
+#endif
+
 /*============================ MACROFIED FUNCTIONS ===========================*/
 
 #if VSF_USBIP_SERVER_CFG_DEBUG == ENABLED
@@ -117,7 +138,14 @@ enum {
     VSF_USBIP_USBD_EVT                          = VSF_EVT_USER + 0x10,
 };
 
-#if VSF_USBIP_DCD_CFG_BACKEND == VSF_USBIP_DCD_CFG_BACKEND_WIN
+#if __VSF_USBIP_SOCKET_BACKEND == ENABLED
+
+#if VSF_USBIP_DCD_CFG_BACKEND == VSF_USBIP_DCD_CFG_BACKEND_LINUX
+typedef int SOCKET;
+typedef socklen_t vk_usbip_socklen_t;
+#else
+typedef int vk_usbip_socklen_t;
+#endif
 
 typedef struct vk_usbip_server_backend_irq_thread_t {
     implement(vsf_arch_irq_thread_t);
@@ -146,7 +174,7 @@ static vsf_err_t __vk_usbip_server_done_urb(vk_usbip_server_t *server, vk_usbip_
 
 static vk_usbip_server_t __vk_usbip_server;
 
-#if VSF_USBIP_DCD_CFG_BACKEND == VSF_USBIP_DCD_CFG_BACKEND_WIN
+#if __VSF_USBIP_SOCKET_BACKEND == ENABLED
 static vk_usbip_server_backend_t __vk_usbip_server_backend;
 #endif
 
@@ -154,9 +182,11 @@ static vk_usbip_server_backend_t __vk_usbip_server_backend;
 
 imp_vsf_pool(vk_usbip_urb_poll, vk_usbip_urb_t)
 
-#if VSF_USBIP_DCD_CFG_BACKEND == VSF_USBIP_DCD_CFG_BACKEND_WIN
+#if __VSF_USBIP_SOCKET_BACKEND == ENABLED
 
+#if VSF_USBIP_DCD_CFG_BACKEND == VSF_USBIP_DCD_CFG_BACKEND_WIN
 #pragma comment(lib,"WS2_32.lib")
+#endif
 
 static void __vk_usbip_server_backend_thread_rx(void *arg)
 {
@@ -168,23 +198,34 @@ static void __vk_usbip_server_backend_thread_rx(void *arg)
 
     __vsf_arch_irq_set_background(&irq_thread->use_as__vsf_arch_irq_thread_t);
 
+#if VSF_USBIP_DCD_CFG_BACKEND == VSF_USBIP_DCD_CFG_BACKEND_WIN
     WSADATA wsaData;
     WORD sockVersion = MAKEWORD(2, 2);
     server->err = 0 == WSAStartup(sockVersion, &wsaData) ?
             VSF_ERR_NONE : VSF_ERR_FAIL;
+#else
+    server->err = VSF_ERR_NONE;
+#endif
     if (VSF_ERR_NONE == server->err) {
         backend->listener_socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
         if (INVALID_SOCKET == backend->listener_socket) {
             server->err = VSF_ERR_FAIL;
         }
     }
+#if VSF_USBIP_DCD_CFG_BACKEND == VSF_USBIP_DCD_CFG_BACKEND_LINUX
     if (VSF_ERR_NONE == server->err) {
-        SOCKADDR_IN sin = {
+        // restart on the same port while the last session is in TIME_WAIT
+        int reuse = 1;
+        setsockopt(backend->listener_socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    }
+#endif
+    if (VSF_ERR_NONE == server->err) {
+        struct sockaddr_in sin = {
             .sin_family             = AF_INET,
             .sin_port               = htons(server->port),
-            .sin_addr.S_un.S_addr   = INADDR_ANY,
+            .sin_addr.s_addr        = htonl(INADDR_ANY),
         };
-        if (SOCKET_ERROR == bind(backend->listener_socket, (LPSOCKADDR)&sin, sizeof(sin))) {
+        if (SOCKET_ERROR == bind(backend->listener_socket, (struct sockaddr *)&sin, sizeof(sin))) {
             server->err = VSF_ERR_FAIL;
         }
     }
@@ -199,12 +240,16 @@ static void __vk_usbip_server_backend_thread_rx(void *arg)
     __vsf_arch_irq_end(&irq_thread->use_as__vsf_arch_irq_thread_t, false);
 
     while (VSF_ERR_NONE == server->err) {
-        SOCKADDR_IN remote;
-        int len = sizeof(remote);
-        backend->socket = accept(backend->listener_socket, (SOCKADDR *)&remote, &len);
+        struct sockaddr_in remote;
+        vk_usbip_socklen_t len = sizeof(remote);
+        backend->socket = accept(backend->listener_socket, (struct sockaddr *)&remote, &len);
         if (INVALID_SOCKET == backend->socket) {
             server->err = VSF_ERR_FAIL;
         } else {
+            // urb header and data go in separate sends, do not hold them for the ack
+            int nodelay = 1;
+            setsockopt(backend->socket, IPPROTO_TCP, TCP_NODELAY, (const char *)&nodelay, sizeof(nodelay));
+
             __vsf_arch_irq_start(&irq_thread->use_as__vsf_arch_irq_thread_t);
                 vsf_eda_post_evt(&server->teda.use_as__vsf_eda_t, VSF_USBIP_SERVER_EVT_BACKEND_CONNECTED);
             __vsf_arch_irq_end(&irq_thread->use_as__vsf_arch_irq_thread_t, false);
@@ -244,7 +289,9 @@ static void __vk_usbip_server_backend_thread_rx(void *arg)
         __vsf_arch_irq_end(&irq_thread->use_as__vsf_arch_irq_thread_t, false);
     }
 
+#if VSF_USBIP_DCD_CFG_BACKEND == VSF_USBIP_DCD_CFG_BACKEND_WIN
     WSACleanup();
+#endif
 }
 
 static void __vk_usbip_server_backend_thread_tx(void *arg)
@@ -272,7 +319,7 @@ static void __vk_usbip_server_backend_thread_tx(void *arg)
                     break;
                 }
 
-                send(backend->socket, (char *)&urb->rep, 48, 0);
+                send(backend->socket, (char *)&urb->rep, 48, __VSF_USBIP_SEND_FLAGS);
                 if (urb->is_unlinked) {
                     actual_length = 0;
                 } else if (urb->req.direction) {
@@ -281,7 +328,7 @@ static void __vk_usbip_server_backend_thread_tx(void *arg)
                     actual_length = 0;
                 }
                 if (actual_length > 0) {
-                    send(backend->socket, (char *)urb->dynmem.buffer, actual_length, 0);
+                    send(backend->socket, (char *)urb->dynmem.buffer, actual_length, __VSF_USBIP_SEND_FLAGS);
                 }
 
                 __vsf_arch_irq_start(&irq_thread->use_as__vsf_arch_irq_thread_t);
@@ -296,7 +343,7 @@ static void __vk_usbip_server_backend_thread_tx(void *arg)
 
             irq_thread->mem.size = 0;
         } else {
-            if (irq_thread->mem.size != send(backend->socket, (char *)irq_thread->mem.buffer, irq_thread->mem.size, 0)) {
+            if (irq_thread->mem.size != send(backend->socket, (char *)irq_thread->mem.buffer, irq_thread->mem.size, __VSF_USBIP_SEND_FLAGS)) {
                 server->err = VSF_ERR_FAIL;
             }
         }
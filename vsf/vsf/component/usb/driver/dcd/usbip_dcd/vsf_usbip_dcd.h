@@ -43,9 +43,14 @@ extern "C" {
 #define VSF_USBIP_DCD_CFG_BACKEND_WIN   1
 #define VSF_USBIP_DCD_CFG_BACKEND_VSF   2
 #define VSF_USBIP_DCD_CFG_BACKEND_LIB   3
+#define VSF_USBIP_DCD_CFG_BACKEND_LINUX 4
 
 #ifndef VSF_USBIP_DCD_CFG_BACKEND
-#   define VSF_USBIP_DCD_CFG_BACKEND    VSF_USBIP_DCD_CFG_BACKEND_WIN
+#   if defined(__LINUX__)
+#       define VSF_USBIP_DCD_CFG_BACKEND    VSF_USBIP_DCD_CFG_BACKEND_LINUX
+#   else
+#       define VSF_USBIP_DCD_CFG_BACKEND    VSF_USBIP_DCD_CFG_BACKEND_WIN
+#   endif
 #endif
 
 #ifndef VSF_USBIP_DCD_CFG_PATH
@@ -612,7 +612,10 @@ void vk_dwcotg_dcd_irq(vk_dwcotg_dcd_t *dwcotg_dcd)
         global_regs->gintsts = USB_OTG_GINTSTS_MMIS;
     }
     if (intsts & USB_OTG_GINTSTS_USBRST) {
-        __vk_dwcotg_dcd_notify(dwcotg_dcd, USB_ON_RESET, 0);
+        // a high speed capable core reports reset after the speed is enumerated
+        if (dwcotg_dcd->param->speed != USB_DC_SPEED_HIGH) {
+            __vk_dwcotg_dcd_notify(dwcotg_dcd, USB_ON_RESET, 0);
+        }
         global_regs->gintsts = USB_OTG_GINTSTS_USBRST;
     }
     if (intsts & USB_OTG_GINTSTS_ENUMDNE) {
@@ -621,6 +624,10 @@ void vk_dwcotg_dcd_irq(vk_dwcotg_dcd_t *dwcotg_dcd)
         global_regs->gusbcfg |= ((0/* USB_SPEED_HIGH*/ == speed) ? 0x09U : 0x05U) << 10;
         dev_global_regs->dctl |= USB_OTG_DCTL_CGINAK;
         global_regs->gintsts = USB_OTG_GINTSTS_ENUMDNE;
+        if (dwcotg_dcd->param->speed == USB_DC_SPEED_HIGH) {
+            __vk_dwcotg_dcd_notify(dwcotg_dcd, USB_ON_RESET,
+                    (0 == speed) ? USB_DC_SPEED_HIGH : USB_DC_SPEED_FULL);
+        }
     }
     if (intsts & USB_OTG_GINTSTS_USBSUSP) {
         __vk_dwcotg_dcd_notify(dwcotg_dcd, USB_ON_SUSPEND, 0);
@@ -36,8 +36,10 @@
 #   define VSF_ARCH_CFG_THREAD_NUM          32
 #endif
 
+// every pooled thread holds its start request, plus the wakeup request and
+// the ones of the irq threads (systimer, drivers)
 #ifndef VSF_ARCH_CFG_IRQ_REQUEST_NUM
-#   define VSF_ARCH_CFG_IRQ_REQUEST_NUM     32
+#   define VSF_ARCH_CFG_IRQ_REQUEST_NUM     (VSF_ARCH_CFG_THREAD_NUM + 32)
 #endif
 
 #ifndef VSF_ARCH_CFG_TRACE_FUNC
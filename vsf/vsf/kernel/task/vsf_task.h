@@ -187,7 +187,7 @@ extern "C" {
             vsf_eda_cfg_t CONNECT3(__,__LINE__,cfg) = {                        \
                 .fn.evthandler = (vsf_task_entry_t)vsf_task_func(__name),       \
                 .priority = (__pri),                                            \
-                .target = NULL,                                                 \
+                .target = 0,                                                    \
             };                                                                  \
             prepare_vsf_task(__name, &((__task)->param));                       \
             vsf_task_start( &((__task)->use_as__vsf_task_t),                    \
@@ -215,7 +215,7 @@ extern "C" {
             vsf_eda_cfg_t CONNECT3(__,__LINE__,cfg) = {                        \
                 .fn.evthandler = (vsf_task_entry_t)vsf_task_func(__name),       \
                 .priority = (__pri),                                            \
-                .target = NULL,                                                 \
+                .target = 0,                                                    \
                 __VA_ARGS__                                                     \
             };                                                                  \
             prepare_vsf_task(__name, &((__task)->param));                       \
@@ -0,0 +1,61 @@
+/*============================ INCLUDES ======================================*/
+#include "crc.h"
+
+/*============================ MACROS ========================================*/
+
+#define CRC32_POLY                  0x04C11DB7UL
+#define CRC32_POLY_REFLECTED        0xEDB88320UL
+
+/*============================ MACROFIED FUNCTIONS ===========================*/
+/*============================ TYPES =========================================*/
+/*============================ GLOBAL VARIABLES ==============================*/
+/*============================ LOCAL VARIABLES ===============================*/
+/*============================ PROTOTYPES ====================================*/
+/*============================ IMPLEMENTATION ================================*/
+
+#if CRC_COUNT > 0
+
+static uint32_t crc32_byte(uint32_t crc, uint8_t data)
+{
+    crc ^= data;
+    for (uint_fast8_t i = 0; i < 8; i++)
+        crc = (crc & 1) ? ((crc >> 1) ^ CRC32_POLY_REFLECTED) : (crc >> 1);
+    return crc;
+}
+
+// the word that takes the unit from its reset value 0xFFFFFFFF to reg
+static uint32_t crc32_seed(uint32_t reg)
+{
+    for (uint_fast8_t i = 0; i < 32; i++)
+        reg = (reg & 1) ? (((reg ^ CRC32_POLY) >> 1) | 0x80000000UL) : (reg >> 1);
+    return ~reg;
+}
+
+/*
+    The unit shifts MSB first, reversing the bits of every word written and
+    of the result gives the LSB first CRC-32. It has no initial value
+    register, a crc going on is loaded by writing the word that leads there.
+    Bytes before and after the aligned words by software.
+*/
+uint32_t vsfhal_crc32(uint32_t crc, uint8_t *buff, uint32_t size)
+{
+    crc = ~crc;
+    for (; size && ((uint32_t)buff & 0x3); size--)
+        crc = crc32_byte(crc, *buff++);
+
+    if (size >= 4) {
+        RCU_AHBEN |= RCU_AHBEN_CRCEN;
+        CRC_CTL = CRC_CTL_RST;
+        if (crc != 0xFFFFFFFF)
+            CRC_DATA = crc32_seed(__RBIT(crc));
+        for (; size >= 4; size -= 4, buff += 4)
+            CRC_DATA = __RBIT(*(uint32_t *)buff);
+        crc = __RBIT(CRC_DATA);
+    }
+
+    while (size--)
+        crc = crc32_byte(crc, *buff++);
+    return ~crc;
+}
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef __HAL_DRIVER_GIGADEVICE_GD32E10X_CRC_H__
+#define __HAL_DRIVER_GIGADEVICE_GD32E10X_CRC_H__
+
+/*============================ INCLUDES ======================================*/
+
+#include "hal/vsf_hal_cfg.h"
+#include "../__device.h"
+
+/*============================ MACROS ========================================*/
+
+#ifndef CRC0_ENABLE
+#   define CRC0_ENABLE          0
+#endif
+
+#define CRC_COUNT               (0 + CRC0_ENABLE)
+
+/*============================ MACROFIED FUNCTIONS ===========================*/
+/*============================ TYPES =========================================*/
+/*============================ GLOBAL VARIABLES ==============================*/
+/*============================ LOCAL VARIABLES ===============================*/
+/*============================ INCLUDES ======================================*/
+/*============================ PROTOTYPES ====================================*/
+
+#if CRC_COUNT
+// CRC-32 of zlib, 0 to start, the last result to go on
+uint32_t vsfhal_crc32(uint32_t crc, uint8_t *buff, uint32_t size);
+#endif
+
+#endif
+/* EOF */
@@ -15,6 +15,9 @@
 #ifndef USART_BUFF_SIZE
 #   define USART_BUFF_SIZE              32
 #endif
+#ifndef USART_RX_FLUSH_US
+#   define USART_RX_FLUSH_US            200     // receiver timeout, passes on a partly filled rx block
+#endif
 
 /*============================ MACROFIED FUNCTIONS ===========================*/
 /*============================ TYPES =========================================*/
@@ -28,19 +31,22 @@ typedef struct usart_control_t {
     vsf_stream_t *tx;
     vsf_stream_t *rx;
     vsf_eda_t eda;
+    uint32_t stream_rx_dropped;     // bytes lost on a full rx stream
+    uint32_t stream_rx_marks;       // DMA half/full transfer count, for lap detection
+    uint32_t stream_rx_marks_seen;  // at the last time the DMA ring was emptied
+    uint16_t stream_rx_fill;        // bytes in the block at the head of a block rx stream
+    uint16_t stream_tx_size;        // part of the tx stream the DMA is sending from
+    volatile bool stream_rx_posted;
+    volatile bool stream_rx_flush;  // line idle, a partly filled block is passed on
 #endif
     void (*ontx)(void *);
     void (*onrx)(void *);
     void *param;
     uint8_t tx_buff[USART_BUFF_SIZE];
     uint8_t rx_buff[USART_BUFF_SIZE * 2];
-#if USART_STREAM_ENABLE
-    uint8_t stream_rx_buff[USART_BUFF_SIZE];
-    uint8_t stream_rx_size;
-#endif
-    uint8_t rx_buff_w_pos;  // Non-DMA RX
-    uint8_t rx_buff_r_pos;
-    uint8_t tx_size;
+    uint16_t rx_buff_w_pos;  // Non-DMA RX
+    uint16_t rx_buff_r_pos;
+    uint16_t tx_size;
     uint8_t dma_idx;
     uint8_t tx_dma_ch;
     uint8_t rx_dma_ch;
@@ -281,7 +287,7 @@ uint32_t vsfhal_usart_config(enum usart_idx_t idx, uint32_t baudrate, uint32_t m
         if (mode == USART_RESET_BAUD_ONLY) {
             USART_CTL0(usartx) &= ~USART_CTL0_UEN;
             USART_BAUD(usartx) = (temp + baudrate - 1) / baudrate;
-            USART_RT(usartx) = min(0xffffff, baudrate * 2 / 10000);      // 200us
+            USART_RT(usartx) = min(0xffffff, (uint64_t)baudrate * USART_RX_FLUSH_US / 1000000);
             USART_CTL0(usartx) |= USART_CTL0_UEN;
         } else {
             uint32_t div = (temp + baudrate - 1) / baudrate;
@@ -296,7 +302,7 @@ uint32_t vsfhal_usart_config(enum usart_idx_t idx, uint32_t baudrate, uint32_t m
         USART_CTL2(usartx) = (mode >> 4) & (USART_CTL2_CTSEN | USART_CTL2_RTSEN | USART_CTL2_HDEN | USART_CTL2_ERRIE);
         USART_CTL3(usartx) = ((mode >> 8) & (USART_CTL3_RINV | USART_CTL3_TINV | USART_CTL3_DINV | USART_CTL3_MSBF)) |
                 USART_CTL3_RTEN | USART_CTL3_RTIE;
-        USART_RT(usartx) = min(0xffffff, baudrate * 2 / 10000);      // 200us
+        USART_RT(usartx) = min(0xffffff, (uint64_t)baudrate * USART_RX_FLUSH_US / 1000000);
 
         switch (idx) {
         #if USART0_ENABLE
@@ -412,27 +418,32 @@ void vsfhal_usart_config_cb(enum usart_idx_t idx, int32_t int_priority, void *p,
     }
 }
 
-uint16_t vsfhal_usart_tx_bytes(enum usart_idx_t idx, uint8_t *data, uint16_t size)
+static void usart_tx_start(usart_control_t *ctrl, uint8_t *buf, uint16_t size)
 {
-    VSF_HAL_ASSERT(idx < USART_IDX_NUM);
-
-    uint8_t *tx_buff = usart_control[idx].tx_buff;
-    usart_control[idx].tx_size = size;
-    
-    if (usart_control[idx].dma_idx != DMA_INVALID_IDX) {
-        uint32_t dmax = (usart_control[idx].dma_idx == 0) ? DMA0 : DMA1;
-        uint8_t tx_dma_ch = usart_control[idx].tx_dma_ch;
+    ctrl->tx_size = size;
 
-        if (data)
-            memcpy(tx_buff, data, size);
+    if (ctrl->dma_idx != DMA_INVALID_IDX) {
+        uint32_t dmax = (ctrl->dma_idx == 0) ? DMA0 : DMA1;
+        uint8_t tx_dma_ch = ctrl->tx_dma_ch;
 
         DMA_CHxCTL(dmax, tx_dma_ch) &= ~DMA_CHXCTL_CHEN;
-        DMA_CHxMADDR(dmax, tx_dma_ch) = (uint32_t)tx_buff;
+        DMA_CHxMADDR(dmax, tx_dma_ch) = (uint32_t)buf;
         DMA_CHxCNT(dmax, tx_dma_ch) = size;
         DMA_CHxCTL(dmax, tx_dma_ch) |= DMA_CHXCTL_CHEN;
     } else {
         #warning "TODO"
     }
+}
+
+uint16_t vsfhal_usart_tx_bytes(enum usart_idx_t idx, uint8_t *data, uint16_t size)
+{
+    VSF_HAL_ASSERT(idx < USART_IDX_NUM);
+
+    uint8_t *tx_buff = usart_control[idx].tx_buff;
+
+    if (data)
+        memcpy(tx_buff, data, size);
+    usart_tx_start(&usart_control[idx], tx_buff, size);
 
     return size;
 }
@@ -450,26 +461,29 @@ uint16_t vsfhal_usart_rx_bytes(enum usart_idx_t idx, uint8_t *data, uint16_t siz
 
     uint_fast16_t end;
     usart_control_t *ctrl = &usart_control[idx];
-    size = vsfhal_usart_rx_get_data_size(idx);
-    size = min(size, size);
+    end = vsfhal_usart_rx_get_data_size(idx);
+    size = min(size, end);
     if (!size)
         return 0;
 
     end = min((USART_BUFF_SIZE * 2) - ctrl->rx_buff_r_pos, size);
     size = size - end;
 
+    // data NULL drops the bytes
     if (end) {
-        memcpy(data, ctrl->rx_buff + ctrl->rx_buff_r_pos, end);
+        if (data)
+            memcpy(data, ctrl->rx_buff + ctrl->rx_buff_r_pos, end);
         ctrl->rx_buff_r_pos = ctrl->rx_buff_r_pos + end;
         if (ctrl->rx_buff_r_pos == (USART_BUFF_SIZE * 2)) {
             ctrl->rx_buff_r_pos = 0;
         }
     }
     if (size) {
-        memcpy(data + end, ctrl->rx_buff, size);
+        if (data)
+            memcpy(data + end, ctrl->rx_buff, size);
         ctrl->rx_buff_r_pos = size;
     }
-    
+
     return end + size;
 }
 
@@ -478,11 +492,11 @@ uint16_t vsfhal_usart_rx_get_data_size(enum usart_idx_t idx)
     VSF_HAL_ASSERT(idx < USART_IDX_NUM);
 
     usart_control_t *ctrl = &usart_control[idx];
-    uint_fast8_t rx_buff_w_pos, rx_buff_r_pos = ctrl->rx_buff_r_pos;
+    uint_fast16_t rx_buff_w_pos, rx_buff_r_pos = ctrl->rx_buff_r_pos;
 
     if (ctrl->dma_idx != DMA_INVALID_IDX) {
         uint32_t dmax = (ctrl->dma_idx == 0) ? DMA0 : DMA1;
-        rx_buff_w_pos = USART_BUFF_SIZE * 2 - DMA_CHxCNT(dmax, ctrl->rx_dma_ch);
+        rx_buff_w_pos = (USART_BUFF_SIZE * 2 - DMA_CHxCNT(dmax, ctrl->rx_dma_ch)) % (USART_BUFF_SIZE * 2);
     } else {
         rx_buff_w_pos = ctrl->rx_buff_w_pos;
     }
@@ -523,6 +537,9 @@ ROOT void USART0_IRQHandler(void)
 
     if (USART_STAT1(USART0) & USART_STAT1_RTF) {
         USART_STAT1(USART0) &= ~USART_STAT1_RTF;
+        #if USART_STREAM_ENABLE
+        usart_control[USART0_IDX].stream_rx_flush = true;
+        #endif
         usart_rx_done(&usart_control[USART0_IDX]);
     }
 }
@@ -538,6 +555,9 @@ ROOT void USART1_IRQHandler(void)
 
     if (USART_STAT1(USART1) & USART_STAT1_RTF) {
         USART_STAT1(USART1) &= ~USART_STAT1_RTF;
+        #if USART_STREAM_ENABLE
+        usart_control[USART1_IDX].stream_rx_flush = true;
+        #endif
         usart_rx_done(&usart_control[USART1_IDX]);
     }
 }
@@ -553,6 +573,9 @@ ROOT void USART2_IRQHandler(void)
     
     if (USART_STAT1(USART2) & USART_STAT1_RTF) {
         USART_STAT1(USART2) &= ~USART_STAT1_RTF;
+        #if USART_STREAM_ENABLE
+        usart_control[USART2_IDX].stream_rx_flush = true;
+        #endif
         usart_rx_done(&usart_control[USART2_IDX]);
     }
 }
@@ -563,61 +586,116 @@ ROOT void TIMER6_IRQHandler(void)
 {
     TIMER_INTF(TIMER6) = 0;
 #if USART3_ENABLE
-    if (vsfhal_usart_rx_get_data_size(USART3_IDX))
+    if (vsfhal_usart_rx_get_data_size(USART3_IDX)) {
+        #if USART_STREAM_ENABLE
+        usart_control[USART3_IDX].stream_rx_flush = true;
+        #endif
         usart_rx_done(&usart_control[USART3_IDX]);
+    }
 #endif  // USART3_ENABLE
 #if USART4_ENABLE
-    if (vsfhal_usart_rx_get_data_size(USART4_IDX))
+    if (vsfhal_usart_rx_get_data_size(USART4_IDX)) {
+        #if USART_STREAM_ENABLE
+        usart_control[USART4_IDX].stream_rx_flush = true;
+        #endif
         usart_rx_done(&usart_control[USART4_IDX]);
+    }
 #endif  // USART4_ENABLE
 }
 #endif  // USART3_ENABLE || USART4_ENABLE
 
 #if USART_STREAM_ENABLE
 
+// the DMA sends straight out of the tx stream, the part is released once it is out
 static void stream_dotx(usart_control_t *ctrl, vsf_stream_t *stream)
 {
+    uint8_t *buf;
     uint32_t size;
-    enum usart_idx_t idx = ((uint32_t)ctrl - (uint32_t)usart_control) / sizeof(usart_control_t);
 
-    size = vsfhal_usart_tx_get_free_size(idx);
+    if (ctrl->tx_size)
+        return;
+
+    if (ctrl->stream_tx_size) {
+        VSF_STREAM_READ(stream, NULL, ctrl->stream_tx_size);
+        ctrl->stream_tx_size = 0;
+    }
+    size = VSF_STREAM_GET_RBUF(stream, &buf);
     if (size) {
-        if (stream->op == &vsf_fifo_stream_op) {
-            uint8_t buf[USART_BUFF_SIZE];
-            size = VSF_STREAM_READ(stream, buf, size);
-            if (size)
-                vsfhal_usart_tx_bytes(idx, buf, size);
-        } else if (stream->op == &vsf_block_stream_op) {
-            uint8_t *buf;
-            size = VSF_STREAM_GET_RBUF(stream, &buf);
-            if (size) {
-                memcpy(usart_control[idx].tx_buff, buf, size);
-                VSF_STREAM_READ(stream, buf, size);
-                vsfhal_usart_tx_bytes(idx, NULL, size);
-            }
-        }
+        ctrl->stream_tx_size = min(size, 0xffff);
+        usart_tx_start(ctrl, buf, ctrl->stream_tx_size);
     }
 }
 
+// lap detection, the DMA went round the ring since it was last emptied
+static bool stream_rx_lapped(usart_control_t *ctrl, uint32_t marks)
+{
+    return (ctrl->dma_idx != DMA_INVALID_IDX) && (marks - ctrl->stream_rx_marks_seen > 2);
+}
+
+/*
+    Received bytes wait in the rx ring until the rx stream has room, and go
+    from there into its write buffer. A block stream gets full blocks, a
+    block is only passed on partly filled when the line goes idle.
+*/
 static void stream_dorx(usart_control_t *ctrl, vsf_stream_t *stream)
 {
-    uint32_t size;
     enum usart_idx_t idx = ((uint32_t)ctrl - (uint32_t)usart_control) / sizeof(usart_control_t);
+    bool is_block = stream->op == &vsf_block_stream_op;
+    bool flush = ctrl->stream_rx_flush;
+    uint32_t marks = ctrl->stream_rx_marks;
+    uint32_t size, block_size;
+    uint8_t *buf;
+
+    ctrl->stream_rx_posted = false;
+    ctrl->stream_rx_flush = false;
+
+    if (stream_rx_lapped(ctrl, marks)) {
+        ctrl->stream_rx_dropped += USART_BUFF_SIZE * 2;
+        vsfhal_usart_rx_bytes(idx, NULL, USART_BUFF_SIZE * 2);
+    }
+    if (!VSF_STREAM_IS_RX_CONNECTED(stream)) {
+        vsfhal_usart_rx_bytes(idx, NULL, USART_BUFF_SIZE * 2);
+        ctrl->stream_rx_marks_seen = marks;
+        return;
+    }
+
+    while (1) {
+        block_size = VSF_STREAM_GET_WBUF(stream, &buf);
+        size = block_size;
+        if (is_block && size) {
+            buf += ctrl->stream_rx_fill;
+            size -= ctrl->stream_rx_fill;
+        }
+        size = vsfhal_usart_rx_bytes(idx, buf, size);
+        if (!size)
+            break;
 
-    if (stream->op == &vsf_fifo_stream_op) {
-        size = ctrl->stream_rx_size;
-        if (size && VSF_STREAM_IS_RX_CONNECTED(stream))
-            VSF_STREAM_WRITE(stream, ctrl->stream_rx_buff, size);
-    } else if (stream->op == &vsf_block_stream_op) {
-        uint8_t *buf;
-        size = VSF_STREAM_GET_WBUF(stream, &buf);
-        size = min(size, ctrl->stream_rx_size);
-        if (size && VSF_STREAM_IS_RX_CONNECTED(stream)) {
-            memcpy(buf, ctrl->stream_rx_buff, size);
-            VSF_STREAM_WRITE(stream, buf, size);
+        if (is_block) {
+            ctrl->stream_rx_fill += size;
+            if (ctrl->stream_rx_fill == block_size) {
+                VSF_STREAM_WRITE(stream, NULL, block_size);
+                ctrl->stream_rx_fill = 0;
+            }
+        } else {
+            VSF_STREAM_WRITE(stream, NULL, size);
+        }
+    }
+
+    if (!vsfhal_usart_rx_get_data_size(idx)) {
+        ctrl->stream_rx_marks_seen = marks;
+        if (flush && ctrl->stream_rx_fill) {
+            VSF_STREAM_WRITE(stream, NULL, ctrl->stream_rx_fill);
+            ctrl->stream_rx_fill = 0;
         }
     }
-    ctrl->stream_rx_size = 0;
+}
+
+static void stream_rx_dma_done(void *p)
+{
+    usart_control_t *ctrl = p;
+
+    ctrl->stream_rx_marks++;
+    usart_rx_done(p);
 }
 
 enum {
@@ -646,6 +724,8 @@ static void usart_stream_evthandler(vsf_eda_t *eda, vsf_evt_t evt)
         stream_dorx(ctrl, rx_stream);
         break;
     case VSF_EVT_RX_STREAM_ONTX:
+        // bytes held back on a full stream can go now
+        stream_dorx(ctrl, rx_stream);
         if (VSF_STREAM_GET_DATA_SIZE(rx_stream)) {
             // used to call __vsf_stream_on_write
             vsf_stream_set_rx_threshold(rx_stream, rx_stream->rx.threshold);
@@ -681,15 +761,9 @@ static void stream_ontx(void *param)
 static void stream_onrx(void *param)
 {
     usart_control_t *ctrl = param;
-    if (ctrl->stream_rx_size == 0) {
-        uint32_t size;
-        enum usart_idx_t idx = ((uint32_t)ctrl - (uint32_t)usart_control) / sizeof(usart_control_t);
-        size = vsfhal_usart_rx_get_data_size(idx);
-        size = min(size, USART_BUFF_SIZE);
-        if (size) {
-            ctrl->stream_rx_size = vsfhal_usart_rx_bytes(idx, ctrl->stream_rx_buff, size);
-            vsf_eda_post_evt(&ctrl->eda, VSF_EVT_RX_STREAM_ONRX);
-        }
+    if (!ctrl->stream_rx_posted) {
+        ctrl->stream_rx_posted = true;
+        vsf_eda_post_evt(&ctrl->eda, VSF_EVT_RX_STREAM_ONRX);
     }
 }
 
@@ -697,6 +771,9 @@ static void vsfhal_usart_stream_fini(enum usart_idx_t idx)
 {
     if (usart_control[idx].tx || usart_control[idx].rx)
         vsfhal_usart_config_cb(idx, 0, NULL, NULL, NULL);
+    // parts held by the DMA belong to the old streams
+    usart_control[idx].stream_tx_size = 0;
+    usart_control[idx].stream_rx_fill = 0;
     if (usart_control[idx].tx) {
         VSF_STREAM_DISCONNECT_RX(usart_control[idx].tx);
         usart_control[idx].tx->rx.evthandler = NULL;
@@ -725,6 +802,9 @@ void vsfhal_usart_stream_config(enum usart_idx_t idx, int32_t eda_priority, int3
     usart_control[idx].tx = tx;
     usart_control[idx].rx = rx;
     vsfhal_usart_config_cb(idx, int_priority, &usart_control[idx], stream_ontx, stream_onrx);
+    if (usart_control[idx].dma_idx != DMA_INVALID_IDX)
+        vsf_dma_config_channel(usart_control[idx].dma_idx, usart_control[idx].rx_dma_ch,
+                stream_rx_dma_done, &usart_control[idx], int_priority);
 
     if (tx) {
         tx->rx.evthandler = tx_stream_rx_evthandler;
@@ -737,6 +817,13 @@ void vsfhal_usart_stream_config(enum usart_idx_t idx, int32_t eda_priority, int3
         VSF_STREAM_CONNECT_TX(rx);
     }
 }
+
+uint32_t vsfhal_usart_stream_get_dropped(enum usart_idx_t idx)
+{
+    uint32_t dropped = usart_control[idx].stream_rx_dropped;
+    usart_control[idx].stream_rx_dropped = 0;
+    return dropped;
+}
 #endif
 
 #endif
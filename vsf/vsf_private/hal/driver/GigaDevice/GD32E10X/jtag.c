@@ -27,6 +27,7 @@ typedef struct jtag_control_t {
 	uint8_t idle;
     uint16_t retry_limit;
     uint16_t delay_tick;
+    uint32_t wait_retries;          // scans repeated after WAIT
 
     #if TIMESTAMP_CLOCK
     uint32_t dap_timestamp;
@@ -368,6 +369,8 @@ uint32_t vsfhal_jtag_dr(uint32_t request, uint32_t dr, uint32_t dr_before, uint3
 
     do
     {
+        if (retry)
+            jtag_control.wait_retries++;
         jtag_control.jtag_rw_dr(dma_bytes, bits_tail, (uint8_t *)&buf_tms, (uint8_t *)&buf_tdi, (uint8_t *)&buf_tdo);
         ack = (buf_tdo >> (dr_before + 3)) & 0x7;
         ack = (ack & 0x4) | ((ack & 0x2) >> 1) | ((ack & 0x1) << 1);
@@ -726,6 +729,13 @@ static void jtag_rw_dr_slow(uint32_t bytelen_dma, uint32_t bitlen_tail, uint8_t
     }
 }
 
+uint32_t vsfhal_jtag_get_retries(void)
+{
+    uint32_t retries = jtag_control.wait_retries;
+    jtag_control.wait_retries = 0;
+    return retries;
+}
+
 #if TIMESTAMP_CLOCK
 uint32_t vsfhal_jtag_get_timestamp(void)
 {
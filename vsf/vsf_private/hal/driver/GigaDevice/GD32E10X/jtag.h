@@ -41,6 +41,7 @@ uint32_t vsfhal_jtag_raw_1bit(uint32_t tms, uint32_t tdi);
 uint32_t vsfhal_jtag_wait(void);
 void vsfhal_jtag_clear(void);
 #endif  // JTAG_ASYNC
+uint32_t vsfhal_jtag_get_retries(void);
 #if TIMESTAMP_CLOCK
 uint32_t vsfhal_jtag_get_timestamp(void);
 #endif  // TIMESTAMP_CLOCK
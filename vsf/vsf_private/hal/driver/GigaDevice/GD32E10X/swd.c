@@ -109,6 +109,8 @@ typedef struct swd_control_t {
     bool data_force;
     uint16_t retry_limit;
     uint16_t delay_tick;
+    uint32_t wait_retries;          // packets repeated after WAIT
+    uint32_t parity_errors;         // reads with bad data parity
 
     #if TIMESTAMP_CLOCK
     uint32_t dap_timestamp;
@@ -119,6 +121,19 @@ typedef struct swd_control_t {
     void (*swd_read_io)(uint8_t *data, uint32_t bits);
     void (*swd_write_io)(uint8_t *data, uint32_t bits);
     void (*swd_delay)(uint16_t delay_tick);
+    #ifdef SWD_BLOCK
+    uint32_t (*swd_read_block)(uint32_t request, uint8_t *r_data, uint16_t count, uint16_t *done);
+    uint32_t (*swd_write_block)(uint32_t request, uint8_t *w_data, uint16_t count, uint16_t *done);
+    #endif
+
+    #ifdef SWD_ASYNC
+    uint32_t status;
+    uint32_t rx_dummy;
+    uint32_t finish_request;
+    uint8_t finish_parity;
+    uint8_t *finish_data;
+    void (*swd_finish)(void);
+    #endif
 } swd_control_t;
 
 #if SWD_COUNT > 0
@@ -133,6 +148,27 @@ static void swd_read_io_quick(uint8_t *data, uint32_t bits);
 static void swd_read_io_slow(uint8_t *data, uint32_t bits);
 static void swd_write_io_quick(uint8_t *data, uint32_t bits);
 static void swd_write_io_slow(uint8_t *data, uint32_t bits);
+#ifdef SWD_BLOCK
+static uint32_t swd_read_block_quick(uint32_t request, uint8_t *r_data, uint16_t count, uint16_t *done);
+static uint32_t swd_read_block_slow(uint32_t request, uint8_t *r_data, uint16_t count, uint16_t *done);
+static uint32_t swd_write_block_quick(uint32_t request, uint8_t *w_data, uint16_t count, uint16_t *done);
+static uint32_t swd_write_block_slow(uint32_t request, uint8_t *w_data, uint16_t count, uint16_t *done);
+#endif
+#ifdef SWD_ASYNC
+static void swd_read_quick_finish(void);
+static void swd_write_quick_finish(void);
+
+// clock out the tail of the frame left on the wire by the last read/write
+static void swd_finish(void)
+{
+    void (*finish)(void) = swd_control.swd_finish;
+
+    if (finish) {
+        swd_control.swd_finish = NULL;
+        finish();
+    }
+}
+#endif
 
 void vsfhal_swd_init(int32_t int_priority)
 {
@@ -160,6 +196,9 @@ void vsfhal_swd_init(int32_t int_priority)
     }
 
     memset(&swd_control, 0, sizeof(swd_control_t));
+    #ifdef SWD_ASYNC
+    swd_control.status = SWD_ACK_OK | SWD_SUCCESS;
+    #endif
 }
 
 void vsfhal_swd_fini(void)
@@ -307,6 +346,10 @@ void vsfhal_swd_config(uint16_t kHz, uint16_t retry, uint8_t idle, uint8_t trn,
     uint32_t temp, apb;
     struct vsfhal_clk_info_t *info = vsfhal_clk_info_get();
 
+    #ifdef SWD_ASYNC
+    swd_finish();
+    #endif
+
     if (kHz < spi_khz_and_apb_clk_table_list[dimof(spi_khz_and_apb_clk_table_list) - 1][1])
         kHz = spi_khz_and_apb_clk_table_list[dimof(spi_khz_and_apb_clk_table_list) - 1][1];
     for (temp = 0; temp < dimof(spi_khz_and_apb_clk_table_list); temp++) {
@@ -375,6 +418,16 @@ void vsfhal_swd_config(uint16_t kHz, uint16_t retry, uint8_t idle, uint8_t trn,
         swd_control.swd_delay = delay_swd_250khz_188khz;
     }
 
+    #ifdef SWD_BLOCK
+    if (swd_control.swd_delay) {
+        swd_control.swd_read_block = swd_read_block_slow;
+        swd_control.swd_write_block = swd_write_block_slow;
+    } else {
+        swd_control.swd_read_block = swd_read_block_quick;
+        swd_control.swd_write_block = swd_write_block_quick;
+    }
+    #endif
+
     // SPI config
     SPI_CTL0(SWD_SPI_BASE) &= ~(SPI_CTL0_SPIEN | SPI_CTL0_PSC | SPI_CTL0_BDEN | SPI_CTL0_CRCEN | SPI_CTL0_FF16);
     SPI_CTL0(SWD_SPI_BASE) |= temp << 3;
@@ -392,6 +445,10 @@ void vsfhal_swd_config(uint16_t kHz, uint16_t retry, uint8_t idle, uint8_t trn,
 void vsfhal_swd_seqout(uint8_t *data, uint32_t bitlen)
 {
     uint_fast32_t bytes = bitlen >> 3;
+
+    #ifdef SWD_ASYNC
+    swd_finish();
+    #endif
     if (bytes) {
         SWDIO_MO_SWCLK_SWITCH_AFPP();
         DMA_CHxCTL(SWD_SPI_DMAX, SWD_SPI_TX_DMA_CH) = DMA_CHXCTL_DIR | DMA_CHXCTL_MNAGA | DMA_CHXCTL_PRIO; 
@@ -410,6 +467,10 @@ void vsfhal_swd_seqout(uint8_t *data, uint32_t bitlen)
 void vsfhal_swd_seqin(uint8_t *data, uint32_t bitlen)
 {
     uint_fast32_t temp, bytes = bitlen >> 3;
+
+    #ifdef SWD_ASYNC
+    swd_finish();
+    #endif
     if (bytes) {
         SWCLK_SWITCH_AFPP();
         temp = SPI_DATA(SWD_SPI_BASE);   // clear rx buffer
@@ -430,15 +491,211 @@ void vsfhal_swd_seqin(uint8_t *data, uint32_t bitlen)
         swd_control.swd_read_io(data, bitlen);
 }
 
+#ifdef SWD_ASYNC
+uint32_t vsfhal_swd_read(uint32_t request, uint8_t *r_data)
+{
+    uint32_t ack;
+
+    swd_finish();
+    if (swd_control.status == (SWD_ACK_OK | SWD_SUCCESS)) {
+        ack = swd_control.swd_read(request, r_data);
+        if (ack == (SWD_ACK_OK | SWD_PARITY_ERROR))
+            swd_control.parity_errors++;
+        if (ack != (SWD_ACK_OK | SWD_SUCCESS))
+            swd_control.status = ack;
+    }
+    return swd_control.status;
+}
+
+uint32_t vsfhal_swd_write(uint32_t request, uint8_t *w_data)
+{
+    uint32_t ack;
+
+    swd_finish();
+    if (swd_control.status == (SWD_ACK_OK | SWD_SUCCESS)) {
+        ack = swd_control.swd_write(request, w_data);
+        if (ack != (SWD_ACK_OK | SWD_SUCCESS))
+            swd_control.status = ack;
+    }
+    return swd_control.status;
+}
+
+uint32_t vsfhal_swd_wait(void)
+{
+    swd_finish();
+    return swd_control.status;
+}
+
+void vsfhal_swd_clear(void)
+{
+    swd_finish();
+    swd_control.status = SWD_ACK_OK | SWD_SUCCESS;
+}
+#else
 uint32_t vsfhal_swd_read(uint32_t request, uint8_t *r_data)
 {
-    return swd_control.swd_read(request, r_data);
+    uint32_t ack = swd_control.swd_read(request, r_data);
+
+    if (ack == (SWD_ACK_OK | SWD_PARITY_ERROR))
+        swd_control.parity_errors++;
+    return ack;
 }
 
 uint32_t vsfhal_swd_write(uint32_t request, uint8_t *w_data)
 {
     return swd_control.swd_write(request, w_data);
 }
+#endif
+
+#ifdef SWD_BLOCK
+#ifdef SWD_ASYNC
+// the frame left on the wire goes first, the block is done on return
+uint32_t vsfhal_swd_read_block(uint32_t request, uint8_t *r_data, uint16_t count, uint16_t *done)
+{
+    swd_finish();
+    *done = 0;
+    if (swd_control.status == (SWD_ACK_OK | SWD_SUCCESS))
+        swd_control.status = swd_control.swd_read_block(request, r_data, count, done);
+    return swd_control.status;
+}
+
+uint32_t vsfhal_swd_write_block(uint32_t request, uint8_t *w_data, uint16_t count, uint16_t *done)
+{
+    swd_finish();
+    *done = 0;
+    if (swd_control.status == (SWD_ACK_OK | SWD_SUCCESS))
+        swd_control.status = swd_control.swd_write_block(request, w_data, count, done);
+    return swd_control.status;
+}
+#else
+uint32_t vsfhal_swd_read_block(uint32_t request, uint8_t *r_data, uint16_t count, uint16_t *done)
+{
+    return swd_control.swd_read_block(request, r_data, count, done);
+}
+
+uint32_t vsfhal_swd_write_block(uint32_t request, uint8_t *w_data, uint16_t count, uint16_t *done)
+{
+    return swd_control.swd_write_block(request, w_data, count, done);
+}
+#endif
+#endif
+
+#if defined(SWD_BLOCK) || defined(SWD_ASYNC)
+/*
+    Data phase of a quick frame in two halves: start hands the 32 bits to the
+    SPI DMA, wait returns once they are through. The CPU is free in between.
+*/
+static void swd_data_in_start(uint8_t *data)
+{
+    uint32_t temp = SPI_DATA(SWD_SPI_BASE);     // clear rx buffer
+
+    DMA_CHxCTL(SWD_SPI_DMAX, SWD_SPI_RX_DMA_CH) = DMA_CHXCTL_MNAGA | DMA_CHXCTL_PRIO;
+    DMA_CHxMADDR(SWD_SPI_DMAX, SWD_SPI_RX_DMA_CH) = (uint32_t)data;
+    DMA_CHxCNT(SWD_SPI_DMAX, SWD_SPI_RX_DMA_CH) = 4;
+    DMA_CHxCTL(SWD_SPI_DMAX, SWD_SPI_RX_DMA_CH) = DMA_CHXCTL_CHEN | DMA_CHXCTL_MNAGA | DMA_CHXCTL_PRIO;
+    DMA_CHxCTL(SWD_SPI_DMAX, SWD_SPI_TX_DMA_CH) = DMA_CHXCTL_DIR | DMA_CHXCTL_PRIO;
+    DMA_CHxMADDR(SWD_SPI_DMAX, SWD_SPI_TX_DMA_CH) = (uint32_t)&swd_control.dummy; // fake tx
+    DMA_CHxCNT(SWD_SPI_DMAX, SWD_SPI_TX_DMA_CH) = 4;
+    DMA_CHxCTL(SWD_SPI_DMAX, SWD_SPI_TX_DMA_CH) = DMA_CHXCTL_CHEN | DMA_CHXCTL_DIR | DMA_CHXCTL_PRIO;
+}
+
+static void swd_data_in_wait(uint8_t *data)
+{
+    while (DMA_CHxCNT(SWD_SPI_DMAX, SWD_SPI_RX_DMA_CH));
+}
+
+static void swd_data_out_start(uint8_t *data)
+{
+    DMA_CHxCTL(SWD_SPI_DMAX, SWD_SPI_TX_DMA_CH) = DMA_CHXCTL_DIR | DMA_CHXCTL_MNAGA | DMA_CHXCTL_PRIO;
+    DMA_CHxMADDR(SWD_SPI_DMAX, SWD_SPI_TX_DMA_CH) = (uint32_t)data;
+    DMA_CHxCNT(SWD_SPI_DMAX, SWD_SPI_TX_DMA_CH) = 4;
+    DMA_CHxCTL(SWD_SPI_DMAX, SWD_SPI_TX_DMA_CH) = DMA_CHXCTL_CHEN | DMA_CHXCTL_DIR | DMA_CHXCTL_MNAGA | DMA_CHXCTL_PRIO;
+}
+
+static void swd_data_out_wait(void)
+{
+    while (DMA_CHxCNT(SWD_SPI_DMAX, SWD_SPI_TX_DMA_CH));
+    while (SPI_STAT(SWD_SPI_BASE) & SPI_STAT_TRANS);
+}
+#endif
+
+#ifdef SWD_ASYNC
+/*
+    Asynchronous mode, quick mode only.
+
+    swd_read_quick/swd_write_quick return as soon as the DMA of the data
+    phase of an OK frame is started. Parity, Trn and Idle of that frame are
+    clocked by its finish handler when the next frame is issued or in
+    vsfhal_swd_wait, so the caller packs the next request while the data
+    phase is on the wire, and the write parity is computed in the same
+    window. A failed ACK, or the parity error of a read, sticks in status and
+    is returned by every call until vsfhal_swd_clear; frames issued after it
+    are dropped.
+*/
+
+// OFF "Instruction scheduling"
+static void swd_read_quick_finish(void)
+{
+    uint_fast32_t tick, temp;
+    uint8_t *r_data = swd_control.finish_data;
+
+    swd_data_in_wait(r_data);
+
+    // Parity:[R]*1
+    SWDIO_MO_SWITCH_ANALOG_IN_SWCLK_SWITCH_OUTPP();
+    IO_CLEAR(PERIPHERAL_GPIO_TCK_SWD_IDX, PERIPHERAL_GPIO_TCK_SWD_PIN);
+    temp = IO_GET(PERIPHERAL_GPIO_TMS_MI_IDX, PERIPHERAL_GPIO_TMS_MI_PIN);
+    IO_SET(PERIPHERAL_GPIO_TCK_SWD_IDX, PERIPHERAL_GPIO_TCK_SWD_PIN);
+
+    tick = swd_control.trn + swd_control.idle;
+
+    // Trn:[C]*trn --> Idle:[C]*idle
+    while (tick--) {
+        IO_CLEAR(PERIPHERAL_GPIO_TCK_SWD_IDX, PERIPHERAL_GPIO_TCK_SWD_PIN);
+        IO_SET(PERIPHERAL_GPIO_TCK_SWD_IDX, PERIPHERAL_GPIO_TCK_SWD_PIN);
+    }
+
+    #if TIMESTAMP_CLOCK
+    if (swd_control.finish_request & SWD_TRANS_TIMESTAMP)
+        swd_control.dap_timestamp = vsfhal_timestamp_get();
+    #endif
+
+    if (temp != get_parity_32bit(get_unaligned_le32(r_data))) {
+        swd_control.status = SWD_ACK_OK | SWD_PARITY_ERROR;
+        swd_control.parity_errors++;
+    }
+}
+
+// OFF "Instruction scheduling"
+static void swd_write_quick_finish(void)
+{
+    uint_fast32_t tick = swd_control.idle;
+
+    swd_data_out_wait();
+
+    // Parity:[W]*1
+    SWDIO_MO_SWITCH_ANALOG_IN_SWCLK_SWITCH_OUTPP();
+    SWDIO_MO_SWITCH_OUTPP();
+    if (swd_control.finish_parity)
+        IO_SET(PERIPHERAL_GPIO_TMS_MO_IDX, PERIPHERAL_GPIO_TMS_MO_PIN);
+    else
+        IO_CLEAR(PERIPHERAL_GPIO_TMS_MO_IDX, PERIPHERAL_GPIO_TMS_MO_PIN);
+    IO_CLEAR(PERIPHERAL_GPIO_TCK_SWD_IDX, PERIPHERAL_GPIO_TCK_SWD_PIN);
+    IO_SET(PERIPHERAL_GPIO_TCK_SWD_IDX, PERIPHERAL_GPIO_TCK_SWD_PIN);
+
+    // Idle:[C]*idle
+    while (tick--) {
+        IO_CLEAR(PERIPHERAL_GPIO_TCK_SWD_IDX, PERIPHERAL_GPIO_TCK_SWD_PIN);
+        IO_SET(PERIPHERAL_GPIO_TCK_SWD_IDX, PERIPHERAL_GPIO_TCK_SWD_PIN);
+    }
+    SWDIO_MO_SWITCH_ANALOG_IN();
+
+    #if TIMESTAMP_CLOCK
+    if (swd_control.finish_request & SWD_TRANS_TIMESTAMP)
+        swd_control.dap_timestamp = vsfhal_timestamp_get();
+    #endif
+}
+#endif
 
 // OFF "Instruction scheduling"
 static uint32_t swd_read_quick(uint32_t request, uint8_t *r_data)
@@ -499,6 +756,15 @@ SYNC_READ_RESTART:
     if (temp == SWD_ACK_OK) {
         // Data:[R]*32
         SWCLK_SWITCH_AFPP();
+        #ifdef SWD_ASYNC
+        if (r_data == (uint8_t *)&buffer)
+            r_data = (uint8_t *)&swd_control.rx_dummy;
+        swd_data_in_start(r_data);
+        swd_control.finish_request = request;
+        swd_control.finish_data = r_data;
+        swd_control.swd_finish = swd_read_quick_finish;
+        return SWD_ACK_OK | SWD_SUCCESS;
+        #endif
         temp = SPI_DATA(SWD_SPI_BASE);   // clear rx buffer
         DMA_CHxCTL(SWD_SPI_DMAX, SWD_SPI_RX_DMA_CH) = DMA_CHXCTL_MNAGA | DMA_CHXCTL_PRIO;
         DMA_CHxMADDR(SWD_SPI_DMAX, SWD_SPI_RX_DMA_CH) = (uint32_t)r_data;
@@ -575,9 +841,10 @@ SYNC_READ_RESTART:
             }
         }
 
-        if ((temp == SWD_ACK_WAIT) && (retry++ < swd_control.retry_limit))
+        if ((temp == SWD_ACK_WAIT) && (retry++ < swd_control.retry_limit)) {
+            swd_control.wait_retries++;
             goto SYNC_READ_RESTART;
-        else
+        } else
             return temp;
     } else {
         // Data:[C]*32
@@ -732,9 +999,10 @@ SYNC_READ_RESTART:
             }
         }
 
-        if ((temp == SWD_ACK_WAIT) && (retry++ < swd_control.retry_limit))
+        if ((temp == SWD_ACK_WAIT) && (retry++ < swd_control.retry_limit)) {
+            swd_control.wait_retries++;
             goto SYNC_READ_RESTART;
-        else
+        } else
             return temp;
     } else {
         // Data:[C]*32
@@ -824,6 +1092,13 @@ SYNC_READ_RESTART:
 
         // Data:[W]*32
         SWDIO_MO_SWCLK_SWITCH_AFPP();
+        #ifdef SWD_ASYNC
+        swd_data_out_start(w_data);
+        swd_control.finish_request = request;
+        swd_control.finish_parity = get_parity_32bit(get_unaligned_le32(w_data));
+        swd_control.swd_finish = swd_write_quick_finish;
+        return SWD_ACK_OK | SWD_SUCCESS;
+        #endif
         DMA_CHxCTL(SWD_SPI_DMAX, SWD_SPI_TX_DMA_CH) = DMA_CHXCTL_DIR | DMA_CHXCTL_MNAGA | DMA_CHXCTL_PRIO; 
         DMA_CHxMADDR(SWD_SPI_DMAX, SWD_SPI_TX_DMA_CH) = (uint32_t)w_data;
         DMA_CHxCNT(SWD_SPI_DMAX, SWD_SPI_TX_DMA_CH) = 4;
@@ -897,9 +1172,10 @@ SYNC_READ_RESTART:
             //    swd_control.swd_delay(swd_control.delay_tick);
         }
 
-        if ((temp == SWD_ACK_WAIT) && (retry++ < swd_control.retry_limit))
+        if ((temp == SWD_ACK_WAIT) && (retry++ < swd_control.retry_limit)) {
+            swd_control.wait_retries++;
             goto SYNC_READ_RESTART;
-        else
+        } else
             return temp;
     } else {
         // Data:[C]*32
@@ -1063,9 +1339,10 @@ SYNC_READ_RESTART:
                 swd_control.swd_delay(swd_control.delay_tick);
         }
 
-        if ((temp == SWD_ACK_WAIT) && (retry++ < swd_control.retry_limit))
+        if ((temp == SWD_ACK_WAIT) && (retry++ < swd_control.retry_limit)) {
+            swd_control.wait_retries++;
             goto SYNC_READ_RESTART;
-        else
+        } else
             return temp;
     } else {
         // Data:[C]*32
@@ -1164,9 +1441,262 @@ static void swd_write_io_slow(uint8_t *data, uint32_t bits)
     SWDIO_MO_SWITCH_ANALOG_IN();
 }
 
+#ifdef SWD_BLOCK
+/*
+    Block transfers for ID_DAP_TransferBlock, quick mode only.
+
+    All frames of a block share one request, so the request byte is encoded
+    once and the data phases go back to back without per-frame dispatch. The
+    data phase is moved by SPI DMA; while it runs, the CPU checks the parity
+    of the previous read or computes the parity of the next write. With
+    data_force every frame has the same shape whatever the ACK, so the ACK is
+    only looked at after the data phase. Whole frames can not be one DMA
+    stream, SWDIO MO/MI change mode at every turnaround.
+
+    A frame answered with WAIT is redone by swd_read_quick/swd_write_quick,
+    which retry as usual, and the block goes on. Any other failure ends the
+    block, *done holds the frames completed before it.
+*/
+
+// OFF "Instruction scheduling"
+static void swd_clock_quick(uint_fast32_t tick)
+{
+    while (tick--) {
+        IO_CLEAR(PERIPHERAL_GPIO_TCK_SWD_IDX, PERIPHERAL_GPIO_TCK_SWD_PIN);
+        IO_SET(PERIPHERAL_GPIO_TCK_SWD_IDX, PERIPHERAL_GPIO_TCK_SWD_PIN);
+    }
+}
+
+// OFF "Instruction scheduling"
+static uint_fast32_t swd_request_quick(uint32_t request_byte)
+{
+    uint_fast32_t ack;
+
+    // Request:[W]*8
+    SWDIO_MO_SWCLK_SWITCH_AFPP();
+    SPI_DATA(SWD_SPI_BASE) = request_byte;
+    while (SPI_STAT(SWD_SPI_BASE) & SPI_STAT_TRANS);
+    ack = SPI_DATA(SWD_SPI_BASE);
+
+    // TRN:[C]*trn
+    SWDIO_MO_SWITCH_ANALOG_IN_SWCLK_SWITCH_OUTPP();
+    swd_clock_quick(swd_control.trn);
+
+    // ACK:[R]*3
+    IO_CLEAR(PERIPHERAL_GPIO_TCK_SWD_IDX, PERIPHERAL_GPIO_TCK_SWD_PIN);
+    ack = IO_GET(PERIPHERAL_GPIO_TMS_MI_IDX, PERIPHERAL_GPIO_TMS_MI_PIN);
+    IO_SET(PERIPHERAL_GPIO_TCK_SWD_IDX, PERIPHERAL_GPIO_TCK_SWD_PIN);
+    IO_CLEAR(PERIPHERAL_GPIO_TCK_SWD_IDX, PERIPHERAL_GPIO_TCK_SWD_PIN);
+    ack |= IO_GET(PERIPHERAL_GPIO_TMS_MI_IDX, PERIPHERAL_GPIO_TMS_MI_PIN) << 1;
+    IO_SET(PERIPHERAL_GPIO_TCK_SWD_IDX, PERIPHERAL_GPIO_TCK_SWD_PIN);
+    IO_CLEAR(PERIPHERAL_GPIO_TCK_SWD_IDX, PERIPHERAL_GPIO_TCK_SWD_PIN);
+    ack |= IO_GET(PERIPHERAL_GPIO_TMS_MI_IDX, PERIPHERAL_GPIO_TMS_MI_PIN) << 2;
+    IO_SET(PERIPHERAL_GPIO_TCK_SWD_IDX, PERIPHERAL_GPIO_TCK_SWD_PIN);
+    return ack;
+}
+
+// WAIT of a block frame, redone with the retries of a single frame
+static uint32_t swd_read_redo(uint32_t request, uint8_t *r_data)
+{
+    uint32_t ack = swd_read_quick(request, r_data);
+
+    #ifdef SWD_ASYNC
+    // parity errors are counted by the finish handler
+    swd_finish();
+    if (ack == (SWD_ACK_OK | SWD_SUCCESS))
+        ack = swd_control.status;
+    #else
+    if (ack == (SWD_ACK_OK | SWD_PARITY_ERROR))
+        swd_control.parity_errors++;
+    #endif
+    return ack;
+}
+
+static uint32_t swd_write_redo(uint32_t request, uint8_t *w_data)
+{
+    uint32_t ack = swd_write_quick(request, w_data);
+
+    #ifdef SWD_ASYNC
+    swd_finish();
+    #endif
+    return ack;
+}
+
+// OFF "Instruction scheduling"
+static uint32_t swd_read_block_quick(uint32_t request, uint8_t *r_data, uint16_t count, uint16_t *done)
+{
+    uint_fast32_t ack = SWD_ACK_OK, parity = 0, n = 0;
+    uint32_t request_byte = ((request << 1) & 0x1e) | 0x81 | (get_parity_4bit(request) << 5);
+    uint8_t *last = NULL;
+    bool bad;
+
+    while (n < count) {
+        ack = swd_request_quick(request_byte);
+
+        if ((ack == SWD_ACK_OK) || swd_control.data_force) {
+            // Data:[R]*32
+            SWCLK_SWITCH_AFPP();
+            swd_data_in_start(r_data);
+            bad = last && (parity != get_parity_32bit(get_unaligned_le32(last)));
+            swd_data_in_wait(r_data);
+
+            // Parity:[R]*1 -> Trn:[C]*trn --> Idle:[C]*idle
+            SWDIO_MO_SWITCH_ANALOG_IN_SWCLK_SWITCH_OUTPP();
+            IO_CLEAR(PERIPHERAL_GPIO_TCK_SWD_IDX, PERIPHERAL_GPIO_TCK_SWD_PIN);
+            parity = IO_GET(PERIPHERAL_GPIO_TMS_MI_IDX, PERIPHERAL_GPIO_TMS_MI_PIN);
+            IO_SET(PERIPHERAL_GPIO_TCK_SWD_IDX, PERIPHERAL_GPIO_TCK_SWD_PIN);
+            swd_clock_quick(swd_control.trn + swd_control.idle);
+        } else {
+            bad = last && (parity != get_parity_32bit(get_unaligned_le32(last)));
+            if ((ack == SWD_ACK_WAIT) || (ack == SWD_ACK_FAULT)) {
+                // Trn:[C]*trn
+                swd_clock_quick(swd_control.trn);
+            } else {
+                // Data:[C]*32 --> Parity:[C]*1
+                swd_clock_quick(33);
+            }
+        }
+
+        if (bad) {
+            n--;
+            ack = SWD_ACK_OK | SWD_PARITY_ERROR;
+            swd_control.parity_errors++;
+            break;
+        }
+        if (ack == SWD_ACK_WAIT) {
+            ack = swd_read_redo(request, r_data);
+            if (ack != (SWD_ACK_OK | SWD_SUCCESS))
+                break;
+            last = NULL;
+        } else if (ack != SWD_ACK_OK) {
+            break;
+        } else {
+            last = r_data;
+        }
+        r_data += 4;
+        n++;
+    }
+
+    if ((n == count) && last && (parity != get_parity_32bit(get_unaligned_le32(last)))) {
+        n--;
+        ack = SWD_ACK_OK | SWD_PARITY_ERROR;
+        swd_control.parity_errors++;
+    }
+    *done = n;
+    return ack;
+}
+
+// OFF "Instruction scheduling"
+static uint32_t swd_write_block_quick(uint32_t request, uint8_t *w_data, uint16_t count, uint16_t *done)
+{
+    uint_fast32_t ack = SWD_ACK_OK, parity, next, n = 0;
+    uint32_t request_byte = ((request << 1) & 0x1e) | 0x81 | (get_parity_4bit(request) << 5);
+
+    next = count ? get_parity_32bit(get_unaligned_le32(w_data)) : 0;
+    while (n < count) {
+        parity = next;
+        ack = swd_request_quick(request_byte);
+
+        if ((ack == SWD_ACK_OK) || swd_control.data_force) {
+            // TRN:[C]*trn
+            swd_clock_quick(swd_control.trn);
+
+            // Data:[W]*32
+            SWDIO_MO_SWCLK_SWITCH_AFPP();
+            swd_data_out_start(w_data);
+            if (n + 1 < count)
+                next = get_parity_32bit(get_unaligned_le32(w_data + 4));
+            swd_data_out_wait();
+
+            // Parity:[W]*1
+            SWDIO_MO_SWITCH_ANALOG_IN_SWCLK_SWITCH_OUTPP();
+            SWDIO_MO_SWITCH_OUTPP();
+            if (parity)
+                IO_SET(PERIPHERAL_GPIO_TMS_MO_IDX, PERIPHERAL_GPIO_TMS_MO_PIN);
+            else
+                IO_CLEAR(PERIPHERAL_GPIO_TMS_MO_IDX, PERIPHERAL_GPIO_TMS_MO_PIN);
+            IO_CLEAR(PERIPHERAL_GPIO_TCK_SWD_IDX, PERIPHERAL_GPIO_TCK_SWD_PIN);
+            IO_SET(PERIPHERAL_GPIO_TCK_SWD_IDX, PERIPHERAL_GPIO_TCK_SWD_PIN);
+
+            // Idle:[C]*idle
+            swd_clock_quick(swd_control.idle);
+            SWDIO_MO_SWITCH_ANALOG_IN();
+        } else if ((ack == SWD_ACK_WAIT) || (ack == SWD_ACK_FAULT)) {
+            // TRN:[C]*trn
+            swd_clock_quick(swd_control.trn);
+        } else {
+            // Data:[C]*32 --> Parity:[C]*1
+            swd_clock_quick(33);
+        }
+
+        if (ack == SWD_ACK_WAIT) {
+            ack = swd_write_redo(request, w_data);
+            if (ack != (SWD_ACK_OK | SWD_SUCCESS))
+                break;
+            if (n + 1 < count)
+                next = get_parity_32bit(get_unaligned_le32(w_data + 4));
+        } else if (ack != SWD_ACK_OK) {
+            break;
+        }
+        w_data += 4;
+        n++;
+    }
+
+    *done = n;
+    return ack;
+}
+
+static uint32_t swd_read_block_slow(uint32_t request, uint8_t *r_data, uint16_t count, uint16_t *done)
+{
+    uint32_t ack = SWD_ACK_OK | SWD_SUCCESS;
+    uint16_t n;
+
+    for (n = 0; n < count; n++, r_data += 4) {
+        ack = swd_read_slow(request, r_data);
+        if (ack == (SWD_ACK_OK | SWD_PARITY_ERROR))
+            swd_control.parity_errors++;
+        if (ack != (SWD_ACK_OK | SWD_SUCCESS))
+            break;
+    }
+    *done = n;
+    return ack;
+}
+
+static uint32_t swd_write_block_slow(uint32_t request, uint8_t *w_data, uint16_t count, uint16_t *done)
+{
+    uint32_t ack = SWD_ACK_OK | SWD_SUCCESS;
+    uint16_t n;
+
+    for (n = 0; n < count; n++, w_data += 4) {
+        ack = swd_write_slow(request, w_data);
+        if (ack != (SWD_ACK_OK | SWD_SUCCESS))
+            break;
+    }
+    *done = n;
+    return ack;
+}
+#endif
+
+uint32_t vsfhal_swd_get_retries(void)
+{
+    uint32_t retries = swd_control.wait_retries;
+    swd_control.wait_retries = 0;
+    return retries;
+}
+
+uint32_t vsfhal_swd_get_parity_errors(void)
+{
+    uint32_t errors = swd_control.parity_errors;
+    swd_control.parity_errors = 0;
+    return errors;
+}
+
 #if TIMESTAMP_CLOCK
 uint32_t vsfhal_swd_get_timestamp(void)
 {
+    #ifdef SWD_ASYNC
+    swd_finish();
+    #endif
     return swd_control.dap_timestamp;
 }
 #endif
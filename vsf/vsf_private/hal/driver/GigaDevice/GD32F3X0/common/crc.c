@@ -0,0 +1,52 @@
+/*============================ INCLUDES ======================================*/
+#include "crc.h"
+
+/*============================ MACROS ========================================*/
+
+#define CRC32_POLY                  0x04C11DB7UL
+#define CRC32_POLY_REFLECTED        0xEDB88320UL
+
+/*============================ MACROFIED FUNCTIONS ===========================*/
+/*============================ TYPES =========================================*/
+/*============================ GLOBAL VARIABLES ==============================*/
+/*============================ LOCAL VARIABLES ===============================*/
+/*============================ PROTOTYPES ====================================*/
+/*============================ IMPLEMENTATION ================================*/
+
+#if CRC_COUNT > 0
+
+static uint32_t crc32_byte(uint32_t crc, uint8_t data)
+{
+    crc ^= data;
+    for (uint_fast8_t i = 0; i < 8; i++)
+        crc = (crc & 1) ? ((crc >> 1) ^ CRC32_POLY_REFLECTED) : (crc >> 1);
+    return crc;
+}
+
+/*
+    The unit shifts MSB first, reversing the bits of every word written and
+    of the result gives the LSB first CRC-32. The register goes in reversed
+    by CRC_IDATA. Bytes before and after the aligned words by software.
+*/
+uint32_t vsfhal_crc32(uint32_t crc, uint8_t *buff, uint32_t size)
+{
+    crc = ~crc;
+    for (; size && ((uint32_t)buff & 0x3); size--)
+        crc = crc32_byte(crc, *buff++);
+
+    if (size >= 4) {
+        RCU_AHBEN |= RCU_AHBEN_CRCEN;
+        CRC_POLY = CRC32_POLY;
+        CRC_IDATA = __RBIT(crc);
+        CRC_CTL = CRC_CTL_PS_32 | CRC_INPUT_DATA_NOT | CRC_CTL_RST;
+        for (; size >= 4; size -= 4, buff += 4)
+            CRC_DATA = __RBIT(*(uint32_t *)buff);
+        crc = __RBIT(CRC_DATA);
+    }
+
+    while (size--)
+        crc = crc32_byte(crc, *buff++);
+    return ~crc;
+}
+
+#endif
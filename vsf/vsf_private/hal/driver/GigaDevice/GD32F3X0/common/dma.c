@@ -78,10 +78,14 @@ ROOT void DMA_Channel3_4_IRQHandler(void)
 
 ROOT void DMA_Channel5_6_IRQHandler(void)
 {
-    if (DMA_INTF & (DMA_INTF_GIF << (4 * 5)))
+    if (DMA_INTF & (DMA_INTF_GIF << (4 * 5))) {
+        DMA_INTC = DMA_INTC_GIFC << (4 * 5);
         dma_irqhandler(DMA0_IDX, 5);
-    if (DMA_INTF & (DMA_INTF_GIF << (4 * 6)))
+    }
+    if (DMA_INTF & (DMA_INTF_GIF << (4 * 6))) {
+        DMA_INTC = DMA_INTC_GIFC << (4 * 6);
         dma_irqhandler(DMA0_IDX, 6);
+    }
 }
 
 #endif
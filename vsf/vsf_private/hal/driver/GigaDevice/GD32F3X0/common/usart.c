@@ -1,6 +1,7 @@
 /*============================ INCLUDES ======================================*/
 
 #define __VSFSTREAM_CLASS_INHERIT__
+#define __VSF_FIFO_STREAM_CLASS_INHERIT__
 
 #include "usart.h"
 #include "io.h"
@@ -15,6 +16,9 @@
 #ifndef USART_BUFF_SIZE
 #   define USART_BUFF_SIZE              32
 #endif
+#ifndef USART_RX_FLUSH_US
+#   define USART_RX_FLUSH_US            200     // receiver timeout, passes on a partly filled rx block
+#endif
 
 /*============================ MACROFIED FUNCTIONS ===========================*/
 /*============================ TYPES =========================================*/
@@ -28,19 +32,25 @@ typedef struct usart_control_t {
     vsf_stream_t *tx;
     vsf_stream_t *rx;
     vsf_eda_t eda;
+    uint32_t stream_rx_dropped;     // bytes lost on a full rx stream
+    uint32_t stream_rx_marks;       // DMA half/full transfer count, for lap detection
+    uint32_t stream_rx_marks_seen;  // at the last time the DMA ring was emptied
+    uint16_t stream_rx_pos;         // direct rx: DMA position already written to the rx stream
+    uint16_t stream_rx_hold;        // direct rx: bytes at the tail read in place, kept on a resync
+    uint16_t stream_rx_fill;        // bytes in the block at the head of a block rx stream
+    uint16_t stream_tx_size;        // part of the tx stream the DMA is sending from
+    bool stream_rx_direct;          // direct rx: the DMA ring is the buffer of the rx stream
+    volatile bool stream_rx_posted;
+    volatile bool stream_rx_flush;  // line idle, a partly filled block is passed on
 #endif
     void (*ontx)(void *);
     void (*onrx)(void *);
     void *param;
     uint8_t tx_buff[USART_BUFF_SIZE];
     uint8_t rx_buff[USART_BUFF_SIZE * 2];
-#if USART_STREAM_ENABLE
-    uint8_t stream_rx_buff[USART_BUFF_SIZE];
-    uint8_t stream_rx_size;
-#endif
-    uint8_t rx_buff_w_pos;  // Non-DMA RX
-    uint8_t rx_buff_r_pos;
-    uint8_t tx_size;
+    uint16_t rx_buff_w_pos;  // Non-DMA RX
+    uint16_t rx_buff_r_pos;
+    uint16_t tx_size;
     uint8_t dma_idx;
     uint8_t tx_dma_ch;
     uint8_t rx_dma_ch;
@@ -80,7 +90,7 @@ static const IRQn_Type usart_irqn_list[USART_COUNT] = {
     USART0_IRQn,
     #endif  // USART0_ENABLE
     #if USART1_ENABLE
-    TIMER5_DAC_IRQn,
+    USART1_IRQn,
     #endif  // USART1_ENABLE
 };
 
@@ -147,21 +157,6 @@ void vsfhal_usart_fini(enum usart_idx_t idx)
     }
 }
 
-#if USART1_ENABLE
-static void enable_overtimer(uint32_t timer_clk)
-{
-    if (!(RCU_APB1EN & RCU_APB1EN_TIMER5EN)) {
-        RCU_APB1EN |= RCU_APB1EN_TIMER5EN;
-        TIMER_CTL0(TIMER5) = TIMER_CTL0_ARSE;
-        TIMER_DMAINTEN(TIMER5) = TIMER_DMAINTEN_UPIE;
-        TIMER_PSC(TIMER5) = timer_clk / 1000000 - 1;    // 1MHz
-        TIMER_CNT(TIMER5) = 1000;                       // 1KHz
-        TIMER_CAR(TIMER5) = 1000;
-        TIMER_CTL0(TIMER5) |= TIMER_CTL0_CEN;
-    }
-}
-#endif
-
 uint32_t vsfhal_usart_config(enum usart_idx_t idx, uint32_t baudrate, uint32_t mode)
 {
     VSF_HAL_ASSERT(idx < USART_IDX_NUM);
@@ -188,7 +183,7 @@ uint32_t vsfhal_usart_config(enum usart_idx_t idx, uint32_t baudrate, uint32_t m
         if (mode == USART_RESET_BAUD_ONLY) {
             USART_CTL0(usartx) &= ~USART_CTL0_UEN;
             USART_BAUD(usartx) = (temp + baudrate - 1) / baudrate;
-            USART_RT(usartx) = min(0xffffff, baudrate * 2 / 10000);      // 200us
+            USART_RT(usartx) = min(0xffffff, (uint64_t)baudrate * USART_RX_FLUSH_US / 1000000);
             USART_CTL0(usartx) |= USART_CTL0_UEN;
         } else {
             uint32_t div = (temp + baudrate - 1) / baudrate;
@@ -202,7 +197,7 @@ uint32_t vsfhal_usart_config(enum usart_idx_t idx, uint32_t baudrate, uint32_t m
         USART_CTL1(usartx) = ((mode << 8) & USART_CTL1_STB) | USART_CTL1_RTEN;
         USART_CTL1(usartx) |= mode & (USART_CTL1_MSBF | USART_CTL1_DINV | USART_CTL1_TINV | USART_CTL1_RINV);
         USART_CTL2(usartx) = (mode >> 4) & (USART_CTL2_CTSEN | USART_CTL2_RTSEN | USART_CTL2_HDEN);
-        USART_RT(usartx) = min(0xffffff, baudrate * 2 / 10000);      // 200us
+        USART_RT(usartx) = min(0xffffff, (uint64_t)baudrate * USART_RX_FLUSH_US / 1000000);
 
         switch (idx) {
         #if USART0_ENABLE
@@ -219,7 +214,8 @@ uint32_t vsfhal_usart_config(enum usart_idx_t idx, uint32_t baudrate, uint32_t m
             #if USART1_DMA_ENABLE
             dma_idx = DMA0_IDX;
             #endif
-            enable_overtimer(temp);
+            // no receiver timeout on USART1, the idle line ends a burst
+            USART_CTL0(usartx) |= USART_CTL0_IDLEIE;
             break;
         #endif
         }
@@ -285,26 +281,31 @@ void vsfhal_usart_config_cb(enum usart_idx_t idx, int32_t int_priority, void *p,
     }
 }
 
-uint16_t vsfhal_usart_tx_bytes(enum usart_idx_t idx, uint8_t *data, uint16_t size)
+static void usart_tx_start(usart_control_t *ctrl, uint8_t *buf, uint16_t size)
 {
-    VSF_HAL_ASSERT(idx < USART_IDX_NUM);
+    ctrl->tx_size = size;
 
-    uint8_t *tx_buff = usart_control[idx].tx_buff;
-    usart_control[idx].tx_size = size;
-    
-    if (usart_control[idx].dma_idx != DMA_INVALID_IDX) {
-        uint8_t tx_dma_ch = usart_control[idx].tx_dma_ch;
-
-        if (data)
-            memcpy(tx_buff, data, size);
+    if (ctrl->dma_idx != DMA_INVALID_IDX) {
+        uint8_t tx_dma_ch = ctrl->tx_dma_ch;
 
         DMA_CHxCTL(DMA, tx_dma_ch) &= ~DMA_CHXCTL_CHEN;
-        DMA_CHxMADDR(DMA, tx_dma_ch) = (uint32_t)tx_buff;
+        DMA_CHxMADDR(DMA, tx_dma_ch) = (uint32_t)buf;
         DMA_CHxCNT(DMA, tx_dma_ch) = size;
         DMA_CHxCTL(DMA, tx_dma_ch) |= DMA_CHXCTL_CHEN;
     } else {
         #warning "TODO"
     }
+}
+
+uint16_t vsfhal_usart_tx_bytes(enum usart_idx_t idx, uint8_t *data, uint16_t size)
+{
+    VSF_HAL_ASSERT(idx < USART_IDX_NUM);
+
+    uint8_t *tx_buff = usart_control[idx].tx_buff;
+
+    if (data)
+        memcpy(tx_buff, data, size);
+    usart_tx_start(&usart_control[idx], tx_buff, size);
 
     return size;
 }
@@ -322,23 +323,26 @@ uint16_t vsfhal_usart_rx_bytes(enum usart_idx_t idx, uint8_t *data, uint16_t siz
 
     uint_fast16_t end;
     usart_control_t *ctrl = &usart_control[idx];
-    size = vsfhal_usart_rx_get_data_size(idx);
-    size = min(size, size);
+    end = vsfhal_usart_rx_get_data_size(idx);
+    size = min(size, end);
     if (!size)
         return 0;
 
     end = min((USART_BUFF_SIZE * 2) - ctrl->rx_buff_r_pos, size);
     size = size - end;
 
+    // data NULL drops the bytes
     if (end) {
-        memcpy(data, ctrl->rx_buff + ctrl->rx_buff_r_pos, end);
+        if (data)
+            memcpy(data, ctrl->rx_buff + ctrl->rx_buff_r_pos, end);
         ctrl->rx_buff_r_pos = ctrl->rx_buff_r_pos + end;
         if (ctrl->rx_buff_r_pos == (USART_BUFF_SIZE * 2)) {
             ctrl->rx_buff_r_pos = 0;
         }
     }
     if (size) {
-        memcpy(data + end, ctrl->rx_buff, size);
+        if (data)
+            memcpy(data + end, ctrl->rx_buff, size);
         ctrl->rx_buff_r_pos = size;
     }
 
@@ -350,10 +354,10 @@ uint16_t vsfhal_usart_rx_get_data_size(enum usart_idx_t idx)
     VSF_HAL_ASSERT(idx < USART_IDX_NUM);
 
     usart_control_t *ctrl = &usart_control[idx];
-    uint_fast8_t rx_buff_w_pos, rx_buff_r_pos = ctrl->rx_buff_r_pos;
+    uint_fast16_t rx_buff_w_pos, rx_buff_r_pos = ctrl->rx_buff_r_pos;
 
     if (ctrl->dma_idx != DMA_INVALID_IDX) {
-        rx_buff_w_pos = USART_BUFF_SIZE * 2 - DMA_CHxCNT(DMA, ctrl->rx_dma_ch);
+        rx_buff_w_pos = (USART_BUFF_SIZE * 2 - DMA_CHxCNT(DMA, ctrl->rx_dma_ch)) % (USART_BUFF_SIZE * 2);
     } else {
         rx_buff_w_pos = ctrl->rx_buff_w_pos;
     }
@@ -388,65 +392,219 @@ ROOT void USART0_IRQHandler(void)
 {
     if (USART_STAT(USART0_BASE) & USART_STAT_RTF) {
         USART_INTC(USART0_BASE) = USART_INTC_RTC;
+        #if USART_STREAM_ENABLE
+        usart_control[USART0_IDX].stream_rx_flush = true;
+        #endif
         usart_rx_done(&usart_control[USART0_IDX]);
     }
 }
 #endif
 
 #if USART1_ENABLE
-ROOT void TIMER5_DAC_IRQHandler(void)
+ROOT void USART1_IRQHandler(void)
 {
-    TIMER_INTF(TIMER5) = 0;
-    if (vsfhal_usart_rx_get_data_size(USART1_IDX))
+    if (USART_STAT(USART1_BASE) & USART_STAT_IDLEF) {
+        USART_INTC(USART1_BASE) = USART_INTC_IDLEC;
+        #if USART_STREAM_ENABLE
+        usart_control[USART1_IDX].stream_rx_flush = true;
+        #endif
         usart_rx_done(&usart_control[USART1_IDX]);
+    }
 }
 #endif  // USART1_ENABLE
 
 #if USART_STREAM_ENABLE
 
+// the DMA sends straight out of the tx stream, the part is released once it is out
 static void stream_dotx(usart_control_t *ctrl, vsf_stream_t *stream)
 {
+    uint8_t *buf;
     uint32_t size;
-    enum usart_idx_t idx = ((uint32_t)ctrl - (uint32_t)usart_control) / sizeof(usart_control_t);
 
-    size = vsfhal_usart_tx_get_free_size(idx);
+    if (ctrl->tx_size)
+        return;
+
+    if (ctrl->stream_tx_size) {
+        VSF_STREAM_READ(stream, NULL, ctrl->stream_tx_size);
+        ctrl->stream_tx_size = 0;
+    }
+    size = VSF_STREAM_GET_RBUF(stream, &buf);
     if (size) {
-        if (stream->op == &vsf_fifo_stream_op) {
-            uint8_t buf[USART_BUFF_SIZE];
-            size = VSF_STREAM_READ(stream, buf, size);
-            if (size)
-                vsfhal_usart_tx_bytes(idx, buf, size);
-        } else if (stream->op == &vsf_block_stream_op) {
-            uint8_t *buf;
-            size = VSF_STREAM_GET_RBUF(stream, &buf);
-            if (size) {
-                memcpy(usart_control[idx].tx_buff, buf, size);
-                VSF_STREAM_READ(stream, buf, size);
-                vsfhal_usart_tx_bytes(idx, NULL, size);
-            }
-        }
+        ctrl->stream_tx_size = min(size, 0xffff);
+        usart_tx_start(ctrl, buf, ctrl->stream_tx_size);
     }
 }
 
+// lap detection, the DMA went round the ring since it was last emptied
+static bool stream_rx_lapped(usart_control_t *ctrl, uint32_t marks)
+{
+    return (ctrl->dma_idx != DMA_INVALID_IDX) && (marks - ctrl->stream_rx_marks_seen > 2);
+}
+
+/*
+    Received bytes wait in the rx ring until the rx stream has room, and go
+    from there into its write buffer. A block stream gets full blocks, a
+    block is only passed on partly filled when the line goes idle.
+*/
 static void stream_dorx(usart_control_t *ctrl, vsf_stream_t *stream)
 {
-    uint32_t size;
     enum usart_idx_t idx = ((uint32_t)ctrl - (uint32_t)usart_control) / sizeof(usart_control_t);
+    bool is_block = stream->op == &vsf_block_stream_op;
+    bool flush = ctrl->stream_rx_flush;
+    uint32_t marks = ctrl->stream_rx_marks;
+    uint32_t size, block_size;
+    uint8_t *buf;
+
+    ctrl->stream_rx_posted = false;
+    ctrl->stream_rx_flush = false;
+
+    if (stream_rx_lapped(ctrl, marks)) {
+        ctrl->stream_rx_dropped += USART_BUFF_SIZE * 2;
+        vsfhal_usart_rx_bytes(idx, NULL, USART_BUFF_SIZE * 2);
+    }
+    if (!VSF_STREAM_IS_RX_CONNECTED(stream)) {
+        vsfhal_usart_rx_bytes(idx, NULL, USART_BUFF_SIZE * 2);
+        ctrl->stream_rx_marks_seen = marks;
+        return;
+    }
 
-    if (stream->op == &vsf_fifo_stream_op) {
-        size = ctrl->stream_rx_size;
-        if (size && VSF_STREAM_IS_RX_CONNECTED(stream))
-            VSF_STREAM_WRITE(stream, ctrl->stream_rx_buff, size);
-    } else if (stream->op == &vsf_block_stream_op) {
-        uint8_t *buf;
-        size = VSF_STREAM_GET_WBUF(stream, &buf);
-        size = min(size, ctrl->stream_rx_size);
-        if (size && VSF_STREAM_IS_RX_CONNECTED(stream)) {
-            memcpy(buf, ctrl->stream_rx_buff, size);
-            VSF_STREAM_WRITE(stream, buf, size);
+    while (1) {
+        block_size = VSF_STREAM_GET_WBUF(stream, &buf);
+        size = block_size;
+        if (is_block && size) {
+            buf += ctrl->stream_rx_fill;
+            size -= ctrl->stream_rx_fill;
         }
+        size = vsfhal_usart_rx_bytes(idx, buf, size);
+        if (!size)
+            break;
+
+        if (is_block) {
+            ctrl->stream_rx_fill += size;
+            if (ctrl->stream_rx_fill == block_size) {
+                VSF_STREAM_WRITE(stream, NULL, block_size);
+                ctrl->stream_rx_fill = 0;
+            }
+        } else {
+            VSF_STREAM_WRITE(stream, NULL, size);
+        }
+    }
+
+    if (!vsfhal_usart_rx_get_data_size(idx)) {
+        ctrl->stream_rx_marks_seen = marks;
+        if (flush && ctrl->stream_rx_fill) {
+            VSF_STREAM_WRITE(stream, NULL, ctrl->stream_rx_fill);
+            ctrl->stream_rx_fill = 0;
+        }
+    }
+}
+
+static void stream_rx_dma_done(void *p)
+{
+    usart_control_t *ctrl = p;
+
+    ctrl->stream_rx_marks++;
+    usart_rx_done(p);
+}
+
+/*
+    Direct rx: the rx DMA runs circularly over the buffer of a fifo stream,
+    received bytes are only published by moving the head of the fifo. The
+    DMA can not be held on a full fifo, so once it laps the reader or more
+    arrived than the fifo has room for, the unread bytes are overwritten.
+    The fifo is then restarted at the DMA position, the unread and the
+    unpublished bytes are counted as dropped, and the reader gets a
+    discontinuity in the same way as from a lost block. A reader sending
+    from the fifo in place announces that part with
+    vsfhal_usart_stream_rx_hold(), it stays in the fifo for the read that
+    follows, but may be overwritten already.
+*/
+
+static void stream_rx_direct_start(usart_control_t *ctrl, vsf_fifo_stream_t *fifo)
+{
+    uint8_t rx_dma_ch = ctrl->rx_dma_ch;
+
+    VSF_HAL_ASSERT(fifo->size <= 0xffff);
+
+    // DMA position 0 is the head of the fifo, unread data is discarded
+    vsf_gint_state_t gint_state = vsf_disable_interrupt();
+    fifo->head = fifo->tail = 0;
+    vsf_set_interrupt(gint_state);
+
+    DMA_CHxCTL(DMA, rx_dma_ch) &= ~DMA_CHXCTL_CHEN;
+    DMA_CHxMADDR(DMA, rx_dma_ch) = (uint32_t)fifo->buffer;
+    DMA_CHxCNT(DMA, rx_dma_ch) = fifo->size;
+    DMA_CHxCTL(DMA, rx_dma_ch) |= DMA_CHXCTL_CHEN;
+
+    ctrl->stream_rx_pos = 0;
+    ctrl->stream_rx_hold = 0;
+    ctrl->stream_rx_marks = ctrl->stream_rx_marks_seen = 0;
+    ctrl->stream_rx_posted = false;
+    ctrl->stream_rx_direct = true;
+}
+
+static void stream_rx_direct_stop(usart_control_t *ctrl)
+{
+    uint8_t rx_dma_ch = ctrl->rx_dma_ch;
+
+    ctrl->stream_rx_direct = false;
+
+    DMA_CHxCTL(DMA, rx_dma_ch) &= ~DMA_CHXCTL_CHEN;
+    DMA_CHxMADDR(DMA, rx_dma_ch) = (uint32_t)ctrl->rx_buff;
+    DMA_CHxCNT(DMA, rx_dma_ch) = USART_BUFF_SIZE * 2;
+    DMA_CHxCTL(DMA, rx_dma_ch) |= DMA_CHXCTL_CHEN;
+    ctrl->rx_buff_r_pos = 0;
+}
+
+static void stream_dorx_direct(usart_control_t *ctrl, vsf_stream_t *stream)
+{
+    vsf_fifo_stream_t *fifo = (vsf_fifo_stream_t *)stream;
+    uint32_t size = fifo->size;
+    uint32_t pos, marks, len, unread, hold;
+    vsf_gint_state_t gint_state;
+    bool lapped;
+
+    ctrl->stream_rx_posted = false;
+    ctrl->stream_rx_flush = false;
+    marks = ctrl->stream_rx_marks;
+    pos = (size - DMA_CHxCNT(DMA, ctrl->rx_dma_ch)) % size;
+    len = (pos + size - ctrl->stream_rx_pos) % size;
+    lapped = stream_rx_lapped(ctrl, marks);
+
+    if (!VSF_STREAM_IS_RX_CONNECTED(stream)) {
+        if (lapped) {
+            // a mark is half of the ring, the marks past a full ring were overwritten
+            ctrl->stream_rx_dropped += (marks - ctrl->stream_rx_marks_seen - 2) * (size / 2);
+            ctrl->stream_rx_marks_seen = marks;
+        }
+        return;
     }
-    ctrl->stream_rx_size = 0;
+
+    if (!lapped && (len <= VSF_STREAM_GET_FREE_SIZE(stream))) {
+        ctrl->stream_rx_marks_seen = marks;
+        if (len) {
+            VSF_STREAM_WRITE(stream, NULL, len);
+            ctrl->stream_rx_pos = pos;
+        }
+        return;
+    }
+
+    // resync, the reader may take bytes out of the fifo meanwhile
+    gint_state = vsf_disable_interrupt();
+    unread = VSF_STREAM_GET_DATA_SIZE(stream);
+    hold = min(ctrl->stream_rx_hold, unread);
+    fifo->head = pos;
+    fifo->tail = (pos + size - hold) % size;
+    vsf_set_interrupt(gint_state);
+
+    // unread and unpublished bytes, a lap only known in half rings
+    ctrl->stream_rx_dropped += unread - hold;
+    if (lapped)
+        ctrl->stream_rx_dropped += (marks - ctrl->stream_rx_marks_seen) * (size / 2);
+    else
+        ctrl->stream_rx_dropped += len;
+    ctrl->stream_rx_marks_seen = marks;
+    ctrl->stream_rx_pos = pos;
 }
 
 enum {
@@ -472,9 +630,17 @@ static void usart_stream_evthandler(vsf_eda_t *eda, vsf_evt_t evt)
         }
         break;
     case VSF_EVT_RX_STREAM_ONRX:
-        stream_dorx(ctrl, rx_stream);
+        if (ctrl->stream_rx_direct)
+            stream_dorx_direct(ctrl, rx_stream);
+        else
+            stream_dorx(ctrl, rx_stream);
         break;
     case VSF_EVT_RX_STREAM_ONTX:
+        // bytes held back on a full stream can go now
+        if (ctrl->stream_rx_direct)
+            stream_dorx_direct(ctrl, rx_stream);
+        else
+            stream_dorx(ctrl, rx_stream);
         if (VSF_STREAM_GET_DATA_SIZE(rx_stream)) {
             // used to call __vsf_stream_on_write
             vsf_stream_set_rx_threshold(rx_stream, rx_stream->rx.threshold);
@@ -510,15 +676,9 @@ static void stream_ontx(void *param)
 static void stream_onrx(void *param)
 {
     usart_control_t *ctrl = param;
-    if (ctrl->stream_rx_size == 0) {
-        uint32_t size;
-        enum usart_idx_t idx = ((uint32_t)ctrl - (uint32_t)usart_control) / sizeof(usart_control_t);
-        size = vsfhal_usart_rx_get_data_size(idx);
-        size = min(size, USART_BUFF_SIZE);
-        if (size) {
-            ctrl->stream_rx_size = vsfhal_usart_rx_bytes(idx, ctrl->stream_rx_buff, size);
-            vsf_eda_post_evt(&ctrl->eda, VSF_EVT_RX_STREAM_ONRX);
-        }
+    if (!ctrl->stream_rx_posted) {
+        ctrl->stream_rx_posted = true;
+        vsf_eda_post_evt(&ctrl->eda, VSF_EVT_RX_STREAM_ONRX);
     }
 }
 
@@ -526,6 +686,11 @@ static void vsfhal_usart_stream_fini(enum usart_idx_t idx)
 {
     if (usart_control[idx].tx || usart_control[idx].rx)
         vsfhal_usart_config_cb(idx, 0, NULL, NULL, NULL);
+    if (usart_control[idx].stream_rx_direct)
+        stream_rx_direct_stop(&usart_control[idx]);
+    // parts held by the DMA belong to the old streams
+    usart_control[idx].stream_tx_size = 0;
+    usart_control[idx].stream_rx_fill = 0;
     if (usart_control[idx].tx) {
         VSF_STREAM_DISCONNECT_RX(usart_control[idx].tx);
         usart_control[idx].tx->rx.evthandler = NULL;
@@ -553,7 +718,13 @@ void vsfhal_usart_stream_config(enum usart_idx_t idx, int32_t eda_priority, int3
 
     usart_control[idx].tx = tx;
     usart_control[idx].rx = rx;
+    // fifo rx streams take the received bytes in place, other streams get a copy
+    if (rx && (rx->op == &vsf_fifo_stream_op) && (usart_control[idx].dma_idx != DMA_INVALID_IDX))
+        stream_rx_direct_start(&usart_control[idx], (vsf_fifo_stream_t *)rx);
     vsfhal_usart_config_cb(idx, int_priority, &usart_control[idx], stream_ontx, stream_onrx);
+    if (usart_control[idx].dma_idx != DMA_INVALID_IDX)
+        vsf_dma_config_channel(usart_control[idx].dma_idx, usart_control[idx].rx_dma_ch,
+                stream_rx_dma_done, &usart_control[idx], int_priority);
 
     if (tx) {
         tx->rx.evthandler = tx_stream_rx_evthandler;
@@ -566,6 +737,19 @@ void vsfhal_usart_stream_config(enum usart_idx_t idx, int32_t eda_priority, int3
         VSF_STREAM_CONNECT_TX(rx);
     }
 }
+
+uint32_t vsfhal_usart_stream_get_dropped(enum usart_idx_t idx)
+{
+    uint32_t dropped = usart_control[idx].stream_rx_dropped;
+    usart_control[idx].stream_rx_dropped = 0;
+    return dropped;
+}
+
+// size bytes at the tail of a direct rx stream are read in place, 0 when done
+void vsfhal_usart_stream_rx_hold(enum usart_idx_t idx, uint32_t size)
+{
+    usart_control[idx].stream_rx_hold = size;
+}
 #endif
 
 #endif
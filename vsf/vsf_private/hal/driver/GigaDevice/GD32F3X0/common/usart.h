@@ -20,6 +20,11 @@
 
 #define USART_COUNT                     (0 + USART0_ENABLE + USART1_ENABLE)
 
+#if USART_STREAM_ENABLE
+// fifo rx streams are received in place, see vsfhal_usart_stream_rx_hold()
+#   define USART_STREAM_RX_DIRECT
+#endif
+
 /*============================ MACROFIED FUNCTIONS ===========================*/
 /*============================ TYPES =========================================*/
 
@@ -72,6 +77,8 @@ uint16_t vsfhal_usart_rx_bytes(enum usart_idx_t idx, uint8_t *data, uint16_t siz
 uint16_t vsfhal_usart_rx_get_data_size(enum usart_idx_t idx);
 #if USART_STREAM_ENABLE
 void vsfhal_usart_stream_config(enum usart_idx_t idx, int32_t eda_priority, int32_t int_priority, vsf_stream_t *tx, vsf_stream_t *rx);
+uint32_t vsfhal_usart_stream_get_dropped(enum usart_idx_t idx);
+void vsfhal_usart_stream_rx_hold(enum usart_idx_t idx, uint32_t size);
 #endif
 #endif
 
@@ -12,6 +12,7 @@
 #       include "hal/vsf_hal_cfg.h"
 #       include "./device.h"
 #       include "./common/usb/usb.h"
+#       include "./common/crc.h"
 #       include "./common/dma.h"
 #       include "./common/flash.h"
 #       include "./common/io.h"
@@ -19,6 +20,7 @@
 #       include "./common/usart.h"
 #       include "./jtag.h"
 #       include "./swd.h"
+#       include "./swo.h"
 #       include "./timestamp.h"
 
 /*============================ MACROS ========================================*/
@@ -34,6 +34,7 @@ typedef struct jtag_control_t {
 	uint8_t idle;
     uint16_t retry_limit;
     uint16_t delay_tick;
+    uint32_t wait_retries;          // scans repeated after WAIT
 
     #if TIMESTAMP_CLOCK
     uint32_t dap_timestamp;
@@ -41,6 +42,18 @@ typedef struct jtag_control_t {
     void (*jtag_rw)(uint32_t bits, uint8_t *tms, uint8_t *tdi, uint8_t *tdo);
     void (*jtag_rw_dr)(uint32_t dma_bytes, uint32_t bits_tail, uint8_t *tms, uint8_t *tdi, uint8_t *tdo);
     void (*jtag_delay)(uint16_t delay_tick);
+
+    #ifdef JTAG_ASYNC
+    uint32_t status;
+    bool finish;
+    uint8_t finish_ack_pos;
+    uint8_t finish_bitlen;
+    uint8_t finish_pos;
+    uint8_t finish_spi_bytes;
+    uint8_t *finish_tms;
+    uint8_t *finish_tdi;
+    uint8_t *finish_tdo;
+    #endif
 } jtag_control_t;
 
 #if JTAG_COUNT > 0
@@ -51,6 +64,9 @@ static void jtag_rw_quick(uint32_t bitlen, uint8_t *tms, uint8_t *tdi, uint8_t *
 static void jtag_rw_slow(uint32_t bitlen, uint8_t *tms, uint8_t *tdi, uint8_t *tdo);
 static void jtag_rw_dr_quick(uint32_t bytelen_dma, uint32_t bitlen_tail, uint8_t *tms, uint8_t *tdi, uint8_t *tdo);
 static void jtag_rw_dr_slow(uint32_t bytelen_dma, uint32_t bitlen_tail, uint8_t *tms, uint8_t *tdi, uint8_t *tdo);
+#ifdef JTAG_ASYNC
+static void jtag_finish(void);
+#endif
 
 void vsfhal_jtag_init(int32_t int_priority)
 {
@@ -76,6 +92,9 @@ void vsfhal_jtag_init(int32_t int_priority)
     }
 
     memset(&jtag_control, 0, sizeof(jtag_control_t));
+    #ifdef JTAG_ASYNC
+    jtag_control.status = DAP_TRANSFER_OK;
+    #endif
 }
 
 void vsfhal_jtag_fini(void)
@@ -215,6 +234,10 @@ void vsfhal_jtag_config(uint16_t kHz, uint16_t retry, uint8_t idle)
 {
     uint32_t temp, apb;
     vsfhal_clk_info_t *info = vsfhal_clk_info_get();
+
+    #ifdef JTAG_ASYNC
+    jtag_finish();
+    #endif
     
     if (kHz < spi_khz_and_apb_clk_table_list[dimof(spi_khz_and_apb_clk_table_list) - 1][1])
         kHz = spi_khz_and_apb_clk_table_list[dimof(spi_khz_and_apb_clk_table_list) - 1][1];
@@ -263,9 +286,21 @@ void vsfhal_jtag_config(uint16_t kHz, uint16_t retry, uint8_t idle)
     SPI_CTL0(JTAG_SPI_BASE) &= ~(SPI_CTL0_SPIEN | SPI_CTL0_PSC | SPI_CTL0_BDEN | SPI_CTL0_CRCEN | SPI_CTL0_FF16);
     SPI_CTL0(JTAG_SPI_BASE) |= temp << 3;
     SPI_CTL0(JTAG_SPI_BASE) |= SPI_CTL0_MSTMOD | SPI_CTL0_SWNSSEN | SPI_CTL0_SWNSS | SPI_CTL0_LF | SPI_CTL0_CKPL | SPI_CTL0_CKPH;
+    #if defined(JTAG_ASYNC) && defined(JTAG_SPI_DMAX)
+    SPI_CTL1(JTAG_SPI_BASE) = SPI_CTL1_DMAREN | SPI_CTL1_DMATEN;
+    #endif
     SPI_CTL0(JTAG_SPI_BASE) |= SPI_CTL0_SPIEN;
+
+    #if defined(JTAG_ASYNC) && defined(JTAG_SPI_DMAX)
+    // DMA TX RX channel config, only used by the async scans
+    DMA_CHxCTL(JTAG_SPI_DMAX, JTAG_SPI_RX_DMA_CH) = DMA_CHXCTL_MNAGA | DMA_CHXCTL_PRIO;
+    DMA_CHxCTL(JTAG_SPI_DMAX, JTAG_SPI_TX_DMA_CH) = DMA_CHXCTL_DIR | DMA_CHXCTL_MNAGA | DMA_CHXCTL_PRIO;
+    DMA_CHxPADDR(JTAG_SPI_DMAX, JTAG_SPI_RX_DMA_CH) = JTAG_SPI_BASE + 0xc;
+    DMA_CHxPADDR(JTAG_SPI_DMAX, JTAG_SPI_TX_DMA_CH) = JTAG_SPI_BASE + 0xc;
+    #endif
 }
 
+#ifdef JTAG_SYNC
 void vsfhal_jtag_raw(uint32_t bitlen, uint8_t *tms, uint8_t *tdi, uint8_t *tdo)
 {
     jtag_control.jtag_rw(bitlen, tms, tdi, tdo);
@@ -369,6 +404,8 @@ uint32_t vsfhal_jtag_dr(uint32_t request, uint32_t dr, uint32_t dr_before, uint3
 
     do
     {
+        if (retry)
+            jtag_control.wait_retries++;
         jtag_control.jtag_rw_dr(dma_bytes, bits_tail, (uint8_t *)&buf_tms, (uint8_t *)&buf_tdi, (uint8_t *)&buf_tdo);
         ack = (buf_tdo >> (dr_before + 3)) & 0x7;
         ack = (ack & 0x4) | ((ack & 0x2) >> 1) | ((ack & 0x1) << 1);
@@ -380,6 +417,179 @@ uint32_t vsfhal_jtag_dr(uint32_t request, uint32_t dr, uint32_t dr_before, uint3
         put_unaligned_le32(buf_tdo >> (dr_before + 6), data);
     return ack;
 }
+#endif
+
+#ifdef JTAG_ASYNC
+/*
+    Asynchronous mode.
+
+    vsfhal_jtag_raw clocks the first byte of the scan by GPIO, puts the bytes
+    after it with a constant TMS level (the Shift-DR/Shift-IR body of a scan,
+    or a TMS run of a sequence) on the SPI and returns; the SPI is moved by
+    DMA when JTAG_SPI_DMAX is configured, otherwise only its last byte is left
+    on the wire. The rest of the scan is clocked by jtag_finish when the next
+    scan is issued or in vsfhal_jtag_wait, so the caller builds the next scan
+    while the current one is on the wire. The tms/tdi/tdo buffers of a scan
+    must stay valid until then.
+
+    With ack_pos, the 3-bit JTAG-DP ACK at that bit of tdo is checked in
+    jtag_finish and the whole scan is repeated on WAIT. A failed ACK sticks in
+    status and is returned by every call until vsfhal_jtag_clear; scans issued
+    after it are dropped.
+*/
+#ifdef JTAG_SPI_DMAX
+static void jtag_spi_start(uint8_t *tdi, uint8_t *tdo, uint32_t bytes)
+{
+    uint32_t temp = SPI_DATA(JTAG_SPI_BASE);    // clear rx buffer
+
+    DMA_CHxCTL(JTAG_SPI_DMAX, JTAG_SPI_RX_DMA_CH) = DMA_CHXCTL_MNAGA | DMA_CHXCTL_PRIO;
+    DMA_CHxMADDR(JTAG_SPI_DMAX, JTAG_SPI_RX_DMA_CH) = (uint32_t)tdo;
+    DMA_CHxCNT(JTAG_SPI_DMAX, JTAG_SPI_RX_DMA_CH) = bytes;
+    DMA_CHxCTL(JTAG_SPI_DMAX, JTAG_SPI_RX_DMA_CH) = DMA_CHXCTL_CHEN | DMA_CHXCTL_MNAGA | DMA_CHXCTL_PRIO;
+    DMA_CHxCTL(JTAG_SPI_DMAX, JTAG_SPI_TX_DMA_CH) = DMA_CHXCTL_DIR | DMA_CHXCTL_MNAGA | DMA_CHXCTL_PRIO;
+    DMA_CHxMADDR(JTAG_SPI_DMAX, JTAG_SPI_TX_DMA_CH) = (uint32_t)tdi;
+    DMA_CHxCNT(JTAG_SPI_DMAX, JTAG_SPI_TX_DMA_CH) = bytes;
+    DMA_CHxCTL(JTAG_SPI_DMAX, JTAG_SPI_TX_DMA_CH) = DMA_CHXCTL_CHEN | DMA_CHXCTL_DIR | DMA_CHXCTL_MNAGA | DMA_CHXCTL_PRIO;
+}
+
+static void jtag_spi_wait(uint8_t *tdo, uint32_t bytes)
+{
+    while (DMA_CHxCNT(JTAG_SPI_DMAX, JTAG_SPI_RX_DMA_CH));
+}
+#else
+static void jtag_spi_start(uint8_t *tdi, uint8_t *tdo, uint32_t bytes)
+{
+    while (--bytes) {
+        SPI_DATA(JTAG_SPI_BASE) = *tdi++;
+        while (SPI_STAT(JTAG_SPI_BASE) & SPI_STAT_TRANS);
+        *tdo++ = SPI_DATA(JTAG_SPI_BASE);
+    }
+    SPI_DATA(JTAG_SPI_BASE) = *tdi;
+}
+
+static void jtag_spi_wait(uint8_t *tdo, uint32_t bytes)
+{
+    while (SPI_STAT(JTAG_SPI_BASE) & SPI_STAT_TRANS);
+    tdo[bytes - 1] = SPI_DATA(JTAG_SPI_BASE);
+}
+#endif
+
+static uint32_t jtag_get_ack(uint8_t *tdo, uint32_t ack_pos)
+{
+    uint32_t ack;
+
+    ack = tdo[ack_pos >> 3] | ((uint32_t)tdo[(ack_pos >> 3) + 1] << 8);
+    ack = (ack >> (ack_pos & 0x7)) & 0x7;
+    return (ack & 0x4) | ((ack & 0x2) >> 1) | ((ack & 0x1) << 1);
+}
+
+// clock out the rest of the scan left on the wire by the last vsfhal_jtag_raw
+static void jtag_finish(void)
+{
+    uint_fast32_t ack, retry, pos, bitlen;
+    uint8_t *tms, *tdi, *tdo;
+
+    if (!jtag_control.finish)
+        return;
+    jtag_control.finish = false;
+
+    bitlen = jtag_control.finish_bitlen;
+    pos = jtag_control.finish_pos;
+    tms = jtag_control.finish_tms;
+    tdi = jtag_control.finish_tdi;
+    tdo = jtag_control.finish_tdo;
+
+    if (jtag_control.finish_spi_bytes) {
+        jtag_spi_wait(tdo + 1, jtag_control.finish_spi_bytes);
+        jtag_set_io_mode();
+    }
+    if (pos < bitlen)
+        jtag_control.jtag_rw(bitlen - pos, tms + (pos >> 3), tdi + (pos >> 3), tdo + (pos >> 3));
+
+    if (jtag_control.finish_ack_pos) {
+        retry = 0;
+        ack = jtag_get_ack(tdo, jtag_control.finish_ack_pos);
+        while ((ack == DAP_TRANSFER_WAIT) && (retry++ < jtag_control.retry_limit)) {
+            jtag_control.wait_retries++;
+            jtag_control.jtag_rw(bitlen, tms, tdi, tdo);
+            ack = jtag_get_ack(tdo, jtag_control.finish_ack_pos);
+        }
+        if (ack != DAP_TRANSFER_OK)
+            jtag_control.status = ack;
+    }
+}
+
+uint32_t vsfhal_jtag_raw(uint8_t ack_pos, uint8_t bitlen, uint8_t *tms, uint8_t *tdi, uint8_t *tdo)
+{
+    uint_fast32_t bytes;
+    uint8_t tms_level;
+
+    jtag_finish();
+    if (jtag_control.status != DAP_TRANSFER_OK)
+        return jtag_control.status;
+
+    #if TIMESTAMP_CLOCK
+    if (ack_pos)     // DAP transfer
+        jtag_control.dap_timestamp = vsfhal_timestamp_get();
+    #endif
+
+    jtag_control.finish_ack_pos = ack_pos;
+    jtag_control.finish_bitlen = bitlen;
+    jtag_control.finish_tms = tms;
+    jtag_control.finish_tdi = tdi;
+    jtag_control.finish_tdo = tdo;
+    jtag_control.finish = true;
+
+    if (bitlen < 16) {
+        jtag_control.finish_pos = 0;
+        jtag_control.finish_spi_bytes = 0;
+        return jtag_control.status;
+    }
+
+    // head, leaves TMS at the level of its last bit
+    jtag_control.jtag_rw(8, tms, tdi, tdo);
+
+    // SPI, whole bytes while TMS keeps that level
+    tms_level = (tms[0] & 0x80) ? 0xff : 0x00;
+    for (bytes = 0; ((bytes + 2) << 3) <= bitlen; bytes++) {
+        if (tms[bytes + 1] != tms_level)
+            break;
+    }
+    jtag_control.finish_pos = 8 + (bytes << 3);
+    jtag_control.finish_spi_bytes = bytes;
+    if (bytes) {
+        jtag_set_spi_mode();
+        jtag_spi_start(tdi + 1, tdo + 1, bytes);
+    }
+    return jtag_control.status;
+}
+
+uint32_t vsfhal_jtag_raw_less_8bit(uint32_t bitlen, uint32_t tms, uint32_t tdi)
+{
+    uint8_t tms_byte = tms, tdi_byte = tdi, tdo_byte;
+
+    jtag_finish();
+    jtag_control.jtag_rw(bitlen, &tms_byte, &tdi_byte, &tdo_byte);
+    return tdo_byte;
+}
+
+uint32_t vsfhal_jtag_raw_1bit(uint32_t tms, uint32_t tdi)
+{
+    return vsfhal_jtag_raw_less_8bit(1, tms ? 0x1 : 0x0, tdi ? 0x1 : 0x0);
+}
+
+uint32_t vsfhal_jtag_wait(void)
+{
+    jtag_finish();
+    return jtag_control.status;
+}
+
+void vsfhal_jtag_clear(void)
+{
+    jtag_finish();
+    jtag_control.status = DAP_TRANSFER_OK;
+}
+#endif
 
 // OFF "Instruction scheduling"
 static void jtag_rw_quick(uint32_t bitlen, uint8_t *tms, uint8_t *tdi, uint8_t *tdo)
@@ -719,6 +929,13 @@ static void jtag_rw_dr_slow(uint32_t bytelen_dma, uint32_t bitlen_tail, uint8_t
     }
 }
 
+uint32_t vsfhal_jtag_get_retries(void)
+{
+    uint32_t retries = jtag_control.wait_retries;
+    jtag_control.wait_retries = 0;
+    return retries;
+}
+
 #if TIMESTAMP_CLOCK
 uint32_t vsfhal_jtag_get_timestamp(void)
 {
@@ -17,6 +17,9 @@
 #define SWD_SYNC
 //#define SWD_ASYNC
 
+// block transfers for ID_DAP_TransferBlock, in both modes
+#define SWD_BLOCK
+
 /*============================ MACROFIED FUNCTIONS ===========================*/
 /*============================ TYPES =========================================*/
 /*============================ GLOBAL VARIABLES ==============================*/
@@ -33,10 +36,16 @@ void vsfhal_swd_seqout(uint8_t *data, uint32_t bitlen);
 void vsfhal_swd_seqin(uint8_t *data, uint32_t bitlen);
 uint32_t vsfhal_swd_read(uint32_t request, uint8_t *r_data);
 uint32_t vsfhal_swd_write(uint32_t request, uint8_t *w_data);
+#ifdef SWD_BLOCK
+uint32_t vsfhal_swd_read_block(uint32_t request, uint8_t *r_data, uint16_t count, uint16_t *done);
+uint32_t vsfhal_swd_write_block(uint32_t request, uint8_t *w_data, uint16_t count, uint16_t *done);
+#endif
 #ifdef SWD_ASYNC
 uint32_t vsfhal_swd_wait(void);
 void vsfhal_swd_clear(void);
 #endif
+uint32_t vsfhal_swd_get_retries(void);
+uint32_t vsfhal_swd_get_parity_errors(void);
 #if TIMESTAMP_CLOCK
 uint32_t vsfhal_swd_get_timestamp(void);
 #endif
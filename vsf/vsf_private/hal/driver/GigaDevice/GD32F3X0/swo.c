@@ -0,0 +1,330 @@
+/*
+Manchester SWO, as sent by the TPIU:
+    idle low, every bit has a transition in its middle: falling for 1, rising for 0
+    Start:[1] --> Data:[8]*n, LSB first --> Low for at least one bit
+
+TIMER1_CH3 captures both edges, DMA stores the 16bit timestamps in a ring.
+The decoder only looks at the distance to the last mid-bit edge:
+    < 1.5 half bit: edge on a bit boundary, skipped
+    < 2.5 half bit: next mid-bit edge, its direction is the bit
+    more:           end of packet
+The half bit is tracked on start bits and mid-bit edges, so the target clock
+may be off the nominal baudrate, and every mid-bit edge resyncs the decoder.
+
+CH0 compares at each half turn of the counter, half a turn without edges means
+the line is idle and the next edge starts a packet, a long gap can not alias.
+*/
+
+#include "swo.h"
+#include "./common/io.h"
+#include "./common/dma.h"
+#include "vsf.h"
+
+#if SWO_MANCHESTER_ENABLE
+
+#define SWO_TIMER                   TIMER1
+#define SWO_TICK_MAX_HZ             64000000    // 10 ticks a half bit at 3.2M, idle poll at 2KHz or slower
+#define SWO_HALF_MAX_TICKS          4096        // 2.5 x 2 half bits in half a turn
+#define SWO_RING_SIZE               512         // edges, power of 2
+#define SWO_OUT_SIZE                32
+
+enum {
+    DECODE_IDLE = 0,
+    DECODE_START,
+    DECODE_DATA,
+};
+
+enum {
+    VSF_EVT_SWO_EDGES           = VSF_EVT_USER + 0,
+};
+
+typedef struct swo_manchester_t {
+    vsf_stream_t *rx;
+    vsf_eda_t eda;
+    uint32_t dropped;           // bytes lost on a full rx stream, lost edges count one
+
+    // written in interrupt
+    volatile uint8_t marks;     // half ring marks passed by the DMA
+    volatile bool idle;
+    volatile uint8_t idle_level;
+    volatile uint16_t idle_w;   // ring position when the line went idle
+    uint16_t poll_w;
+    bool quiet;
+
+    uint8_t marks_seen;
+    uint16_t ring_r;
+    uint16_t half_min;          // start bit half period accepted, in ticks
+    uint16_t half_max;
+    uint32_t half16;            // tracked half period, in 1/16 ticks
+
+    uint8_t state;
+    uint8_t level;              // line level after the last edge
+    uint8_t byte;
+    uint8_t bits;
+    uint16_t last;              // last mid-bit edge
+    uint16_t half_1p5;          // from half16, updated every byte
+    uint16_t half_2p5;
+
+    uint16_t ring[SWO_RING_SIZE];
+} swo_manchester_t;
+
+static swo_manchester_t swo_manchester;
+
+static uint16_t ring_pos(void)
+{
+    return (SWO_RING_SIZE - DMA_CHxCNT(DMA, SWO_MANCHESTER_DMA_CH)) & (SWO_RING_SIZE - 1);
+}
+
+static uint8_t line_level(void)
+{
+    return vsfhal_gpio_read(SWO_MANCHESTER_IO_IDX, 0x1 << SWO_MANCHESTER_IO_PIN) ? 1 : 0;
+}
+
+static void stream_dorx(swo_manchester_t *m, uint8_t *buf, uint32_t size)
+{
+    if (size && VSF_STREAM_IS_RX_CONNECTED(m->rx))
+        m->dropped += size - VSF_STREAM_WRITE(m->rx, buf, size);
+}
+
+// the state is kept in locals, an edge on a bit boundary costs a few cycles
+static void decode(swo_manchester_t *m, uint16_t w)
+{
+    uint8_t out[SWO_OUT_SIZE];
+    uint32_t size = 0;
+    uint16_t r = m->ring_r;
+    uint16_t last = m->last;
+    uint16_t half_1p5 = m->half_1p5, half_2p5 = m->half_2p5;
+    uint32_t half16 = m->half16;
+    uint8_t state = m->state, level = m->level, byte = m->byte, bits = m->bits;
+
+    while (r != w) {
+        uint16_t t = m->ring[r];
+        uint16_t dt = t - last;
+
+        r = (r + 1) & (SWO_RING_SIZE - 1);
+        level ^= 1;
+
+        switch (state) {
+        case DECODE_DATA:
+            if (dt < half_1p5)
+                break;
+            if (dt < half_2p5) {
+                last = t;
+                half16 += ((int32_t)dt * 8 - (int32_t)half16) / 8;
+                byte = (byte >> 1) | (level ? 0 : 0x80);
+                if (++bits == 8) {
+                    bits = 0;
+                    half_1p5 = half16 * 3 / 32;
+                    half_2p5 = half16 * 5 / 32;
+                    out[size++] = byte;
+                    if (size == SWO_OUT_SIZE) {
+                        stream_dorx(m, out, size);
+                        size = 0;
+                    }
+                }
+                break;
+            }
+            // end of packet, a partial byte is noise
+            state = DECODE_IDLE;
+            // fall through
+        case DECODE_IDLE:
+            if (level) {
+                last = t;
+                state = DECODE_START;
+            }
+            break;
+        case DECODE_START:
+            if (level) {
+                last = t;
+            } else if ((dt >= m->half_min) && (dt <= m->half_max)) {
+                last = t;
+                half16 += ((int32_t)dt * 16 - (int32_t)half16) / 4;
+                half16 = min(max(half16, m->half_min * 16), m->half_max * 16);
+                half_1p5 = half16 * 3 / 32;
+                half_2p5 = half16 * 5 / 32;
+                bits = 0;
+                state = DECODE_DATA;
+            } else {
+                state = DECODE_IDLE;
+            }
+            break;
+        }
+    }
+    m->ring_r = r;
+    m->last = last;
+    m->half16 = half16;
+    m->half_1p5 = half_1p5;
+    m->half_2p5 = half_2p5;
+    m->state = state;
+    m->level = level;
+    m->byte = byte;
+    m->bits = bits;
+    stream_dorx(m, out, size);
+}
+
+static void swo_manchester_evthandler(vsf_eda_t *eda, vsf_evt_t evt)
+{
+    swo_manchester_t *m = container_of(eda, swo_manchester_t, eda);
+    vsf_gint_state_t gint_state;
+    uint16_t w, idle_w, n;
+    uint8_t marks, idle_level;
+    bool idle;
+
+    if ((evt != VSF_EVT_SWO_EDGES) || !m->rx)
+        return;
+
+    gint_state = vsf_disable_interrupt();
+    marks = m->marks;
+    idle = m->idle;
+    idle_w = m->idle_w;
+    idle_level = m->idle_level;
+    m->idle = false;
+    w = ring_pos();
+    vsf_set_interrupt(gint_state);
+
+    n = (w - m->ring_r) & (SWO_RING_SIZE - 1);
+    m->marks_seen += ((m->ring_r & (SWO_RING_SIZE / 2 - 1)) + n) / (SWO_RING_SIZE / 2);
+    if ((int8_t)(marks - m->marks_seen) > 0) {
+        // overwritten by the DMA before decoded
+        m->marks_seen = marks;
+        m->ring_r = w;
+        m->state = DECODE_IDLE;
+        m->level = line_level();
+        m->dropped++;
+        return;
+    }
+
+    if (idle) {
+        decode(m, idle_w);
+        m->state = DECODE_IDLE;
+        m->level = idle_level;
+    }
+    decode(m, w);
+}
+
+static void swo_manchester_dma_done(void *p)
+{
+    swo_manchester_t *m = p;
+
+    m->marks++;
+    vsf_eda_post_evt(&m->eda, VSF_EVT_SWO_EDGES);
+}
+
+ROOT void TIMER1_IRQHandler(void)
+{
+    swo_manchester_t *m = &swo_manchester;
+    uint16_t w = ring_pos();
+    uint8_t level = line_level();
+
+    if (TIMER_INTF(SWO_TIMER) & TIMER_INTF_CH3OF)
+        m->dropped++;
+    TIMER_INTF(SWO_TIMER) = 0;
+    TIMER_CH0CV(SWO_TIMER) = (TIMER_CH0CV(SWO_TIMER) + 0x8000) & 0xffff;
+
+    if (w != m->poll_w) {
+        m->poll_w = w;
+        m->quiet = false;
+        vsf_eda_post_evt(&m->eda, VSF_EVT_SWO_EDGES);
+    } else if (!m->quiet && (w == ring_pos())) {
+        m->quiet = true;
+        m->idle = true;
+        m->idle_w = w;
+        m->idle_level = level;
+        vsf_eda_post_evt(&m->eda, VSF_EVT_SWO_EDGES);
+    }
+}
+
+static void swo_manchester_fini(swo_manchester_t *m)
+{
+    if (!m->rx)
+        return;
+
+    NVIC_DisableIRQ(TIMER1_IRQn);
+    TIMER_CTL0(SWO_TIMER) = 0;
+    TIMER_DMAINTEN(SWO_TIMER) = 0;
+    TIMER_CHCTL2(SWO_TIMER) = 0;
+    RCU_APB1EN &= ~RCU_APB1EN_TIMER1EN;
+
+    DMA_CHxCTL(DMA, SWO_MANCHESTER_DMA_CH) = 0;
+    vsf_dma_config_channel(DMA0_IDX, SWO_MANCHESTER_DMA_CH, NULL, NULL, -1);
+    vsfhal_gpio_config(SWO_MANCHESTER_IO_IDX, 0x1 << SWO_MANCHESTER_IO_PIN, IO_INPUT_FLOAT);
+
+    VSF_STREAM_DISCONNECT_TX(m->rx);
+    m->rx = NULL;
+}
+
+void vsfhal_swo_manchester_config(uint32_t baudrate, int32_t eda_priority, int32_t int_priority, vsf_stream_t *rx)
+{
+    swo_manchester_t *m = &swo_manchester;
+    struct vsfhal_clk_info_t *info = vsfhal_clk_info_get();
+    uint32_t timer_clk, psc, half;
+
+    swo_manchester_fini(m);
+    if (!rx || !baudrate)
+        return;
+
+    if (info->apb1_freq_hz == info->ahb_freq_hz)
+        timer_clk = info->apb1_freq_hz;
+    else
+        timer_clk = info->apb1_freq_hz * 2;
+    psc = max((timer_clk + SWO_TICK_MAX_HZ - 1) / SWO_TICK_MAX_HZ,
+            timer_clk / 2 / SWO_HALF_MAX_TICKS / baudrate + 1);
+    half = timer_clk / psc / 2 / baudrate;
+    m->half_min = max(half / 2, 1);
+    m->half_max = half * 2;
+    m->half16 = timer_clk / psc * 8 / baudrate;
+
+    m->marks = 0;
+    m->marks_seen = 0;
+    m->idle = false;
+    m->quiet = false;
+    m->poll_w = 0;
+    m->ring_r = 0;
+    m->state = DECODE_IDLE;
+    m->level = line_level();
+
+    const vsf_eda_cfg_t cfg = {
+        .fn.evthandler  = swo_manchester_evthandler,
+        .priority       = eda_priority,
+    };
+    vsf_eda_start(&m->eda, (vsf_eda_cfg_t *)&cfg);
+    m->rx = rx;
+    VSF_STREAM_CONNECT_TX(rx);
+
+    DMA_CHxCTL(DMA, SWO_MANCHESTER_DMA_CH) = 0;
+    DMA_CHxPADDR(DMA, SWO_MANCHESTER_DMA_CH) = (uint32_t)&TIMER_CH3CV(SWO_TIMER);
+    DMA_CHxMADDR(DMA, SWO_MANCHESTER_DMA_CH) = (uint32_t)m->ring;
+    DMA_CHxCNT(DMA, SWO_MANCHESTER_DMA_CH) = SWO_RING_SIZE;
+    DMA_CHxCTL(DMA, SWO_MANCHESTER_DMA_CH) = DMA_CHXCTL_CMEN | DMA_CHXCTL_MNAGA | DMA_PERIPHERAL_WIDTH_16BIT |
+            DMA_MEMORY_WIDTH_16BIT | DMA_PRIORITY_HIGH | DMA_CHXCTL_FTFIE | DMA_CHXCTL_HTFIE;
+    vsf_dma_config_channel(DMA0_IDX, SWO_MANCHESTER_DMA_CH, swo_manchester_dma_done, m, int_priority);
+    DMA_CHxCTL(DMA, SWO_MANCHESTER_DMA_CH) |= DMA_CHXCTL_CHEN;
+
+    // 32bit on TIMER1, wrapped at 16bit to match the DMA width
+    RCU_APB1EN |= RCU_APB1EN_TIMER1EN;
+    TIMER_CTL0(SWO_TIMER) = 0;
+    TIMER_PSC(SWO_TIMER) = psc - 1;
+    TIMER_CAR(SWO_TIMER) = 0xffff;
+    TIMER_CNT(SWO_TIMER) = 0;
+    TIMER_CHCTL0(SWO_TIMER) = 0;                            // CH0 compare, no output
+    TIMER_CH0CV(SWO_TIMER) = 0x8000;
+    TIMER_CHCTL1(SWO_TIMER) = (0x1ul << 8) | (0x1ul << 12); // CH3 on CI3, filter fCK_TIMER N=2
+    TIMER_CHCTL2(SWO_TIMER) = TIMER_CHCTL2_CH3EN | TIMER_CHCTL2_CH3P | TIMER_CHCTL2_CH3NP;  // both edges
+    TIMER_SWEVG(SWO_TIMER) = TIMER_SWEVG_UPG;
+    TIMER_INTF(SWO_TIMER) = 0;
+    TIMER_DMAINTEN(SWO_TIMER) = TIMER_DMAINTEN_CH0IE | TIMER_DMAINTEN_CH3DEN;
+    NVIC_SetPriority(TIMER1_IRQn, int_priority);
+    NVIC_EnableIRQ(TIMER1_IRQn);
+
+    vsfhal_gpio_config(SWO_MANCHESTER_IO_IDX, 0x1 << SWO_MANCHESTER_IO_PIN, SWO_MANCHESTER_IO_AF);
+    TIMER_CTL0(SWO_TIMER) = TIMER_CTL0_CEN;
+}
+
+uint32_t vsfhal_swo_manchester_get_dropped(void)
+{
+    uint32_t dropped = swo_manchester.dropped;
+    swo_manchester.dropped = 0;
+    return dropped;
+}
+
+#endif  // SWO_MANCHESTER_ENABLE
@@ -0,0 +1,32 @@
+#ifndef __HAL_DRIVER_GIGADEVICE_GD32F3X0_SWO_H__
+#define __HAL_DRIVER_GIGADEVICE_GD32F3X0_SWO_H__
+
+/*============================ INCLUDES ======================================*/
+
+#include "hal/vsf_hal_cfg.h"
+#include "__device.h"
+#if SWO_MANCHESTER_ENABLE
+#   include "service/simple_stream/vsf_simple_stream.h"
+#endif
+
+/*============================ MACROS ========================================*/
+
+#ifndef SWO_MANCHESTER_ENABLE
+#   define SWO_MANCHESTER_ENABLE        0
+#endif
+
+/*============================ MACROFIED FUNCTIONS ===========================*/
+/*============================ TYPES =========================================*/
+/*============================ GLOBAL VARIABLES ==============================*/
+/*============================ LOCAL VARIABLES ===============================*/
+/*============================ INCLUDES ======================================*/
+/*============================ PROTOTYPES ====================================*/
+
+#if SWO_MANCHESTER_ENABLE
+// rx NULL stops the capture, baudrate is only the nominal rate, the bit clock is taken from each start bit
+void vsfhal_swo_manchester_config(uint32_t baudrate, int32_t eda_priority, int32_t int_priority, vsf_stream_t *rx);
+uint32_t vsfhal_swo_manchester_get_dropped(void);
+#endif
+
+#endif
+/* EOF */
@@ -85,6 +85,8 @@ typedef struct swd_control_t {
     bool data_force;
     uint16_t retry_limit;
     uint16_t delay_tick;
+    uint32_t wait_retries;          // packets repeated after WAIT
+    uint32_t parity_errors;         // reads with bad data parity
 
     #if TIMESTAMP_CLOCK
     uint32_t dap_timestamp;
@@ -381,7 +383,11 @@ void vsfhal_swd_seqin(uint8_t *data, uint32_t bitlen)
 
 uint32_t vsfhal_swd_read(uint32_t request, uint8_t *r_data)
 {
-    return swd_control.swd_read(request, r_data);
+    uint32_t ack = swd_control.swd_read(request, r_data);
+
+    if (ack == (SWD_ACK_OK | SWD_PARITY_ERROR))
+        swd_control.parity_errors++;
+    return ack;
 }
 
 uint32_t vsfhal_swd_write(uint32_t request, uint8_t *w_data)
@@ -541,9 +547,10 @@ SYNC_READ_RESTART:
             //SPI0->CR0 = SWD_SPI_CR0_DEFAULT | SPI_CR0_DSS_8BIT;
         }
 
-        if ((temp == SWD_ACK_WAIT) && (retry++ < swd_control.retry_limit))
+        if ((temp == SWD_ACK_WAIT) && (retry++ < swd_control.retry_limit)) {
+            swd_control.wait_retries++;
             goto SYNC_READ_RESTART;
-        else
+        } else
             return temp;
     } else {
         // Data:[C]*32
@@ -722,9 +729,10 @@ SYNC_READ_RESTART:
             //SPI0->CR0 = SWD_SPI_CR0_DEFAULT | SPI_CR0_DSS_8BIT;
         }
 
-        if ((temp == SWD_ACK_WAIT) && (retry++ < swd_control.retry_limit))
+        if ((temp == SWD_ACK_WAIT) && (retry++ < swd_control.retry_limit)) {
+            swd_control.wait_retries++;
             goto SYNC_READ_RESTART;
-        else
+        } else
             return temp;
     } else {
         // Data:[C]*32
@@ -908,9 +916,10 @@ SYNC_READ_RESTART:
 
         SWDIO_MO_TO_IN();
         SWDIO_MI_TO_IN();
-        if ((temp == SWD_ACK_WAIT) && (retry++ < swd_control.retry_limit))
+        if ((temp == SWD_ACK_WAIT) && (retry++ < swd_control.retry_limit)) {
+            swd_control.wait_retries++;
             goto SYNC_READ_RESTART;
-        else
+        } else
             return temp;
     } else {
         // Data:[C]*32
@@ -1098,9 +1107,10 @@ SYNC_READ_RESTART:
 
         SWDIO_MO_TO_IN();
         SWDIO_MI_TO_IN();
-        if ((temp == SWD_ACK_WAIT) && (retry++ < swd_control.retry_limit))
+        if ((temp == SWD_ACK_WAIT) && (retry++ < swd_control.retry_limit)) {
+            swd_control.wait_retries++;
             goto SYNC_READ_RESTART;
-        else
+        } else
             return temp;
     } else {
         // Data:[C]*32
@@ -1203,6 +1213,20 @@ static void swd_write_io_slow(uint8_t *data, uint32_t bits)
     SWDIO_MO_TO_IN();
 }
 
+uint32_t vsfhal_swd_get_retries(void)
+{
+    uint32_t retries = swd_control.wait_retries;
+    swd_control.wait_retries = 0;
+    return retries;
+}
+
+uint32_t vsfhal_swd_get_parity_errors(void)
+{
+    uint32_t errors = swd_control.parity_errors;
+    swd_control.parity_errors = 0;
+    return errors;
+}
+
 #if TIMESTAMP_CLOCK
 uint32_t vsfhal_swd_get_timestamp(void)
 {
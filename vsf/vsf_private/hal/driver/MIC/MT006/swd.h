@@ -37,6 +37,8 @@ uint32_t vsfhal_swd_write(uint32_t request, uint8_t *w_data);
 uint32_t vsfhal_swd_wait(void);
 void vsfhal_swd_clear(void);
 #endif
+uint32_t vsfhal_swd_get_retries(void);
+uint32_t vsfhal_swd_get_parity_errors(void);
 #if TIMESTAMP_CLOCK
 uint32_t vsfhal_swd_get_timestamp(void);
 #endif
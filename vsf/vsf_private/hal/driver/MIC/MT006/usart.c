@@ -42,6 +42,7 @@ typedef struct usart_control_t {
     uint8_t rx_buffer_r_select;
     bool rx_onrx;
     vsf_eda_t eda;
+    uint32_t stream_rx_dropped;     // bytes lost on a full rx stream
 #endif
     void (*ontx)(void *);
     void (*onrx)(void *);
@@ -359,7 +360,7 @@ static void stream_dorx(usart_control_t *ctrl, vsf_stream_t *stream)
         uint8_t buf[USART_RX_FIFO_SIZE];
         size = vsfhal_usart_rx_bytes(idx, buf, USART_RX_FIFO_SIZE);
         if (size && VSF_STREAM_IS_RX_CONNECTED(stream))
-            VSF_STREAM_WRITE(stream, buf, size);
+            ctrl->stream_rx_dropped += size - VSF_STREAM_WRITE(stream, buf, size);
     } else if (stream->op == &vsf_block_stream_op) {
         // NULL
     }
@@ -543,6 +544,13 @@ void vsfhal_usart_stream_config(enum usart_idx_t idx, int32_t eda_priority, int3
         VSF_STREAM_CONNECT_TX(rx);
     }
 }
+
+uint32_t vsfhal_usart_stream_get_dropped(enum usart_idx_t idx)
+{
+    uint32_t dropped = usart_control[idx].stream_rx_dropped;
+    usart_control[idx].stream_rx_dropped = 0;
+    return dropped;
+}
 #endif
 
 #endif